@@ -20,6 +20,9 @@ namespace NangaParbat
 
     DWS(): Parameterisation{"DWS", 2, std::vector<double>{0.207309505279, 0.09258432985738}, true}, _Q02(3.2) { };
 
+    std::unique_ptr<Parameterisation> Clone() const { return std::unique_ptr<Parameterisation>(new DWS{*this}); };
+    using Parameterisation::Clone;
+
     double Evaluate(double const&, double const& b, double const& zeta, int const& ifunc) const
     {
       if (ifunc < 0 || ifunc >= this->_nfuncs)
@@ -31,6 +34,32 @@ namespace NangaParbat
       return exp( - ( g1 + g2 * log(zeta / _Q02) / 2 ) * pow(b, 2) / 2 );
     };
 
+    void EvaluateBatch(int const& n, double const*, double const* b, double const* zeta, int const& ifunc, double* f) const
+    {
+      if (ifunc < 0 || ifunc >= this->_nfuncs)
+        throw std::runtime_error("[DWS::EvaluateBatch]: function index out of range");
+
+      const double g1    = this->_pars[0];
+      const double g2h   = this->_pars[1] / 2;
+      const double lnQ02 = log(_Q02);
+
+      for (int i = 0; i < n; i++)
+        f[i] = exp( - ( g1 + g2h * ( log(zeta[i]) - lnQ02 ) ) * b[i] * b[i] / 2 );
+    };
+
+    bool IsSeparable() const { return true; }
+
+    std::vector<double> bFactors(double const& b, int const&) const { return {b * b}; };
+
+    std::vector<double> zetaFactors(double const& zeta, int const&) const { return {log(zeta / _Q02)}; };
+
+    std::vector<int> GetFactorDependencies(FactorKind const&, int const&) const { return {}; };
+
+    double Combine(double const*, double const* bf, double const* zf, int const&) const
+    {
+      return exp( - ( this->_pars[0] + this->_pars[1] * zf[0] / 2 ) * bf[0] / 2 );
+    };
+
     double Derive(double const&, double const& b, double const& zeta, int const& ifunc, int const& ipar) const
     {
       const double g1 = this->_pars[0];
@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include "NangaParbat/parameterisation.h"
+#include "NangaParbat/autodiffparameterisation.h"
 
 #include <math.h>
 
@@ -14,29 +14,71 @@ namespace NangaParbat
    * @brief Pavia 2017 parameterisation derived from the
    * "Parameterisation" mother class.
    */
-  class PV17: public NangaParbat::Parameterisation
+  class PV17: public NangaParbat::AutoDiffParameterisation<PV17, 11>
   {
   public:
     // The default parameters correspond to those of replica 105 of
     // the PV17 fit. See Tabs. X and XI of
     // https://arxiv.org/pdf/1703.10157.pdf.
-    PV17(): Parameterisation{"PV17", 2, std::vector<double>{0.12840E+00, 0.28516E+00, 0.29755E+01, 0.17293E+00, 0.39432E+00, 2.12062E-01, 0.21012E+01, 0.93554E-01, 0.25246E+01, 0.52915E+01, 3.37975E-02}} { };
+    PV17(): AutoDiffParameterisation{"PV17", 2, {0.12840E+00, 0.28516E+00, 0.29755E+01, 0.17293E+00, 0.39432E+00, 2.12062E-01, 0.21012E+01, 0.93554E-01, 0.25246E+01, 0.52915E+01, 3.37975E-02}} { };
 
-    double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const
+    template<class T>
+    T EvaluateT(double const& x, double const& b, double const& zeta, int const& ifunc, T const* p) const
     {
       if (ifunc < 0 || ifunc >= this->_nfuncs)
-        throw std::runtime_error("[PV17::Evaluate]: function index out of range");
+        throw std::runtime_error("[PV17::EvaluateT]: function index out of range");
 
       // If the value of 'x' exceeds one returns zero
       if (x >= 1)
         return 0;
 
       // Evolution
-      const double g2   = this->_pars[0];
-      const double Q02  = 1;
-      const double evol = exp( - g2 * log(zeta / Q02) * b * b / 4 );
+      const T g2       = p[0];
+      const double Q02 = 1;
+      const T evol     = exp( - g2 * log(zeta / Q02) * b * b / 4 );
 
       // TMD PDFs
+      if (ifunc == 0)
+        {
+          const T N1        = p[1];
+          const T alpha     = p[2];
+          const T sigma     = p[3];
+          const T lambda    = p[4];
+          const double xhat = 0.1;
+          const T g1        = N1 * pow(x / xhat, sigma) * pow((1 - x) / (1 - xhat), alpha);
+          return evol * exp( - g1 * pow(b / 2, 2) ) * ( 1 - lambda * pow(g1 * b / 2, 2) / ( 1 + lambda * g1 ) );
+        }
+      // TMD FFs
+      else
+        {
+          const T N3        = p[5];
+          const T beta      = p[6];
+          const T delta     = p[7];
+          const T gamma     = p[8];
+          const T lambdaF   = p[9];
+          const T N4        = p[10];
+          const double zhat = 0.5;
+          const T cmn       = ( ( pow(x, beta) + delta ) / ( pow(zhat, beta) + delta ) ) * pow((1 - x) / (1 - zhat), gamma);
+          const T g3        = N3 * cmn;
+          const T g4        = N4 * cmn;
+          const double z2   = x * x;
+          return evol * ( g3 * exp( - g3 * pow(b / 2, 2) / z2 )
+                          + ( lambdaF / z2 ) * pow(g4, 2) * ( 1 - g4 * pow(b / 2, 2) / z2 ) * exp( - g4 * pow(b / 2, 2) / z2 ) )
+                 / ( g3 + ( lambdaF / z2 ) * pow(g4, 2) );
+        }
+    };
+
+    void EvaluateBatch(int const& n, double const* x, double const* b, double const* zeta, int const& ifunc, double* f) const
+    {
+      if (ifunc < 0 || ifunc >= this->_nfuncs)
+        throw std::runtime_error("[PV17::EvaluateBatch]: function index out of range");
+
+      // Evolution
+      const double g2q = this->_pars[0] / 4;
+
+      // The choice of the function is made once for all points. The
+      // loops are branch free, points with x >= 1 are set to zero at
+      // the end.
       if (ifunc == 0)
         {
           const double N1     = this->_pars[1];
@@ -44,10 +86,15 @@ namespace NangaParbat
           const double sigma  = this->_pars[3];
           const double lambda = this->_pars[4];
           const double xhat   = 0.1;
-          const double g1     = N1 * pow(x / xhat, sigma) * pow((1 - x) / (1 - xhat), alpha);
-          return evol * exp( - g1 * pow(b / 2, 2) ) * ( 1 - lambda * pow(g1 * b / 2, 2) / ( 1 + lambda * g1 ) );
+          const double N1h    = N1 / pow(xhat, sigma) / pow(1 - xhat, alpha);
+          for (int i = 0; i < n; i++)
+            {
+              const double b2  = b[i] * b[i];
+              const double g1  = N1h * exp( sigma * log(x[i]) + alpha * log(1 - x[i]) );
+              const double fNP = exp( - ( g2q * log(zeta[i]) + g1 / 4 ) * b2 ) * ( 1 - lambda * g1 * g1 * b2 / 4 / ( 1 + lambda * g1 ) );
+              f[i] = ( x[i] < 1 ? fNP : 0 );
+            }
         }
-      // TMD FFs
       else
         {
           const double N3      = this->_pars[5];
@@ -57,16 +104,105 @@ namespace NangaParbat
           const double lambdaF = this->_pars[9];
           const double N4      = this->_pars[10];
           const double zhat    = 0.5;
-          const double cmn     = ( ( pow(x, beta) + delta ) / ( pow(zhat, beta) + delta ) ) * pow((1 - x) / (1 - zhat), gamma);
-          const double g3      = N3 * cmn;
-          const double g4      = N4 * cmn;
-          const double z2      = x * x;
-          return evol * ( g3 * exp( - g3 * pow(b / 2, 2) / z2 )
-                          + ( lambdaF / z2 ) * pow(g4, 2) * ( 1 - g4 * pow(b / 2, 2) / z2 ) * exp( - g4 * pow(b / 2, 2) / z2 ) )
+          const double iden    = 1 / ( pow(zhat, beta) + delta );
+          const double ln1mzh  = log(1 - zhat);
+          for (int i = 0; i < n; i++)
+            {
+              const double b2q = b[i] * b[i] / 4;
+              const double z2  = x[i] * x[i];
+              const double cmn = ( exp(beta * log(x[i])) + delta ) * iden * exp( gamma * ( log(1 - x[i]) - ln1mzh ) );
+              const double g3  = N3 * cmn;
+              const double g4  = N4 * cmn;
+              const double lg4 = lambdaF / z2 * g4 * g4;
+              const double fNP = exp( - g2q * log(zeta[i]) * b2q * 4 )
+                                 * ( g3 * exp( - g3 * b2q / z2 ) + lg4 * ( 1 - g4 * b2q / z2 ) * exp( - g4 * b2q / z2 ) ) / ( g3 + lg4 );
+              f[i] = ( x[i] < 1 ? fNP : 0 );
+            }
+        }
+    };
+
+    bool IsSeparable() const { return true; }
+
+    std::vector<double> xFactors(double const& x, int const& ifunc) const
+    {
+      // Flag for x < 1 followed by g1 for PDFs and by g3, g4, and
+      // x^2 for FFs.
+      if (ifunc == 0)
+        {
+          if (x >= 1)
+            return {0, 0};
+
+          const double N1    = this->_pars[1];
+          const double alpha = this->_pars[2];
+          const double sigma = this->_pars[3];
+          const double xhat  = 0.1;
+          return {1, N1 * pow(x / xhat, sigma) * pow((1 - x) / (1 - xhat), alpha)};
+        }
+      else
+        {
+          if (x >= 1)
+            return {0, 0, 0, 0};
+
+          const double N3    = this->_pars[5];
+          const double beta  = this->_pars[6];
+          const double delta = this->_pars[7];
+          const double gamma = this->_pars[8];
+          const double N4    = this->_pars[10];
+          const double zhat  = 0.5;
+          const double cmn   = ( ( pow(x, beta) + delta ) / ( pow(zhat, beta) + delta ) ) * pow((1 - x) / (1 - zhat), gamma);
+          return {1, N3 * cmn, N4 * cmn, x * x};
+        }
+    };
+
+    std::vector<double> bFactors(double const& b, int const&) const { return {pow(b / 2, 2)}; };
+
+    std::vector<double> zetaFactors(double const& zeta, int const&) const { return {log(zeta)}; };
+
+    std::vector<int> GetFactorDependencies(FactorKind const& kind, int const& ifunc) const
+    {
+      // Only the x factors depend on the parameters
+      if (kind != xFactor)
+        return {};
+
+      return (ifunc == 0 ? std::vector<int>{1, 2, 3} : std::vector<int>{5, 6, 7, 8, 10});
+    };
+
+    double Combine(double const* xf, double const* bf, double const* zf, int const& ifunc) const
+    {
+      if (xf[0] == 0)
+        return 0;
+
+      const double b2q  = bf[0];
+      const double evol = exp( - this->_pars[0] * zf[0] * b2q );
+      if (ifunc == 0)
+        {
+          const double lambda = this->_pars[4];
+          const double g1     = xf[1];
+          return evol * exp( - g1 * b2q ) * ( 1 - lambda * g1 * g1 * b2q / ( 1 + lambda * g1 ) );
+        }
+      else
+        {
+          const double lambdaF = this->_pars[9];
+          const double g3      = xf[1];
+          const double g4      = xf[2];
+          const double z2      = xf[3];
+          return evol * ( g3 * exp( - g3 * b2q / z2 )
+                          + ( lambdaF / z2 ) * pow(g4, 2) * ( 1 - g4 * b2q / z2 ) * exp( - g4 * b2q / z2 ) )
                  / ( g3 + ( lambdaF / z2 ) * pow(g4, 2) );
         }
     };
 
+    std::vector<int> GetParameterDependencies(int const& ipar) const
+    {
+      if (ipar < 0 || ipar >= this->GetParameterNumber())
+        throw std::runtime_error("[PV17::GetParameterDependencies]: parameter index out of range");
+
+      // The evolution parameter g2 is shared, the following four
+      // parameters only enter the PDF, and the remaining ones only
+      // enter the FF.
+      return (ipar == 0 ? std::vector<int>{0, 1} : (ipar < 5 ? std::vector<int>{0} : std::vector<int>{1}));
+    };
+
     std::string LatexFormula() const
     {
       std::string formula;
@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include "NangaParbat/parameterisation.h"
+#include "NangaParbat/autodiffparameterisation.h"
 
 #include <math.h>
 
@@ -14,52 +14,53 @@ namespace NangaParbat
    * @brief Pavia 2019 parameterisation derived from the
    * "Parameterisation" mother class.
    */
-  class PV19: public NangaParbat::Parameterisation
+  class PV19: public NangaParbat::AutoDiffParameterisation<PV19, 14>
   {
   public:
 
-    PV19(): Parameterisation{"PV19", 2, std::vector<double> {0.02986, 3.8486, 18.5075, 4.938, 0.0, 0.8407, 0.7921, 62.47, 4.075, 0.0, 0.0, 0.1, 0.01781, 2.0}} {};
+    PV19(): AutoDiffParameterisation{"PV19", 2, {0.02986, 3.8486, 18.5075, 4.938, 0.0, 0.8407, 0.7921, 62.47, 4.075, 0.0, 0.0, 0.1, 0.01781, 2.0}} {};
 
-    double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const
+    template<class T>
+    T EvaluateT(double const& x, double const& b, double const& zeta, int const& ifunc, T const* p) const
     {
       if (ifunc < 0 || ifunc >= this->_nfuncs)
-        throw std::runtime_error("[PV19::Evaluate]: function index out of range");
+        throw std::runtime_error("[PV19::EvaluateT]: function index out of range");
 
       // If the value of 'x' exceeds one returns zero
       if (x >= 1)
         return 0;
 
       // Free paraMeters
-      const double g2      = this->_pars[0];
-      const double N1      = this->_pars[1];
-      const double alpha   = this->_pars[2];
-      const double sigma   = this->_pars[3];
-      const double delta   = this->_pars[4];
-      const double lambdaB = this->_pars[5];
-      const double N1B     = this->_pars[6];
-      const double alphaB  = this->_pars[7];
-      const double sigmaB  = this->_pars[8];
-      const double deltaB  = this->_pars[9];
-      const double lambdaC = this->_pars[10];
-      const double g1C     = this->_pars[11];
-      const double g2B     = this->_pars[12];
-      const double beta    = this->_pars[13];
+      const T g2      = p[0];
+      const T N1      = p[1];
+      const T alpha   = p[2];
+      const T sigma   = p[3];
+      const T delta   = p[4];
+      const T lambdaB = p[5];
+      const T N1B     = p[6];
+      const T alphaB  = p[7];
+      const T sigmaB  = p[8];
+      const T deltaB  = p[9];
+      const T lambdaC = p[10];
+      const T g1C     = p[11];
+      const T g2B     = p[12];
+      const T beta    = p[13];
 
       // Useful definitions
-      const double lambdaB2 = lambdaB * lambdaB;
-      const double lambdaC2 = lambdaC * lambdaC;
-      const double g1C2     = g1C * g1C;
+      const T lambdaB2 = lambdaB * lambdaB;
+      const T lambdaC2 = lambdaC * lambdaC;
+      const T g1C2     = g1C * g1C;
 
       // x-dependent bits
-      const double g1  = N1 *  ( pow(x, sigma)  + delta  ) / ( pow(_xhat, sigma)  + delta  ) * pow((1 - x) / (1 - _xhat), alpha);
-      const double g1B = N1B * ( pow(x, sigmaB) + deltaB ) / ( pow(_xhat, sigmaB) + deltaB ) * pow((1 - x) / (1 - _xhat), alphaB);
+      const T g1  = N1 *  ( pow(x, sigma)  + delta  ) / ( pow(_xhat, sigma)  + delta  ) * pow((1 - x) / (1 - _xhat), alpha);
+      const T g1B = N1B * ( pow(x, sigmaB) + deltaB ) / ( pow(_xhat, sigmaB) + deltaB ) * pow((1 - x) / (1 - _xhat), alphaB);
 
       // bT-dependent bits
       const double b2 = b * b;
 
       // zeta-dependent bit (i.e. non perturbative evolution)
-      const double lnz    = log(zeta / _Q02);
-      const double NPevol = exp( - ( g2 * pow(b, beta) + g2B * b2 * b2 ) * lnz / 4 );
+      const double lnz = log(zeta / _Q02);
+      const T NPevol   = exp( - ( g2 * pow(b, beta) + g2B * b2 * b2 ) * lnz / 4 );
 
       return
         ( ( 1 - lambdaB2 ) / ( 1 + g1 / 4  * b2 )
@@ -67,6 +68,70 @@ namespace NangaParbat
         * NPevol;
     };
 
+    bool IsSeparable() const { return true; }
+
+    std::vector<double> xFactors(double const& x, int const&) const
+    {
+      // Flag for x < 1, g1, and g1B
+      if (x >= 1)
+        return {0, 0, 0};
+
+      const double N1     = this->_pars[1];
+      const double alpha  = this->_pars[2];
+      const double sigma  = this->_pars[3];
+      const double delta  = this->_pars[4];
+      const double N1B    = this->_pars[6];
+      const double alphaB = this->_pars[7];
+      const double sigmaB = this->_pars[8];
+      const double deltaB = this->_pars[9];
+      return {1,
+              N1 *  ( pow(x, sigma)  + delta  ) / ( pow(_xhat, sigma)  + delta  ) * pow((1 - x) / (1 - _xhat), alpha),
+              N1B * ( pow(x, sigmaB) + deltaB ) / ( pow(_xhat, sigmaB) + deltaB ) * pow((1 - x) / (1 - _xhat), alphaB)};
+    };
+
+    std::vector<double> bFactors(double const& b, int const&) const
+    {
+      // b^2, b^beta, and the x-independent g1C term
+      const double g1C = this->_pars[11];
+      const double b2  = b * b;
+      return {b2, pow(b, this->_pars[13]), g1C * g1C * ( 1 - g1C / 4 * b2 ) * exp( - g1C / 4 * b2 )};
+    };
+
+    std::vector<double> zetaFactors(double const& zeta, int const&) const { return {log(zeta / _Q02)}; };
+
+    std::vector<int> GetFactorDependencies(FactorKind const& kind, int const&) const
+    {
+      switch (kind)
+        {
+        case xFactor:
+          return {1, 2, 3, 4, 6, 7, 8, 9};
+        case bFactor:
+          return {11, 13};
+        default:
+          return {};
+        }
+    };
+
+    double Combine(double const* xf, double const* bf, double const* zf, int const&) const
+    {
+      if (xf[0] == 0)
+        return 0;
+
+      const double g2       = this->_pars[0];
+      const double lambdaB2 = this->_pars[5] * this->_pars[5];
+      const double lambdaC2 = this->_pars[10] * this->_pars[10];
+      const double g1C      = this->_pars[11];
+      const double g2B      = this->_pars[12];
+      const double g1       = xf[1];
+      const double g1B      = xf[2];
+      const double b2       = bf[0];
+      const double NPevol   = exp( - ( g2 * bf[1] + g2B * b2 * b2 ) * zf[0] / 4 );
+      return
+        ( ( 1 - lambdaB2 ) / ( 1 + g1 / 4  * b2 )
+          + lambdaB2 * ( g1B * exp( - g1B / 4  * b2 ) + lambdaC2 * bf[2] ) / ( g1B + lambdaC2 * g1C * g1C ) )
+        * NPevol;
+    };
+
     std::string LatexFormula() const
     {
       std::string formula;
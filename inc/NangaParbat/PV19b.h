@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include "NangaParbat/parameterisation.h"
+#include "NangaParbat/autodiffparameterisation.h"
 
 #include <math.h>
 
@@ -14,47 +14,48 @@ namespace NangaParbat
    * @brief Pavia 2019 parameterisation derived from the
    * "Parameterisation" mother class.
    */
-  class PV19b: public NangaParbat::Parameterisation
+  class PV19b: public NangaParbat::AutoDiffParameterisation<PV19b, 9>
   {
   public:
 
-    PV19b(): Parameterisation{"PV19b", 2, std::vector<double> {0, 0, 0, 0, 0, 0, 0, 0, 0}} {};
+    PV19b(): AutoDiffParameterisation{"PV19b", 2, {0, 0, 0, 0, 0, 0, 0, 0, 0}} {};
 
-    double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const
+    template<class T>
+    T EvaluateT(double const& x, double const& b, double const& zeta, int const& ifunc, T const* p) const
     {
       if (ifunc < 0 || ifunc >= this->_nfuncs)
-        throw std::runtime_error("[PV19b::Evaluate]: function index out of range");
+        throw std::runtime_error("[PV19b::EvaluateT]: function index out of range");
 
       // If the value of 'x' exceeds one returns zero
       if (x >= 1)
         return 0;
 
       // Free parameters
-      const double g2     = this->_pars[0];
-      const double N1     = this->_pars[1];
-      const double alpha  = this->_pars[2];
-      const double sigma  = this->_pars[3];
-      const double lambda = this->_pars[4];
-      const double N1B    = this->_pars[5];
-      const double alphaB = this->_pars[6];
-      const double sigmaB = this->_pars[7];
-      const double g2B    = this->_pars[8];
+      const T g2     = p[0];
+      const T N1     = p[1];
+      const T alpha  = p[2];
+      const T sigma  = p[3];
+      const T lambda = p[4];
+      const T N1B    = p[5];
+      const T alphaB = p[6];
+      const T sigmaB = p[7];
+      const T g2B    = p[8];
 
       // x-dependent bits
-      const double g1  = exp( sigma * ( x / alpha - 1 ) );
-      const double g1B = N1B * exp( - pow( ( x - alphaB ) / sigmaB, 2 ) / 2 );
+      const T g1  = exp( sigma * ( x / alpha - 1 ) );
+      const T g1B = N1B * exp( - pow( ( x - alphaB ) / sigmaB, 2 ) / 2 );
       //const double g1B = N1B * exp( - pow(log(sigmaB) * log( x / alphaB ), 2 ) / 2 );
 
       // bT-dependent bits
       const double b2 = b * b;
 
       // different contributions
-      const double term1 = 1 / ( 1 + g1 * b2 / 4 );
-      const double term2 = exp( - g1B * b2 / 4 );
+      const T term1 = 1 / ( 1 + g1 * b2 / 4 );
+      const T term2 = exp( - g1B * b2 / 4 );
 
       // zeta-dependent bit (i.e. non perturbative evolution)
-      const double lnz    = log(zeta / _Q02);
-      const double NPevol = exp( - ( g2 + g2B * b2 ) * b2 * lnz / 4 );
+      const double lnz = log(zeta / _Q02);
+      const T NPevol   = exp( - ( g2 + g2B * b2 ) * b2 * lnz / 4 );
 
       return ( ( 1 - lambda ) * term1 + lambda * term2 - N1 ) * NPevol;
     };
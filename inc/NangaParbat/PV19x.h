@@ -20,6 +20,9 @@ namespace NangaParbat
 
     PV19x(): Parameterisation{"PV19x", 2, std::vector<double> {0, 0, 0, 0, 0, 0, 0, 0, 0}} {};
 
+    std::unique_ptr<Parameterisation> Clone() const { return std::unique_ptr<Parameterisation>(new PV19x{*this}); };
+    using Parameterisation::Clone;
+
     double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const
     {
       if (ifunc < 0 || ifunc >= this->_nfuncs)
@@ -53,6 +56,82 @@ namespace NangaParbat
       return ( ( 1 - lambda ) / ( 1 + g1 / 4 * b2 ) + lambda * exp( - g1B / 4 * b2 ) ) * NPevol;
     };
 
+    void EvaluateBatch(int const& n, double const* x, double const* b, double const* zeta, int const& ifunc, double* f) const
+    {
+      if (ifunc < 0 || ifunc >= this->_nfuncs)
+        throw std::runtime_error("[PV19x::EvaluateBatch]: function index out of range");
+
+      // Parameter-dependent constants
+      const double g2     = this->_pars[0];
+      const double N1s    = this->_pars[1] / this->_pars[3];
+      const double lnal   = log(this->_pars[2]);
+      const double is2    = 1 / ( 2 * this->_pars[3] * this->_pars[3] );
+      const double lambda = this->_pars[4];
+      const double N1Bs   = this->_pars[5] / this->_pars[7];
+      const double lnalB  = log(this->_pars[6]);
+      const double is2B   = 1 / ( 2 * this->_pars[7] * this->_pars[7] );
+      const double g2B    = this->_pars[8];
+      const double lnQ02  = log(_Q02);
+
+      // Branch-free loop, points with x >= 1 are set to zero at the
+      // end.
+      for (int i = 0; i < n; i++)
+        {
+          const double lnx    = log(x[i]);
+          const double g1     = N1s  * exp( - ( lnx - lnal )  * ( lnx - lnal )  * is2  ) / x[i];
+          const double g1B    = N1Bs * exp( - ( lnx - lnalB ) * ( lnx - lnalB ) * is2B ) / x[i];
+          const double b2     = b[i] * b[i];
+          const double lnevol = - ( g2 + g2B * b2 ) * b2 * ( log(zeta[i]) - lnQ02 ) / 4;
+          const double fNP    = ( 1 - lambda ) * exp(lnevol) / ( 1 + g1 / 4 * b2 ) + lambda * exp( lnevol - g1B / 4 * b2 );
+          f[i] = ( x[i] < 1 ? fNP : 0 );
+        }
+    };
+
+    bool IsSeparable() const { return true; }
+
+    std::vector<double> xFactors(double const& x, int const&) const
+    {
+      // Flag for x < 1, g1, and g1B
+      if (x >= 1)
+        return {0, 0, 0};
+
+      const double N1     = this->_pars[1];
+      const double alpha  = this->_pars[2];
+      const double sigma  = this->_pars[3];
+      const double N1B    = this->_pars[5];
+      const double alphaB = this->_pars[6];
+      const double sigmaB = this->_pars[7];
+      return {1,
+              N1  * exp( - pow(log(x / alpha),  2) / 2 / pow(sigma, 2)  ) / x / sigma,
+              N1B * exp( - pow(log(x / alphaB), 2) / 2 / pow(sigmaB, 2) ) / x / sigmaB};
+    };
+
+    std::vector<double> bFactors(double const& b, int const&) const { return {b * b}; };
+
+    std::vector<double> zetaFactors(double const& zeta, int const&) const { return {log(zeta / _Q02)}; };
+
+    std::vector<int> GetFactorDependencies(FactorKind const& kind, int const&) const
+    {
+      // Only the x factors depend on the parameters
+      if (kind != xFactor)
+        return {};
+
+      return {1, 2, 3, 5, 6, 7};
+    };
+
+    double Combine(double const* xf, double const* bf, double const* zf, int const&) const
+    {
+      if (xf[0] == 0)
+        return 0;
+
+      const double g2     = this->_pars[0];
+      const double lambda = this->_pars[4];
+      const double g2B    = this->_pars[8];
+      const double b2     = bf[0];
+      const double NPevol = exp( - ( g2 + g2B * b2 ) * b2 * zf[0] / 4 );
+      return ( ( 1 - lambda ) / ( 1 + xf[1] / 4 * b2 ) + lambda * exp( - xf[2] / 4 * b2 ) ) * NPevol;
+    };
+
     double Derive(double const& x, double const& b, double const& zeta, int const& ifunc, int const& ipar) const
     {
       // Free parameters
@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include "NangaParbat/parameterisation.h"
+#include "NangaParbat/autodiffparameterisation.h"
 
 #include <math.h>
 
@@ -14,59 +14,71 @@ namespace NangaParbat
    * @brief Pavia 2017 parameterisation derived from the
    * "Parameterisation" mother class.
    */
-  class PV20Sivers: public NangaParbat::Parameterisation
+  class PV20Sivers: public NangaParbat::AutoDiffParameterisation<PV20Sivers, 11>
   {
   public:
     // The default parameters correspond to those of replica 105 of
     // the PV20Sivers fit. See Tabs. X and XI of
     // https://arxiv.org/pdf/1703.10157.pdf.
-    PV20Sivers(): Parameterisation{"PV20Sivers", 2, std::vector<double>{0.128, 0.285, 2.98, 0.173, 0.39, 0.212, 2.10, 0.094, 2.52, 5.29, 0.033}} { };
+    PV20Sivers(): AutoDiffParameterisation{"PV20Sivers", 2, {0.128, 0.285, 2.98, 0.173, 0.39, 0.212, 2.10, 0.094, 2.52, 5.29, 0.033}} { };
 
-    double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const
+    template<class T>
+    T EvaluateT(double const& x, double const& b, double const& zeta, int const& ifunc, T const* p) const
     {
       if (ifunc < 0 || ifunc >= this->_nfuncs)
-        throw std::runtime_error("[PV20Sivers::Evaluate]: function index out of range");
+        throw std::runtime_error("[PV20Sivers::EvaluateT]: function index out of range");
 
       // If the value of 'x' exceeds one returns zero
       if (x >= 1)
         return 0;
 
       // Evolution
-      const double g2   = this->_pars[0];
-      const double Q02  = 1;
-      const double evol = exp( - g2 * log(zeta / Q02) * b * b / 4 );
+      const T g2       = p[0];
+      const double Q02 = 1;
+      const T evol     = exp( - g2 * log(zeta / Q02) * b * b / 4 );
 
       // TMD PDFs
       if (ifunc == 0)
         {
-          const double N1     = this->_pars[1];
-          const double alpha  = this->_pars[2];
-          const double sigma  = this->_pars[3];
-          const double lambda = this->_pars[4];
-          const double xhat   = 0.1;
-          const double g1     = N1 * pow(x / xhat, sigma) * pow((1 - x) / (1 - xhat), alpha);
+          const T N1        = p[1];
+          const T alpha     = p[2];
+          const T sigma     = p[3];
+          const T lambda    = p[4];
+          const double xhat = 0.1;
+          const T g1        = N1 * pow(x / xhat, sigma) * pow((1 - x) / (1 - xhat), alpha);
           return evol * exp( - g1 * pow(b / 2, 2) ) * ( 1 - lambda * pow(g1 * b / 2, 2) / ( 1 + lambda * g1 ) );
         }
       // TMD FFs
       else
         {
-          const double N3      = this->_pars[5];
-          const double beta    = this->_pars[6];
-          const double delta   = this->_pars[7];
-          const double gamma   = this->_pars[8];
-          const double lambdaF = this->_pars[9];
-          const double N4      = this->_pars[10];
-          const double zhat    = 0.5;
-          const double cmn     = ( ( pow(x, beta) + delta ) / ( pow(zhat, beta) + delta ) ) * pow((1 - x) / (1 - zhat), gamma);
-          const double g3      = N3 * cmn;
-          const double g4      = N4 * cmn;
-          const double z2      = x * x;
+          const T N3        = p[5];
+          const T beta      = p[6];
+          const T delta     = p[7];
+          const T gamma     = p[8];
+          const T lambdaF   = p[9];
+          const T N4        = p[10];
+          const double zhat = 0.5;
+          const T cmn       = ( ( pow(x, beta) + delta ) / ( pow(zhat, beta) + delta ) ) * pow((1 - x) / (1 - zhat), gamma);
+          const T g3        = N3 * cmn;
+          const T g4        = N4 * cmn;
+          const double z2   = x * x;
           return evol * ( g3 * exp( - g3 * pow(b / 2, 2) / z2 )
                           + ( lambdaF / z2 ) * pow(g4, 2) * ( 1 - g4 * pow(b / 2, 2) / z2 ) * exp( - g4 * pow(b / 2, 2) / z2 ) )
                  / ( g3 + ( lambdaF / z2 ) * pow(g4, 2) );
         }
     };
 
+    std::vector<int> GetParameterDependencies(int const& ipar) const
+    {
+      if (ipar < 0 || ipar >= this->GetParameterNumber())
+        throw std::runtime_error("[PV20Sivers::GetParameterDependencies]: parameter index out of range");
+
+      // The evolution parameter g2 is shared, the following four
+      // parameters only enter the PDF, and the remaining ones only
+      // enter the FF.
+      return (ipar == 0 ? std::vector<int>{0, 1} : (ipar < 5 ? std::vector<int>{0} : std::vector<int>{1}));
+    };
+
     std::string LatexFormula() const
     {
       std::string formula;
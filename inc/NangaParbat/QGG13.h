@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include "NangaParbat/parameterisation.h"
+#include "NangaParbat/autodiffparameterisation.h"
 
 #include <math.h>
 #include <apfel/constants.h>
@@ -15,41 +15,42 @@ namespace NangaParbat
    * @brief Pavia 2019 parameterisation derived from the
    * "Parameterisation" mother class.
    */
-  class QGG13: public NangaParbat::Parameterisation
+  class QGG13: public NangaParbat::AutoDiffParameterisation<QGG13, 13>
   {
   public:
 
-    QGG13(): Parameterisation{"QGG13", 2, std::vector<double>{0.13, 0.285, 2.98, 0.173, 0.39, 0., 0.1, 0.1, 0., 0., 0., 0.1, 1.}} { };
+    QGG13(): AutoDiffParameterisation{"QGG13", 2, {0.13, 0.285, 2.98, 0.173, 0.39, 0., 0.1, 0.1, 0., 0., 0., 0.1, 1.}} { };
 
-    double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const
+    template<class T>
+    T EvaluateT(double const& x, double const& b, double const& zeta, int const& ifunc, T const* p) const
     {
       if (ifunc < 0 || ifunc >= this->_nfuncs)
-        throw std::runtime_error("[QGG13::Evaluate]: function index out of range");
+        throw std::runtime_error("[QGG13::EvaluateT]: function index out of range");
 
       // If the value of 'x' exceeds one returns zero
       if (x >= 1)
         return 0;
 
       // Free paraMeters
-      const double g2      = this->_pars[0];
-      const double N1      = this->_pars[1];
-      const double alpha   = this->_pars[2];
-      const double sigma   = this->_pars[3];
-      const double delta   = this->_pars[4];
-      const double lambdaB = this->_pars[5];
-      const double N1B     = this->_pars[6];
-      const double alphaB  = this->_pars[7];
-      const double sigmaB  = this->_pars[8];
-      const double deltaB  = this->_pars[9];
-      const double lambdaC = this->_pars[10];
-      const double g1C     = this->_pars[11];
-      const double qq      = this->_pars[12];
+      const T g2      = p[0];
+      const T N1      = p[1];
+      const T alpha   = p[2];
+      const T sigma   = p[3];
+      const T delta   = p[4];
+      const T lambdaB = p[5];
+      const T N1B     = p[6];
+      const T alphaB  = p[7];
+      const T sigmaB  = p[8];
+      const T deltaB  = p[9];
+      const T lambdaC = p[10];
+      const T g1C     = p[11];
+      const T qq      = p[12];
 
       // TMD PDFs
-      const double Q02   = 1;
-      const double xhat  = 0.1;
-      const double g1    = N1 * ( pow(x, sigma) + delta ) / ( pow(xhat, sigma) + delta ) * pow((1 - x) / (1 - xhat), alpha);
-      const double g1B   = N1B * ( pow(x, sigmaB) + deltaB ) / ( pow(xhat, sigmaB) + deltaB ) * pow((1 - x) / (1 - xhat), alphaB);
+      const double Q02  = 1;
+      const double xhat = 0.1;
+      const T g1        = N1 * ( pow(x, sigma) + delta ) / ( pow(xhat, sigma) + delta ) * pow((1 - x) / (1 - xhat), alpha);
+      const T g1B       = N1B * ( pow(x, sigmaB) + deltaB ) / ( pow(xhat, sigmaB) + deltaB ) * pow((1 - x) / (1 - xhat), alphaB);
 
       return (
                ((1 - pow(lambdaB, 2)) / (pow(1 +  g1/4  * b * b, qq)))
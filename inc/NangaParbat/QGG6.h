@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include "NangaParbat/parameterisation.h"
+#include "NangaParbat/autodiffparameterisation.h"
 
 #include <math.h>
 #include <apfel/constants.h>
@@ -15,34 +15,35 @@ namespace NangaParbat
    * @brief Pavia 2019 parameterisation derived from the
    * "Parameterisation" mother class.
    */
-  class QGG6: public NangaParbat::Parameterisation
+  class QGG6: public NangaParbat::AutoDiffParameterisation<QGG6, 6>
   {
   public:
 
-    QGG6(): Parameterisation{"QGG6", 2, std::vector<double>{0.13, 0.285, 2.98, 0.173, 0.39, 0.0}} { };
+    QGG6(): AutoDiffParameterisation{"QGG6", 2, {0.13, 0.285, 2.98, 0.173, 0.39, 0.0}} { };
 
-    double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const
+    template<class T>
+    T EvaluateT(double const& x, double const& b, double const& zeta, int const& ifunc, T const* p) const
     {
       if (ifunc < 0 || ifunc >= this->_nfuncs)
-        throw std::runtime_error("[QGG6::Evaluate]: function index out of range");
+        throw std::runtime_error("[QGG6::EvaluateT]: function index out of range");
 
       // If the value of 'x' exceeds one returns zero
       if (x >= 1)
         return 0;
 
       // Free paraMeters
-      const double g2     = this->_pars[0];
-      const double N1     = this->_pars[1];
-      const double alpha  = this->_pars[2];
-      const double sigma  = this->_pars[3];
-      const double lambda = this->_pars[4];
-      const double delta  = this->_pars[5];
+      const T g2     = p[0];
+      const T N1     = p[1];
+      const T alpha  = p[2];
+      const T sigma  = p[3];
+      const T lambda = p[4];
+      const T delta  = p[5];
 
       // TMD PDFs
-      const double Q02 = 1;
+      const double Q02  = 1;
       const double xhat = 0.1;
 
-      const double g1   = N1 * ( pow(x, sigma) ) / ( pow(xhat, sigma) ) * pow((1 - x) / (1 - xhat), alpha);
+      const T g1 = N1 * ( pow(x, sigma) ) / ( pow(xhat, sigma) ) * pow((1 - x) / (1 - xhat), alpha);
 
       // ---  PV19 QGaussian + Gaussian, 6 parameters ---
       return ((1 - pow(lambda, 2)) / (pow(1 + g1 / 4 * b * b, 1)) + pow(lambda,2) * exp( - delta/ 2 * b * b ) ) * exp( - g2 * log(zeta / Q02) * b * b / 4 );
@@ -0,0 +1,117 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include "NangaParbat/parameterisation.h"
+#include "NangaParbat/dual.h"
+
+#include <stdexcept>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Helper class that provides exact derivatives to a
+   * parameterisation through forward-mode automatic
+   * differentiation. A model derives from it as
+   *
+   *   class Model: public AutoDiffParameterisation<Model, npars>
+   *
+   * and implements the function body once as a template in the type
+   * of the parameters:
+   *
+   *   template<class T> T EvaluateT(double const& x, double const& b, double const& zeta, int const& ifunc, T const* p) const;
+   *
+   * "Evaluate" instantiates it with T = double, while "Derive",
+   * "Gradient", and "GradientBatch" instantiate it with T =
+   * Dual<npars> and obtain all the derivatives in one single
+   * pass. The parameterisation is flagged as providing analytic
+   * derivatives.
+   */
+  template<class Model, int NPars>
+  class AutoDiffParameterisation: public Parameterisation
+  {
+  public:
+    /**
+     * @brief The "AutoDiffParameterisation" constructor
+     * @param name: name of the parameterisation object
+     * @param nfuncs: number of parametric functions
+     * @param pars: vector of parameters (must have NPars entries)
+     */
+    AutoDiffParameterisation(std::string const& name, int const& nfuncs, std::vector<double> const& pars):
+      Parameterisation{name, nfuncs, pars, true}
+    {
+      if ((int) pars.size() != NPars)
+        throw std::runtime_error("[AutoDiffParameterisation::AutoDiffParameterisation]: wrong number of parameters for " + name);
+    }
+
+    std::unique_ptr<Parameterisation> Clone() const
+    {
+      return std::unique_ptr<Parameterisation>(new Model{static_cast<Model const&>(*this)});
+    }
+    using Parameterisation::Clone;
+
+    void SetParameters(std::vector<double> const& pars)
+    {
+      if ((int) pars.size() != NPars)
+        throw std::runtime_error("[AutoDiffParameterisation::SetParameters]: wrong number of parameters for " + this->_name);
+      this->_pars = pars;
+    }
+
+    double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const
+    {
+      return static_cast<Model const*>(this)->template EvaluateT<double>(x, b, zeta, ifunc, this->_pars.data());
+    }
+
+    double Derive(double const& x, double const& b, double const& zeta, int const& ifunc, int const& ipar) const
+    {
+      if (ipar < 0 || ipar >= NPars)
+        throw std::runtime_error("[AutoDiffParameterisation::Derive]: parameter index out of range");
+
+      return EvaluateDual(x, b, zeta, ifunc).GetDerivative(ipar);
+    }
+
+    double Gradient(double const& x, double const& b, double const& zeta, int const& ifunc, double* grad) const
+    {
+      const Dual<NPars> f = EvaluateDual(x, b, zeta, ifunc);
+      for (int ipar = 0; ipar < NPars; ipar++)
+        grad[ipar] = f.GetDerivative(ipar);
+      return f.GetValue();
+    }
+
+    void GradientBatch(int const& n, double const* x, double const* b, double const* zeta, int const& ifunc, double* grad) const
+    {
+      const std::array<Dual<NPars>, NPars> p = DualParameters();
+      for (int i = 0; i < n; i++)
+        {
+          const Dual<NPars> f = static_cast<Model const*>(this)->template EvaluateT<Dual<NPars>>(x[i], b[i], zeta[i], ifunc, p.data());
+          for (int ipar = 0; ipar < NPars; ipar++)
+            grad[i * NPars + ipar] = f.GetDerivative(ipar);
+        }
+    }
+
+  private:
+    /**
+     * @brief Function that returns the parameters promoted to
+     * independent dual variables.
+     */
+    std::array<Dual<NPars>, NPars> DualParameters() const
+    {
+      std::array<Dual<NPars>, NPars> p;
+      for (int ipar = 0; ipar < NPars; ipar++)
+        p[ipar] = Dual<NPars> {this->_pars[ipar], ipar};
+      return p;
+    }
+
+    /**
+     * @brief Function that evaluates the model with the parameters
+     * promoted to independent dual variables.
+     */
+    Dual<NPars> EvaluateDual(double const& x, double const& b, double const& zeta, int const& ifunc) const
+    {
+      const std::array<Dual<NPars>, NPars> p = DualParameters();
+      return static_cast<Model const*>(this)->template EvaluateT<Dual<NPars>>(x, b, zeta, ifunc, p.data());
+    }
+  };
+}
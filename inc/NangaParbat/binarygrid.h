@@ -0,0 +1,179 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <yaml-cpp/yaml.h>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Class that gives read-only access to a grid stored in the
+   * NangaParbat binary format. The file is memory mapped so that
+   * opening it costs (almost) nothing and only the pages actually
+   * accessed during the interpolation are loaded in memory.
+   *
+   * The file is made of a fixed-size header followed by arrays of
+   * doubles in the native byte order of the machine that produced
+   * it:
+   *  - header: the magic string "NPGRID01" followed by the number of
+   *    axes, the number of nodes of each of the (up to four) axes,
+   *    and the number of flavours, all stored as 64-bit integers,
+   *  - the nodes of each axis,
+   *  - the flavour indices,
+   *  - the grid values ordered as [axis 1]...[axis n][flavour].
+   *
+   * The axes are ordered as in the YAML grids, i.e. {Q, x, qT/Q} for
+   * TMDs and {Q, x, z, qT/Q} for structure functions. The latter
+   * have one single flavour with index zero.
+   */
+  class BinaryGrid
+  {
+  public:
+    /**
+     * @brief The "BinaryGrid" constructor
+     * @param file: path to the binary file
+     */
+    BinaryGrid(std::string const& file);
+
+    /**
+     * @brief The "BinaryGrid" destructor. It unmaps the file.
+     */
+    ~BinaryGrid();
+
+    BinaryGrid(BinaryGrid const&) = delete;
+    BinaryGrid& operator = (BinaryGrid const&) = delete;
+
+    /**
+     * @brief Function that returns the nodes of the axes
+     */
+    std::vector<std::vector<double>> const& GetAxes() const { return _axes; }
+
+    /**
+     * @brief Function that returns the flavour indices
+     */
+    std::vector<int> const& GetFlavours() const { return _flavours; }
+
+    /**
+     * @brief Function that returns the pointer to the first grid
+     * value.
+     */
+    double const* GetData() const { return _data; }
+
+  private:
+    std::string                      _file;     //!< Path to the file
+    void*                            _map;      //!< Address of the mapped region
+    std::size_t                      _size;     //!< Size in bytes of the mapped region
+    std::vector<std::vector<double>> _axes;     //!< Nodes of the axes
+    std::vector<int>                 _flavours; //!< Flavour indices
+    double const*                    _data;     //!< Grid values
+  };
+
+  /**
+   * @brief Function that writes a grid in the NangaParbat binary
+   * format.
+   * @param file: path to the output file
+   * @param axes: nodes of the axes
+   * @param flavours: flavour indices
+   * @param data: grid values ordered as [axis 1]...[axis n][flavour]
+   */
+  void WriteBinaryGrid(std::string                      const& file,
+                       std::vector<std::vector<double>> const& axes,
+                       std::vector<int>                 const& flavours,
+                       std::vector<double>              const& data);
+
+  /**
+   * @brief Function that tells whether the binary version of a grid
+   * should be used in place of the YAML one, i.e. if the ".bin" file
+   * exists and it is not older than the ".yaml" file. This protects
+   * against binary files left over by a previous production of the
+   * same set.
+   * @param file: path to the grid without extension
+   * @return true if "<file>.bin" is to be used
+   */
+  bool UseBinaryGrid(std::string const& file);
+
+  /**
+   * @brief Function that collects the values of a TMD grid in YAML
+   * format in a contiguous vector ordered as [Q][x][qT/Q][flavour],
+   * i.e. the layout of the binary format.
+   * @param grid: the YAML node containing the grid (as produced by "EmitTMDGrid")
+   * @param flavours: on exit, the flavour indices
+   * @return the grid values
+   */
+  std::vector<double> FlattenTMDGrid(YAML::Node const& grid, std::vector<int>& flavours);
+
+  /**
+   * @brief Function that writes a TMD grid in the NangaParbat binary
+   * format.
+   * @param grid: the YAML node containing the grid (as produced by "EmitTMDGrid")
+   * @param file: path to the output file
+   */
+  void WriteTMDGridBinary(YAML::Node const& grid, std::string const& file);
+
+  /**
+   * @brief Function that writes a structure-function grid in the
+   * NangaParbat binary format.
+   * @param grid: the YAML node containing the grid (as produced by "EmitStructGrid")
+   * @param file: path to the output file
+   */
+  void WriteStructGridBinary(YAML::Node const& grid, std::string const& file);
+
+  /**
+   * @brief Function that converts all the members of a set of grids
+   * (either TMDs or structure functions) from YAML to the binary
+   * format. The binary files are placed next to the YAML ones with
+   * extension ".bin". The info file is left untouched.
+   * @param name: name of the set
+   * @param folder: folder where the set is (default: current folder)
+   */
+  void ConvertGridSetToBinary(std::string const& name, std::string const& folder = ".");
+
+  /**
+   * @brief Function that emits a grid given in the layout of the
+   * binary format in the YAML format of the TMD (three axes) or
+   * structure-function (four axes) grids.
+   * @param axes: nodes of the axes
+   * @param flavours: flavour indices
+   * @param data: grid values ordered as [axis 1]...[axis n][flavour]
+   * @return a YAML emitter
+   */
+  std::unique_ptr<YAML::Emitter> EmitGridYAML(std::vector<std::vector<double>> const& axes,
+                                              std::vector<int>                 const& flavours,
+                                              std::vector<double>              const& data);
+
+  /**
+   * @brief Function that computes node by node the statistics of a
+   * Monte Carlo set of grids stored in binary format, i.e. mean,
+   * standard deviation, and lower and upper bounds of the central
+   * interval containing a fraction "cl" of the replicas. Members are
+   * read one slice of the first axis at a time so that the full
+   * ensemble is never held in memory.
+   * @param files: binary files of the replicas
+   * @param cl: confidence level (default: 0.68)
+   * @return the vector {mean, standard deviation, lower bound, upper bound} of grid values
+   */
+  std::vector<std::vector<double>> ComputeSummaryGrids(std::vector<std::string> const& files, double const& cl = 0.68);
+
+  /**
+   * @brief Function that computes the summary members of a Monte
+   * Carlo set of grids (see "ComputeSummaryGrids") and writes them as
+   * additional members of the set.
+   * @param files: binary files of the replicas
+   * @param base: path of the members without member number, e.g. "<folder>/<name>"
+   * @param first: member number of the first summary member
+   * @param binary: whether to also write the members in binary format
+   * @param cl: confidence level (default: 0.68)
+   * @return a YAML emitter with the "SummaryMembers" and "SummaryCL" keys to be appended to the info file
+   */
+  std::unique_ptr<YAML::Emitter> WriteSummaryMembers(std::vector<std::string> const& files,
+                                                     std::string              const& base,
+                                                     int                      const& first,
+                                                     bool                     const& binary,
+                                                     double                   const& cl = 0.68);
+}
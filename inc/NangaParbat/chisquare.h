@@ -9,6 +9,7 @@
 #include "NangaParbat/datahandler.h"
 #include "NangaParbat/convolutiontable.h"
 #include "NangaParbat/parameterisation.h"
+#include "NangaParbat/predictionkernels.h"
 
 namespace NangaParbat
 {
@@ -17,6 +18,15 @@ namespace NangaParbat
    * given a set of "DataHandler" objects and the corresponding
    * "ConvolutionTable" objects. The computation depends of the
    * non-perturbative functions given as input.
+   *
+   * The predictions of each dataset are cached together with the
+   * parameters they have been computed with, and recomputed only if
+   * at least one of the parameters they depend on has changed (see
+   * "Parameterisation::GetParameterDependencies"). This saves most
+   * of the convolutions when the parameters are varied one at a time
+   * (as in the computation of numerical gradients) and some datasets
+   * do not depend on them. As a consequence, the same "ChiSquare"
+   * object must not be used concurrently by different threads.
    */
   class ChiSquare
   {
@@ -40,12 +50,50 @@ namespace NangaParbat
 
     /**
      * @brief Add ("DataHandler","ConvolutionTable") pair block to the
-     * "DSVect" vector.
+     * "DSVect" vector. The experimental values and the cut mask are
+     * arranged here for the computation of the residuals, therefore
+     * the data have to be fluctuated before the block is added.
      * @param DSBlock: the ("DataHandler","ConvolutionTable")-pair
      * block to be appended
      */
     virtual void AddBlock(std::pair<DataHandler*, ConvolutionTable*> DSBlock);
 
+    /**
+     * @brief Same as above with a mask applied on top of the cuts of
+     * the "ConvolutionTable" object, such that the same tables can be
+     * used with different selections of points (e.g. the training and
+     * validation sets of a cross-validation).
+     * @param DSBlock: the ("DataHandler","ConvolutionTable")-pair
+     * block to be appended
+     * @param mask: the additional mask
+     */
+    void AddBlock(std::pair<DataHandler*, ConvolutionTable*> DSBlock, std::valarray<bool> const& mask);
+
+    /**
+     * @brief Function that sets the kernel used to compute the
+     * predictions (see "GetPredictionKernel"). If no kernel is set,
+     * "ConvolutionTable::GetPredictions" is used.
+     * @param kernel: the prediction kernel
+     */
+    void SetPredictionKernel(PredictionKernel const& kernel) { _kernel = kernel; ClearPredictionCache(); };
+
+    /**
+     * @brief Function that empties the cache of the predictions, so
+     * that they are all recomputed at the next call. This is only
+     * needed if the parameterisation changes in a way that is not
+     * reflected by its parameters.
+     */
+    void ClearPredictionCache() const;
+
+    /**
+     * @brief Function that returns the predictions for a given
+     * dataset. Predictions are only computed if the parameters they
+     * depend on have changed since the last call.
+     * @param ids: the dataset index
+     * @return the vector of predictions
+     */
+    std::vector<double> GetPredictions(int const& ids) const;
+
     /**
      * @brief Function that returns the residuals of the
      * &chi;<SUP>2</SUP> deriving from the Cholesky decomposition of
@@ -58,6 +106,32 @@ namespace NangaParbat
      */
     std::vector<double> GetResiduals(int const& ids, bool const& central = false) const;
 
+    /**
+     * @brief Same as above but with the predictions given as an input
+     * rather than computed, so that they can be reused.
+     * @param ids: the dataset index
+     * @param pred: the predictions for the dataset
+     * @param central: if true, the residuals are computed using the
+     * experimental central values rather than the fluctuated data
+     * (default: false)
+     * @return the vector of residuals
+     */
+    std::vector<double> GetResiduals(int const& ids, std::vector<double> const& pred, bool const& central = false) const;
+
+    /**
+     * @brief Same as above for several sets of predictions at once,
+     * e.g. for a scan over the parameters. The lower-diagonal system
+     * is solved for all of them in a single pass over the Cholesky
+     * decomposition of the covariance matrix.
+     * @param ids: the dataset index
+     * @param preds: the sets of predictions for the dataset
+     * @param central: if true, the residuals are computed using the
+     * experimental central values rather than the fluctuated data
+     * (default: false)
+     * @return the vectors of residuals ordered as [set][point]
+     */
+    std::vector<std::vector<double>> GetResiduals(int const& ids, std::vector<std::vector<double>> const& preds, bool const& central = false) const;
+
     /**
      * @brief Function that returns the derivative of the residuals of
      * the &chi;<SUP>2</SUP> deriving from the Cholesky decomposition
@@ -68,6 +142,16 @@ namespace NangaParbat
      */
     std::vector<double> GetResidualDerivatives(int const& ids, int const& ipar) const;
 
+    /**
+     * @brief Function that returns the derivatives of the residuals
+     * w.r.t. all the parameters at once, i.e. the Jacobian of the
+     * residuals. The lower-diagonal system is solved for all the
+     * parameters in a single pass.
+     * @param ids: the dataset index
+     * @return the vectors of derivatives of the residuals ordered as [parameter][point]
+     */
+    std::vector<std::vector<double>> GetResidualDerivatives(int const& ids) const;
+
     /**
      * @brief Function that returns the systematic shifts and the
      * associated penalty term of the &chi;<SUP>2</SUP>.
@@ -77,6 +161,16 @@ namespace NangaParbat
      */
     std::pair<std::vector<double>, double> GetSystematicShifts(int const& ids) const;
 
+    /**
+     * @brief Same as above but with the predictions given as an input
+     * rather than computed, so that they can be reused.
+     * @param ids: the dataset index
+     * @param pred: the predictions for the dataset
+     * @return a pair with the vector of nuisance parameters as a
+     * first entry and the penalty as a second.
+     */
+    std::pair<std::vector<double>, double> GetSystematicShifts(int const& ids, std::vector<double> const& pred) const;
+
     /**
      * @brief Function that evaluates the &chi;<SUP>2</SUP>'s
      * @param ids: the dataset index (default: -1, the global
@@ -182,11 +276,52 @@ namespace NangaParbat
      */
     std::vector<double> GetParameters() const { return _NPFunc->GetParameters(); };
 
+  protected:
+    /**
+     * @brief Structure containing the linear system that determines
+     * the nuisance parameters of one dataset, A &lambda; = &rho;,
+     * with A = 1 + B<SUP>T</SUP> B and &rho; = B<SUP>T</SUP> r, where
+     * B is the matrix of the correlated uncertainties divided by the
+     * uncorrelated ones and r is the vector of the residuals divided
+     * by the uncorrelated uncertainties. A does not depend on the
+     * predictions and is factorised only once.
+     */
+    struct NuisanceSystem
+    {
+      int                   nsys; //!< Number of correlated uncertainties
+      std::vector<double>   B;    //!< The matrix B (ndata x nsys, row major)
+      TriangularMatrix      L;    //!< Cholesky decomposition of A
+    };
+
+    /**
+     * @brief Structure containing the experimental values of one
+     * dataset arranged such that the residuals are computed without
+     * branching on the cut mask. For the points that pass the qT / Q
+     * cut, the residuals are r<SUB>j</SUB> = b<SUB>j</SUB> -
+     * t<SUB>j</SUB>, where b<SUB>j</SUB> is the (fluctuated)
+     * experimental value minus the central value for the points that
+     * do not pass the other cuts, and t<SUB>j</SUB> is the prediction
+     * for the active points, i.e. those that pass all the cuts, and
+     * zero otherwise.
+     */
+    struct MaskedData
+    {
+      std::vector<int>    active; //!< Indices of the active points
+      std::vector<double> bfluc;  //!< Vector b with the fluctuated data
+      std::vector<double> bcntr;  //!< Vector b with the central values
+    };
+
   protected:
     std::vector<std::pair<DataHandler*, ConvolutionTable*>> _DSVect;  //!< Vector of "DataHandler-ConvolutionTable" pairs
     Parameterisation*                                       _NPFunc;  //!< Parameterisation of the non-perturbative component
     std::vector<int>                                        _ndata;   //!< Vector constaining the number of data points per dataset that pass the qT/Q cut
     std::vector<int>                                        _ndatac;  //!< Vector constaining the number of data points per dataset that pass all the cuts
+    PredictionKernel                                        _kernel;  //!< Kernel used to compute the predictions
+    std::vector<std::vector<int>>                           _deppars; //!< Indices of the parameters the predictions of each dataset depend on
+    mutable std::vector<std::vector<double>>                _cpred;   //!< Cached predictions of each dataset
+    mutable std::vector<std::vector<double>>                _cpars;   //!< Parameters used to compute the cached predictions
+    std::vector<NuisanceSystem>                             _nuis;    //!< Nuisance-parameter systems of each dataset
+    std::vector<MaskedData>                                 _masked;  //!< Experimental values of each dataset arranged according to the cut mask
 
     friend YAML::Emitter& operator << (YAML::Emitter& os, ChiSquare const& chi2);
   };
@@ -74,6 +74,30 @@ namespace NangaParbat
     std::map<double, double> ConvoluteSIDIS(std::function<double(double const&, double const&, double const&)> const& fNP,
                                             std::function<double(double const&, double const&, double const&)> const& DNP) const;
 
+    /**
+     * @brief This function convolutes a Drell-Yan input convolution
+     * table with a parameterisation. The function is evaluated on all
+     * the (Q, xi) nodes at once for each Ogata point through
+     * "Parameterisation::EvaluateBatch". Separable parameterisations
+     * are evaluated by combining factors that are computed only once
+     * per distinct value of x, zeta, and b.
+     * @param NPFunc: the parameterisation (function 0 is used for PDFs)
+     * @return a map that associates each value of qT to a prediction.
+     */
+    std::map<double, double> ConvoluteDY(Parameterisation const& NPFunc) const;
+
+    /**
+     * @brief This function convolutes a SIDIS input convolution table
+     * with a parameterisation. The functions are evaluated on all the
+     * (Q, xb, z) nodes at once for each Ogata point through
+     * "Parameterisation::EvaluateBatch". Separable parameterisations
+     * are evaluated by combining factors that are computed only once
+     * per distinct value of x, z, zeta, and b.
+     * @param NPFunc: the parameterisation (function 0 is used for PDFs and function 1 for FFs)
+     * @return a map that associates each value of qT to a prediction.
+     */
+    std::map<double, double> ConvoluteSIDIS(Parameterisation const& NPFunc) const;
+
     /**
      * @brief This function returns a vector of predictions given two
      * user-defined non-perturbative functions.
@@ -95,6 +119,43 @@ namespace NangaParbat
      */
     virtual std::vector<double> GetPredictions(std::function<double(double const&, double const&, double const&, int const&)> const& fNP) const;
 
+    /**
+     * @brief This function returns a vector of predictions given a
+     * parameterisation. It is equivalent to passing
+     * "NPFunc.Function()" to the function above but evaluates the
+     * parameterisation on arrays of nodes.
+     * @param NPFunc: the parameterisation
+     * @return a vector of predictions.
+     */
+    virtual std::vector<double> GetPredictions(Parameterisation const& NPFunc) const;
+
+    /**
+     * @brief This function returns the derivatives of the predictions
+     * w.r.t. all the parameters of a parameterisation. The function
+     * is evaluated on the nodes as in "GetPredictions" and its
+     * gradient through "Parameterisation::GradientBatch", and the
+     * derivatives are obtained through the product rule in one single
+     * pass over the table.
+     * @param NPFunc: the parameterisation
+     * @return a vector of derivatives of the predictions ordered as [parameter][point].
+     */
+    std::vector<std::vector<double>> GetPredictionDerivatives(Parameterisation const& NPFunc) const;
+
+    /**
+     * @brief This function returns a vector of predictions given a
+     * parameterisation of known concrete type. The contraction is
+     * instantiated for the type "Model" and the function is called
+     * non virtually, so that the compiler can inline it in the loop
+     * over the nodes. It is equivalent to "GetPredictions(NPFunc)",
+     * which remains the path to be used when the type of the
+     * parameterisation is only known at run time. Separable
+     * parameterisations are passed on to "GetPredictions".
+     * @param NPFunc: the parameterisation
+     * @return a vector of predictions.
+     */
+    template<class Model>
+    std::vector<double> Predict(Model const& NPFunc) const;
+
     /**
      * @brief This function returns a vector of predictions given two
      * user-defined non-perturbative function.
@@ -109,6 +170,9 @@ namespace NangaParbat
      * function "fNP" and may behave unexpectedly. Specifically, this
      * is used to compute the anaylitic derivative of the chi2 used
      * duering the minimisation.
+     * @note For Drell-Yan the functional "ConvoluteDY" uses the same
+     * function for both hadrons, therefore the product rule cannot be
+     * applied here. Use "GetPredictionDerivatives" instead.
      */
     virtual  std::vector<double> GetPredictions(std::function<double(double const&, double const&, double const&, int const&)> const& fNP,
                                                 std::function<double(double const&, double const&, double const&, int const&)> const& dNP) const;
@@ -129,7 +193,31 @@ namespace NangaParbat
      * @brief This function returns the mask of points that pass all
      * the cuts.
      */
-    std::valarray<bool> GetCutMask() const { return _cutmask; };
+    std::valarray<bool> const& GetCutMask() const { return _cutmask; };
+
+    /**
+     * @brief This function returns the indices of the
+     * non-perturbative functions entering the predictions, i.e. the
+     * PDF (0) for Drell-Yan, the PDF (0) and the FF (1) for SIDIS,
+     * and the FF (1) for e<SUP>+</SUP>e<SUP>-</SUP> annihilation.
+     */
+    std::vector<int> GetFunctionIndices() const;
+
+    /**
+     * @brief This function enables (or disables) the incremental mode
+     * for separable parameterisations. In this mode the x and &zeta;
+     * factors of the parameterisation on the nodes of the table (see
+     * "Parameterisation::IsSeparable") are kept in buffers across
+     * calls and, when the parameters change, only the buffers that
+     * depend on the parameters that have changed (see
+     * "Parameterisation::GetFactorDependencies") are recomputed before
+     * contracting the table. The b factors are always computed on the
+     * fly. Since the buffers are updated by "GetPredictions", a table
+     * in incremental mode must not be used concurrently by different
+     * threads.
+     * @param incremental: whether the incremental mode is enabled (default: true)
+     */
+    void SetIncrementalMode(bool const& incremental = true);
 
   protected:
     std::string                                                           const _name;    //!< Name of the table
@@ -153,6 +241,91 @@ namespace NangaParbat
     double                                                                      _acc;     //!< The Ogata-quadrature accuracy
     std::vector<std::shared_ptr<Cut>>                                           _cuts;    //!< Cut objects
     std::valarray<bool>                                                         _cutmask; //!< Mask of points that pass the cuts
+    std::vector<double>                                                         _xn1;     //!< x1 on the (Q, xi) nodes (DY) or xb on the (Q, xb, z) nodes (SIDIS)
+    std::vector<double>                                                         _xn2;     //!< x2 on the (Q, xi) nodes (DY) or z on the (Q, xb, z) nodes (SIDIS)
+    std::vector<double>                                                         _zetan;   //!< Rapidity scale on the nodes
+
+    /**
+     * @brief Buffer of the factors of a separable parameterisation on
+     * a set of nodes.
+     */
+    struct FactorBuffer
+    {
+      std::string         name;       //!< Name of the parameterisation
+      std::vector<double> pars;       //!< Parameters used to compute the factors
+      std::vector<double> tab;        //!< Factors ordered as [node][factor]
+      int                 stride = 0; //!< Number of factors per node
+    };
+    bool                                                                        _incr;    //!< Whether the incremental mode is enabled
+    mutable std::vector<FactorBuffer>                                           _fbuf;    //!< Factor buffers of the incremental mode
+
+    /**
+     * @brief This function combines the predictions at the qT-bin
+     * bounds into the binned predictions.
+     * @param pred: the map returned by the "Convolute" functions
+     * @return a vector of predictions.
+     */
+    std::vector<double> BinPredictions(std::map<double, double> const& pred) const;
+
+    /**
+     * @brief This function evaluates the factors of a separable
+     * parameterisation (see "Parameterisation::IsSeparable") on a
+     * vector of coordinates.
+     * @param v: the coordinates
+     * @param factors: the function returning the factors at a given coordinate
+     * @param stride: on exit, the number of factors per coordinate
+     * @return the factors ordered as [coordinate][factor].
+     */
+    std::vector<double> TabulateFactors(std::vector<double>                                   const& v,
+                                        std::function<std::vector<double>(double const&)> const& factors,
+                                        int&                                                         stride) const;
+
+    /**
+     * @brief This function brings a buffer of x or &zeta; factors of
+     * a separable parameterisation up to date, i.e. it tabulates the
+     * factors again only if the buffer is empty, if it was filled by a
+     * different parameterisation, or if one of the parameters the
+     * factors depend on has changed.
+     * @param NPFunc: the parameterisation
+     * @param v: the coordinates
+     * @param kind: the kind of factors (either x or &zeta;)
+     * @param ifunc: the index of the function
+     * @param fb: the buffer
+     */
+    void UpdateFactorBuffer(Parameterisation             const& NPFunc,
+                            std::vector<double>          const& v,
+                            Parameterisation::FactorKind const& kind,
+                            int                          const& ifunc,
+                            FactorBuffer&                       fb) const;
+
+    /**
+     * @brief This function brings the factor buffers of a separable
+     * parameterisation up to date on the nodes of the table (see
+     * "UpdateFactorBuffer"). Nothing is done if the parameterisation
+     * is not separable.
+     * @param NPFunc: the parameterisation
+     * @param fb: the buffers, resized to the number required by the process
+     */
+    void UpdateFactorBuffers(Parameterisation const& NPFunc, std::vector<FactorBuffer>& fb) const;
+
+    /**
+     * @brief This function evaluates the non-perturbative functions on
+     * all the nodes of the table at one point of the Ogata quadrature,
+     * by combining the buffered factors if the parameterisation is
+     * separable and through "EvaluateBatch" otherwise.
+     * @param NPFunc: the parameterisation
+     * @param fb: the factor buffers filled by "UpdateFactorBuffers"
+     * @param bq: the impact parameter (DY) or the impact parameter divided by z (SIDIS)
+     * @param bn: on exit, the impact parameter on the nodes
+     * @param f1: on exit, the function of the first hadron (DY) or the PDF (SIDIS) on the nodes
+     * @param f2: on exit, the function of the second hadron (DY) or the FF (SIDIS) on the nodes
+     */
+    void EvaluateOnNodes(Parameterisation          const& NPFunc,
+                         std::vector<FactorBuffer> const& fb,
+                         double                    const& bq,
+                         std::vector<double>&             bn,
+                         std::vector<double>&             f1,
+                         std::vector<double>&             f2) const;
 
     /**
      * @name FF_SIDIS
@@ -165,4 +338,109 @@ namespace NangaParbat
     virtual std::vector<double> GetPredictions(std::function<double(double const&, double const&, double const&)> const&) const { return {}; };
     ///@}
   };
+
+  //_________________________________________________________________________________
+  template<class Model>
+  std::vector<double> ConvolutionTable::Predict(Model const& NPFunc) const
+  {
+    // Separable parameterisations are faster through the factorised
+    // path, where most of the function is computed once per table
+    // rather than once per node.
+    if (NPFunc.Model::IsSeparable())
+      return GetPredictions(static_cast<Parameterisation const&>(NPFunc));
+
+    std::map<double, double> pred;
+    switch (_proc)
+      {
+      // Drell-Yan: two PDFs
+      case DataHandler::Process::DY:
+      {
+        const int nxi = _xig.size();
+        for (int iqT = 0; iqT < (int) _qTv.size(); iqT++)
+          {
+            if (_qTv[iqT] / _Qg.front() > _qToQmax)
+              {
+                pred.insert({_qTv[iqT],  0});
+                pred.insert({-_qTv[iqT], 0});
+                continue;
+              }
+            const auto& wgt  = _WDY.at(_qTv[iqT]);
+            const auto& psf  = _PSRed.at(_qTv[iqT]);
+            const auto& dpsf = _dPSRed.at(_qTv[iqT]);
+            double cs  = 0;
+            double dcs = 0;
+            for (int n = 0; n < (int) _zOgata.size(); n++)
+              {
+                const double b = _zOgata[n] / _qTv[iqT];
+                double csn  = 0;
+                double dcsn = 0;
+                for (int tau = 0; tau < (int) _Qg.size(); tau++)
+                  for (int alpha = 0; alpha < nxi; alpha++)
+                    {
+                      const int    i  = tau * nxi + alpha;
+                      const double wf = wgt[n][tau][alpha]
+                                        * NPFunc.Model::Evaluate(_xn1[i], b, _zetan[i], 0)
+                                        * NPFunc.Model::Evaluate(_xn2[i], b, _zetan[i], 0);
+                      csn  += wf * psf[tau][alpha];
+                      dcsn += wf * dpsf[tau][alpha];
+                    }
+                cs  += csn;
+                dcs += dcsn;
+                // Break the loop if the accuracy is satisfied
+                // (assuming convergence).
+                if (std::abs(csn/cs) < _acc)
+                  break;
+              }
+            pred.insert({_qTv[iqT],  cs});
+            pred.insert({-_qTv[iqT], dcs});
+          }
+        break;
+      }
+
+      // SIDIS: one PDF and one FF
+      case DataHandler::Process::SIDIS:
+      {
+        const int nxb = _xbg.size();
+        const int nz  = _zg.size();
+        for (int iqT = 0; iqT < (int) _qTv.size(); iqT++)
+          {
+            if (_qTv[iqT] / _Qg.front() / _zg.front() > _qToQmax)
+              {
+                pred.insert({_qTv[iqT], 0});
+                continue;
+              }
+            const auto& wgt = _WSIDIS.at(_qTv[iqT]);
+            double cs = 0;
+            for (int n = 0; n < (int) _zOgata.size(); n++)
+              {
+                const double bz = _zOgata[n] / _qTv[iqT];
+                double csn = 0;
+                for (int tau = 0; tau < (int) _Qg.size(); tau++)
+                  for (int alpha = 0; alpha < nxb; alpha++)
+                    for (int beta = 0; beta < nz; beta++)
+                      {
+                        const int    i = ( tau * nxb + alpha ) * nz + beta;
+                        const double b = _xn2[i] * bz;
+                        csn += wgt[n][tau][alpha][beta]
+                               * NPFunc.Model::Evaluate(_xn1[i], b, _zetan[i], 0)
+                               * NPFunc.Model::Evaluate(_xn2[i], b, _zetan[i], 1);
+                      }
+                cs += csn;
+                // Break the loop if the accuracy is satisfied
+                // (assuming convergence).
+                if (std::abs(csn/cs) < _acc)
+                  break;
+              }
+            pred.insert({_qTv[iqT], cs});
+          }
+        break;
+      }
+
+      // e+e- annihilation into two hadrons: two FFs (Not present
+      // yet)
+      case DataHandler::Process::DIA:
+        break;
+      }
+    return BinPredictions(pred);
+  }
 }
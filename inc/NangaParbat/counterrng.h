@@ -0,0 +1,69 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Counter-based random-number generator (Philox4x32-10, see
+   * Salmon et al., SC11). The i-th random block of a stream is a
+   * function of the key of the stream and of i only, therefore
+   * streams do not carry any state: they can be split among threads
+   * and their numbers produced in any order with identical results.
+   */
+  class CounterRNG
+  {
+  public:
+    /**
+     * @brief The "CounterRNG" constructor.
+     * @param key: the key that identifies the stream
+     */
+    CounterRNG(uint64_t const& key);
+
+    /**
+     * @brief The "CounterRNG" constructor with the key derived from a
+     * seed, a replica index, and a name (e.g. that of a dataset), so
+     * that each combination defines an independent stream.
+     * @param seed: the seed
+     * @param replica: the replica index
+     * @param name: the name
+     */
+    CounterRNG(int const& seed, int const& replica, std::string const& name);
+
+    /**
+     * @brief Function that returns the i-th block of 128 random bits
+     * of the stream.
+     * @param i: the index of the block
+     */
+    std::array<uint32_t, 4> Block(uint64_t const& i) const;
+
+    /**
+     * @brief Function that returns the i-th number of the stream
+     * uniformly distributed in (0, 1).
+     * @param i: the index of the number
+     */
+    double Uniform(uint64_t const& i) const;
+
+    /**
+     * @brief Function that returns the i-th number of the stream
+     * normally distributed with zero mean and unit variance (obtained
+     * with the Box-Muller method from the i-th block).
+     * @param i: the index of the number
+     */
+    double Gaussian(uint64_t const& i) const;
+
+    /**
+     * @brief Function that returns the key of the stream
+     */
+    uint64_t GetKey() const { return _key; }
+
+  private:
+    uint64_t const _key; //!< The key of the stream
+  };
+}
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "NangaParbat/parameterisation.h"
+#include "NangaParbat/tmdservice.h"
 
 #include <vector>
 #include <memory>
@@ -96,13 +97,17 @@ namespace NangaParbat
    * @param Output: name of the output grid
    * @param repID: number of the replica
    * @param structype: whether F_UUT or others (not implemented yet)
+   * @param binary: whether to also write the members in binary format (default: false)
+   * @param summary: whether to also write the summary members, i.e. mean, standard deviation, and lower and upper bounds of the 68% CL interval of the replicas, recorded in the info file under "SummaryMembers" (default: false)
    */
   void ProduceStructGrid(std::string const& GridsDirectory,
                          std::string const& GridTMDPDFfolder,
                          std::string const& GridTMDFFfolder,
                          std::string const& Output,
                          std::string const& repID = "none",
-                         std::string const& structype = "FUUT");
+                         std::string const& structype = "FUUT",
+                         bool        const& binary = false,
+                         bool        const& summary = false);
 
   /**
    * @brief Function that produces the structure function interpolation grid in
@@ -128,7 +133,9 @@ namespace NangaParbat
   /**
    * @brief Function that produces the structure function interpolation grid in
    * momentum space. This is supposed to resamble an LHAPDF grid.
-   * We use plain YAML format.
+   * We use plain YAML format. The collinear distributions are
+   * tabulated from 0.5 GeV and the strong coupling of each
+   * distribution is evaluated directly from its own LHAPDF set.
    * @param FitDirectory: path to main folder, output of NangaParbat fit
    * @param repnumber: replica number
    * @param fdg: 4D grid used
@@ -142,6 +149,28 @@ namespace NangaParbat
                                                       FourDGrid   const& fdg,
                                                       int         const& qToQcut);
 
+  /**
+   * @brief Same as above but with the evolved TMD PDFs and FFs taken
+   * from an existing "TMDService" object, so that they can be shared
+   * by several grids. The Q nodes are computed concurrently, each
+   * with its own copy of the parameterisation.
+   * @param service: the TMD service (must be initialised for both PDFs and FFs)
+   * @param FitDirectory: path to main folder, output of NangaParbat fit
+   * @param repnumber: replica number
+   * @param pf: whether F_UUT or others (not implemented yet)
+   * @param fdg: 4D grid used
+   * @param qToQcut: cut for the convolution integral
+   * @param nthreads: number of threads (default: 0, i.e. the number of available cores)
+   * @return a YAML emitter
+   */
+  std::unique_ptr<YAML::Emitter> EmitStructGridDirect(TMDService  const& service,
+                                                      std::string const& FitDirectory,
+                                                      int         const& repnumber,
+                                                      std::string const& pf,
+                                                      FourDGrid   const& fdg,
+                                                      int         const& qToQcut,
+                                                      int         const& nthreads = 0);
+
   /**
    * @brief Function that produces the info file of the TMD set. This
    * is suppose to resamble an LHAPDF info file for the TMDs. We use
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "NangaParbat/parameterisation.h"
+#include "NangaParbat/tmdservice.h"
 
 #include <vector>
 #include <memory>
@@ -122,13 +123,16 @@ namespace NangaParbat
    * @param ReportFolder: path to the report folder
    * @param Output: name of the output grid
    * @param pf: whether PDFs ("pdf") of FFs ("ff")
+   * @param binary: whether to also write the members in binary format (default: false)
+   * @param summary: whether to also write the summary members, i.e. mean, standard deviation, and lower and upper bounds of the 68% CL interval of the replicas, recorded in the info file under "SummaryMembers" (default: false)
    */
-  void ProduceTMDGrid(std::string const& ReportFolder, std::string const& Output, std::string const& distype = "pdf");
+  void ProduceTMDGrid(std::string const& ReportFolder, std::string const& Output, std::string const& distype = "pdf", bool const& binary = false, bool const& summary = false);
 
   /**
    * @brief Function that produces the TMD interpolation grid in
    * momentum space. This is supposed to resamble an LHAPDF grid for
-   * the TMDs. We use plain YAML format.
+   * the TMDs. We use plain YAML format. The strong coupling is
+   * evaluated directly from the LHAPDF set of the distribution.
    * @param config: the YAML node with the theory settings
    * @param parameterisation: the parameterisation type
    * @param params: the vector of parameters to be used for the tabulation
@@ -141,6 +145,45 @@ namespace NangaParbat
                                              std::string         const& pf,
                                              ThreeDGrid          const& tdg);
 
+  /**
+   * @brief Same as above but with the perturbative ingredients taken
+   * from an existing "TMDService" object, so that they can be shared
+   * by several grids. The Q nodes are computed concurrently.
+   * @param service: the TMD service (must be initialised for "pf")
+   * @param parameterisation: the parameterisation type
+   * @param params: the vector of parameters to be used for the tabulation
+   * @param pf: whether PDFs ("pdf") of FFs ("ff")
+   * @param tdg: the three-dimensional grid
+   * @param nthreads: number of threads (default: 0, i.e. the number of available cores)
+   * @return a YAML emitter
+   */
+  std::unique_ptr<YAML::Emitter> EmitTMDGrid(TMDService          const& service,
+                                             std::string         const& parameterisation,
+                                             std::vector<double> const& params,
+                                             std::string         const& pf,
+                                             ThreeDGrid          const& tdg,
+                                             int                 const& nthreads = 0);
+
+  /**
+   * @brief Same as above but with the parameterisation given as an
+   * object (e.g. one defined by expressions in the fit card) rather
+   * than by name. The object is not modified: each Q node uses its
+   * own copy with parameters "params".
+   * @param service: the TMD service (must be initialised for "pf")
+   * @param parameterisation: the parameterisation
+   * @param params: the vector of parameters to be used for the tabulation
+   * @param pf: whether PDFs ("pdf") of FFs ("ff")
+   * @param tdg: the three-dimensional grid
+   * @param nthreads: number of threads (default: 0, i.e. the number of available cores)
+   * @return a YAML emitter
+   */
+  std::unique_ptr<YAML::Emitter> EmitTMDGrid(TMDService          const& service,
+                                             Parameterisation    const& parameterisation,
+                                             std::vector<double> const& params,
+                                             std::string         const& pf,
+                                             ThreeDGrid          const& tdg,
+                                             int                 const& nthreads = 0);
+
   /**
    * @brief Function that produces the info file of the TMD set. This
    * is suppose to resamble an LHAPDF info file for the TMDs. We use
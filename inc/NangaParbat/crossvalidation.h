@@ -0,0 +1,37 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include <valarray>
+#include <vector>
+#include <string>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Function that generates the training masks of a set of
+   * training/validation splits of a dataset. The validation mask of
+   * each split is the complement of the training mask within the
+   * eligible points. The random numbers are drawn from counter-based
+   * streams (see "CounterRNG") identified by the seed and the name of
+   * the dataset, such that the masks do not depend on the order in
+   * which datasets and splits are processed.
+   * @param mask: the mask of the eligible points (e.g. those that pass the kinematic cuts)
+   * @param nsplits: number of splits
+   * @param kfold: if true, the eligible points are randomly partitioned into "nsplits" folds and the i-th split uses the i-th fold for validation, otherwise each split is drawn independently
+   * @param TrainingFrac: fraction of the eligible points used for training in each split (only used if "kfold" is false)
+   * @param seed: the seed of the random streams
+   * @param name: the name of the dataset
+   * @param NMin: minimum number of eligible points below which all points are used for training in all splits (default: 10)
+   * @return the training masks of the "nsplits" splits
+   */
+  std::vector<std::valarray<bool>> GenerateTrainingMasks(std::valarray<bool> const& mask,
+                                                         int                 const& nsplits,
+                                                         bool                const& kfold,
+                                                         double              const& TrainingFrac,
+                                                         int                 const& seed,
+                                                         std::string         const& name,
+                                                         int                 const& NMin = 10);
+}
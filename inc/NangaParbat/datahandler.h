@@ -7,6 +7,9 @@
 #include <string>
 #include <vector>
 #include <utility>
+#include <memory>
+
+#include "NangaParbat/linearsystems.h"
 
 #include <apfel/apfelxx.h>
 #include <yaml-cpp/yaml.h>
@@ -18,6 +21,11 @@ namespace NangaParbat
    * @brief The "DataHandler" class provides a common interface to all
    * datasets. It provides methods to get kinematics, central values,
    * uncertainties, etc.
+   *
+   * The content of the datafile and the covariance matrix are held
+   * through shared pointers, so that copying a "DataHandler" object
+   * only copies the fluctuated data and the t0 predictions. Accessors
+   * return constant references.
    */
   class DataHandler
   {
@@ -99,6 +107,34 @@ namespace NangaParbat
      */
     DataHandler(std::string const& name, YAML::Node const& datafile, gsl_rng* rng = nullptr, int const& fluctuation = 0, std::vector<double> const& t0 = {});
 
+    /**
+     * @brief The "DataHandler" constructor from the path to the
+     * datafile. If the binary cache of the datafile (see "WriteCache"
+     * and "DataCacheFile") exists and was written from the datafile
+     * with its current size and modification time, the data are read
+     * from the cache without parsing the datafile.
+     * The covariance matrix and its decompositions are also read from
+     * the cache if no t0 predictions are given.
+     * @param name: the name associated to the data set
+     * @param datafile: the path to the datafile
+     * @param rng: GSL random number object
+     * @param fluctuation: ID of the fluctuation (i.e. Monte-Carlo replica ID) (default: 0, i.e. no fluctuations)
+     * @param t0: vector of predictions to be used for the t0-prescription
+     */
+    DataHandler(std::string const& name, std::string const& datafile, gsl_rng* rng = nullptr, int const& fluctuation = 0, std::vector<double> const& t0 = {});
+
+    /**
+     * @brief Function that writes the content of the datafile, the
+     * covariance matrix, and its decompositions to a binary file that
+     * can be read back by the constructor from the path. Size and
+     * modification time of the datafile are stored in the cache such
+     * that it is ignored as soon as the datafile changes.
+     * @param file: the output file
+     * @param datafile: the path to the datafile the object was read from
+     * @note The covariance matrix must not depend on t0 predictions.
+     */
+    void WriteCache(std::string const& file, std::string const& datafile) const;
+
     /**
      * @brief Function that fluctuates data
      * @param rng: GSL random number object
@@ -106,6 +142,31 @@ namespace NangaParbat
      */
     void FluctuateData(gsl_rng *rng, int const &fluctuation);
 
+    /**
+     * @brief Function that generates the fluctuations of several
+     * Monte-Carlo replicas at once. The random numbers of each replica
+     * are drawn from a counter-based stream identified by the seed,
+     * the replica ID, and the name of the dataset (see "CounterRNG"),
+     * so that the fluctuations of a given replica do not depend on
+     * which other replicas are generated, in which order, or on how
+     * many threads. As in "FluctuateData", replica 0 corresponds to
+     * the central values.
+     * @param seed: the seed
+     * @param first: ID of the first replica
+     * @param nrep: number of replicas
+     * @param nthreads: number of threads (default: 0, i.e. the number of available cores)
+     * @return the fluctuated data as an nrep x ndata matrix
+     */
+    apfel::matrix<double> FluctuateBatch(int const& seed, int const& first, int const& nrep, int const& nthreads = 0) const;
+
+    /**
+     * @brief Function that fluctuates data as the corresponding
+     * replica of "FluctuateBatch".
+     * @param seed: the seed
+     * @param fluctuation: ID of the fluctuation (i.e. Monte-Carlo replica ID)
+     */
+    void FluctuateDataCounterBased(int const& seed, int const& fluctuation);
+
     /**
      * @brief Function that sets the data central values replacing that
      * introduced in the constructor.
@@ -116,22 +177,22 @@ namespace NangaParbat
     /**
      * @brief Function that returns the name of the dataset
      */
-    std::string GetName() const { return _name; };
+    std::string const& GetName() const { return _data->name; };
 
     /**
      * @brief Function that returns the datafile in YAML format
      */
-    YAML::Node GetDataFile() const { return _datafile; };
+    YAML::Node GetDataFile() const;
 
     /**
      * @brief Function that returns the process code
      */
-    Process GetProcess() const { return _proc; };
+    Process GetProcess() const { return _data->proc; };
 
     /**
      * @brief Function that returns the observable code
      */
-    Observable GetObservable() const { return _obs; };
+    Observable GetObservable() const { return _data->obs; };
 
     /**
      * @brief Function that returns the target isoscalarity
@@ -139,92 +200,109 @@ namespace NangaParbat
      * isoscalarity 1, meaning that it's a single hadron whose
      * distributions don't need to be manipulated.
      */
-    double GetTargetIsoscalarity() const { return _targetiso; };
+    double GetTargetIsoscalarity() const { return _data->targetiso; };
 
     /**
      * @brief Function that returns the possible identified hadron
      * species in the final state.
      */
-    std::string GetHadron() const { return _hadron; };
+    std::string const& GetHadron() const { return _data->hadron; };
 
     /**
      * @brief Function that returns the charge of the identified final
      * state.
      */
-    int GetCharge() const { return _charge; };
+    int GetCharge() const { return _data->charge; };
 
     /**
      * @brief Function that returns the quark-tagged compoments. Zero
      * corresponds to total.
      */
-    std::vector<apfel::QuarkFlavour> GetTagging() const { return _tagging; };
+    std::vector<apfel::QuarkFlavour> const& GetTagging() const { return _data->tagging; };
 
     /**
      * @brief Function that returns any possible constant prefactor to
      * be used to multiply the theoretical predictions.
      */
-    double GetPrefactor() const { return _prefact; };
+    double GetPrefactor() const { return _data->prefact; };
 
     /**
      * @brief Function that returns the kinematic object
      */
-    Kinematics GetKinematics() const { return _kin; };
+    Kinematics const& GetKinematics() const { return _data->kin; };
 
     /**
      * @brief Function that returns the mean values
      */
-    std::vector<double> GetMeanValues() const { return _means; };
+    std::vector<double> const& GetMeanValues() const { return _data->means; };
 
     /**
      * @brief Function that returns the fluctuated data
      */
-    std::vector<double> GetFluctutatedData() const { return _fluctuations; };
+    std::vector<double> const& GetFluctutatedData() const { return _fluctuations; };
 
     /**
      * @brief Function that returns the sum in quadrature of the
      * uncorrelated uncertainties.
      */
-    std::vector<double> GetUncorrelatedUnc() const { return _uncor; };
+    std::vector<double> const& GetUncorrelatedUnc() const { return _data->uncor; };
 
     /**
      * @brief Function that returns the additive correlated systematic
      * uncertainties.
      */
-    std::vector<std::vector<double>> GetAddCorrelatedUnc() const { return _corra; };
+    std::vector<std::vector<double>> const& GetAddCorrelatedUnc() const { return _data->corra; };
 
     /**
      * @brief Function that returns the multiplicative correlated
      * systematic uncertainties.
      */
-    std::vector<std::vector<double>> GetMultCorrelatedUnc() const { return _corrm; };
+    std::vector<std::vector<double>> const& GetMultCorrelatedUnc() const { return _data->corrm; };
 
     /**
      * @brief Function that returns the all the correlated systematic
      * uncertainties (additive first and multiplicative second).
      */
-    std::vector<std::vector<double>> GetCorrelatedUnc() const { return _corr; };
+    std::vector<std::vector<double>> const& GetCorrelatedUnc() const { return _data->corr; };
 
     /**
      * @brief Function that returns the covariance matrix of the
      * correlated uncertainties.
      */
-    apfel::matrix<double> GetCovarianceMatrix() const { return _covmat; };
+    apfel::matrix<double> const& GetCovarianceMatrix() const { return _cov->covmat; };
 
     /**
      * @brief Function that returns the Cholesky decomposition of the
      * covariance matrix.
      */
-    apfel::matrix<double> GetCholeskyDecomposition() const { return _CholL; };
+    TriangularMatrix const& GetCholeskyDecomposition() const { return _cov->CholL; };
+
+    /**
+     * @brief Function that tells whether the Cholesky decomposition of
+     * the covariance matrix is also available in low-rank form (see
+     * "GetLowRankCholeskyDecomposition").
+     */
+    bool HasLowRankCovariance() const { return !_cov->CholLR.d.empty(); };
+
+    /**
+     * @brief Function that returns the Cholesky decomposition of the
+     * covariance matrix written as the sum of the diagonal matrix of
+     * the uncorrelated uncertainties and of the outer products of the
+     * correlated ones. This is only available when the number of
+     * correlated uncertainties is smaller than the number of points
+     * and the uncorrelated uncertainties are all non-zero.
+     */
+    LowRankCholesky const& GetLowRankCholeskyDecomposition() const { return _cov->CholLR; };
 
     /**
      * @brief Function that returns the set of t0 predictions
      */
-    std::vector<double> GetT0() const { return _t0; };
+    std::vector<double> const& GetT0() const { return _t0; };
 
     /**
      * @brief Function that returns the plotting labels.
      */
-    std::map<std::string, std::string> GetLabels() const { return _labels; };
+    std::map<std::string, std::string> const& GetLabels() const { return _data->labels; };
 
     /**
      * @brief Get vector of bins. This is currently used only for the
@@ -232,34 +310,98 @@ namespace NangaParbat
      * @todo Integrate it better in the rest of the
      * class.
      */
-    std::vector<Binning> GetBinning() const { return _bins; }
+    std::vector<Binning> const& GetBinning() const { return _data->bins; }
 
   protected:
+    /**
+     * @brief Structure containing the content of the datafile. This
+     * is never modified once filled in, therefore it is shared among
+     * the copies of a "DataHandler" object (see "SetMeans" for the
+     * only exception).
+     */
+    struct Data
+    {
+      std::string                        name;      //!< Name of the dataset
+      YAML::Node                         datafile;  //!< Datafile in YAML (not filled in if the data are read from the cache)
+      std::string                        path;      //!< Path to the datafile (only if the data are read from the cache)
+      Process                            proc;      //!< The process
+      Observable                         obs;       //!< The observable
+      double                             targetiso; //!< Isoscalarity of the target
+      std::string                        hadron;    //!< Hadron species identified in the final state
+      double                             charge;    //!< Charge of the identified final state
+      std::vector<apfel::QuarkFlavour>   tagging;   //!< Possible quark-tagged components
+      double                             prefact;   //!< Possible overall prefactor to multiply the theoretical predictions
+      Kinematics                         kin;       //!< Kinematics block
+      std::vector<double>                means;     //!< Vector of central values
+      std::vector<double>                uncor;     //!< Vector of uncorrelated uncertainties
+      std::vector<std::vector<double>>   corra;     //!< Additive correlated uncertainties
+      std::vector<std::vector<double>>   corrm;     //!< Multiplicative correlated uncertainties
+      std::vector<std::vector<double>>   corr;      //!< All correlated uncertainties
+      std::map<std::string, std::string> labels;    //!< Labels used for plotting
+      std::vector<Binning>               bins;      //!< Vector of bins (currently used only for the FF_SIDIS project)
+    };
+
+    /**
+     * @brief Structure containing the covariance matrix and its
+     * decompositions. These depend on the t0 predictions and are
+     * shared among copies with the same t0.
+     */
+    struct Covariance
+    {
+      apfel::matrix<double> covmat; //!< Covariance matrix
+      TriangularMatrix      CholL;  //!< Cholesky decomposition of the covariance matrix
+      LowRankCholesky       CholLR; //!< Low-rank Cholesky decomposition of the covariance matrix (if available)
+    };
+
+  protected:
+    /**
+     * @brief Function that reads the content of the datafile.
+     * @param name: the name associated to the data set
+     * @param datafile: the YAML:Node with the datafile
+     */
+    void ReadDatafile(std::string const& name, YAML::Node const& datafile);
+
+    /**
+     * @brief Function that reads the binary cache of a datafile.
+     * @param name: the name associated to the data set
+     * @param datafile: the path to the datafile
+     * @return false if the cache does not exist, is older than the
+     * datafile, or is corrupted, true otherwise
+     */
+    bool ReadCache(std::string const& name, std::string const& datafile);
 
-    std::string                        _name;         //!< Name of the dataset
-    YAML::Node                         _datafile;     //!< Datafile in YAML
-    Process                            _proc;         //!< The process
-    Observable                         _obs;          //!< The observable
-    double                             _targetiso;    //!< Isoscalarity of the target
-    std::string                        _hadron;       //!< Hadron species identified in the final state
-    double                             _charge;       //!< Charge of the identified final state
-    std::vector<apfel::QuarkFlavour>   _tagging;      //!< Possible quark-tagged components
-    double                             _prefact;      //!< Possible overall prefactor to multiply the theoretical predictions
-    Kinematics                         _kin;          //!< Kinematics block
-    std::vector<double>                _means;        //!< Vector of central values
-    std::vector<double>                _uncor;        //!< Vector of uncorrelated uncertainties
-    std::vector<std::vector<double>>   _corra;        //!< Additive correlated uncertainties
-    std::vector<std::vector<double>>   _corrm;        //!< Multiplicative correlated uncertainties
-    std::vector<std::vector<double>>   _corr;         //!< All correlated uncertainties
-    apfel::matrix<double>              _covmat;       //!< Covariance matrix
-    apfel::matrix<double>              _CholL;        //!< Cholesky decomposition of the covariance matrix
-    std::map<std::string, std::string> _labels;       //!< Labels used for plotting
-    std::vector<double>                _fluctuations; //!< Vector of fluctuated data
-    std::vector<double>                _t0;           //!< Vector of t0-predictions
-    std::vector<Binning>               _bins;         //!< Vector of bins (currently used only for the FF_SIDIS project)
+    /**
+     * @brief Function that parses the content of a binary cache. The
+     * data members are set only if the whole cache could be read.
+     * @param name: the name associated to the data set
+     * @param datafile: the path to the datafile
+     * @param buf: the content of the cache
+     * @note It throws if the cache is corrupted.
+     */
+    void ParseCache(std::string const& name, std::string const& datafile, std::string const& buf);
+
+    /**
+     * @brief Function that constructs the covariance matrix and its
+     * decompositions given the data and the t0 predictions.
+     */
+    void ComputeCovarianceMatrix();
+
+  protected:
+    std::shared_ptr<Data const>       _data;         //!< Shared content of the datafile
+    std::shared_ptr<Covariance const> _cov;          //!< Shared covariance matrix
+    std::vector<double>               _fluctuations; //!< Vector of fluctuated data
+    std::vector<double>               _t0;           //!< Vector of t0-predictions
 
     friend std::ostream& operator << (std::ostream& os, DataHandler const& DH);
   };
 
   std::ostream& operator << (std::ostream &os, DataHandler const& DH);
+
+  /**
+   * @brief Function that returns the name of the binary cache
+   * associated to a datafile, i.e. the path of the datafile with the
+   * extension replaced by ".bin".
+   * @param datafile: the path to the datafile
+   */
+  std::string DataCacheFile(std::string const& datafile);
 }
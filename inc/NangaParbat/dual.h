@@ -0,0 +1,171 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include <array>
+#include <cmath>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Forward-mode dual number carrying the value of a quantity
+   * along with its derivatives w.r.t. N independent variables. It
+   * supports the arithmetic operators and the elementary functions
+   * used by the parameterisations, so that a function body written
+   * as a template in the floating-point type can be instantiated with
+   * "Dual<N>" to obtain the exact gradient in one single pass.
+   *
+   * The elementary functions are defined as friends and are found by
+   * argument-dependent lookup only, therefore they do not hide the
+   * standard ones for plain doubles.
+   */
+  template<int N>
+  class Dual
+  {
+  public:
+    /**
+     * @brief The "Dual" constructor for constants, i.e. with vanishing
+     * derivatives.
+     * @param v: the value
+     */
+    Dual(double const& v = 0): _v(v), _d{} {}
+
+    /**
+     * @brief The "Dual" constructor for the independent variables.
+     * @param v: the value
+     * @param i: the index of the variable, i.e. the only derivative equal to one
+     */
+    Dual(double const& v, int const& i): _v(v), _d{} { _d[i] = 1; }
+
+    /**
+     * @name Getters
+     */
+    ///@{
+    double                       GetValue()                    const { return _v; }
+    double                       GetDerivative(int const& i)   const { return _d[i]; }
+    std::array<double, N> const& GetGradient()                 const { return _d; }
+    ///@}
+
+    /**
+     * @name Compound assignment operators
+     */
+    ///@{
+    Dual& operator += (Dual const& o)
+    {
+      _v += o._v;
+      for (int i = 0; i < N; i++)
+        _d[i] += o._d[i];
+      return *this;
+    }
+    Dual& operator -= (Dual const& o)
+    {
+      _v -= o._v;
+      for (int i = 0; i < N; i++)
+        _d[i] -= o._d[i];
+      return *this;
+    }
+    Dual& operator *= (Dual const& o)
+    {
+      for (int i = 0; i < N; i++)
+        _d[i] = _d[i] * o._v + _v * o._d[i];
+      _v *= o._v;
+      return *this;
+    }
+    Dual& operator /= (Dual const& o)
+    {
+      const double inv = 1 / o._v;
+      _v *= inv;
+      for (int i = 0; i < N; i++)
+        _d[i] = ( _d[i] - _v * o._d[i] ) * inv;
+      return *this;
+    }
+    Dual& operator += (double const& c) { _v += c; return *this; }
+    Dual& operator -= (double const& c) { _v -= c; return *this; }
+    Dual& operator *= (double const& c)
+    {
+      _v *= c;
+      for (int i = 0; i < N; i++)
+        _d[i] *= c;
+      return *this;
+    }
+    Dual& operator /= (double const& c) { return *this *= 1 / c; }
+    ///@}
+
+    /**
+     * @name Arithmetic operators
+     */
+    ///@{
+    friend Dual operator + (Dual a, Dual const& b)   { return a += b; }
+    friend Dual operator + (Dual a, double const& c) { return a += c; }
+    friend Dual operator + (double const& c, Dual a) { return a += c; }
+    friend Dual operator - (Dual a, Dual const& b)   { return a -= b; }
+    friend Dual operator - (Dual a, double const& c) { return a -= c; }
+    friend Dual operator - (double const& c, Dual const& a) { return - a + c; }
+    friend Dual operator * (Dual a, Dual const& b)   { return a *= b; }
+    friend Dual operator * (Dual a, double const& c) { return a *= c; }
+    friend Dual operator * (double const& c, Dual a) { return a *= c; }
+    friend Dual operator / (Dual a, Dual const& b)   { return a /= b; }
+    friend Dual operator / (Dual a, double const& c) { return a /= c; }
+    friend Dual operator / (double const& c, Dual const& a) { return Dual{c} /= a; }
+    friend Dual operator - (Dual a)                  { return a *= -1; }
+    ///@}
+
+    /**
+     * @name Elementary functions
+     */
+    ///@{
+    friend Dual exp(Dual const& a)
+    {
+      const double e = std::exp(a._v);
+      return Chain(a, e, e);
+    }
+    friend Dual log(Dual const& a)
+    {
+      return Chain(a, std::log(a._v), 1 / a._v);
+    }
+    friend Dual sqrt(Dual const& a)
+    {
+      const double s = std::sqrt(a._v);
+      return Chain(a, s, 0.5 / s);
+    }
+    friend Dual pow(Dual const& a, double const& e)
+    {
+      // std::pow handles negative bases with integer exponents as
+      // for plain doubles.
+      const double p = std::pow(a._v, e);
+      return Chain(a, p, ( e == 0 ? 0 : e * std::pow(a._v, e - 1) ));
+    }
+    friend Dual pow(double const& c, Dual const& e)
+    {
+      // The derivative vanishes along with the value for a null base
+      // (and positive exponent), while the logarithm would make it
+      // NaN.
+      const double p = std::pow(c, e._v);
+      return Chain(e, p, ( c == 0 ? 0 : p * std::log(c) ));
+    }
+    friend Dual pow(Dual const& a, Dual const& e)
+    {
+      return exp(e * log(a));
+    }
+    ///@}
+
+  private:
+    /**
+     * @brief Function that applies the chain rule: it returns f(a)
+     * given f and f' at the value of "a".
+     */
+    static Dual Chain(Dual const& a, double const& f, double const& df)
+    {
+      Dual r{f};
+      for (int i = 0; i < N; i++)
+        r._d[i] = df * a._d[i];
+      return r;
+    }
+
+  private:
+    double                _v; //!< Value
+    std::array<double, N> _d; //!< Derivatives
+  };
+}
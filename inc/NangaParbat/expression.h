@@ -0,0 +1,161 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Node of the syntax tree of an expression (defined in the
+   * source file).
+   */
+  struct ExpressionNode;
+
+  /**
+   * @brief Class that parses a mathematical expression of a set of
+   * named variables and manipulates it symbolically. The grammar
+   * supports numbers, variables, named constants, the binary
+   * operators +, -, *, /, ^ (or **), the unary minus, parentheses,
+   * and the functions exp, log, sqrt, abs, sin, cos, and pow(a, b).
+   * Expressions are simplified as they are built, i.e. constant
+   * subexpressions are folded and trivial operations (such as
+   * multiplications by zero or one) are removed.
+   */
+  class Expression
+  {
+  public:
+    /**
+     * @brief The "Expression" constructor.
+     * @param expr: the string to be parsed
+     * @param variables: the names of the variables
+     * @param constants: named constants replaced by their value (default: none). The constant "pi" is always available.
+     */
+    Expression(std::string const& expr, std::vector<std::string> const& variables, std::map<std::string, double> const& constants = {});
+
+    /**
+     * @brief Function that returns the derivative of the expression
+     * w.r.t. one of the variables computed symbolically.
+     * @param ivar: index of the variable
+     */
+    Expression Derive(int const& ivar) const;
+
+    /**
+     * @brief Function that tells whether the expression depends on a
+     * given variable.
+     * @param ivar: index of the variable
+     */
+    bool DependsOn(int const& ivar) const;
+
+    /**
+     * @brief Function that evaluates the expression by walking the
+     * syntax tree. This is slow and meant for checks only, use
+     * "ExpressionProgram" for production.
+     * @param vars: the values of the variables
+     */
+    double Evaluate(std::vector<double> const& vars) const;
+
+    /**
+     * @brief Function that returns the expression as a string
+     */
+    std::string ToString() const;
+
+    /**
+     * @name Getters
+     */
+    ///@{
+    std::vector<std::string>              const& GetVariables() const { return _variables; }
+    std::shared_ptr<ExpressionNode const> const& GetRoot()      const { return _root; }
+    ///@}
+
+  private:
+    Expression(std::vector<std::string> const& variables, std::shared_ptr<ExpressionNode const> const& root);
+
+  private:
+    std::vector<std::string>              _variables; //!< Names of the variables
+    std::shared_ptr<ExpressionNode const> _root;      //!< Root of the syntax tree
+  };
+
+  /**
+   * @brief Class that compiles a set of expressions of the same
+   * variables into a program for a register machine and executes
+   * it. Subexpressions shared among (and within) the expressions are
+   * computed only once. The first "narrays" variables are meant to
+   * change from point to point (e.g. x, b, and zeta), the remaining
+   * ones are constant over a batch of points (e.g. the parameters):
+   * instructions that only depend on the latter are executed once
+   * per batch and the others are executed one chunk of points at a
+   * time with tight loops that the compiler can vectorise.
+   */
+  class ExpressionProgram
+  {
+  public:
+    /**
+     * @brief The "ExpressionProgram" constructor.
+     * @param exprs: the expressions (the outputs of the program)
+     * @param narrays: the number of variables that change from point to point
+     */
+    ExpressionProgram(std::vector<Expression> const& exprs, int const& narrays);
+
+    /**
+     * @brief Function that evaluates all the expressions at one
+     * point.
+     * @param vars: the values of all the variables
+     * @param res: on exit, the values of the expressions
+     */
+    void Evaluate(double const* vars, double* res) const;
+
+    /**
+     * @brief Function that evaluates all the expressions on a batch
+     * of points.
+     * @param n: number of points
+     * @param arrays: pointers to the "narrays" arrays of "n" values of the variables that change from point to point
+     * @param scalars: the values of the remaining variables
+     * @param res: on exit, the values of the expressions ordered as [expression][point]
+     */
+    void EvaluateBatch(int const& n, double const* const* arrays, double const* scalars, double* res) const;
+
+    /**
+     * @name Getters
+     */
+    ///@{
+    int GetNumberOfOutputs()      const { return _outputs.size(); }
+    int GetNumberOfInstructions() const { return _code.size(); }
+    ///@}
+
+  private:
+    /**
+     * @brief Instruction of the register machine. The result goes
+     * into the register with the same index as the instruction.
+     */
+    struct Instruction
+    {
+      int    op;      //!< Operation
+      int    a;       //!< First operand (register)
+      int    b;       //!< Second operand (register)
+      int    index;   //!< Index of the variable
+      double value;   //!< Value of the constant
+      bool   uniform; //!< Whether the result is the same for all the points of a batch
+    };
+
+    /**
+     * @brief Function that appends the instructions of a node (and
+     * those of its operands) to the program.
+     * @return the register of the result
+     */
+    int Compile(std::shared_ptr<ExpressionNode const> const& node, std::map<ExpressionNode const*, int>& done, std::map<std::string, int>& seen);
+
+  private:
+    int                      _nvars;   //!< Number of variables
+    int                      _narrays; //!< Number of variables that change from point to point
+    std::vector<Instruction> _code;    //!< The instructions
+    std::vector<int>         _outputs; //!< Registers of the outputs
+    std::vector<int>         _varying; //!< Instructions that depend on the point
+    std::vector<int>         _bcast;   //!< Uniform registers used by varying instructions
+  };
+}
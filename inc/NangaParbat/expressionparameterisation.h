@@ -0,0 +1,85 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include "NangaParbat/parameterisation.h"
+#include "NangaParbat/expression.h"
+
+#include <yaml-cpp/yaml.h>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Parameterisation derived from the "Parameterisation"
+   * mother class whose functions are given as strings, typically in
+   * the fit card, rather than in a header. This allows one to fit a
+   * new model without recompiling the library. The functions are
+   * expressions of the variables "x", "b", and "zeta" and of the
+   * parameters (see "Expression" for the grammar). They are compiled
+   * once, along with their derivatives w.r.t. the parameters
+   * computed symbolically, into programs that are evaluated on
+   * batches of points (see "ExpressionProgram"). Like the
+   * hand-written parameterisations, functions that depend on x
+   * vanish for x >= 1.
+   */
+  class ExpressionParameterisation: public NangaParbat::Parameterisation
+  {
+  public:
+    /**
+     * @brief The "ExpressionParameterisation" constructor.
+     * @param name: name of the parameterisation
+     * @param config: YAML node with the keys "parameters" (names of the parameters), "functions" (one expression per function), and, optionally, "values" (default values of the parameters, zero otherwise), "constants" (map of named constants), "latex", and "description"
+     */
+    ExpressionParameterisation(std::string const& name, YAML::Node const& config);
+
+    std::unique_ptr<Parameterisation> Clone() const { return std::unique_ptr<Parameterisation>(new ExpressionParameterisation{*this}); };
+    using Parameterisation::Clone;
+
+    /**
+     * @brief Function that sets the parameters. Unlike the base-class
+     * implementation, it checks that their number matches the number
+     * of parameters of the expressions.
+     * @param pars: the vector of parameters
+     */
+    void SetParameters(std::vector<double> const& pars);
+
+    double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const;
+
+    void EvaluateBatch(int const& n, double const* x, double const* b, double const* zeta, int const& ifunc, double* f) const;
+
+    double Derive(double const& x, double const& b, double const& zeta, int const& ifunc, int const& ipar) const;
+
+    double Gradient(double const& x, double const& b, double const& zeta, int const& ifunc, double* grad) const;
+
+    /**
+     * @brief Function that returns the indices of the functions whose
+     * expressions contain a given parameter.
+     * @param ipar: index of the parameter
+     */
+    std::vector<int> GetParameterDependencies(int const& ipar) const;
+
+    std::string              LatexFormula()      const;
+    std::vector<std::string> GetParameterNames() const { return _parnames; };
+    std::string              GetDescription()    const { return _description; };
+
+  private:
+    /**
+     * @brief Function that runs one of the programs at a single
+     * point.
+     */
+    double Run(ExpressionProgram const& prog, double const& x, double const& b, double const& zeta, int const& ifunc, double* res) const;
+
+  private:
+    std::vector<std::string>                              _parnames;    //!< Names of the parameters
+    std::vector<std::string>                              _functions;   //!< Expressions of the functions
+    std::string                                           _latex;       //!< LaTeX formula
+    std::string                                           _description; //!< Description
+    std::vector<bool>                                     _xdep;        //!< Whether the functions depend on x
+    std::vector<std::vector<int>>                         _deps;        //!< Functions that depend on each parameter
+    std::vector<std::shared_ptr<ExpressionProgram const>> _values;      //!< Programs of the functions
+    std::vector<std::vector<std::shared_ptr<ExpressionProgram const>>> _derivs; //!< Programs of the derivatives ordered as [function][parameter]
+    std::vector<std::shared_ptr<ExpressionProgram const>> _gradients;   //!< Programs of the functions followed by all their derivatives
+  };
+}
@@ -7,6 +7,8 @@
 #include "NangaParbat/tmdgrid.h"
 #include "NangaParbat/structgrid.h"
 
+#include <mutex>
+
 namespace NangaParbat
 {
   /**
@@ -51,6 +53,86 @@ namespace NangaParbat
    */
   std::vector<StructGrid*> mkSFs(std::string const& name);
 
+  /**
+   * @brief Class that gives access to the members of a set of grids
+   * (TMDs or structure functions). Opening the set only requires
+   * reading the info file, while each member is loaded on first
+   * access. Members available in binary format (see "BinaryGrid") are
+   * memory mapped, otherwise they are read from YAML.
+   */
+  template<class Grid>
+  class LazyGridSet
+  {
+  public:
+    /**
+     * @brief The "LazyGridSet" constructor
+     * @param name: name of the set
+     * @param folder: folder where the set is (default: current folder)
+     */
+    LazyGridSet(std::string const& name, std::string const& folder = ".");
+
+    /**
+     * @brief Function that returns the number of members of the set
+     */
+    int GetNumberOfMembers() const { return _members.size(); }
+
+    /**
+     * @brief Function that returns a member of the set loading it if
+     * needed. Thread safe.
+     * @param mem: member to be returned (from 0 to "NumMembers" - 1)
+     */
+    Grid const* GetMember(int const& mem) const;
+
+    /**
+     * @brief Function that returns the names of the summary members
+     * of the set (see "WriteSummaryMembers"), if any.
+     */
+    std::vector<std::string> GetSummaryMemberNames() const;
+
+    /**
+     * @brief Function that returns a summary member of the set
+     * loading it if needed. The summary members are not counted in
+     * "NumMembers" and their member numbers are read from the
+     * "SummaryMembers" key of the info file. Thread safe.
+     * @param name: name of the summary member (e.g. "mean" or "std")
+     */
+    Grid const* GetSummaryMember(std::string const& name) const;
+
+    /**
+     * @brief Same as "GetMember"
+     */
+    Grid const* operator [] (int const& mem) const { return GetMember(mem); }
+
+    /**
+     * @brief Function that returns the YAML Node with the set info
+     */
+    YAML::Node GetInfoNode() const { return _info; };
+
+  private:
+    std::string                                          const _name;    //!< Name of the set
+    std::string                                          const _path;    //!< Path to the set
+    YAML::Node                                           const _info;    //!< Info node
+    std::map<std::string, int>                           const _sumids;  //!< Member numbers of the summary members
+    mutable std::vector<std::unique_ptr<Grid>>                 _members; //!< Members loaded so far
+    mutable std::map<std::string, std::unique_ptr<Grid>>       _summary; //!< Summary members loaded so far
+    mutable std::mutex                                         _mutex;   //!< Mutex guarding the loading
+  };
+
+  /**
+   * @brief Factory that returns a "LazyGridSet" of TMDs.
+   * @param name: name of the TMD set
+   * @param folder: folder where the TMD set is (default: current folder)
+   */
+  LazyGridSet<TMDGrid>* mkTMDsLazy(std::string const& name, std::string const& folder = ".");
+
+  /**
+   * @brief Factory that returns a "LazyGridSet" of structure
+   * functions.
+   * @param name: name of the structure function set
+   * @param folder: folder where the structure function set is (default: current folder)
+   */
+  LazyGridSet<StructGrid>* mkSFsLazy(std::string const& name, std::string const& folder = ".");
+
   /**
    * @brief Function that performs the convolution of two TMD
    * distributions in kT space.
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "NangaParbat/datahandler.h"
+#include "NangaParbat/tmdservice.h"
 
 #include <utility>
 #include <memory>
@@ -23,8 +24,9 @@ namespace NangaParbat
     /**
      * @brief The "FastInterface" constructor.
      * @param config: the YAML:Node with the configuration information
+     * @param service: the TMD service to be used for the collinear distributions, the strong coupling, and the evolved TMDs. It must be initialised with the same configuration and for both PDFs and FFs. If not provided, a new one is constructed (default: nullptr)
      */
-    FastInterface(YAML::Node const& config);
+    FastInterface(YAML::Node const& config, std::shared_ptr<TMDService const> const& service = nullptr);
 
     /**
      * @brief Function returns the luminosity for the Drell-Yan
@@ -66,17 +68,8 @@ namespace NangaParbat
 
   private:
     YAML::Node                                                                                  _config;          //!< Configuration YAML::Node
-    std::vector<double>                                                                         _Thresholds;      //!< Heavy-quark thresholds
-    std::unique_ptr<apfel::TabulateObject<double>>                                              _TabAlphas;       //!< Strong coupling
+    std::shared_ptr<TMDService const>                                                           _tmds;            //!< Collinear distributions, strong coupling, and evolved TMDs
     std::unique_ptr<apfel::TabulateObject<double>>                                              _TabAlphaem;      //!< Fine-structure coupling
-    std::map<int,apfel::TmdObjects>                                                             _TmdPdfObjs;      //!< Space-like TMD objects
-    std::map<int,apfel::TmdObjects>                                                             _TmdFfObjs;       //!< Time-like TMD objects
-    std::unique_ptr<const apfel::Grid>                                                          _gpdf;            //!< APFEL x-space grid for PDFs
-    std::unique_ptr<const apfel::Grid>                                                          _gff;             //!< APFEL x-space grid for FFs
-    std::unique_ptr<apfel::TabulateObject<apfel::Set<apfel::Distribution>>>                     _TabPDFs;         //!< Collinear PDFs
-    std::unique_ptr<apfel::TabulateObject<apfel::Set<apfel::Distribution>>>                     _TabFFs;          //!< Collinear FFs
-    std::function<apfel::Set<apfel::Distribution>(double const&, double const&, double const&)> _EvTMDPDFs;       //!< TMD PDFs
-    std::function<apfel::Set<apfel::Distribution>(double const&, double const&, double const&)> _EvTMDFFs;        //!< TMD FFs
     std::function<apfel::Set<apfel::Distribution>(double const&)>                               _MatchTMDPDFs;    //!< TMD PDFs w/o/ Sudakov evolution
     std::function<apfel::Set<apfel::Distribution>(double const&)>                               _MatchTMDFFs;     //!< TMD FFs w/o/ Sudakov evolution
     std::function<double(double const&, double const&, double const&)>                          _QuarkSudakov;    //!< Quark evolution factor
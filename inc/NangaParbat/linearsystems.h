@@ -8,12 +8,139 @@
 
 namespace NangaParbat
 {
+  /**
+   * @brief Structure that holds a lower-triangular matrix in packed
+   * row-major storage: the i-th row occupies the i + 1 consecutive
+   * elements starting at i (i + 1) / 2. This takes half the memory
+   * of the full matrix and makes the rows, that are accessed by the
+   * factorisation and by the forward substitution, contiguous.
+   */
+  struct TriangularMatrix
+  {
+    /**
+     * @brief The TriangularMatrix constructor.
+     * @param n: number of rows
+     */
+    TriangularMatrix(int const& n = 0): n(n), v(n * ( n + 1 ) / 2, 0.) {};
+
+    /**
+     * @brief Function that returns the (i, j)-th element. Elements
+     * above the diagonal are zero.
+     */
+    double operator () (int const& i, int const& j) const { return (j > i ? 0 : v[i * ( i + 1 ) / 2 + j]); };
+
+    /**
+     * @brief Function that returns a pointer to the first element of
+     * the i-th row.
+     */
+    double const* Row(int const& i) const { return v.data() + i * ( i + 1 ) / 2; };
+    double*       Row(int const& i)       { return v.data() + i * ( i + 1 ) / 2; };
+
+    int                 n; //!< Number of rows
+    std::vector<double> v; //!< Elements (n (n + 1) / 2, packed row major)
+  };
+
+  /**
+   * @brief Structure that holds the Cholesky decomposition L of a
+   * matrix of the form V = D + U U<SUP>T</SUP>, with D diagonal and
+   * U with k << n columns, in generator form: L(i, i) = d<SUB>i</SUB>
+   * and L(i, j) = u<SUB>i</SUB> &middot; g<SUB>j</SUB> for i > j,
+   * where u<SUB>i</SUB> is the i-th row of U. This takes O(n k)
+   * memory and allows solving the triangular system in O(n k)
+   * operations rather than O(n<SUP>2</SUP>).
+   */
+  struct LowRankCholesky
+  {
+    int                 k; //!< Number of columns of U
+    std::vector<double> d; //!< Diagonal of L
+    std::vector<double> u; //!< Rows of U (n x k, row major)
+    std::vector<double> g; //!< Generators of the off-diagonal part of L (n x k, row major)
+  };
+
+  /**
+   * @brief Function that enables or disables the validation of the
+   * results of the functions below, i.e. the reconstruction of the
+   * decomposed matrices and the substitution of the solutions into
+   * the systems. These checks cost as much as the computations
+   * themselves and are therefore disabled by default. Positive
+   * definiteness is always checked while factorising.
+   * @param checks: whether the validation is enabled
+   */
+  void SetLinearSystemChecks(bool const& checks);
+
+  /**
+   * @brief Function that tells whether the validation of the linear
+   * systems is enabled.
+   */
+  bool LinearSystemChecks();
+
+  /**
+   * @brief Cholesky decomposition in place. The factorisation is
+   * blocked such that the rows involved in each block fit in cache.
+   * @param n: size of the matrix
+   * @param A: lower triangle of the symmetric matrix in packed storage (see "TriangularMatrix"), overwritten by its Cholesky decomposition
+   */
+  void CholeskyDecomposition(int const& n, double* A);
+
   /**
    * @brief Cholesky decomposition of the covariance matrix.
-   * @param V: the covariance matrix
-   * @return The Cholesky decomposition matrix L such that L<SUP>T</SUP>L = V
+   * @param V: the covariance matrix (only the lower triangle is used)
+   * @return The Cholesky decomposition matrix L such that L L<SUP>T</SUP> = V
+   */
+  TriangularMatrix CholeskyDecomposition(apfel::matrix<double> const& V);
+
+  /**
+   * @brief Cholesky decomposition of a matrix of the form V = D +
+   * U U<SUP>T</SUP>.
+   * @param D: the diagonal of D (must be positive)
+   * @param U: the rows of U
+   * @return The Cholesky decomposition L such that L L<SUP>T</SUP> = V in generator form
+   */
+  LowRankCholesky CholeskyDecomposition(std::vector<double> const& D, std::vector<std::vector<double>> const& U);
+
+  /**
+   * @brief Solve lower-diagonal system of equations by forward
+   * substitution in place. The system defined by the leading m x m
+   * block of L is solved.
+   * @param L: lower-diagonal matrix in packed storage
+   * @param m: number of constants
+   * @param x: vector of constants, overwritten by the solution
    */
-  apfel::matrix<double> CholeskyDecomposition(apfel::matrix<double> const V);
+  void SolveLowerSystem(TriangularMatrix const& L, int const& m, double* x);
+
+  /**
+   * @brief Solve upper-diagonal system of equations L<SUP>T</SUP> x
+   * = y by backward substitution in place. The system defined by the
+   * leading m x m block of L is solved.
+   * @param L: lower-diagonal matrix in packed storage
+   * @param m: number of constants
+   * @param x: vector of constants, overwritten by the solution
+   */
+  void SolveUpperSystem(TriangularMatrix const& L, int const& m, double* x);
+
+  /**
+   * @brief Solve lower-diagonal system of equations with several
+   * vectors of constants at once by forward substitution in place,
+   * i.e. compute X = L<SUP>-1</SUP> Y. The system defined by the
+   * leading m x m block of L is solved. The substitution is blocked
+   * such that each row of L is read once for all the vectors and
+   * each block of rows of X is reused while in cache.
+   * @param L: lower-diagonal matrix in packed storage
+   * @param m: number of rows of Y
+   * @param nrhs: number of vectors of constants, i.e. columns of Y
+   * @param X: the matrix Y (m x nrhs, row major), overwritten by the solution
+   */
+  void SolveLowerSystem(TriangularMatrix const& L, int const& m, int const& nrhs, double* X);
+
+  /**
+   * @brief Solve lower-diagonal system of equations by forward
+   * substitution. If y has m < n elements, the system defined by the
+   * leading m x m block of L is solved.
+   * @param L: lower-diagonal matrix in packed storage
+   * @param y: vector of constants
+   * @return the solution vector x
+   */
+  std::vector<double> SolveLowerSystem(TriangularMatrix const& L, std::vector<double> const& y);
 
   /**
    * @brief Solve lower-diagonal system of equations by forward substitution
@@ -21,7 +148,28 @@ namespace NangaParbat
    * @param y: vector of constants
    * @return the solution vector x
    */
-  std::vector<double> SolveLowerSystem(apfel::matrix<double> L, std::vector<double> y);
+  std::vector<double> SolveLowerSystem(apfel::matrix<double> const& L, std::vector<double> const& y);
+
+  /**
+   * @brief Solve lower-diagonal system of equations by forward
+   * substitution with the matrix in generator form. If y has m < n
+   * elements, the system defined by the leading m x m block of L is
+   * solved.
+   * @param L: lower-diagonal matrix in generator form
+   * @param y: vector of constants
+   * @return the solution vector x
+   */
+  std::vector<double> SolveLowerSystem(LowRankCholesky const& L, std::vector<double> const& y);
+
+  /**
+   * @brief Same as above for several vectors of constants at once
+   * with the matrix in generator form.
+   * @param L: lower-diagonal matrix in generator form
+   * @param m: number of rows of Y
+   * @param nrhs: number of vectors of constants, i.e. columns of Y
+   * @param X: the matrix Y (m x nrhs, row major), overwritten by the solution
+   */
+  void SolveLowerSystem(LowRankCholesky const& L, int const& m, int const& nrhs, double* X);
 
   /**
    * @brief Solve upper-diagonal system of equations by backward substitution
@@ -29,7 +177,7 @@ namespace NangaParbat
    * @param y: vector of constants
    * @return the solution vector
    */
-  std::vector<double> SolveUpperSystem(apfel::matrix<double> U, std::vector<double> y);
+  std::vector<double> SolveUpperSystem(apfel::matrix<double> const& U, std::vector<double> const& y);
 
   /**
    * @brief Solve symmetric system of equations
@@ -37,5 +185,16 @@ namespace NangaParbat
    * @param rho: vector of constants
    * @return the solution vector
    */
-  std::vector<double> SolveSymmetricSystem(apfel::matrix<double> A, std::vector<double> rho);
+  std::vector<double> SolveSymmetricSystem(apfel::matrix<double> const& A, std::vector<double> const& rho);
+
+  /**
+   * @brief Solve symmetric system of equations given the Cholesky
+   * decomposition of the matrix, i.e. by forward and backward
+   * substitution. This is convenient when the same matrix is used
+   * with several vectors of constants.
+   * @param L: Cholesky decomposition of the symmetric matrix (see "CholeskyDecomposition")
+   * @param rho: vector of constants
+   * @return the solution vector
+   */
+  std::vector<double> SolveCholeskySystem(TriangularMatrix const& L, std::vector<double> const& rho);
 }
@@ -14,6 +14,10 @@ namespace NangaParbat
   /**
    * @brief Parameterisation derived from the "Parameterisation"
    * mother class to compute the mean replica of a Monte Carlo set.
+   * The replicas are tabulated on a grid in (x, b<SUB>T</SUB>,
+   * &zeta;) one at a time and accumulated into mean and variance
+   * grids, so that memory does not depend on the number of replicas
+   * and the evaluation costs one interpolation.
    */
   class MeanReplica: public NangaParbat::Parameterisation
   {
@@ -23,13 +27,26 @@ namespace NangaParbat
      * @param InputFolder: path to the folder where the replicas are
      * @param FitConfigFile: configuration file in YAML format
      * @param discard: vector of replicas to be discarded
+     * @param nx: number of nodes of the grid in x (default: 100)
+     * @param nbT: number of nodes of the grid in b<SUB>T</SUB> (default: 100)
+     * @param nzeta: number of nodes of the grid in &zeta; (default: 50)
+     * @param nthreads: number of threads used for the tabulation (default: 0, i.e. the number of available cores)
      */
-    MeanReplica(std::string const& InputFolder, std::string const& FitConfigFile, std::vector<int> const& discard = {});
+    MeanReplica(std::string      const& InputFolder,
+                std::string      const& FitConfigFile,
+                std::vector<int> const& discard  = {},
+                int              const& nx       = 100,
+                int              const& nbT      = 100,
+                int              const& nzeta    = 50,
+                int              const& nthreads = 0);
 
     /**
-     * @brief The "MeanReplica" destructor
+     * @brief Function that returns an independent copy of the mean
+     * replica. The grids and the parameterisation used in the fit are
+     * not modified after construction and are shared with the copy.
      */
-    ~MeanReplica();
+    std::unique_ptr<Parameterisation> Clone() const { return std::unique_ptr<Parameterisation>(new MeanReplica{*this}); };
+    using Parameterisation::Clone;
 
     /**
      * @brief Function that returns the value of one of the functions.
@@ -42,6 +59,24 @@ namespace NangaParbat
      */
     double Evaluate(double const& x, double const& bT, double const& zeta, int const& ifunc) const;
 
+    /**
+     * @brief Function that returns the variance over the replicas of
+     * one of the functions.
+     * @param x: momentum fraction
+     * @param b: impact parameter
+     * @param zeta: rapidity scale &zeta;
+     * @param ifunc: index of the function
+     * @return it returns the variance of the ifunc-th function at (x,
+     * b, &zeta;)
+     */
+    double Variance(double const& x, double const& bT, double const& zeta, int const& ifunc) const;
+
+    /**
+     * @brief Function that returns the number of replicas averaged
+     * over.
+     */
+    int GetNumberOfReplicas() const { return _nrep; };
+
     /**
      * @brief Function that returns a string with the formula
      * of the non-perturbative function(s) in LaTex format.
@@ -55,12 +90,19 @@ namespace NangaParbat
     std::vector<std::string> GetParameterNames() const;
 
   private:
-    NangaParbat::Parameterisation                *_NPFunc;
-    std::vector<NangaParbat::Parameterisation*>   _NPFuncv;
-    std::unique_ptr<apfel::QGrid<double>>         _xg;
-    std::unique_ptr<apfel::QGrid<double>>         _bTg;
-    std::unique_ptr<apfel::QGrid<double>>         _zetag;
-    std::vector<std::vector<std::vector<double>>> _fNP1g;
-    std::vector<std::vector<std::vector<double>>> _fNP2g;
+    /**
+     * @brief Function that interpolates a grid ordered as
+     * [function][x][bT][zeta].
+     */
+    double Interpolate(std::vector<double> const& grid, double const& x, double const& bT, double const& zeta, int const& ifunc) const;
+
+  private:
+    std::shared_ptr<Parameterisation>           _NPFunc; //!< Parameterisation used in the fit
+    int                                         _nrep;   //!< Number of replicas
+    std::shared_ptr<apfel::QGrid<double> const> _xg;
+    std::shared_ptr<apfel::QGrid<double> const> _bTg;
+    std::shared_ptr<apfel::QGrid<double> const> _zetag;
+    std::vector<double>                         _mean;   //!< Mean over the replicas ordered as [function][x][bT][zeta]
+    std::vector<double>                         _var;    //!< Variance over the replicas ordered as [function][x][bT][zeta]
   };
 }
@@ -11,6 +11,7 @@
 #include "NangaParbat/PV19x.h"
 #include "NangaParbat/QGG6.h"
 #include "NangaParbat/QGG13.h"
+#include "NangaParbat/expressionparameterisation.h"
 
 #include <map>
 #include <memory>
@@ -18,36 +19,51 @@
 namespace NangaParbat
 {
   /**
-   * @brief Map of currently available parameterisations. Each of them
-   * must correspond to a header file containing a class deriving from
-   * the NangaParbat::Parameterisation mother class.
+   * @brief Function that returns the registry of the currently
+   * available parameterisations. Each of them must correspond to a
+   * header file containing a class deriving from the
+   * NangaParbat::Parameterisation mother class and implementing
+   * "Clone". The objects in the registry are immutable prototypes:
+   * instances to be used (and whose parameters can be set) are
+   * obtained through "MakeParameterisation". The registry is built
+   * once, in a thread-safe way, on first use.
    */
-  const std::map<std::string, Parameterisation*> AvPars
-  {
-    {"DWS",   new NangaParbat::DWS{}},
-    {"PV17",  new NangaParbat::PV17{}},
-    //{"PV19",  new NangaParbat::PV19{}},
-    {"PV19b", new NangaParbat::PV19b{}},
-    {"PV19x", new NangaParbat::PV19x{}}//,
-    //{"QGG6",  new NangaParbat::QGG6{}},
-    //{"QGG13", new NangaParbat::QGG13{}}
-  };
-  /*
-  const std::map<std::string, std::shared_ptr<Parameterisation>> AvParsSptr
-  {
-    {"DWS",   std::shared_ptr<NangaParbat::DWS>{new NangaParbat::DWS{}}},
-    {"PV17",  std::shared_ptr<NangaParbat::PV17>{new NangaParbat::PV17{}}},
-    //{"PV19",  std::shared_ptr<NangaParbat::PV19>{new NangaParbat::PV19{}}},
-    {"PV19b", std::shared_ptr<NangaParbat::PV19b>{new NangaParbat::PV19b{}}},
-    {"PV19x", std::shared_ptr<NangaParbat::PV19x>{new NangaParbat::PV19x{}}}//,
-    //{"QGG6",  std::shared_ptr<NangaParbat::QGG6>{new NangaParbat::QGG6{}}},
-    //{"QGG13", std::shared_ptr<NangaParbat::QGG13>{new NangaParbat::QGG13{}}}
-  };
-  */
+  std::map<std::string, std::unique_ptr<Parameterisation const>> const& AvailableParameterisations();
+
+  /**
+   * @brief Utility function that returns a new, independently owned,
+   * instance of a specific parameterisation with its default
+   * parameters. Different instances do not share any state and can
+   * therefore be used concurrently in different threads.
+   * @param name: name of the parameterisation
+   */
+  std::unique_ptr<Parameterisation> MakeParameterisation(std::string const& name);
+
+  /**
+   * @brief Utility function that returns a new, independently owned,
+   * instance of a specific parameterisation with a given set of
+   * parameters.
+   * @param name: name of the parameterisation
+   * @param pars: the set of parameters
+   */
+  std::unique_ptr<Parameterisation> MakeParameterisation(std::string const& name, ParameterSet const& pars);
+
+  /**
+   * @brief Utility function that returns a new instance of the
+   * parameterisation specified in a configuration (e.g. a fit card
+   * or a fit report). If the configuration contains an "Expression"
+   * node, an "ExpressionParameterisation" named after the
+   * "Parameterisation" key is built out of it, otherwise the
+   * parameterisation is taken from the registry.
+   * @param config: the configuration
+   */
+  std::unique_ptr<Parameterisation> MakeParameterisation(YAML::Node const& config);
+
   /**
-   * @brief Utility function that returns a pointer to a
-   * NangaParbat::Parameterisation object pointing to a specific
-   * parameterisation.
+   * @brief Utility function that returns a pointer to a new instance
+   * of a specific parameterisation. The object is owned by the
+   * caller, who is responsible for deleting it. Prefer
+   * "MakeParameterisation".
    * @param name: name of the parameterisation
    */
   Parameterisation* GetParametersation(std::string const& name);
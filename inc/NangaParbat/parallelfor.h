@@ -0,0 +1,23 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include <functional>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Function that runs the body of a loop over the indices [0,
+   * n) concurrently. Indices are handed out dynamically to a pool of
+   * threads so that iterations of different cost are balanced. The
+   * body must be safe to run concurrently for different
+   * indices. The first exception thrown by the body, if any, is
+   * rethrown after all threads have finished.
+   * @param n: number of iterations
+   * @param body: the body of the loop as a function of the index
+   * @param nthreads: number of threads (default: 0, i.e. the number of available cores)
+   */
+  void ParallelFor(int const& n, std::function<void(int const&)> const& body, int const& nthreads = 0);
+}
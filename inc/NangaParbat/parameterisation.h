@@ -8,10 +8,38 @@
 #include <iostream>
 #include <functional>
 #include <map>
+#include <memory>
 #include <apfel/apfelxx.h>
 
 namespace NangaParbat
 {
+  /**
+   * @brief Lightweight immutable handle to a set of parameters. Copies
+   * share the same values, which can never be modified, so that a
+   * parameter set can be passed around threads freely.
+   */
+  class ParameterSet
+  {
+  public:
+    /**
+     * @brief The "ParameterSet" constructor
+     * @param pars: the vector of parameters
+     */
+    ParameterSet(std::vector<double> const& pars = {}): _pars(std::make_shared<std::vector<double> const>(pars)) {};
+
+    /**
+     * @name Getters
+     */
+    ///@{
+    std::vector<double> const& GetValues()                const { return *_pars; }
+    int                        size()                     const { return _pars->size(); }
+    double                     operator [] (int const& i) const { return (*_pars)[i]; }
+    ///@}
+
+  private:
+    std::shared_ptr<std::vector<double> const> _pars; //!< The shared parameters
+  };
+
   /**
    * @brief Mother class that implements the main feautures of a
    * functional parameterisation of non-perturbative functions.
@@ -40,6 +68,29 @@ namespace NangaParbat
      */
     virtual void SetParameters(std::vector<double> const& pars) { _pars = pars; };
 
+    /**
+     * @brief Virtual function that returns an independent copy of the
+     * parameterisation. Copies do not share any state with the
+     * original so that, for example, different threads can set
+     * different parameters on their own copies. The default
+     * implementation throws: parameterisations that can be copied
+     * must override it.
+     */
+    virtual std::unique_ptr<Parameterisation> Clone() const;
+
+    /**
+     * @brief Function that returns an independent copy of the
+     * parameterisation with a given set of parameters.
+     * @param pars: the set of parameters
+     */
+    std::unique_ptr<Parameterisation> Clone(ParameterSet const& pars) const;
+
+    /**
+     * @brief Function that returns the current parameters as an
+     * immutable set.
+     */
+    ParameterSet GetParameterSet() const { return ParameterSet{GetParameters()}; }
+
     /**
      * @brief Virtual function that returns the value of one of the functions.
      * @param x: momentum fraction
@@ -51,6 +102,90 @@ namespace NangaParbat
      */
     virtual double Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const { return 0; };
     virtual void EvaluateOnGrid() {};
+
+    /**
+     * @brief Virtual function that evaluates one of the functions on
+     * arrays of points. The default implementation calls "Evaluate"
+     * point by point. Derived classes may override it with a
+     * branch-free loop that hoists the parameter-dependent constants
+     * out of the loop so that the compiler can vectorise it.
+     * @param n: number of points
+     * @param x: array of momentum fractions
+     * @param b: array of impact parameters
+     * @param zeta: array of rapidity scales
+     * @param ifunc: index of the function
+     * @param f: on exit, the n values of the ifunc-th function
+     */
+    virtual void EvaluateBatch(int const& n, double const* x, double const* b, double const* zeta, int const& ifunc, double* f) const;
+
+    /**
+     * @name Separable structure
+     * Optional interface for parameterisations that can be written as
+     * f(x, b, &zeta;) = C(X(x), B(b), Z(&zeta;)), where X, B, and Z
+     * are vectors of factors that depend only on x, only on b, and
+     * only on &zeta;, respectively, and C is a combiner cheaper than
+     * the full evaluation. A caller that evaluates the function on a
+     * grid can compute each factor only once per distinct value of
+     * the corresponding coordinate and combine them node by node. For
+     * any given function index, the number of factors of each kind
+     * must not depend on the point. The combiner must reproduce
+     * "Evaluate".
+     */
+    ///@{
+    /**
+     * @brief Whether the parameterisation provides the separable
+     * structure (default: false).
+     */
+    virtual bool IsSeparable() const { return false; }
+
+    /**
+     * @brief Factors that depend only on x.
+     * @param x: momentum fraction
+     * @param ifunc: index of the function
+     */
+    virtual std::vector<double> xFactors(double const& x, int const& ifunc) const { return {}; }
+
+    /**
+     * @brief Factors that depend only on b.
+     * @param b: impact parameter
+     * @param ifunc: index of the function
+     */
+    virtual std::vector<double> bFactors(double const& b, int const& ifunc) const { return {}; }
+
+    /**
+     * @brief Factors that depend only on &zeta;, typically its
+     * logarithm.
+     * @param zeta: rapidity scale
+     * @param ifunc: index of the function
+     */
+    virtual std::vector<double> zetaFactors(double const& zeta, int const& ifunc) const { return {}; }
+
+    /**
+     * @brief Function that combines the factors into the value of the
+     * function.
+     * @param xf: pointer to the x factors
+     * @param bf: pointer to the b factors
+     * @param zf: pointer to the &zeta; factors
+     * @param ifunc: index of the function
+     */
+    virtual double Combine(double const* xf, double const* bf, double const* zf, int const& ifunc) const { return 0; }
+
+    /**
+     * @brief Kinds of factors
+     */
+    enum FactorKind: int {xFactor = 0, bFactor = 1, zetaFactor = 2};
+
+    /**
+     * @brief Indices of the parameters the factors of a given kind
+     * depend on. Callers that keep the factors across parameter
+     * updates use it to recompute only those that have changed. The
+     * default assumes that all factors depend on all parameters.
+     * @param kind: kind of factors
+     * @param ifunc: index of the function
+     */
+    virtual std::vector<int> GetFactorDependencies(FactorKind const& kind, int const& ifunc) const;
+    ///@}
+
     /**
      * @brief Function that returns the parametrisation in the form of
      * a std::function.
@@ -71,6 +206,43 @@ namespace NangaParbat
     virtual double Derive(double const& x, double const& b, double const& zeta, int const& ifunc, int const& ipar) const { return 0; };
     virtual void DeriveOnGrid() {};
 
+    /**
+     * @brief Virtual function that returns the derivatives of one of
+     * the functions w.r.t. all the parameters at once. The default
+     * implementation calls "Derive" for each parameter.
+     * @param x: momentum fraction
+     * @param b: impact parameter
+     * @param zeta: rapidity scale
+     * @param ifunc: index of the function
+     * @param grad: on exit, the derivatives w.r.t. the parameters (as many as "GetParameterNumber()")
+     * @return the value of the function
+     */
+    virtual double Gradient(double const& x, double const& b, double const& zeta, int const& ifunc, double* grad) const;
+
+    /**
+     * @brief Virtual function that returns the derivatives of one of
+     * the functions w.r.t. all the parameters on arrays of points. The
+     * default implementation calls "Gradient" point by point.
+     * @param n: number of points
+     * @param x: array of momentum fractions
+     * @param b: array of impact parameters
+     * @param zeta: array of rapidity scales
+     * @param ifunc: index of the function
+     * @param grad: on exit, the derivatives ordered as [point][parameter]
+     */
+    virtual void GradientBatch(int const& n, double const* x, double const* b, double const* zeta, int const& ifunc, double* grad) const;
+
+    /**
+     * @brief Virtual function that returns the indices of the
+     * functions that depend on a given parameter. This allows the
+     * users of the parameterisation to skip the computations that do
+     * not depend on the parameters that have changed. The default
+     * implementation assumes that all functions depend on all
+     * parameters.
+     * @param ipar: index of the parameter
+     */
+    virtual std::vector<int> GetParameterDependencies(int const& ipar) const;
+
     /**
      * @brief Function that returns the derivative of the
      * parametrisation in the form of a std::function.
@@ -0,0 +1,30 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include "NangaParbat/convolutiontable.h"
+
+#include <functional>
+#include <string>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Type of the functions that compute the predictions of a
+   * convolution table given a parameterisation.
+   */
+  typedef std::function<std::vector<double>(ConvolutionTable const&, Parameterisation const&)> PredictionKernel;
+
+  /**
+   * @brief Function that returns the prediction kernel instantiated
+   * for the parameterisation with a given name (see
+   * "ConvolutionTable::Predict"). The kernel throws if it is called
+   * with a parameterisation of a different type.
+   * @param name: name of the parameterisation
+   * @return the specialised kernel if available, otherwise the kernel
+   * that uses "ConvolutionTable::GetPredictions".
+   */
+  PredictionKernel GetPredictionKernel(std::string const& name);
+}
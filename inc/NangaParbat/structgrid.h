@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include "NangaParbat/binarygrid.h"
+
 #include <yaml-cpp/yaml.h>
 #include <apfel/apfelxx.h>
 
@@ -23,6 +25,13 @@ namespace NangaParbat
      */
     StructGrid(YAML::Node const& info, YAML::Node const& grid);
 
+    /**
+     * @brief The "StructGrid" constructor from a grid in binary format
+     * @param info: the info file of the grid
+     * @param grid: the memory-mapped binary grid
+     */
+    StructGrid(YAML::Node const& info, std::shared_ptr<BinaryGrid const> const& grid);
+
     /**
      * @brief Function that returns the value of one of the functions.
      * @param x: momentum fraction
@@ -39,11 +48,16 @@ namespace NangaParbat
     YAML::Node GetInfoNode() const { return _info; };
 
   private:
-    YAML::Node                                                   const  _info;
-    std::unique_ptr<apfel::QGrid<double>>                        const  _xg;
-    std::unique_ptr<apfel::QGrid<double>>                        const  _zg;
-    std::unique_ptr<apfel::QGrid<double>>                        const  _qToQg;
-    std::unique_ptr<apfel::QGrid<double>>                        const  _Qg;
-    std::vector<std::vector<std::vector<std::vector<double>>>>   const  _stfunc;
+    YAML::Node                            const  _info;
+    std::unique_ptr<apfel::QGrid<double>> const  _xg;
+    std::unique_ptr<apfel::QGrid<double>> const  _zg;
+    std::unique_ptr<apfel::QGrid<double>> const  _qToQg;
+    std::unique_ptr<apfel::QGrid<double>> const  _Qg;
+    int                                   const  _nx;     //!< Number of nodes in x
+    int                                   const  _nz;     //!< Number of nodes in z
+    int                                   const  _nqToQ;  //!< Number of nodes in qT/Q
+    std::vector<double>                          _store;  //!< Grid values (when read from YAML)
+    std::shared_ptr<BinaryGrid const>     const  _bin;    //!< Memory-mapped grid (when read from binary)
+    double const*                                _stfunc; //!< Grid values ordered as [Q][x][z][qT/Q]
   };
 }
@@ -0,0 +1,153 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include "NangaParbat/parameterisation.h"
+
+#include <apfel/qgrid.h>
+#include <memory>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Parameterisation derived from the "Parameterisation"
+   * mother class that tabulates another parameterisation on a grid in
+   * (x, b<SUB>T</SUB>, &zeta;) and returns its interpolation. This is
+   * convenient for parameterisations that are expensive to evaluate
+   * (e.g. numerical integrals inside "Evaluate") because the wrapped
+   * parameterisation is evaluated only on the nodes of the grid, each
+   * time the parameters are set, rather than at each point requested
+   * by the convolution tables. Points outside the grid are computed
+   * with the wrapped parameterisation.
+   */
+  class TabulatedParameterisation: public NangaParbat::Parameterisation
+  {
+  public:
+    /**
+     * @brief The "TabulatedParameterisation" constructor. The grids
+     * left empty are replaced by logarithmically spaced grids: 100
+     * nodes in [10<SUP>-6</SUP>, 0.99] for x, 100 nodes in
+     * [10<SUP>-5</SUP>, 10] GeV<SUP>-1</SUP> for b<SUB>T</SUB>, and
+     * 50 nodes in [4, 40000] GeV<SUP>2</SUP> for &zeta;.
+     * @param NPFunc: the parameterisation to be tabulated (not owned)
+     * @param xg: nodes in x (default: empty)
+     * @param bTg: nodes in b<SUB>T</SUB> (default: empty)
+     * @param zetag: nodes in &zeta; (default: empty)
+     * @param degree: interpolation degree (default: 3, i.e. cubic)
+     * @param derivatives: whether the derivatives w.r.t. the parameters are also tabulated (default: false)
+     * @param nthreads: number of threads used to fill in the grid (default: 0, i.e. the number of available cores)
+     */
+    TabulatedParameterisation(Parameterisation          *NPFunc,
+                              std::vector<double> const& xg          = {},
+                              std::vector<double> const& bTg         = {},
+                              std::vector<double> const& zetag       = {},
+                              int                 const& degree      = 3,
+                              bool                const& derivatives = false,
+                              int                 const& nthreads    = 0);
+
+    /**
+     * @brief Function that returns an independent copy of the
+     * tabulated parameterisation. The copy owns a clone of the
+     * wrapped parameterisation, such that the parameters of the two
+     * can be set independently, and shares the (immutable) grids.
+     */
+    std::unique_ptr<Parameterisation> Clone() const;
+    using Parameterisation::Clone;
+
+    /**
+     * @brief Function that sets the parameters of the wrapped
+     * parameterisation and tabulates it again.
+     * @param pars: the vector of parameters
+     */
+    void SetParameters(std::vector<double> const& pars);
+
+    /**
+     * @brief Function that returns the interpolated value of one of
+     * the functions.
+     * @param x: momentum fraction
+     * @param bT: impact parameter
+     * @param zeta: rapidity scale &zeta;
+     * @param ifunc: index of the function
+     */
+    double Evaluate(double const& x, double const& bT, double const& zeta, int const& ifunc) const;
+
+    /**
+     * @brief Function that returns the interpolated derivative of one
+     * of the functions. If the derivatives are not tabulated, the
+     * wrapped parameterisation is used.
+     * @param x: momentum fraction
+     * @param bT: impact parameter
+     * @param zeta: rapidity scale &zeta;
+     * @param ifunc: index of the function
+     * @param ipar: index of the parameter
+     */
+    double Derive(double const& x, double const& bT, double const& zeta, int const& ifunc, int const& ipar) const;
+
+    /**
+     * @brief Function that returns the interpolated derivatives of one
+     * of the functions w.r.t. all the parameters at once. If the
+     * derivatives are not tabulated, the wrapped parameterisation is
+     * used.
+     */
+    double Gradient(double const& x, double const& bT, double const& zeta, int const& ifunc, double* grad) const;
+
+    /**
+     * @brief Function that returns the indices of the functions that
+     * depend on a given parameter as given by the wrapped
+     * parameterisation.
+     * @param ipar: index of the parameter
+     */
+    std::vector<int> GetParameterDependencies(int const& ipar) const { return _NPFunc->GetParameterDependencies(ipar); };
+
+    /**
+     * @brief Function that estimates the interpolation error by
+     * comparing the interpolated functions with the wrapped
+     * parameterisation in the middle of the cells of the grid, where
+     * the interpolation is least accurate.
+     * @param stride: one cell every "stride" along each axis is checked (default: 1, i.e. all cells)
+     * @return for each function, the pair (maximum absolute error,
+     * maximum relative error). The relative error is computed w.r.t.
+     * the larger between the absolute value of the function and
+     * 10<SUP>-3</SUP> times its maximum over the grid, so that zeros
+     * of the function do not dominate it.
+     */
+    std::vector<std::pair<double, double>> GetInterpolationError(int const& stride = 1) const;
+
+    /**
+     * @brief Function that prints the interpolation error (see
+     * "GetInterpolationError").
+     * @param stride: one cell every "stride" along each axis is checked (default: 1, i.e. all cells)
+     */
+    void ReportInterpolationError(int const& stride = 1) const;
+
+    std::string              LatexFormula()      const { return _NPFunc->LatexFormula(); };
+    std::vector<std::string> GetParameterNames() const { return _NPFunc->GetParameterNames(); };
+    std::string              GetDescription()    const { return "Tabulated version of " + _NPFunc->GetName() + ": " + _NPFunc->GetDescription(); };
+
+  private:
+    /**
+     * @brief Function that fills in the grid.
+     */
+    void Tabulate();
+
+    /**
+     * @brief Function that interpolates the "nk" entries starting
+     * from "k" of the grid of the "ifunc"-th function.
+     * @return false if the point is outside the grid
+     */
+    bool Interpolate(double const& x, double const& bT, double const& zeta, int const& ifunc, int const& k, int const& nk, double* res) const;
+
+  private:
+    Parameterisation                           *_NPFunc;   //!< The wrapped parameterisation
+    std::shared_ptr<Parameterisation>           _owned;    //!< The wrapped parameterisation if owned (i.e. for clones)
+    bool                                  const _derivs;   //!< Whether the derivatives are tabulated
+    int                                   const _nthreads; //!< Number of threads
+    std::shared_ptr<apfel::QGrid<double> const> _xg;       //!< Grid in x
+    std::shared_ptr<apfel::QGrid<double> const> _bTg;      //!< Grid in bT
+    std::shared_ptr<apfel::QGrid<double> const> _zetag;    //!< Grid in zeta
+    int                                         _nk;       //!< Number of entries per node (function and derivatives)
+    std::vector<double>                         _tab;      //!< Grid values ordered as [function][x][bT][zeta][entry]
+  };
+}
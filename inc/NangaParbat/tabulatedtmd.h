@@ -0,0 +1,78 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include "NangaParbat/parameterisation.h"
+
+#include <memory>
+#include <apfel/apfelxx.h>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Class that tabulates in bT the perturbative part of a TMD,
+   * i.e. bT times the evolved TMD computed at b*(bT, Q), for a given
+   * flavour, x, and Q. The non-perturbative function is applied on
+   * top of the tabulation at evaluation time. This way the expensive
+   * perturbative part is computed only once and the TMD can be
+   * obtained for many sets of non-perturbative parameters (e.g. the
+   * replicas of a fit) at a small extra cost.
+   */
+  class TabulatedTMD
+  {
+  public:
+    /**
+     * @brief The "TabulatedTMD" constructor
+     * @param EvTMDs: the evolved TMDs as functions of (b, mu, zeta) in the QCD evolution basis
+     * @param bstar: the b* prescription
+     * @param ifl: the flavour index in the physical basis
+     * @param x: momentum fraction
+     * @param Q: final scale (mu = Q and zeta = Q<SUP>2</SUP>)
+     * @param bThresholds: heavy-quark thresholds in bT (default: none)
+     * @param nb: number of nodes of the tabulation (default: 300)
+     * @param bmin: lower bound of the tabulation (default: 10<SUP>-4</SUP>)
+     * @param bmax: upper bound of the tabulation (default: 10)
+     */
+    TabulatedTMD(std::function<apfel::Set<apfel::Distribution>(double const&, double const&, double const&)> const& EvTMDs,
+                 std::function<double(double const&, double const&)>                                          const& bstar,
+                 int                                                                                          const& ifl,
+                 double                                                                                       const& x,
+                 double                                                                                       const& Q,
+                 std::vector<double>                                                                          const& bThresholds = {},
+                 int                                                                                          const& nb = 300,
+                 double                                                                                       const& bmin = 1e-4,
+                 double                                                                                       const& bmax = 10);
+
+    /**
+     * @brief Function that returns the tabulated perturbative part
+     * @param bT: impact parameter
+     * @return bT times the perturbative TMD
+     */
+    double Evaluate(double const& bT) const { return _tab->Evaluate(bT); }
+
+    /**
+     * @brief Function that returns the full TMD in bT space
+     * multiplied by bT, i.e. the integrand of the Hankel transform.
+     * @param NPFunc: the non-perturbative function
+     * @param ifunc: index of the non-perturbative function to be used
+     */
+    std::function<double(double const&)> bTSpace(Parameterisation const& NPFunc, int const& ifunc) const;
+
+    /**
+     * @brief Function that returns the full TMD in qT space.
+     * @param NPFunc: the non-perturbative function
+     * @param ifunc: index of the non-perturbative function to be used
+     * @param qTv: vector of values of qT
+     * @return the TMD at the values of qT in qTv
+     */
+    std::vector<double> qTSpace(Parameterisation const& NPFunc, int const& ifunc, std::vector<double> const& qTv) const;
+
+  private:
+    double                                         const _x;     //!< Momentum fraction
+    double                                         const _Q;     //!< Final scale
+    std::unique_ptr<apfel::TabulateObject<double>> const _tab;   //!< Tabulated perturbative part
+    apfel::DoubleExponentialQuadrature             const _DEObj; //!< Quadrature for the Hankel transform
+  };
+}
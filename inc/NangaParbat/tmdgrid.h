@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "NangaParbat/binarygrid.h"
+
 #include <yaml-cpp/yaml.h>
 #include <apfel/apfelxx.h>
 
@@ -21,6 +23,13 @@ namespace NangaParbat
      */
     TMDGrid(YAML::Node const& info, YAML::Node const& grid);
 
+    /**
+     * @brief The "TMDGrid" constructor from a grid in binary format
+     * @param info: the info file of the grid
+     * @param grid: the memory-mapped binary grid
+     */
+    TMDGrid(YAML::Node const& info, std::shared_ptr<BinaryGrid const> const& grid);
+
     /**
      * @brief Function that returns the value of one of the functions.
      * @param x: momentum fraction
@@ -36,10 +45,15 @@ namespace NangaParbat
     YAML::Node GetInfoNode() const { return _info; };
 
   private:
-    YAML::Node                                                   const _info;
-    std::unique_ptr<apfel::QGrid<double>>                        const _xg;
-    std::unique_ptr<apfel::QGrid<double>>                        const _qToQg;
-    std::unique_ptr<apfel::QGrid<double>>                        const _Qg;
-    std::map<int, std::vector<std::vector<std::vector<double>>>> const _tmds;
+    YAML::Node                            const _info;
+    std::unique_ptr<apfel::QGrid<double>> const _xg;
+    std::unique_ptr<apfel::QGrid<double>> const _qToQg;
+    std::unique_ptr<apfel::QGrid<double>> const _Qg;
+    int                                   const _nx;    //!< Number of nodes in x
+    int                                   const _nqToQ; //!< Number of nodes in qT/Q
+    std::vector<int>                            _flv;   //!< Flavour indices
+    std::vector<double>                         _store; //!< Grid values (when read from YAML)
+    std::shared_ptr<BinaryGrid const>     const _bin;   //!< Memory-mapped grid (when read from binary)
+    double const*                               _tmds;  //!< Grid values ordered as [Q][x][qT/Q][flavour]
   };
 }
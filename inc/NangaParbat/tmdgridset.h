@@ -0,0 +1,88 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include <yaml-cpp/yaml.h>
+#include <apfel/apfelxx.h>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Class for the interpolation of all the members of a TMD
+   * set at once. The members are assumed to share the same grid in
+   * (Q, x, qT/Q), therefore the axes are stored only once and the
+   * values of all members are collected in a single block ordered as
+   * [member][Q][x][qT/Q][flavour]. This allows one to compute the
+   * interpolation weights only once per point and to evaluate all
+   * members in one single pass.
+   */
+  class TMDGridSet
+  {
+  public:
+    /**
+     * @brief The "TMDGridSet" constructor. Members available in binary
+     * format are read from the ".bin" files, otherwise from YAML.
+     * @param name: name of the TMD set
+     * @param folder: folder where the TMD set is (default: current folder)
+     */
+    TMDGridSet(std::string const& name, std::string const& folder = ".");
+
+    /**
+     * @brief Function that returns the value of all the members of the
+     * set.
+     * @param x: momentum fraction
+     * @param qT: transverse momentum
+     * @param Q: renormalisation scale (assumed to be equal to the square root of zeta)
+     * @return a vector (one entry per member) of maps flavour-value
+     */
+    std::vector<std::map<int, double>> EvaluateMembers(double const& x, double const& qT, double const& Q) const;
+
+    /**
+     * @brief Function that returns mean and standard deviation of the
+     * set. Following the usual convention for Monte Carlo sets, if the
+     * set has more than one member, member 0 (the fit to the central
+     * values) is excluded from the statistics.
+     * @param x: momentum fraction
+     * @param qT: transverse momentum
+     * @param Q: renormalisation scale (assumed to be equal to the square root of zeta)
+     * @return a map flavour-(mean, standard deviation)
+     */
+    std::map<int, std::pair<double, double>> EvaluateMeanStd(double const& x, double const& qT, double const& Q) const;
+
+    /**
+     * @brief Function that returns the number of members
+     */
+    int GetNumberOfMembers() const { return _nmem; }
+
+    /**
+     * @brief Function that returns the flavour indices
+     */
+    std::vector<int> const& GetFlavours() const { return _flv; }
+
+    /**
+     * @brief Function that returns the YAML Node with the set info
+     */
+    YAML::Node GetInfoNode() const { return _info; };
+
+  private:
+    /**
+     * @brief Function that evaluates all members and returns the
+     * values in a vector ordered as [member][flavour].
+     */
+    std::vector<double> EvaluateBlock(double const& x, double const& qT, double const& Q) const;
+
+  private:
+    YAML::Node                            const _info;
+    int                                   const _nmem;  //!< Number of members
+    std::unique_ptr<apfel::QGrid<double>>       _xg;
+    std::unique_ptr<apfel::QGrid<double>>       _qToQg;
+    std::unique_ptr<apfel::QGrid<double>>       _Qg;
+    int                                         _nx;    //!< Number of nodes in x
+    int                                         _nqToQ; //!< Number of nodes in qT/Q
+    std::size_t                                 _msize; //!< Number of values per member
+    std::vector<int>                            _flv;   //!< Flavour indices
+    std::vector<double>                         _tmds;  //!< Values ordered as [member][Q][x][qT/Q][flavour]
+  };
+}
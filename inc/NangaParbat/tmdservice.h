@@ -0,0 +1,155 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#pragma once
+
+#include <map>
+#include <list>
+#include <tuple>
+#include <mutex>
+#include <memory>
+#include <yaml-cpp/yaml.h>
+#include <apfel/apfelxx.h>
+
+namespace NangaParbat
+{
+  /**
+   * @brief Class that collects, for a given theory configuration, all
+   * the ingredients needed to compute perturbative TMDs: heavy-quark
+   * thresholds, strong coupling, x-space grids, tabulated collinear
+   * distributions, TMD objects, and evolved TMDs. Everything is
+   * constructed once and can be shared by all the consumers (grid
+   * producers, interpolation tables, plotting).
+   *
+   * After construction the object is read-only and the evaluation of
+   * the TMDs is thread safe. Evaluations are memoised in a bounded
+   * least-recently-used cache keyed on the distribution type and on
+   * the logarithms of b, mu, and zeta rounded to a given resolution.
+   */
+  class TMDService
+  {
+  public:
+    /**
+     * @brief The "TMDService" constructor.
+     * @param config: the YAML node with the theory settings (as in "tables/config.yaml")
+     * @param dists: the distributions to be initialised, "pdf" and/or "ff" (default: both)
+     * @param cachesize: maximum number of evaluations kept in the cache, zero disables the cache (default: 500)
+     * @param resolution: resolution on log(b), log(mu), and log(zeta) used to identify cached evaluations (default: 1e-7)
+     * @param nQ: number of nodes used to tabulate the collinear distributions in the scale (default: 100)
+     * @param Qmin: lower bound of the tabulation of the collinear distributions, if not positive it is added to the lower bound of each LHAPDF set (default: 0)
+     * @param alphas: the strong coupling, "tabulated" from the reference set, evaluated "direct"ly from the reference set, or evaluated directly from the "own" set of each distribution (default: "tabulated")
+     * @note The heavy-quark thresholds are taken from the PDF set, if
+     * requested, otherwise from the FF set (reference set). They are
+     * used for both distributions.
+     */
+    TMDService(YAML::Node               const& config,
+               std::vector<std::string> const& dists = {"pdf", "ff"},
+               int                      const& cachesize = 500,
+               double                   const& resolution = 1e-7,
+               int                      const& nQ = 100,
+               double                   const& Qmin = 0,
+               std::string              const& alphas = "tabulated");
+
+    TMDService(TMDService const&) = delete;
+    TMDService& operator = (TMDService const&) = delete;
+
+    /**
+     * @brief Function that returns the evolved TMDs in the QCD
+     * evolution basis.
+     * @param pf: whether PDFs ("pdf") of FFs ("ff")
+     * @param b: impact parameter
+     * @param mu: renormalisation scale
+     * @param zeta: rapidity scale
+     * @return the set of TMDs
+     */
+    apfel::Set<apfel::Distribution> Evaluate(std::string const& pf, double const& b, double const& mu, double const& zeta) const;
+
+    /**
+     * @brief Function that returns the evolved TMDs as a function of
+     * (b, mu, zeta). The function goes through the cache and relies
+     * on this object being alive.
+     * @param pf: whether PDFs ("pdf") of FFs ("ff")
+     */
+    std::function<apfel::Set<apfel::Distribution>(double const&, double const&, double const&)> GetTMDs(std::string const& pf) const;
+
+    /**
+     * @brief Function that returns the YAML node with the theory
+     * settings
+     */
+    YAML::Node GetConfig() const { return _config; }
+
+    /**
+     * @brief Function that returns the heavy-quark thresholds
+     */
+    std::vector<double> const& GetThresholds() const { return _Thresholds; }
+
+    /**
+     * @brief Function that returns the strong coupling of the
+     * reference set
+     * @param mu: renormalisation scale
+     */
+    double Alphas(double const& mu) const { return _Alphas(mu); }
+
+    /**
+     * @brief Function that returns the quark flavours of the LHAPDF
+     * set of a distribution
+     * @param pf: whether PDFs ("pdf") of FFs ("ff")
+     */
+    std::vector<int> const& GetFlavours(std::string const& pf) const { return Get(pf).flavours; }
+
+    /**
+     * @brief Function that returns the x-space grid
+     * @param pf: whether PDFs ("pdf") of FFs ("ff")
+     */
+    apfel::Grid const& GetGrid(std::string const& pf) const { return *Get(pf).g; }
+
+    /**
+     * @brief Function that returns the tabulated collinear
+     * distributions in the QCD evolution basis
+     * @param pf: whether PDFs ("pdf") of FFs ("ff")
+     */
+    apfel::TabulateObject<apfel::Set<apfel::Distribution>> const& GetCollinearDistributions(std::string const& pf) const { return *Get(pf).TabDists; }
+
+    /**
+     * @brief Function that returns the TMD objects
+     * @param pf: whether PDFs ("pdf") of FFs ("ff")
+     */
+    std::map<int, apfel::TmdObjects> const& GetTmdObjects(std::string const& pf) const { return Get(pf).TmdObjs; }
+
+  private:
+    /**
+     * @brief Structure that collects the ingredients of one
+     * distribution type.
+     */
+    struct Ingredients
+    {
+      int                                                                                         index;    //!< Index of the distribution used in the cache key
+      std::vector<int>                                                                            flavours; //!< Quark flavours of the LHAPDF set
+      std::unique_ptr<const apfel::Grid>                                                          g;        //!< x-space grid
+      std::unique_ptr<apfel::TabulateObject<apfel::Set<apfel::Distribution>>>                     TabDists; //!< Collinear distributions
+      std::map<int, apfel::TmdObjects>                                                            TmdObjs;  //!< TMD objects
+      std::function<apfel::Set<apfel::Distribution>(double const&, double const&, double const&)> EvTMDs;   //!< Evolved TMDs
+    };
+
+    /**
+     * @brief Function that returns the ingredients of a distribution
+     * type and throws if they have not been initialised.
+     */
+    Ingredients const& Get(std::string const& pf) const;
+
+  private:
+    typedef std::tuple<int, long long, long long, long long> Key;
+    typedef std::list<std::pair<Key, apfel::Set<apfel::Distribution>>> CacheList;
+
+    YAML::Node                                     const _config;     //!< Theory settings
+    int                                            const _cachesize;  //!< Maximum size of the cache
+    double                                         const _resolution; //!< Resolution of the cache keys
+    std::vector<double>                                  _Thresholds; //!< Heavy-quark thresholds
+    std::function<double(double const&)>                 _Alphas;     //!< Strong coupling of the reference set
+    std::map<std::string, Ingredients>                   _dists;      //!< Ingredients of each distribution type
+    mutable CacheList                                    _cache;      //!< Cached evaluations, most recent first
+    mutable std::map<Key, CacheList::iterator>           _index;      //!< Position of the cached evaluations in the list
+    mutable std::mutex                                   _mutex;      //!< Mutex protecting the cache
+  };
+}
@@ -13,14 +13,14 @@ int main(int argc, char* argv[])
   if (argc > 1 && std::strncmp(argv[1], "python", 6) == 0)
     {
       std::cout << "=== ";
-      for (auto const& p : NangaParbat::AvPars)
+      for (auto const& p : NangaParbat::AvailableParameterisations())
         std::cout << p.first << " ";
       std::cout << "===\n";
     }
   else
     {
       std::cout << "\nAvailable parameterisations:" << std::endl;
-      for (auto const& p : NangaParbat::AvPars)
+      for (auto const& p : NangaParbat::AvailableParameterisations())
         std::cout << "- " << p.first << ": " << p.second->GetDescription() << std::endl;
       std::cout << "\n";
     }
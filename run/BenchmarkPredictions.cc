@@ -0,0 +1,85 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/nonpertfunctions.h"
+#include "NangaParbat/convolutiontable.h"
+#include "NangaParbat/predictionkernels.h"
+#include "NangaParbat/listdir.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+//_________________________________________________________________________________
+int main(int argc, char* argv[])
+{
+  // Check that the input is correct otherwise stop the code
+  if (argc < 3 || strcmp(argv[1], "--help") == 0)
+    {
+      std::cout << "\nInvalid Parameters:" << std::endl;
+      std::cout << "Syntax: ./BenchmarkPredictions <path to tables folder> <parameterisation> [number of repetitions]\n" << std::endl;
+      exit(-10);
+    }
+
+  // Parameterisation and corresponding specialised kernel
+  const std::string parname = argv[2];
+  const std::unique_ptr<NangaParbat::Parameterisation const> NPFunc = NangaParbat::MakeParameterisation(parname);
+  const NangaParbat::PredictionKernel kernel = NangaParbat::GetPredictionKernel(parname);
+
+  // Number of repetitions
+  const int nrep = (argc > 3 ? std::max(atoi(argv[3]), 1) : 1);
+
+  // Function that times a given path over the repetitions and
+  // returns the time in milliseconds and the predictions.
+  const auto timeit = [=] (std::function<std::vector<double>()> const& path, std::vector<double>& pred) -> double
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nrep; i++)
+      pred = path();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / nrep;
+  };
+
+  // Run over the tables in the folder
+  std::vector<std::string> files = NangaParbat::list_dir(argv[1]);
+  std::sort(files.begin(), files.end());
+  double tfunc = 0;
+  double tpars = 0;
+  double tkern = 0;
+  std::cout << std::scientific;
+  std::cout << "# table, std::function path [ms], parameterisation path [ms], specialised kernel [ms], speed-up of the kernel, max. relative difference" << std::endl;
+  for (auto const& f : files)
+    {
+      if (f.size() < 5 || f.substr(f.size() - 5) != ".yaml")
+        continue;
+
+      // Skip files that are not interpolation tables
+      const YAML::Node table = YAML::LoadFile(std::string(argv[1]) + "/" + f);
+      if (!table["weights"])
+        continue;
+
+      const NangaParbat::ConvolutionTable ct{table};
+
+      // Type-erased paths through the std::function returned by
+      // "Parameterisation::Function" and through the virtual
+      // interface of the parameterisation, and specialised kernel.
+      std::vector<double> pfunc, ppars, pkern;
+      const double tf = timeit([&] { return ct.GetPredictions(NPFunc->Function()); }, pfunc);
+      const double tp = timeit([&] { return ct.GetPredictions(*NPFunc); }, ppars);
+      const double tk = timeit([&] { return kernel(ct, *NPFunc); }, pkern);
+
+      double maxdiff = 0;
+      for (int i = 0; i < (int) pfunc.size(); i++)
+        if (pfunc[i] != 0)
+          maxdiff = std::max({maxdiff, std::abs(ppars[i] / pfunc[i] - 1), std::abs(pkern[i] / pfunc[i] - 1)});
+
+      std::cout << table["name"].as<std::string>() << "\t" << tf << "\t" << tp << "\t" << tk << "\t" << tf / tk << "\t" << maxdiff << std::endl;
+      tfunc += tf;
+      tpars += tp;
+      tkern += tk;
+    }
+  std::cout << "Total\t" << tfunc << "\t" << tpars << "\t" << tkern << "\t" << tfunc / tkern << std::endl;
+
+  return 0;
+}
@@ -59,7 +59,7 @@ int main(int argc, char* argv[])
         NangaParbat::ConvolutionTable* ct =  new NangaParbat::ConvolutionTable{YAML::LoadFile(std::string(argv[4]) + "/" + ds["name"].as<std::string>() + ".yaml"), fitconfig["qToQmax"].as<double>()};
 
         // Datafile
-        NangaParbat::DataHandler* dh = new NangaParbat::DataHandler{ds["name"].as<std::string>(), YAML::LoadFile(std::string(argv[3]) + "/" + exp.first.as<std::string>() + "/" + ds["file"].as<std::string>())};
+        NangaParbat::DataHandler* dh = new NangaParbat::DataHandler{ds["name"].as<std::string>(), std::string(argv[3]) + "/" + exp.first.as<std::string>() + "/" + ds["file"].as<std::string>()};
 
         // Add chi2 block
         chi2.AddBlock(std::make_pair(dh, ct));
@@ -29,7 +29,7 @@ int main(int argc, char* argv[])
   apfel::Timer t;
 
   // Get predictions and print them
-  for (double p : ct.GetPredictions(NPFunc.Function()))
+  for (double p : ct.GetPredictions(NPFunc))
     std::cout << std::scientific << p << std::endl;
 
   t.stop();
@@ -0,0 +1,25 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/binarygrid.h"
+
+#include <cstring>
+#include <iostream>
+
+//_________________________________________________________________________________
+int main(int argc, char* argv[])
+{
+  // Check that the input is correct otherwise stop the code
+  if (argc < 2 || strcmp(argv[1], "--help") == 0)
+    {
+      std::cout << "\nInvalid Parameters:" << std::endl;
+      std::cout << "Syntax: ./ConvertGrids <name of the set> [folder of the set]\n" << std::endl;
+      exit(-10);
+    }
+
+  // Convert all members of the set into binary format
+  NangaParbat::ConvertGridSetToBinary(argv[1], (argc > 2 ? argv[2] : "."));
+
+  return 0;
+}
@@ -14,12 +14,22 @@ int main(int argc, char* argv[])
   if (argc < 4 || strcmp(argv[1], "--help") == 0)
     {
       std::cout << "\nInvalid Parameters:" << std::endl;
-      std::cout << "Syntax: ./CreateGrids <report folder> <pdf/ff> <output>\n" << std::endl;
+      std::cout << "Syntax: ./CreateGrids <report folder> <pdf/ff> <output> [binary] [summary]\n" << std::endl;
       exit(-10);
     }
 
+  // Optional flags: write the binary version of the grids and/or the
+  // summary members.
+  bool binary  = false;
+  bool summary = false;
+  for (int i = 4; i < argc; i++)
+    if (strcmp(argv[i], "binary") == 0)
+      binary = true;
+    else if (strcmp(argv[i], "summary") == 0)
+      summary = true;
+
   // Produce the folder with the grids
-  NangaParbat::ProduceTMDGrid(argv[1], argv[3], argv[2]);
+  NangaParbat::ProduceTMDGrid(argv[1], argv[3], argv[2], binary, summary);
 
   return 0;
 }
@@ -44,7 +44,7 @@ int main(int argc, char* argv[])
         {
           std::cout << "- " << ds["name"].as<std::string>() << std::endl;
           const std::string datafile = std::string(argv[2]) + "/" + exp.first.as<std::string>() + "/" + ds["file"].as<std::string>();
-          DHVect.push_back(NangaParbat::DataHandler{ds["name"].as<std::string>(), YAML::LoadFile(datafile)});
+          DHVect.push_back(NangaParbat::DataHandler{ds["name"].as<std::string>(), datafile});
         }
 
   // Compute tables
@@ -3,12 +3,129 @@
 //
 
 #include "NangaParbat/preprocessing.h"
+#include "NangaParbat/datahandler.h"
+#include "NangaParbat/parallelfor.h"
+#include "NangaParbat/listdir.h"
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
 #include <sys/stat.h>
 
+namespace
+{
+  /**
+   * @brief Structure describing one preprocessing function along with
+   * the raw data it depends on.
+   */
+  struct FilterUnit
+  {
+    std::string              experiment; //!< Experiment under which the datasets are listed in datasets.yaml
+    std::string              name;       //!< Name of the unit used for the bookkeeping
+    std::string              (*preprocess)(std::string const&, std::string const&, bool const&); //!< Preprocessing function
+    std::string              ofolder;    //!< Folder of the processed datafiles
+    std::vector<std::string> rawfolders; //!< Folders of the raw data
+    std::vector<std::string> pdferrors;  //!< Prefixes of the PDF-error files
+  };
+
+  //_________________________________________________________________________________
+  void Hash(uint64_t& h, std::string const& s)
+  {
+    // FNV-1a
+    for (unsigned char c : s + '\0')
+      {
+        h ^= c;
+        h *= 0x100000001B3ULL;
+      }
+  }
+
+  //_________________________________________________________________________________
+  void HashFile(uint64_t& h, std::string const& path, std::string const& rel)
+  {
+    // Files are identified by path, size, and modification time.
+    // Folders are walked recursively in alphabetical order.
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+      return;
+
+    Hash(h, rel);
+    if (S_ISDIR(st.st_mode))
+      {
+        std::vector<std::string> entries = NangaParbat::list_dir(path);
+        std::sort(entries.begin(), entries.end());
+        for (auto const& e : entries)
+          if (e != "." && e != "..")
+            HashFile(h, path + "/" + e, rel + "/" + e);
+      }
+    else
+      Hash(h, std::to_string(st.st_size) + " " + std::to_string(st.st_mtime));
+  }
+
+  //_________________________________________________________________________________
+  std::string Executable(std::string const& argv0)
+  {
+    // The executable is looked for through "/proc" first and through
+    // the command line then. If it cannot be found, the processing
+    // could not be redone when the code changes, therefore stop.
+    struct stat st;
+    for (auto const& exe : {std::string{"/proc/self/exe"}, argv0})
+      if (stat(exe.c_str(), &st) == 0 && !S_ISDIR(st.st_mode))
+        return exe;
+    throw std::runtime_error("[Executable]: cannot find the executable '" + argv0 + "'");
+  }
+
+  //_________________________________________________________________________________
+  std::string InputHash(FilterUnit const& u, std::string const& RawDataPath, std::string const& exe, bool const& pdferr)
+  {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    Hash(h, u.name + (pdferr ? " pdferr" : ""));
+
+    // Executable, so that the processing is redone when the code
+    // changes.
+    HashFile(h, exe, "exe");
+
+    for (auto const& f : u.rawfolders)
+      HashFile(h, RawDataPath + "/" + f, f);
+
+    if (pdferr)
+      {
+        std::vector<std::string> entries = NangaParbat::list_dir(RawDataPath + "/PDFErrors");
+        std::sort(entries.begin(), entries.end());
+        for (auto const& e : entries)
+          for (auto const& p : u.pdferrors)
+            if (e.compare(0, p.size(), p) == 0)
+              {
+                HashFile(h, RawDataPath + "/PDFErrors/" + e, e);
+                break;
+              }
+      }
+
+    std::ostringstream os;
+    os << std::hex << std::setw(16) << std::setfill('0') << h;
+    return os.str();
+  }
+
+  //_________________________________________________________________________________
+  bool OutputsExist(FilterUnit const& u, std::string const& fragment, std::string const& ProcessedDataPath)
+  {
+    // Both the processed datafiles and their binary caches are
+    // required, since the caches are written along with the datafiles.
+    struct stat st;
+    for (auto const& ds : YAML::Load(fragment))
+      {
+        const std::string datafile = ProcessedDataPath + "/" + u.ofolder + "/" + ds["file"].as<std::string>();
+        if (stat(datafile.c_str(), &st) != 0 || stat(NangaParbat::DataCacheFile(datafile).c_str(), &st) != 0)
+          return false;
+      }
+    return true;
+  }
+}
+
 //_________________________________________________________________________________
 int main(int argc, char* argv[])
 {
@@ -16,7 +133,7 @@ int main(int argc, char* argv[])
   if(argc < 3 || strcmp(argv[1], "--help") == 0)
     {
       std::cout << "\nInvalid Parameters:" << std::endl;
-      std::cout << "Syntax: ./Filter <path to raw-data folder> <path to processed data>\n" << std::endl;
+      std::cout << "Syntax: ./Filter <path to raw-data folder> <path to processed data> [--force]\n" << std::endl;
       exit(-10);
     }
 
@@ -26,64 +143,127 @@ int main(int argc, char* argv[])
   // Path to to output folder
   const std::string ProcessedDataPath = std::string(argv[2]);
 
+  // Whether to process all datasets irrespective of whether they
+  // are up to date
+  const bool force = (argc > 3 && strcmp(argv[3], "--force") == 0);
+
   // Create output folder
   mkdir(ProcessedDataPath.c_str(), ACCESSPERMS);
 
-  // Dataset file created dunring the filtering
-  std::ofstream fout(ProcessedDataPath + "/datasets.yaml");
-
   // Include on not PDF uncertainties
   const bool pdferr = true;
 
-  fout << "E605:\n";
-  fout << NangaParbat::PreprocessE605(RawDataPath, ProcessedDataPath, pdferr);
-
-  fout << "E288:\n";
-  fout << NangaParbat::PreprocessE288(RawDataPath, ProcessedDataPath, pdferr);
-
-  //fout << "PHENIX:\n";
-  //fout << NangaParbat::PreprocessPHENIX200(RawDataPath, ProcessedDataPath, pdferr);
-
-  fout << "STAR:\n";
-  fout << NangaParbat::PreprocessSTAR510(RawDataPath, ProcessedDataPath, pdferr);
-
-  fout << "CDF:\n";
-  fout << NangaParbat::PreprocessCDFRunI(RawDataPath,  ProcessedDataPath, pdferr);
-  fout << NangaParbat::PreprocessCDFRunII(RawDataPath, ProcessedDataPath, pdferr);
-
-  fout << "D0:\n";
-  fout << NangaParbat::PreprocessD0RunI(RawDataPath,    ProcessedDataPath, pdferr);
-  fout << NangaParbat::PreprocessD0RunII(RawDataPath,   ProcessedDataPath, pdferr);
-  fout << NangaParbat::PreprocessD0RunIImu(RawDataPath, ProcessedDataPath, pdferr);
+  // Preprocessing units in the order in which they appear in the
+  // dataset file
+  const std::vector<FilterUnit> units
+  {
+    {"E605",    "E605",        NangaParbat::PreprocessE605,        "E605",    {"HEPData-ins302822-v1-yaml"},  {"E605"}},
+    {"E288",    "E288",        NangaParbat::PreprocessE288,        "E288",    {"HEPData-ins153009-v1-yaml"},  {"E288"}},
+    //{"PHENIX",  "PHENIX200",   NangaParbat::PreprocessPHENIX200,   "PHENIX",  {"PHENIX_200"},                 {}},
+    {"STAR",    "STAR510",     NangaParbat::PreprocessSTAR510,     "STAR",    {"STAR_510"},                   {}},
+    {"CDF",     "CDFRunI",     NangaParbat::PreprocessCDFRunI,     "CDF",     {"HEPData-ins505738-v1-yaml"},  {"CDF_RunI."}},
+    {"CDF",     "CDFRunII",    NangaParbat::PreprocessCDFRunII,    "CDF",     {"HEPData-ins1124333-v1-yaml"}, {"CDF_RunII."}},
+    {"D0",      "D0RunI",      NangaParbat::PreprocessD0RunI,      "D0",      {"HEPData-ins503361-v1-yaml"},  {"D0_RunI."}},
+    {"D0",      "D0RunII",     NangaParbat::PreprocessD0RunII,     "D0",      {"HEPData-ins769689-v1-yaml"},  {"D0_RunII."}},
+    {"D0",      "D0RunIImu",   NangaParbat::PreprocessD0RunIImu,   "D0",      {"HEPData-ins856972-v1-yaml"},  {"D0_RunIImu."}},
+    {"LHCb",    "LHCb7TeV",    NangaParbat::PreprocessLHCb7TeV,    "LHCb",    {"HEPData-ins1373300-v1-yaml"}, {"LHCb_7TeV."}},
+    {"LHCb",    "LHCb8TeV",    NangaParbat::PreprocessLHCb8TeV,    "LHCb",    {"HEPData-ins1406555-v1-yaml"}, {"LHCb_7TeV."}},
+    {"LHCb",    "LHCb13TeV",   NangaParbat::PreprocessLHCb13TeV,   "LHCb",    {"LHCb_13TeV"},                 {}},
+    {"CMS",     "CMS7TeV",     NangaParbat::PreprocessCMS7TeV,     "CMS",     {"HEPData-ins941555-v1-yaml"},  {"CMS_7TeV."}},
+    {"CMS",     "CMS8TeV",     NangaParbat::PreprocessCMS8TeV,     "CMS",     {"HEPData-ins1471281-v1-yaml"}, {"CMS_8TeV."}},
+    {"ATLAS",   "ATLAS7TeV",   NangaParbat::PreprocessATLAS7TeV,   "ATLAS",   {"HEPData-ins1300647-v1-yaml"}, {"ATLAS_7TeV"}},
+    {"ATLAS",   "ATLAS8TeV",   NangaParbat::PreprocessATLAS8TeV,   "ATLAS",   {"HEPData-ins1408516-v1-yaml"}, {"ATLAS_8TeV"}},
+    {"HERMES",  "HERMES",      NangaParbat::PreprocessHERMES,      "HERMES",  {"HERMES"},                     {"HERMES"}},
+    {"COMPASS", "COMPASS",     NangaParbat::PreprocessCOMPASS,     "COMPASS", {"HEPData-ins1624692-v1-yaml"}, {"COMPASS"}},
+    {"E537",    "E537",        NangaParbat::PreprocessE537,        "E537",    {"HEPData-ins253413-v1-yaml"},  {"E537"}},
+    {"E537",    "E537_xF",     NangaParbat::PreprocessE537_xF,     "E537",    {"HEPData-ins253413-v1-yaml"},  {"E537"}},
+    {"E615",    "E615",        NangaParbat::PreprocessE615,        "E615",    {"E615"},                       {"E615"}},
+    {"E615",    "E615_xF",     NangaParbat::PreprocessE615_xF,     "E615xF",  {"E615"},                       {"E615"}}
+  };
 
-  fout << "LHCb:\n";
-  fout << NangaParbat::PreprocessLHCb7TeV(RawDataPath,  ProcessedDataPath, pdferr);
-  fout << NangaParbat::PreprocessLHCb8TeV(RawDataPath,  ProcessedDataPath, pdferr);
-  fout << NangaParbat::PreprocessLHCb13TeV(RawDataPath, ProcessedDataPath, pdferr);
+  // Executable entering the hash of the inputs
+  const std::string exe = Executable(argv[0]);
 
-  fout << "CMS:\n";
-  fout << NangaParbat::PreprocessCMS7TeV(RawDataPath, ProcessedDataPath, pdferr);
-  fout << NangaParbat::PreprocessCMS8TeV(RawDataPath, ProcessedDataPath, pdferr);
-
-  fout << "ATLAS:\n";
-  fout << NangaParbat::PreprocessATLAS7TeV(RawDataPath, ProcessedDataPath, pdferr);
-  fout << NangaParbat::PreprocessATLAS8TeV(RawDataPath, ProcessedDataPath, pdferr);
+  // Bookkeeping of the previous run: hash of the inputs and list of
+  // datasets of each unit
+  const std::string statefile = ProcessedDataPath + "/.filter.yaml";
+  std::vector<std::string> oldhashes(units.size());
+  std::vector<std::string> oldfragments(units.size());
+  struct stat st;
+  if (!force && stat(statefile.c_str(), &st) == 0)
+    {
+      const YAML::Node state = YAML::LoadFile(statefile);
+      for (int i = 0; i < (int) units.size(); i++)
+        if (state[units[i].name])
+          {
+            oldhashes[i]    = state[units[i].name]["hash"].as<std::string>();
+            oldfragments[i] = state[units[i].name]["datasets"].as<std::string>();
+          }
+    }
 
-  fout << "HERMES:\n";
-  fout << NangaParbat::PreprocessHERMES(RawDataPath, ProcessedDataPath, pdferr);
+  // Run the units concurrently. Each of them either processes its
+  // raw data, or reuses the list of datasets of the previous run if
+  // its inputs have not changed.
+  std::vector<std::string> hashes(units.size());
+  std::vector<std::string> fragments(units.size());
+  NangaParbat::ParallelFor(units.size(), [&] (int const& i) -> void
+  {
+    FilterUnit const& u = units[i];
+    hashes[i] = InputHash(u, RawDataPath, exe, pdferr);
+    if (hashes[i] == oldhashes[i] && OutputsExist(u, oldfragments[i], ProcessedDataPath))
+      {
+        std::cout << "Skipping " << u.name << ": up to date" << std::endl;
+        fragments[i] = oldfragments[i];
+        return;
+      }
 
-  fout << "COMPASS:\n";
-  fout << NangaParbat::PreprocessCOMPASS(RawDataPath, ProcessedDataPath, pdferr);
+    fragments[i] = u.preprocess(RawDataPath, ProcessedDataPath, pdferr);
 
-  fout << "E537:\n";
-  fout << NangaParbat::PreprocessE537(RawDataPath, ProcessedDataPath, pdferr);
-  fout << NangaParbat::PreprocessE537_xF(RawDataPath, ProcessedDataPath, pdferr);
+    // Write the binary caches of the processed datafiles, which allow
+    // the "DataHandler" objects to skip parsing them.
+    bool cached = true;
+    for (auto const& ds : YAML::Load(fragments[i]))
+      {
+        const std::string datafile = ProcessedDataPath + "/" + u.ofolder + "/" + ds["file"].as<std::string>();
+        try
+          {
+            NangaParbat::DataHandler{ds["name"].as<std::string>(), YAML::LoadFile(datafile)}.WriteCache(NangaParbat::DataCacheFile(datafile), datafile);
+          }
+        catch (std::exception const& e)
+          {
+            std::cout << "Cache for " << ds["name"].as<std::string>() << " not written: " << e.what() << std::endl;
+            cached = false;
+          }
+      }
 
-  fout << "E615:\n";
-  fout << NangaParbat::PreprocessE615(RawDataPath, ProcessedDataPath, pdferr);
-  fout << NangaParbat::PreprocessE615_xF(RawDataPath, ProcessedDataPath, pdferr);
+    // A unit is up to date only if all its caches exist (see
+    // "OutputsExist"), therefore it will be processed again.
+    if (!cached)
+      std::cout << "Warning: not all the caches of " << u.name << " have been written, it will be processed again at the next run" << std::endl;
+  });
 
+  // Dataset file assembled in the order of the units
+  std::ofstream fout(ProcessedDataPath + "/datasets.yaml");
+  for (int i = 0; i < (int) units.size(); i++)
+    {
+      if (i == 0 || units[i].experiment != units[i-1].experiment)
+        fout << units[i].experiment << ":\n";
+      fout << fragments[i];
+    }
   fout.close();
 
+  // Save bookkeeping for the next run
+  YAML::Emitter em;
+  em << YAML::BeginMap;
+  for (int i = 0; i < (int) units.size(); i++)
+    em << YAML::Key << units[i].name << YAML::Value << YAML::BeginMap
+       << YAML::Key << "hash" << YAML::Value << hashes[i]
+       << YAML::Key << "datasets" << YAML::Value << YAML::DoubleQuoted << fragments[i]
+       << YAML::EndMap;
+  em << YAML::EndMap;
+  std::ofstream sout(statefile);
+  sout << em.c_str() << std::endl;
+  sout.close();
+
   return 0;
 }
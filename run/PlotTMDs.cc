@@ -5,12 +5,13 @@
 #include "NangaParbat/fastinterface.h"
 #include "NangaParbat/bstar.h"
 #include "NangaParbat/nonpertfunctions.h"
+#include "NangaParbat/tabulatedtmd.h"
+#include "NangaParbat/tmdservice.h"
 
 #include <fstream>
 #include <cstring>
 #include <algorithm>
 #include <apfel/apfelxx.h>
-#include <LHAPDF/LHAPDF.h>
 
 //_________________________________________________________________________________
 int main(int argc, char* argv[])
@@ -32,56 +33,25 @@ int main(int argc, char* argv[])
   // Distribution prefix
   const std::string pf = argv[3];
 
-  // Open LHAPDF set
-  LHAPDF::PDF* dist = LHAPDF::mkPDF(config[pf + "set"]["name"].as<std::string>(), config[pf + "set"]["member"].as<int>());
+  if (pf != "pdf" && pf != "ff")
+    throw std::runtime_error("[PlotTMDs]: Unknown distribution prefix");
+
+  // Set verbosity level of APFEL++ to the minimum
+  apfel::SetVerbosityLevel(0);
 
-  // Rotate sets into the QCD evolution basis
-  const auto RotDists = [&] (double const& x, double const& mu) -> std::map<int,double> { return apfel::PhysToQCDEv(dist->xfxQ(x, mu)); };
+  // Evolved TMD distributions. Each point in b is computed only once
+  // by the tabulation below, therefore the cache is not needed. The
+  // strong coupling is evaluated directly from the LHAPDF set.
+  const NangaParbat::TMDService service{config, {pf}, 0, 1e-7, 100, 0, "own"};
+  const auto EvTMDs = service.GetTMDs(pf);
 
-  // Heavy-quark thresholds
-  std::vector<double> Thresholds;
+  // Heavy-quark thresholds in b
   std::vector<double> bThresholds;
   const double Ci  = config["TMDscales"]["Ci"].as<double>();
-  for (auto const& v : dist->flavors())
-    if (v > 0 && v < 7)
-      {
-        Thresholds.push_back(dist->quarkThreshold(v));
-        bThresholds.push_back(Ci * 2 * exp(- apfel::emc) / dist->quarkThreshold(v));
-      }
+  for (auto const& v : service.GetThresholds())
+    bThresholds.push_back(Ci * 2 * exp(- apfel::emc) / v);
   sort(bThresholds.begin(), bThresholds.end());
 
-  // Set verbosity level of APFEL++ to the minimum
-  apfel::SetVerbosityLevel(0);
-
-  // Define x-space grid
-  std::vector<apfel::SubGrid> vsg;
-  for (auto const& sg : config["xgrid" + pf])
-    vsg.push_back({sg[0].as<int>(), sg[1].as<double>(), sg[2].as<int>()});
-  const apfel::Grid g{vsg};
-
-  // Construct set of distributions as a function of the scale to be
-  // tabulated.
-  const auto EvolvedDists = [=,&g] (double const& mu) -> apfel::Set<apfel::Distribution>
-  {
-    return apfel::Set<apfel::Distribution>{apfel::EvolutionBasisQCD{apfel::NF(mu, Thresholds)}, DistributionMap(g, RotDists, mu)};
-  };
-
-  // Tabulate collinear distributions
-  const apfel::TabulateObject<apfel::Set<apfel::Distribution>> TabDists{EvolvedDists, 100, dist->qMin(), dist->qMax(), 3, Thresholds};
-
-  // Build evolved TMD distributions
-  const int pto = config["PerturbativeOrder"].as<int>();
-  const auto Alphas = [&] (double const& mu) -> double{ return dist->alphasQ(mu); };
-  const auto CollDists = [&] (double const& mu) -> apfel::Set<apfel::Distribution> { return TabDists.Evaluate(mu); };
-
-  std::function<apfel::Set<apfel::Distribution>(double const&, double const&, double const&)> EvTMDs;
-  if (pf == "pdf")
-    EvTMDs = BuildTmdPDFs(apfel::InitializeTmdObjects(g, Thresholds), CollDists, Alphas, pto, Ci);
-  else if (pf == "ff")
-    EvTMDs = BuildTmdFFs(apfel::InitializeTmdObjects(g, Thresholds), CollDists, Alphas, pto, Ci);
-  else
-    throw std::runtime_error("[PlotTMDs]: Unknown distribution prefix");
-
   // b* prescription
   const std::function<double(double const&, double const&)> bs = NangaParbat::bstarMap.at(config["bstar"].as<std::string>());
 
@@ -90,14 +60,10 @@ int main(int argc, char* argv[])
 
   // Final scale
   const double Q = std::stoi(argv[5]);
-  const double Q2 = Q * Q;
 
   // Value of x
   const double x = std::stod(argv[6]);
 
-  // Double exponential quadrature
-  apfel::DoubleExponentialQuadrature DEObj{};
-
   // Values of qT
   const int nqT   = 100;
   const double qTmin = Q * 1e-4;
@@ -122,25 +88,24 @@ int main(int argc, char* argv[])
   const YAML::Node parfile = YAML::LoadFile(argv[7]);
 
   // Get parameterisation and sets of parameters
-  NangaParbat::Parameterisation *NPFunc = NangaParbat::GetParametersation(parfile["Parameterisation"].as<std::string>());
+  const std::unique_ptr<NangaParbat::Parameterisation> NPFunc = NangaParbat::MakeParameterisation(parfile);
   const std::vector<std::vector<double>> pars = parfile["Parameters"].as<std::vector<std::vector<double>>>();
 
   apfel::Timer t;
+
+  // Tabulate the perturbative part of the TMD in bT once for all the
+  // sets of parameters.
+  const NangaParbat::TabulatedTMD TabTMD{EvTMDs, bs, ifl, x, Q, bThresholds};
+
   // Loop over sets of parameters
-  std::vector<std::vector<double>> tmds(pars.size(), std::vector<double>(qTv.size()));
+  std::vector<std::vector<double>> tmds(pars.size());
   for (int ip = 0; ip < (int) pars.size(); ip++)
     {
       // Set vector of parameters
       NPFunc->SetParameters(pars[ip]);
 
-      // bT-space TMD
-      const auto xFb = [&] (double const& bT) -> double { return bT * QCDEvToPhys(EvTMDs(bs(bT, Q), Q, Q2).GetObjects()).at(ifl).Evaluate(x) * NPFunc->Evaluate(x, bT, Q2, (pf == "pdf" ? 0 : 1)); };
-      const apfel::TabulateObject<double> TabxFb{xFb, 300, 0.0001, 10, 3, bThresholds, [] (double const& x)->double{ return log(x); }, [] (double const& x)->double{ return exp(x); }};
-      const std::function<double(double const&)> txFb = [&] (double const& bT) -> double{ return TabxFb.Evaluate(bT); };
-
       // Compute TMDs in qT space
-      for (int iqT = 0; iqT < (int) qTv.size(); iqT++)
-        tmds[ip][iqT] = DEObj.transform(txFb, qTv[iqT]);
+      tmds[ip] = TabTMD.qTSpace(*NPFunc, (pf == "pdf" ? 0 : 1), qTv);
     }
   t.stop();
 
@@ -161,8 +126,5 @@ int main(int argc, char* argv[])
   fout << out.c_str() << std::endl;
   fout.close();
 
-  // Delete LHAPDF set
-  delete dist;
-
   return 0;
 }
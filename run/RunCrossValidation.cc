@@ -0,0 +1,236 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/chisquare.h"
+#include "NangaParbat/minimisation.h"
+#include "NangaParbat/nonpertfunctions.h"
+#include "NangaParbat/crossvalidation.h"
+#include "NangaParbat/parallelfor.h"
+
+#include <apfel/timer.h>
+#include <fstream>
+#include <numeric>
+#include <cmath>
+#include <sys/stat.h>
+#include <cstring>
+
+//_________________________________________________________________________________
+int main(int argc, char* argv[])
+{
+  // Check that the input is correct otherwise stop the code
+  if (argc < 5 || strcmp(argv[1], "--help") == 0)
+    {
+      std::cout << "\nInvalid Parameters:" << std::endl;
+      std::cout << "Syntax: ./RunCrossValidation <output dir> <fit configuration file> <path to data folder> <path to tables folder> [number of threads]\n" << std::endl;
+      exit(-10);
+    }
+
+  // Timer
+  apfel::Timer t;
+
+  // Reading fit  parameters from an input card
+  const YAML::Node fitconfig = YAML::LoadFile(argv[2]);
+
+  // Cross-validation settings
+  const YAML::Node cvconfig = fitconfig["CrossValidation"];
+  if (!cvconfig)
+    throw std::runtime_error("[RunCrossValidation]: the fit configuration file has no 'CrossValidation' node");
+
+  const int    nsplits      = cvconfig["Splits"].as<int>();
+  const bool   kfold        = (cvconfig["KFold"] ? cvconfig["KFold"].as<bool>() : false);
+  const double TrainingFrac = (cvconfig["TrainingFraction"] ? cvconfig["TrainingFraction"].as<double>() : 0.5);
+  const int    NMin         = (cvconfig["NMin"] ? cvconfig["NMin"].as<int>() : 10);
+  const int    seed         = fitconfig["Seed"].as<int>();
+
+  // Number of splits fitted concurrently (0 means as many as the
+  // available cores)
+  const int nthreads = (argc > 5 ? atoi(argv[5]) : 0);
+
+  // Minimiser
+  const std::string minimiser = fitconfig["Minimiser"].as<std::string>();
+  if (minimiser != "none" && minimiser != "minuit" && minimiser != "ceres")
+    throw std::runtime_error("[RunCrossValidation]: Unknown minimiser");
+
+  // Create output folder
+  const std::string OutputFolder = std::string(argv[1]);
+  mkdir(OutputFolder.c_str(), ACCESSPERMS);
+
+  // Parameterisation used for the t0 predictions and to count the
+  // points that pass the qT / Q cut
+  const std::unique_ptr<NangaParbat::Parameterisation> NPFunc = NangaParbat::MakeParameterisation(fitconfig);
+  if (fitconfig["t0prescription"].as<bool>())
+    NPFunc->SetParameters(fitconfig["t0parameters"].as<std::vector<double>>());
+
+  // Read tables and data only once. All the splits are fitted to the
+  // central values.
+  std::vector<std::unique_ptr<NangaParbat::ConvolutionTable>> cts;
+  std::vector<std::unique_ptr<NangaParbat::DataHandler>>      dhs;
+  NangaParbat::ChiSquare chi2{NPFunc.get()};
+  const YAML::Node datasets = YAML::LoadFile(std::string(argv[3]) + "/datasets.yaml");
+  for (auto const& exp : datasets)
+    for (auto const& ds : exp.second)
+      {
+        std::cout << "Reading table for " << ds["name"].as<std::string>() << "..." << std::endl;
+
+        // Convolution table
+        cts.emplace_back(new NangaParbat::ConvolutionTable{YAML::LoadFile(std::string(argv[4]) + "/" + ds["name"].as<std::string>() + ".yaml"),
+                                                           fitconfig["qToQmax"].as<double>()});
+
+        // Datafile
+        dhs.emplace_back(new NangaParbat::DataHandler{ds["name"].as<std::string>(),
+                                                      std::string(argv[3]) + "/" + exp.first.as<std::string>() + "/" + ds["file"].as<std::string>(),
+                                                      nullptr, 0,
+                                                      (fitconfig["t0prescription"].as<bool>() ? cts.back()->GetPredictions(*NPFunc) : std::vector<double>{})});
+
+        chi2.AddBlock(std::make_pair(dhs.back().get(), cts.back().get()));
+      }
+  const int nsets = dhs.size();
+
+  // Generate the training masks of all the splits up front. The
+  // eligible points are those that pass all the cuts, including the
+  // qT / Q one. The validation set of each split is made of the
+  // eligible points that are not used for training.
+  const std::vector<int> ndata = chi2.GetDataPointNumbers();
+  std::vector<std::valarray<bool>> eligible(nsets);
+  std::vector<std::vector<std::valarray<bool>>> training(nsets);
+  for (int i = 0; i < nsets; i++)
+    {
+      eligible[i] = cts[i]->GetCutMask();
+      for (int j = std::max(ndata[i], 0); j < (int) eligible[i].size(); j++)
+        eligible[i][j] = false;
+      training[i] = NangaParbat::GenerateTrainingMasks(eligible[i], nsplits, kfold, TrainingFrac, seed, dhs[i]->GetName(), NMin);
+    }
+
+  // Each split has its own parameterisation, since the minimisers
+  // set the parameters, and its own copy of the parameter settings.
+  std::vector<std::unique_ptr<NangaParbat::Parameterisation>> NPFuncs(nsplits);
+  std::vector<YAML::Node> parameters(nsplits);
+  for (int is = 0; is < nsplits; is++)
+    {
+      NPFuncs[is]    = NangaParbat::MakeParameterisation(fitconfig);
+      parameters[is] = YAML::Clone(fitconfig["Parameters"]);
+    }
+
+  // Report time elapsed
+  t.stop();
+
+  // Fit the splits concurrently
+  t.start();
+  std::vector<double> chi2t(nsplits), chi2v(nsplits);
+  NangaParbat::ParallelFor(nsplits, [&] (int const& is) -> void
+  {
+    // Training and validation chi2's sharing tables, data and
+    // parameterisation
+    NangaParbat::ChiSquare trn{NPFuncs[is].get()};
+    NangaParbat::ChiSquare val{NPFuncs[is].get()};
+    if (!fitconfig["Expression"])
+      {
+        trn.SetPredictionKernel(NangaParbat::GetPredictionKernel(fitconfig["Parameterisation"].as<std::string>()));
+        val.SetPredictionKernel(NangaParbat::GetPredictionKernel(fitconfig["Parameterisation"].as<std::string>()));
+      }
+    for (int i = 0; i < nsets; i++)
+      {
+        trn.AddBlock(std::make_pair(dhs[i].get(), cts[i].get()), training[i][is]);
+        val.AddBlock(std::make_pair(dhs[i].get(), cts[i].get()), eligible[i] && !training[i][is]);
+      }
+
+    // Fit the training set
+    bool status;
+    if (minimiser == "none")
+      status = NoMinimiser(trn, parameters[is]);
+    else if (minimiser == "minuit")
+      status = MinuitMinimiser(trn, parameters[is]);
+    else
+      status = CeresMinimiser(trn, parameters[is]);
+
+    // Training and validation chi2's of each dataset computed from
+    // the same predictions and normalised to the respective number
+    // of points
+    const std::vector<int> nt = trn.GetDataPointNumbersAfterCuts();
+    const std::vector<int> nv = val.GetDataPointNumbersAfterCuts();
+    std::vector<double> sxt(nsets), sxv(nsets);
+    for (int i = 0; i < nsets; i++)
+      {
+        const std::vector<double> pred = trn.GetPredictions(i);
+        const std::vector<double> xt = trn.GetResiduals(i, pred);
+        const std::vector<double> xv = val.GetResiduals(i, pred);
+        sxt[i] = std::inner_product(xt.begin(), xt.end(), xt.begin(), 0.);
+        sxv[i] = std::inner_product(xv.begin(), xv.end(), xv.begin(), 0.);
+      }
+    const int ntt = std::accumulate(nt.begin(), nt.end(), 0);
+    const int nvt = std::accumulate(nv.begin(), nv.end(), 0);
+    chi2t[is] = (ntt == 0 ? 0 : std::accumulate(sxt.begin(), sxt.end(), 0.) / ntt);
+    chi2v[is] = (nvt == 0 ? 0 : std::accumulate(sxv.begin(), sxv.end(), 0.) / nvt);
+
+    // Produce the report of the split: chi2's, validation points,
+    // and the report of the training fit.
+    YAML::Emitter cvout;
+    cvout.SetDoublePrecision(8);
+    cvout << YAML::BeginMap;
+    cvout << YAML::Key << "Status" << YAML::Value << status;
+    cvout << YAML::Key << "Training chi2" << YAML::Value << chi2t[is];
+    cvout << YAML::Key << "Validation chi2" << YAML::Value << chi2v[is];
+    cvout << YAML::Key << "Datasets" << YAML::Value << YAML::BeginSeq;
+    for (int i = 0; i < nsets; i++)
+      {
+        std::vector<int> vpoints;
+        for (int j = 0; j < (int) eligible[i].size(); j++)
+          if (eligible[i][j] && !training[i][is][j])
+            vpoints.push_back(j);
+
+        cvout << YAML::BeginMap;
+        cvout << YAML::Key << "Name" << YAML::Value << dhs[i]->GetName();
+        cvout << YAML::Key << "Training points" << YAML::Value << nt[i];
+        cvout << YAML::Key << "Validation points" << YAML::Value << nv[i];
+        cvout << YAML::Key << "Training chi2" << YAML::Value << (nt[i] == 0 ? 0 : sxt[i] / nt[i]);
+        cvout << YAML::Key << "Validation chi2" << YAML::Value << (nv[i] == 0 ? 0 : sxv[i] / nv[i]);
+        cvout << YAML::Key << "Validation indices" << YAML::Value << YAML::Flow << vpoints;
+        cvout << YAML::EndMap;
+      }
+    cvout << YAML::EndSeq;
+    cvout << YAML::EndMap;
+
+    YAML::Emitter out;
+    out << trn;
+
+    const std::string SplitFolder = OutputFolder + "/split_" + std::to_string(is);
+    mkdir(SplitFolder.c_str(), ACCESSPERMS);
+    std::ofstream rout(SplitFolder + "/Report.yaml");
+    rout << cvout.c_str() << std::endl;
+    rout << out.c_str() << std::endl;
+    rout.close();
+  }, nthreads);
+
+  // Summary of all the splits
+  const double mt = std::accumulate(chi2t.begin(), chi2t.end(), 0.) / nsplits;
+  const double mv = std::accumulate(chi2v.begin(), chi2v.end(), 0.) / nsplits;
+  double sv = 0;
+  for (double const& c : chi2v)
+    sv += ( c - mv ) * ( c - mv );
+  sv = (nsplits > 1 ? sqrt(sv / ( nsplits - 1 )) : 0);
+
+  YAML::Emitter sout;
+  sout.SetDoublePrecision(8);
+  sout << YAML::BeginMap;
+  sout << YAML::Key << "Splits" << YAML::Value << nsplits;
+  sout << YAML::Key << "KFold" << YAML::Value << kfold;
+  if (!kfold)
+    sout << YAML::Key << "Training fraction" << YAML::Value << TrainingFrac;
+  sout << YAML::Key << "Training chi2" << YAML::Value << YAML::Flow << chi2t;
+  sout << YAML::Key << "Validation chi2" << YAML::Value << YAML::Flow << chi2v;
+  sout << YAML::Key << "Mean training chi2" << YAML::Value << mt;
+  sout << YAML::Key << "Mean validation chi2" << YAML::Value << mv;
+  sout << YAML::Key << "Validation chi2 standard deviation" << YAML::Value << sv;
+  sout << YAML::EndMap;
+  std::ofstream fout(OutputFolder + "/CrossValidation.yaml");
+  fout << sout.c_str() << std::endl;
+  fout.close();
+
+  std::cout << "Mean training chi2 = " << mt << ", mean validation chi2 = " << mv << " +/- " << sv << "\n" << std::endl;
+
+  // Report time elapsed
+  t.stop();
+
+  return 0;
+}
@@ -6,6 +6,7 @@
 #include "NangaParbat/minimisation.h"
 #include "NangaParbat/nonpertfunctions.h"
 #include "NangaParbat/meanreplica.h"
+#include "NangaParbat/counterrng.h"
 
 #include <apfel/timer.h>
 #include <algorithm>
@@ -31,7 +32,7 @@ int main(int argc, char* argv[])
   YAML::Node fitconfig = YAML::LoadFile(argv[2]);
 
   // Allocate "Parameterisation" derived object
-  NangaParbat::Parameterisation *NPFunc = NangaParbat::GetParametersation(fitconfig["Parameterisation"].as<std::string>());
+  const std::unique_ptr<NangaParbat::Parameterisation> NPFunc = NangaParbat::MakeParameterisation(fitconfig);
 
   // Initialise GSL random-number generator
   gsl_rng *rng = gsl_rng_alloc(gsl_rng_ranlxs2);
@@ -40,12 +41,33 @@ int main(int argc, char* argv[])
   // Replica ID number
   const int ReplicaID = atoi(argv[5]);
 
+  // Whether the data are fluctuated with counter-based streams that
+  // only depend on the seed, the replica ID, and the dataset name. In
+  // this case the GSL stream is not used for the data, such that it
+  // would be in the same state for all replicas when drawing the
+  // fluctuations of the initial parameters (see "Paramfluct"). It is
+  // therefore seeded per replica.
+  const bool CounterBased = (fitconfig["CounterBasedRNG"] && fitconfig["CounterBasedRNG"].as<bool>());
+  if (CounterBased)
+    gsl_rng_set(rng, NangaParbat::CounterRNG{fitconfig["Seed"].as<int>(), ReplicaID, "Paramfluct"}.Block(0)[0]);
+
+  // Whether the tables keep the factors of separable
+  // parameterisations on their nodes across the calls of the
+  // minimiser and only recompute those that depend on the parameters
+  // that have changed (see "ConvolutionTable::SetIncrementalMode").
+  const bool Incremental = (fitconfig["IncrementalPredictions"] && fitconfig["IncrementalPredictions"].as<bool>());
+
   // Create replica folder
   const std::string OutputFolder = std::string(argv[1]) + "/replica_" + std::string(argv[5]);
   mkdir((OutputFolder).c_str(), ACCESSPERMS);
 
   // Define "ChiSquare" object with a given qT / Q cut
-  NangaParbat::ChiSquare chi2{NPFunc};
+  NangaParbat::ChiSquare chi2{NPFunc.get()};
+
+  // Use the prediction kernel specialised for the parameterisation
+  // (not available for parameterisations defined in the fit card)
+  if (!fitconfig["Expression"])
+    chi2.SetPredictionKernel(NangaParbat::GetPredictionKernel(fitconfig["Parameterisation"].as<std::string>()));
 
   // Set parameters for the t0 predictions using "t0parameters" in the
   // configuration card only if the the t0 has been enabled and the
@@ -66,12 +88,17 @@ int main(int argc, char* argv[])
         NangaParbat::ConvolutionTable* ct = new NangaParbat::ConvolutionTable{YAML::LoadFile(std::string(argv[4]) + "/" + ds["name"].as<std::string>() + ".yaml"),
                                                                               fitconfig["qToQmax"].as<double>()};
         //ct.NumericalAccuracy(NPFunc->Function());
+        ct->SetIncrementalMode(Incremental);
 
         // Datafile
         NangaParbat::DataHandler* dh = new NangaParbat::DataHandler{ds["name"].as<std::string>(),
-                                                                    YAML::LoadFile(std::string(argv[3]) + "/" + exp.first.as<std::string>() + "/" + ds["file"].as<std::string>()),
-                                                                    rng, ReplicaID,
-                                                                    (fitconfig["t0prescription"].as<bool>() ? ct->GetPredictions(NPFunc->Function()) : std::vector<double>{})};
+                                                                    std::string(argv[3]) + "/" + exp.first.as<std::string>() + "/" + ds["file"].as<std::string>(),
+                                                                    (CounterBased ? nullptr : rng), (CounterBased ? 0 : ReplicaID),
+                                                                    (fitconfig["t0prescription"].as<bool>() ? ct->GetPredictions(*NPFunc) : std::vector<double>{})};
+
+        // Counter-based fluctuations
+        if (CounterBased)
+          dh->FluctuateDataCounterBased(fitconfig["Seed"].as<int>(), ReplicaID);
 
         // Add chi2 block
         chi2.AddBlock(std::make_pair(dh, ct));
@@ -102,6 +129,15 @@ int main(int argc, char* argv[])
   std::ofstream rout(OutputFolder + "/Report.yaml");
   rout << "Status: " << status << std::endl;
   rout << out.c_str() << std::endl;
+
+  // Parameterisations defined in the fit card are also needed to read
+  // the report.
+  if (fitconfig["Expression"])
+    {
+      YAML::Emitter exout;
+      exout << YAML::BeginMap << YAML::Key << "Expression" << YAML::Value << fitconfig["Expression"] << YAML::EndMap;
+      rout << exout.c_str() << std::endl;
+    }
   rout.close();
 
   // Produce plots and modify fitconfig.yaml to dump into the output
@@ -121,9 +157,6 @@ int main(int argc, char* argv[])
   // Delete random-number generator
   gsl_rng_free(rng);
 
-  // Delete "Parameterisation" object
-  delete NPFunc;
-
   // Report time elapsed
   t.stop();
 
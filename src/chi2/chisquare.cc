@@ -6,6 +6,7 @@
 #include "NangaParbat/linearsystems.h"
 
 #include <numeric>
+#include <algorithm>
 #include <math.h>
 #include <sys/stat.h>
 #include <fstream>
@@ -36,14 +37,23 @@ namespace NangaParbat
   //_________________________________________________________________________________
   void ChiSquare::AddBlock(std::pair<DataHandler*, ConvolutionTable*> DSBlock)
   {
+    AddBlock(DSBlock, DSBlock.second->GetCutMask());
+  }
+
+  //_________________________________________________________________________________
+  void ChiSquare::AddBlock(std::pair<DataHandler*, ConvolutionTable*> DSBlock, std::valarray<bool> const& mask)
+  {
+    if (mask.size() != DSBlock.second->GetCutMask().size())
+      throw std::runtime_error("[ChiSquare::AddBlock]: mismatch in the size of the mask");
+
     // Push "DataHandler-ConvolutionTable" back
     _DSVect.push_back(DSBlock);
 
     // Determine number of data points that pass the cut qT / Q.
-    const DataHandler::Kinematics kin     = DSBlock.first->GetKinematics();
-    const double                  qToQMax = DSBlock.second->GetCutqToverQ();
-    const std::vector<double>     qTv     = kin.qTv;
-    const double                  Qmin    = (kin.Intv1 ? kin.var1b.first : ( kin.var1b.first + kin.var1b.second ) / 2);
+    DataHandler::Kinematics const& kin     = DSBlock.first->GetKinematics();
+    const double                   qToQMax = DSBlock.second->GetCutqToverQ();
+    std::vector<double> const&     qTv     = kin.qTv;
+    const double                   Qmin    = (kin.Intv1 ? kin.var1b.first : ( kin.var1b.first + kin.var1b.second ) / 2);
 
     // Run over the qTv vector, count how many data points pass
     // the cut and push the number into the "_ndata" vector.
@@ -55,162 +65,346 @@ namespace NangaParbat
     _ndata.push_back(idata - (kin.IntqT ? 1 : 0));
 
     // Data the pass all the cuts
-    const std::valarray<bool> cm = DSBlock.second->GetCutMask();
+    const std::valarray<bool> cm = DSBlock.second->GetCutMask() && mask;
     _ndatac.push_back(std::count(std::begin(cm), std::end(cm), true));
+
+    // Parameters that affect at least one of the functions entering
+    // the predictions of this block.
+    const std::vector<int> funcs = DSBlock.second->GetFunctionIndices();
+    std::vector<int> deppars;
+    for (int ipar = 0; ipar < _NPFunc->GetParameterNumber(); ipar++)
+      for (int ifunc : _NPFunc->GetParameterDependencies(ipar))
+        if (std::find(funcs.begin(), funcs.end(), ifunc) != funcs.end())
+          {
+            deppars.push_back(ipar);
+            break;
+          }
+    _deppars.push_back(deppars);
+
+    // Empty cache
+    _cpred.push_back({});
+    _cpars.push_back({});
+
+    // Nuisance-parameter system for the points that pass the qT / Q
+    // cut. Multiplicative uncertainties are rescaled by the t0
+    // predictions, if present.
+    const int nd = std::max(_ndata.back(), 0);
+    std::vector<double> const& mean = DSBlock.first->GetMeanValues();
+    std::vector<double> const& uncu = DSBlock.first->GetUncorrelatedUnc();
+    std::vector<double> const& t0   = DSBlock.first->GetT0();
+    std::vector<std::vector<double>> const& corra = DSBlock.first->GetAddCorrelatedUnc();
+    std::vector<std::vector<double>> const& corrm = DSBlock.first->GetMultCorrelatedUnc();
+    NuisanceSystem ns;
+    ns.nsys = (mean.empty() ? 0 : corra[0].size() + corrm[0].size());
+    ns.B.resize(nd * ns.nsys);
+    for (int j = 0; j < nd; j++)
+      {
+        double* Bj = ns.B.data() + j * ns.nsys;
+        for (auto const& a : corra[j])
+          *Bj++ = a * mean[j] / uncu[j];
+        for (auto const& m : corrm[j])
+          *Bj++ = m * (t0.empty() ? mean[j] : t0[j]) / uncu[j];
+      }
+
+    // Construct and factorise A = 1 + B^T * B
+    if (ns.nsys > 0)
+      {
+        apfel::matrix<double> A;
+        A.resize(ns.nsys, ns.nsys, 0.);
+        for (int alpha = 0; alpha < ns.nsys; alpha++)
+          {
+            A(alpha, alpha) = 1;
+            for (int j = 0; j < nd; j++)
+              {
+                double const* Bj = ns.B.data() + j * ns.nsys;
+                for (int beta = 0; beta < ns.nsys; beta++)
+                  A(alpha, beta) += Bj[alpha] * Bj[beta];
+              }
+          }
+        ns.L = CholeskyDecomposition(A);
+      }
+    _nuis.push_back(ns);
+
+    // Indices of the active points and experimental values arranged
+    // such that the residuals are b - t (see "MaskedData").
+    std::vector<double> const& fluc = DSBlock.first->GetFluctutatedData();
+    MaskedData md;
+    md.bfluc.resize(nd);
+    md.bcntr.resize(nd);
+    for (int j = 0; j < nd; j++)
+      if (cm[j])
+        {
+          md.active.push_back(j);
+          md.bfluc[j] = fluc[j];
+          md.bcntr[j] = mean[j];
+        }
+      else
+        {
+          md.bfluc[j] = fluc[j] - mean[j];
+          md.bcntr[j] = 0;
+        }
+    _masked.push_back(md);
   };
 
   //_________________________________________________________________________________
-  std::vector<double> ChiSquare::GetResiduals(int const& ids, bool const& central) const
+  void ChiSquare::ClearPredictionCache() const
+  {
+    for (int ids = 0; ids < (int) _DSVect.size(); ids++)
+      {
+        _cpred[ids].clear();
+        _cpars[ids].clear();
+      }
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> ChiSquare::GetPredictions(int const& ids) const
   {
     if (ids < 0 || ids >= (int) _DSVect.size())
-      throw std::runtime_error("[ChiSquare::GetResiduals]: index out of range");
+      throw std::runtime_error("[ChiSquare::GetPredictions]: index out of range");
 
-    // Get "DataHandler" and "ConvolutionTable" objects
-    DataHandler      *dh = _DSVect[ids].first;
-    ConvolutionTable *ct = _DSVect[ids].second;
+    // Use the cached predictions if none of the relevant parameters
+    // has changed.
+    const std::vector<double> pars = _NPFunc->GetParameters();
+    bool cached = (!_cpred[ids].empty() && _cpars[ids].size() == pars.size());
+    for (int i = 0; cached && i < (int) _deppars[ids].size(); i++)
+      cached = (_cpars[ids][_deppars[ids][i]] == pars[_deppars[ids][i]]);
 
-    // Get experimental values
-    const std::vector<double> cntr = dh->GetMeanValues();
-    std::vector<double> mean;
-    if (central)
-      mean = cntr;
-    else
-      mean = dh->GetFluctutatedData();
+    if (!cached)
+      {
+        ConvolutionTable const& ct = *_DSVect[ids].second;
+        _cpred[ids] = (_kernel ? _kernel(ct, *_NPFunc) : ct.GetPredictions(*_NPFunc));
+        _cpars[ids] = pars;
+      }
+    return _cpred[ids];
+  }
 
-    // Get predictions
-    const std::vector<double> pred = ct->GetPredictions(_NPFunc->Function());
+  //_________________________________________________________________________________
+  std::vector<double> ChiSquare::GetResiduals(int const& ids, bool const& central) const
+  {
+    return GetResiduals(ids, GetPredictions(ids), central);
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> ChiSquare::GetResiduals(int const& ids, std::vector<double> const& pred, bool const& central) const
+  {
+    if (ids < 0 || ids >= (int) _DSVect.size())
+      throw std::runtime_error("[ChiSquare::GetResiduals]: index out of range");
+
+    // Get "DataHandler" object
+    DataHandler *dh = _DSVect[ids].first;
 
     // Check that the number of points in the DataHandler and
     // Convolution table objects is the same.
-    if (mean.size() != pred.size())
+    if (dh->GetMeanValues().size() != pred.size())
       throw std::runtime_error("[ChiSquare::GetResiduals]: mismatch in the number of points");
 
-    // Get cut mask
-    const std::valarray<bool> cm = ct->GetCutMask();
+    // Compute residuals subtracting the predictions only for the
+    // points that pass the cuts.
+    MaskedData const& md = _masked[ids];
+    std::vector<double> res = (central ? md.bcntr : md.bfluc);
+    for (int const& j : md.active)
+      res[j] -= pred[j];
 
-    // Compute residuals only for the points that pass the cuts, set
-    // the others to zero.
-    std::vector<double> res(_ndata[ids], 0.);
-    for (int j = 0; j < _ndata[ids]; j++)
-      res[j] = mean[j] - (cm[j] ? pred[j] : cntr[j]);
+    // Solve lower-diagonal system and return the result. Use the
+    // low-rank decomposition of the covariance matrix if available.
+    if (dh->HasLowRankCovariance())
+      return SolveLowerSystem(dh->GetLowRankCholeskyDecomposition(), res);
 
-    // Solve lower-diagonal system and return the result
     return SolveLowerSystem(dh->GetCholeskyDecomposition(), res);
   }
 
+  //_________________________________________________________________________________
+  std::vector<std::vector<double>> ChiSquare::GetResiduals(int const& ids, std::vector<std::vector<double>> const& preds, bool const& central) const
+  {
+    if (ids < 0 || ids >= (int) _DSVect.size())
+      throw std::runtime_error("[ChiSquare::GetResiduals]: index out of range");
+
+    // Get "DataHandler" object
+    DataHandler *dh = _DSVect[ids].first;
+
+    // Check that the number of points in the DataHandler and
+    // Convolution table objects is the same.
+    const int nset = preds.size();
+    for (int is = 0; is < nset; is++)
+      if (dh->GetMeanValues().size() != preds[is].size())
+        throw std::runtime_error("[ChiSquare::GetResiduals]: mismatch in the number of points");
+
+    // Collect the residuals of all sets of predictions as the columns
+    // of a (ndata x nset) matrix and solve the lower-diagonal system
+    // for all of them at once.
+    MaskedData const& md = _masked[ids];
+    std::vector<double> const& b = (central ? md.bcntr : md.bfluc);
+    const int nd = b.size();
+    std::vector<double> R(nd * nset);
+    for (int j = 0; j < nd; j++)
+      std::fill(R.begin() + j * nset, R.begin() + ( j + 1 ) * nset, b[j]);
+    for (int const& j : md.active)
+      for (int is = 0; is < nset; is++)
+        R[j * nset + is] -= preds[is][j];
+
+    if (dh->HasLowRankCovariance())
+      SolveLowerSystem(dh->GetLowRankCholeskyDecomposition(), nd, nset, R.data());
+    else
+      SolveLowerSystem(dh->GetCholeskyDecomposition(), nd, nset, R.data());
+
+    std::vector<std::vector<double>> res(nset, std::vector<double>(nd));
+    for (int j = 0; j < nd; j++)
+      for (int is = 0; is < nset; is++)
+        res[is][j] = R[j * nset + is];
+
+    return res;
+  }
+
   //_________________________________________________________________________________
   std::vector<double> ChiSquare::GetResidualDerivatives(int const& ids, int const& ipar) const
   {
     if (ids < 0 || ids >= (int) _DSVect.size())
       throw std::runtime_error("[ChiSquare::GetResidualDerivatives]: index out of range");
 
+    if (ipar < 0 || ipar >= _NPFunc->GetParameterNumber())
+      throw std::runtime_error("[ChiSquare::GetResidualDerivatives]: parameter index out of range");
+
     // Get "DataHandler" and "ConvolutionTable" objects
     DataHandler      *dh = _DSVect[ids].first;
     ConvolutionTable *ct = _DSVect[ids].second;
 
-    // Get (fluctuated) experimental central values
-    const std::vector<double> mean = dh->GetFluctutatedData();
-
-    // Get predictions
-    auto const dNP = [&] (double const& x, double const& b, double const& zeta, int const& ifun) -> double{ return _NPFunc->Derive(x, b, zeta, ifun, ipar); };
-    const std::vector<double> dpred = ct->GetPredictions(_NPFunc->Function(), dNP);
+    // The derivatives of the predictions come w.r.t. all parameters
+    // in one go, but only the system of the ipar-th one is solved.
+    const std::vector<double> dpred = ct->GetPredictionDerivatives(*_NPFunc)[ipar];
 
     // Check that the number of points in the DataHandler and
     // Convolution table objects is the same.
-    if (mean.size() != dpred.size())
+    if (dh->GetMeanValues().size() != dpred.size())
       throw std::runtime_error("[ChiSquare::GetResidualDerivatives]: mismatch in the number of points");
 
-    // Get cut mask
-    const std::valarray<bool> cm = ct->GetCutMask();
+    // Derivatives of the residuals of the points that pass the cuts,
+    // the others being zero.
+    MaskedData const& md = _masked[ids];
+    std::vector<double> dres(md.bfluc.size(), 0.);
+    for (int const& j : md.active)
+      dres[j] = - dpred[j];
 
-    // Compute residuals only for the points that pass the cuts, set
-    // the others to zero.
-    std::vector<double> res(_ndata[ids], 0.);
-    for (int j = 0; j < _ndata[ids]; j++)
-      res[j] = (cm[j] ? - dpred[j] : 0);
+    // Use the low-rank decomposition of the covariance matrix if
+    // available.
+    if (dh->HasLowRankCovariance())
+      return SolveLowerSystem(dh->GetLowRankCholeskyDecomposition(), dres);
 
-    // Solve lower-diagonal system and return the result
-    return SolveLowerSystem(dh->GetCholeskyDecomposition(), res);
+    return SolveLowerSystem(dh->GetCholeskyDecomposition(), dres);
   }
 
   //_________________________________________________________________________________
-  std::pair<std::vector<double>, double> ChiSquare::GetSystematicShifts(int const& ids) const
+  std::vector<std::vector<double>> ChiSquare::GetResidualDerivatives(int const& ids) const
   {
     if (ids < 0 || ids >= (int) _DSVect.size())
-      throw std::runtime_error("[ChiSquare::GetResiduals]: index out of range");
-
-    // Number of data points
-    const int nd = _ndata[ids];
+      throw std::runtime_error("[ChiSquare::GetResidualDerivatives]: index out of range");
 
     // Get "DataHandler" and "ConvolutionTable" objects
     DataHandler      *dh = _DSVect[ids].first;
     ConvolutionTable *ct = _DSVect[ids].second;
 
-    // Get experimental central values, uncorrelated and correlated
-    // uncertainties. Rescale the multiplicative correlation if the t0
-    // prescription is being used.
-    const std::vector<double> fluc = dh->GetFluctutatedData();
-    const std::vector<double> mean = dh->GetMeanValues();
-    const std::vector<double> uncu = dh->GetUncorrelatedUnc();
-    const std::vector<double> t0   = dh->GetT0();
-    const std::vector<std::vector<double>> corra = dh->GetAddCorrelatedUnc();
-    const std::vector<std::vector<double>> corrm = dh->GetMultCorrelatedUnc();
-    std::vector<std::vector<double>> corr(mean.size());
+    // Get the derivatives of the predictions w.r.t. all parameters in
+    // one go.
+    const std::vector<std::vector<double>> dpred = ct->GetPredictionDerivatives(*_NPFunc);
+
+    // Check that the number of points in the DataHandler and
+    // Convolution table objects is the same.
+    const int npar = dpred.size();
+    for (int ipar = 0; ipar < npar; ipar++)
+      if (dh->GetMeanValues().size() != dpred[ipar].size())
+        throw std::runtime_error("[ChiSquare::GetResidualDerivatives]: mismatch in the number of points");
+
+    // Collect the derivatives of the residuals of the points that
+    // pass the cuts, the others being zero, as the columns of a
+    // (ndata x npar) matrix, and solve the lower-diagonal system for
+    // all of them at once.
+    MaskedData const& md = _masked[ids];
+    const int nd = md.bfluc.size();
+    std::vector<double> J(nd * npar, 0.);
+    for (int const& j : md.active)
+      for (int ipar = 0; ipar < npar; ipar++)
+        J[j * npar + ipar] = - dpred[ipar][j];
+
+    // Use the low-rank decomposition of the covariance matrix if
+    // available.
+    if (dh->HasLowRankCovariance())
+      SolveLowerSystem(dh->GetLowRankCholeskyDecomposition(), nd, npar, J.data());
+    else
+      SolveLowerSystem(dh->GetCholeskyDecomposition(), nd, npar, J.data());
+
+    std::vector<std::vector<double>> dres(npar, std::vector<double>(nd));
     for (int j = 0; j < nd; j++)
-      {
-        std::vector<double> c = corra[j];
-        double t0fact = 1;
-        if (!t0.empty())
-          t0fact = t0[j] / mean[j];
-        for (auto const m : corrm[j])
-          c.push_back(t0fact * m);
-        corr[j] = c;
-      }
+      for (int ipar = 0; ipar < npar; ipar++)
+        dres[ipar][j] = J[j * npar + ipar];
 
-    // Get predictions
-    const std::vector<double> pred = ct->GetPredictions(_NPFunc->Function());
+    return dres;
+  }
 
-    // Get cut mask
-    const std::valarray<bool> cm = ct->GetCutMask();
+  //_________________________________________________________________________________
+  std::pair<std::vector<double>, double> ChiSquare::GetSystematicShifts(int const& ids) const
+  {
+    return GetSystematicShifts(ids, GetPredictions(ids));
+  }
 
-    // Compute residuals only for the points that pass the cuts, set
-    // the others to zero.
-    std::vector<double> res(mean.size(), 0.);
-    for (int j = 0; j < nd; j++)
-      res[j] = fluc[j] - (cm[j] ? pred[j] : mean[j]);
+  //_________________________________________________________________________________
+  std::pair<std::vector<double>, double> ChiSquare::GetSystematicShifts(int const& ids, std::vector<double> const& pred) const
+  {
+    if (ids < 0 || ids >= (int) _DSVect.size())
+      throw std::runtime_error("[ChiSquare::GetSystematicShifts]: index out of range");
+
+    // Number of data points
+    const int nd = _ndata[ids];
+
+    // Get "DataHandler" object
+    DataHandler *dh = _DSVect[ids].first;
 
-    // Construct matrix A and vector rho
-    const int nsys = corr[0].size();
-    apfel::matrix<double> A;
-    A.resize(nsys, nsys, 0.);
+    // Get experimental central values and uncorrelated uncertainties
+    std::vector<double> const& mean = dh->GetMeanValues();
+    std::vector<double> const& uncu = dh->GetUncorrelatedUnc();
+
+    // Check that the number of points in the DataHandler and
+    // Convolution table objects is the same.
+    if (mean.size() != pred.size())
+      throw std::runtime_error("[ChiSquare::GetSystematicShifts]: mismatch in the number of points");
+
+    // Nuisance-parameter system of this dataset
+    NuisanceSystem const& ns = _nuis[ids];
+    const int nsys = ns.nsys;
+
+    // Residuals subtracting the predictions only for the points that
+    // pass the cuts.
+    MaskedData const& md = _masked[ids];
+    std::vector<double> res = md.bfluc;
+    for (int const& j : md.active)
+      res[j] -= pred[j];
+
+    // Compute rho = B^T * r, with r the residuals divided by the
+    // uncorrelated uncertainties.
     std::vector<double> rho(nsys, 0.);
-    for(int alpha = 0; alpha < nsys; alpha++)
+    for (int j = 0; j < nd; j++)
       {
-        for(int j = 0; j < nd; j++)
-          rho[alpha] += res[j] * corr[j][alpha] * mean[j] / pow(uncu[j], 2);
-
-        A(alpha, alpha) = 1;
-        for(int beta = 0; beta < nsys; beta++)
-          for(int j = 0; j < nd; j++)
-            A(alpha, beta) += corr[j][alpha] * corr[j][beta] * pow(mean[j], 2) / pow(uncu[j], 2);
+        const double r = res[j] / uncu[j];
+        double const* Bj = ns.B.data() + j * nsys;
+        for (int alpha = 0; alpha < nsys; alpha++)
+          rho[alpha] += Bj[alpha] * r;
       }
 
-    // Solve A * lambda = rho to obtain the nuisance parameters
-    const std::vector<double> lambda = SolveSymmetricSystem(A, rho);
+    // Solve A * lambda = rho to obtain the nuisance parameters using
+    // the precomputed decomposition of A.
+    const std::vector<double> lambda = (nsys > 0 ? SolveCholeskySystem(ns.L, rho) : rho);
 
     // Compute systematic shifs
     std::vector<double> shifts(mean.size(), 0.);
     for (int j = 0; j < nd; j++)
-      for(int alpha = 0; alpha < nsys; alpha++)
-        shifts[j] += lambda[alpha] * corr[j][alpha] * mean[j];
+      {
+        double const* Bj = ns.B.data() + j * nsys;
+        for (int alpha = 0; alpha < nsys; alpha++)
+          shifts[j] += lambda[alpha] * Bj[alpha];
+        shifts[j] *= uncu[j];
+      }
 
     // Compute penalty
-    double penalty = 0;
-    for(int alpha = 0; alpha < nsys; alpha++)
-      penalty += pow(lambda[alpha], 2);
+    const double penalty = std::inner_product(lambda.begin(), lambda.end(), lambda.begin(), 0.);
 
-    // Solve A * lambda = rho to obtain the nuisance parameters lambda
-    // and return the result.
     return std::make_pair(shifts, penalty);
   }
 
@@ -263,28 +457,25 @@ namespace NangaParbat
     for (int i = 0; i < nsets; i++)
       vx[i] = GetResiduals(i);
 
-    // Loop over parameters
-    for (int ipar = 0; ipar < npars; ipar++)
+    // Loop over the the blocks and get the derivatives of the
+    // residuals w.r.t. all parameters at once to construct the
+    // derivative of the chi2.
+    int ntot = 0;
+    for (int i = 0; i < nsets; i++)
       {
-        // Initialise chi2 and number of data points
-        double dchi2 = 0;
-        int ntot = 0;
+        const std::vector<std::vector<double>> dx = GetResidualDerivatives(i);
+        for (int ipar = 0; ipar < npars; ipar++)
+          for (int j = 0; j < (int) dx[ipar].size(); j++)
+            ders[ipar] += 2 * vx[i][j] * dx[ipar][j];
 
-        // Loop over the the blocks
-        for (int i = 0; i < nsets; i++)
-          {
-            // Get residuals and its derivatives to construct the
-            // derivative of the chi2.
-            const std::vector<double> dx = GetResidualDerivatives(i, ipar);
+        // Increment number of points
+        ntot += _ndata[i];
+      }
 
-            for (int j = 0; j < (int) dx.size(); j++)
-              dchi2 += 2 * vx[i][j] * dx[j];
+    // Normalise to the number of data points
+    for (int ipar = 0; ipar < npars; ipar++)
+      ders[ipar] /= ntot;
 
-            // Increment number of points
-            ntot += _ndata[i];
-          }
-        ders[ipar] = dchi2 / ntot;
-      }
     return ders;
   }
 
@@ -293,9 +484,32 @@ namespace NangaParbat
   {
     os.SetFloatPrecision(8);
     os.SetDoublePrecision(8);
+
+    // Compute the predictions of each dataset only once and use them
+    // for the partial and global error functions and chi2's.
+    const int nsets = chi2._DSVect.size();
+    std::vector<std::vector<double>> preds(nsets);
+    std::vector<double> errf(nsets), chi2s(nsets);
+    double errftot = 0;
+    double chi2tot = 0;
+    int    ntot    = 0;
+    for (int i = 0; i < nsets; i++)
+      {
+        preds[i] = chi2.GetPredictions(i);
+        const std::vector<double> x  = chi2.GetResiduals(i, preds[i]);
+        const std::vector<double> xc = chi2.GetResiduals(i, preds[i], true);
+        const double sx  = std::inner_product(x.begin(), x.end(), x.begin(), 0.);
+        const double sxc = std::inner_product(xc.begin(), xc.end(), xc.begin(), 0.);
+        errf[i]  = (chi2._ndata[i] == 0 ? 0 : sx / chi2._ndata[i]);
+        chi2s[i] = (chi2._ndata[i] == 0 ? 0 : sxc / chi2._ndata[i]);
+        errftot += sx;
+        chi2tot += sxc;
+        ntot    += chi2._ndata[i];
+      }
+
     os << YAML::BeginMap;
-    os << YAML::Key << "Global error function" << YAML::Value << chi2.Evaluate();
-    os << YAML::Key << "Global chi2" << YAML::Value << chi2.Evaluate(-1, true);
+    os << YAML::Key << "Global error function" << YAML::Value << (ntot == 0 ? 0 : errftot / ntot);
+    os << YAML::Key << "Global chi2" << YAML::Value << (ntot == 0 ? 0 : chi2tot / ntot);
     os << YAML::Key << "Parameterisation" << YAML::Value << chi2._NPFunc->GetName();
     os << YAML::Key << "Non-perturbative function" << YAML::Value << chi2.GetNonPerturbativeFunction()->LatexFormula();
 
@@ -307,38 +521,41 @@ namespace NangaParbat
 
     // Loop over the blocks
     os << YAML::Key << "Experiments" << YAML::Value << YAML::BeginSeq;
-    for (int i = 0; i < (int) chi2._DSVect.size(); i++)
+    for (int i = 0; i < nsets; i++)
       {
         // Number of data points
         const int nd = chi2._ndata[i];
 
-        // Get "DataHandler" and "ConvolutionTable" objects
-        DataHandler      * dh = chi2._DSVect[i].first;
-        ConvolutionTable * ct = chi2._DSVect[i].second;
+        // Get "DataHandler" object
+        DataHandler* dh = chi2._DSVect[i].first;
 
-        // Get predictions
-        const std::vector<double> pred = ct->GetPredictions(chi2._NPFunc->Function());
+        // Predictions
+        const std::vector<double>& pred = preds[i];
 
         // Get systematic shifts and associated penalty
-        const std::pair<std::vector<double>, double> sp = chi2.GetSystematicShifts(i);
+        const std::pair<std::vector<double>, double> sp = chi2.GetSystematicShifts(i, pred);
         const std::vector<double> shifts = sp.first;
 
         // Get experimental central values and uncorrelated
         // uncertainties.
-        const std::vector<double> mean = dh->GetMeanValues();
-        const std::vector<double> fluc = dh->GetFluctutatedData();
-        const std::vector<double> uncu = dh->GetUncorrelatedUnc();
-
-        // Compute chi2 starting from the penalty
+        std::vector<double> const& mean = dh->GetMeanValues();
+        std::vector<double> const& fluc = dh->GetFluctutatedData();
+        std::vector<double> const& uncu = dh->GetUncorrelatedUnc();
+
+        // Compute chi2 starting from the penalty. Predictions are
+        // subtracted only for the points that pass the cuts.
+        std::vector<double> res = chi2._masked[i].bfluc;
+        for (int const& j : chi2._masked[i].active)
+          res[j] -= pred[j];
         double chi2n = sp.second;
         for(int j = 0; j < nd; j++)
-          chi2n += pow( ( fluc[j] - pred[j] - shifts[j] ) / uncu[j], 2);
+          chi2n += pow( ( res[j] - shifts[j] ) / uncu[j], 2);
         chi2n /= nd;
 
         // Make sure that the chi2 computed in terms of the nuisance
         // parameters agrees with that computed using the covariance
         // matrix.
-        const double chi2c = chi2.Evaluate(i);
+        const double chi2c = errf[i];
         if (std::abs(( chi2c - chi2n ) / chi2c) > 1e-5)
           throw std::runtime_error("[ChiSquare::operator<<]: chi2 reconstruction failed");
 
@@ -359,7 +576,7 @@ namespace NangaParbat
         os << YAML::Key << "xlabelpy" << YAML::Value << labels.at("xlabelpy");
         os << YAML::Key << "ylabelpy" << YAML::Value << labels.at("ylabelpy");
         os << YAML::Key << "partial error function" << YAML::Value << chi2c;
-        os << YAML::Key << "partial chi2" << YAML::Value << chi2.Evaluate(i, true);
+        os << YAML::Key << "partial chi2" << YAML::Value << chi2s[i];
         os << YAML::Key << "penalty chi2" << YAML::Value << sp.second / nd;
         os << YAML::Key << "qT" << YAML::Value << YAML::Flow << YAML::BeginSeq;
         for (int j = 0; j < nd; j++)
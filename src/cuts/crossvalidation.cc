@@ -0,0 +1,83 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/crossvalidation.h"
+#include "NangaParbat/counterrng.h"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace NangaParbat
+{
+  namespace
+  {
+    //_________________________________________________________________________________
+    std::vector<int> Shuffle(std::vector<int> v, CounterRNG const& rng)
+    {
+      // Fisher-Yates shuffle with the i-th swap driven by the i-th
+      // number of the stream
+      for (int i = (int) v.size() - 1; i > 0; i--)
+        std::swap(v[i], v[std::min((int) ( rng.Uniform(i) * ( i + 1 ) ), i)]);
+      return v;
+    }
+  }
+
+  //_________________________________________________________________________________
+  std::vector<std::valarray<bool>> GenerateTrainingMasks(std::valarray<bool> const& mask,
+                                                         int                 const& nsplits,
+                                                         bool                const& kfold,
+                                                         double              const& TrainingFrac,
+                                                         int                 const& seed,
+                                                         std::string         const& name,
+                                                         int                 const& NMin)
+  {
+    if (nsplits < 1)
+      throw std::runtime_error("[GenerateTrainingMasks]: the number of splits must be positive.");
+
+    if (!kfold && (TrainingFrac <= 0 || TrainingFrac > 1))
+      throw std::runtime_error("[GenerateTrainingMasks]: the training fraction must be in (0, 1].");
+
+    // Indices of the eligible points
+    std::vector<int> eligible;
+    for (int j = 0; j < (int) mask.size(); j++)
+      if (mask[j])
+        eligible.push_back(j);
+
+    // All the eligible points are used for training if they are too
+    // few.
+    std::vector<std::valarray<bool>> masks(nsplits, mask);
+    const int n = eligible.size();
+    if (n <= NMin)
+      return masks;
+
+    // The key of the streams is salted, such that they are
+    // independent of those used to fluctuate the data of the same
+    // dataset (see "DataHandler::FluctuateDataCounterBased").
+    const std::string key = name + "/cv";
+    if (kfold)
+      {
+        // The i-th fold is made of the points that occupy the
+        // positions i, i + nsplits, i + 2 nsplits, ... in one random
+        // permutation.
+        const std::vector<int> perm = Shuffle(eligible, CounterRNG{seed, 0, key});
+        for (int k = 0; k < n; k++)
+          masks[k % nsplits][perm[k]] = false;
+      }
+    else
+      {
+        // The points that occupy the first positions in an
+        // independent random permutation per split are used for
+        // validation, in the same number as in "TrainingCut".
+        const int nval = floor(n * ( 1 - TrainingFrac ));
+        for (int is = 0; is < nsplits; is++)
+          {
+            const std::vector<int> perm = Shuffle(eligible, CounterRNG{seed, is, key});
+            for (int k = 0; k < nval; k++)
+              masks[is][perm[k]] = false;
+          }
+      }
+    return masks;
+  }
+}
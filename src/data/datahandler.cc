@@ -5,15 +5,113 @@
 
 #include "NangaParbat/datahandler.h"
 #include "NangaParbat/linearsystems.h"
+#include "NangaParbat/counterrng.h"
+#include "NangaParbat/parallelfor.h"
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <math.h>
 #include <numeric>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <gsl/gsl_randist.h>
 
 namespace NangaParbat
 {
+  namespace
+  {
+    // Magic string of the binary cache of the datafiles
+    const char DataCacheMagic[] = "NPDATA03";
+
+    // Size in bytes of the header of the cache: magic string and
+    // stamp of the datafile (see "SourceStamp").
+    const std::size_t DataCacheHeaderSize = 8 + 3 * sizeof(int64_t);
+
+    //_________________________________________________________________________________
+    // Size and modification time (with nanoseconds) of the datafile,
+    // stored in the cache to make sure that it is only used for the
+    // datafile it was written from. An empty vector is returned if the
+    // datafile cannot be accessed.
+    std::vector<int64_t> SourceStamp(std::string const& datafile)
+    {
+      struct stat st;
+      if (stat(datafile.c_str(), &st) != 0)
+        return {};
+      return {(int64_t) st.st_size, (int64_t) st.st_mtim.tv_sec, (int64_t) st.st_mtim.tv_nsec};
+    }
+
+    //_________________________________________________________________________________
+    template<typename T>
+    void Put(std::string& buf, T const& v)
+    {
+      buf.append(reinterpret_cast<char const*>(&v), sizeof(T));
+    }
+
+    //_________________________________________________________________________________
+    void PutString(std::string& buf, std::string const& s)
+    {
+      Put<int64_t>(buf, s.size());
+      buf.append(s);
+    }
+
+    //_________________________________________________________________________________
+    void PutVector(std::string& buf, std::vector<double> const& v)
+    {
+      Put<int64_t>(buf, v.size());
+      buf.append(reinterpret_cast<char const*>(v.data()), v.size() * sizeof(double));
+    }
+
+    /**
+     * @brief Sequential reader of a memory buffer that throws if the
+     * end of the buffer is reached prematurely.
+     */
+    struct CacheReader
+    {
+      char const* p;
+      char const* end;
+
+      void Check(std::size_t const& n) const
+      {
+        if (n > (std::size_t) ( end - p ))
+          throw std::runtime_error("[DataHandler::ReadCache]: the cache is corrupted.");
+      }
+
+      template<typename T>
+      T Get()
+      {
+        Check(sizeof(T));
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+      }
+
+      std::string GetString()
+      {
+        const std::size_t n = Get<int64_t>();
+        Check(n);
+        const std::string s(p, n);
+        p += n;
+        return s;
+      }
+
+      std::vector<double> GetVector()
+      {
+        const std::size_t n = Get<int64_t>();
+        Check(n * sizeof(double));
+        std::vector<double> v(n);
+        if (n > 0)
+          std::memcpy(v.data(), p, n * sizeof(double));
+        p += n * sizeof(double);
+        return v;
+      }
+    };
+  }
   //_________________________________________________________________________
   DataHandler::Kinematics::Kinematics():
     ndata(0),
@@ -68,51 +166,67 @@ namespace NangaParbat
   }
 
   //_________________________________________________________________________________
-  DataHandler::DataHandler(DataHandler const& DH)
+  DataHandler::DataHandler(DataHandler const& DH):
+    _data(DH._data),
+    _cov(DH._cov),
+    _fluctuations(DH._fluctuations),
+    _t0(DH._t0)
   {
-    _name         = DH._name;
-    _datafile     = DH._datafile;
-    _proc         = DH._proc;
-    _obs          = DH._obs;
-    _targetiso    = DH._targetiso;
-    _hadron       = DH._hadron;
-    _charge       = DH._charge;
-    _tagging      = DH._tagging;
-    _prefact      = DH._prefact;
-    _kin          = DH._kin;
-    _means        = DH._means;
-    _uncor        = DH._uncor;
-    _corra        = DH._corra;
-    _corrm        = DH._corrm;
-    _corr         = DH._corr;
-    _covmat       = DH._covmat;
-    _CholL        = DH._CholL;
-    _labels       = DH._labels;
-    _fluctuations = DH._fluctuations;
-    _t0           = DH._t0;
-    _bins         = DH._bins;
   }
 
   //_________________________________________________________________________________
   DataHandler::DataHandler(std::string const& name, YAML::Node const& datafile, gsl_rng* rng, int const& fluctuation, std::vector<double> const& t0):
-    _name(name),
-    _datafile(datafile),
-    _proc(UnknownProcess),
-    _obs(UnknownObservable),
-    _targetiso(1),
-    _hadron("NONE"),
-    _charge(0),
-    _tagging({apfel::QuarkFlavour::TOTAL}),
-    _prefact(1),
-    _kin(DataHandler::Kinematics{}),
-    _labels({}),
     _t0(t0)
   {
+    // Read datafile
+    ReadDatafile(name, datafile);
+
+    // Construct covariance matrix
+    ComputeCovarianceMatrix();
+
+    // Fluctuate data given the replica ID and the random-number
+    FluctuateData(rng, fluctuation);
+  }
+
+  //_________________________________________________________________________________
+  DataHandler::DataHandler(std::string const& name, std::string const& datafile, gsl_rng* rng, int const& fluctuation, std::vector<double> const& t0):
+    _t0(t0)
+  {
+    // Read the binary cache if it is up to date, otherwise parse the
+    // datafile.
+    if (!ReadCache(name, datafile))
+      ReadDatafile(name, YAML::LoadFile(datafile));
+
+    // Construct covariance matrix, unless it has been read from the
+    // cache.
+    if (!_cov)
+      ComputeCovarianceMatrix();
+
+    // Fluctuate data given the replica ID and the random-number
+    FluctuateData(rng, fluctuation);
+  }
+
+  //_________________________________________________________________________________
+  void DataHandler::ReadDatafile(std::string const& name, YAML::Node const& datafile)
+  {
+    // Content of the datafile, shared with the copies of this object
+    const std::shared_ptr<Data> data = std::make_shared<Data>();
+    data->name      = name;
+    data->datafile  = datafile;
+    data->proc      = UnknownProcess;
+    data->obs       = UnknownObservable;
+    data->targetiso = 1;
+    data->hadron    = "NONE";
+    data->charge    = 0;
+    data->tagging   = {apfel::QuarkFlavour::TOTAL};
+    data->prefact   = 1;
+    data->kin       = DataHandler::Kinematics{};
+
     // Retrieve kinematics
     for (auto const& dv : datafile["dependent_variables"])
       {
         // Get labels
-        _labels = dv["header"].as<std::map<std::string, std::string>>();
+        data->labels = dv["header"].as<std::map<std::string, std::string>>();
 
         // Run over the qualifiers and make sure that all necessary
         // parameters are found.
@@ -122,11 +236,11 @@ namespace NangaParbat
             if (ql["name"].as<std::string>() == "process")
               {
                 if (ql["value"].as<std::string>() == "DY")
-                  _proc = DY;
+                  data->proc = DY;
                 else if (ql["value"].as<std::string>() == "SIDIS")
-                  _proc = SIDIS;
+                  data->proc = SIDIS;
                 else if (ql["value"].as<std::string>() == "SIA")
-                  _proc = SIA;
+                  data->proc = SIA;
                 else
                   throw std::runtime_error("[DataHandler::DataHandler]: Unknown process.");
               }
@@ -135,83 +249,83 @@ namespace NangaParbat
             if (ql["name"].as<std::string>() == "observable")
               {
                 if (ql["value"].as<std::string>() == "dsigma/dxdydz")
-                  _obs = dsigma_dxdydz;
+                  data->obs = dsigma_dxdydz;
                 else if (ql["value"].as<std::string>() == "dsigma/dxdQdz")
-                  _obs = dsigma_dxdQdz;
+                  data->obs = dsigma_dxdQdz;
                 else if (ql["value"].as<std::string>() == "multiplicity")
-                  _obs = dsigma_dxdQdz;
+                  data->obs = dsigma_dxdQdz;
                 else
                   throw std::runtime_error("[DataHandler::DataHandler]: Unknown observable.");
               }
 
             // Isoscalarity
             if (ql["name"].as<std::string>() == "target_isoscalarity")
-              _targetiso = ql["value"].as<double>();
+              data->targetiso = ql["value"].as<double>();
 
             // Hadron species
             if (ql["name"].as<std::string>() == "hadron")
-              _hadron = ql["value"].as<std::string>();
+              data->hadron = ql["value"].as<std::string>();
 
             // Final state charge
             if (ql["name"].as<std::string>() == "charge")
-              _charge = ql["value"].as<int>();
+              data->charge = ql["value"].as<int>();
 
             // Quark-tagging
             if (ql["name"].as<std::string>() == "tagging")
               {
-                _tagging.clear();
+                data->tagging.clear();
                 for (std::string t : ql["value"].as<std::vector<std::string>>())
                   if (t == "d")
-                    _tagging.push_back(apfel::QuarkFlavour::DOWN);
+                    data->tagging.push_back(apfel::QuarkFlavour::DOWN);
                   else if (t == "u")
-                    _tagging.push_back(apfel::QuarkFlavour::UP);
+                    data->tagging.push_back(apfel::QuarkFlavour::UP);
                   else if (t == "s")
-                    _tagging.push_back(apfel::QuarkFlavour::STRANGE);
+                    data->tagging.push_back(apfel::QuarkFlavour::STRANGE);
                   else if (t == "c")
-                    _tagging.push_back(apfel::QuarkFlavour::CHARM);
+                    data->tagging.push_back(apfel::QuarkFlavour::CHARM);
                   else if (t == "b")
-                    _tagging.push_back(apfel::QuarkFlavour::BOTTOM);
+                    data->tagging.push_back(apfel::QuarkFlavour::BOTTOM);
                   else if (t == "t")
-                    _tagging.push_back(apfel::QuarkFlavour::TOP);
+                    data->tagging.push_back(apfel::QuarkFlavour::TOP);
                   else
                     throw std::runtime_error("[DataHandler::DataHandler]: Unknown quark-flavour tag");
               }
 
             // Possible prefactor
             if (ql["name"].as<std::string>() == "prefactor")
-              _prefact = ql["value"].as<double>();
+              data->prefact = ql["value"].as<double>();
 
             // Center of mass energy
             if (ql["name"].as<std::string>() == "Vs")
-              _kin.Vs = ql["value"].as<double>();
+              data->kin.Vs = ql["value"].as<double>();
 
             // Invariant-mass (DY) or virtuality (SIDIS) interval
             if (ql["name"].as<std::string>() == "Q")
               {
-                _kin.var1b = std::make_pair(ql["low"].as<double>(), ql["high"].as<double>());
-                _kin.Intv1 = ql["integrate"].as<bool>();
+                data->kin.var1b = std::make_pair(ql["low"].as<double>(), ql["high"].as<double>());
+                data->kin.Intv1 = ql["integrate"].as<bool>();
               }
 
             // Rapidity (DY) or Bjorken-x (SIDIS) interval
             if (ql["name"].as<std::string>() == "y" || ql["name"].as<std::string>() == "x")
               {
-                _kin.var2b = std::make_pair(ql["low"].as<double>(), ql["high"].as<double>());
-                _kin.Intv2 = ql["integrate"].as<bool>();
+                data->kin.var2b = std::make_pair(ql["low"].as<double>(), ql["high"].as<double>());
+                data->kin.Intv2 = ql["integrate"].as<bool>();
               }
 
             // z interval (SIDIS and SIA)
             if (ql["name"].as<std::string>() == "z")
               {
-                _kin.var3b = std::make_pair(ql["low"].as<double>(), ql["high"].as<double>());
-                _kin.Intv3 = ql["integrate"].as<bool>();
+                data->kin.var3b = std::make_pair(ql["low"].as<double>(), ql["high"].as<double>());
+                data->kin.Intv3 = ql["integrate"].as<bool>();
               }
 
             // Phase-space reductions (lepton cuts for DY and W, y cuts for SIDIS)
             if (ql["name"].as<std::string>() == "PS_reduction")
               {
-                _kin.PSRed    = true;
-                _kin.pTMin    = (_proc == DY ? ql["pTmin"].as<double>(): ql["W"].as<double>()) ;
-                _kin.etaRange = std::make_pair((_proc == DY ? ql["etamin"].as<double>(): ql["ymin"].as<double>()), (_proc == DY ? ql["etamax"].as<double>(): ql["ymax"].as<double>()));
+                data->kin.PSRed    = true;
+                data->kin.pTMin    = (data->proc == DY ? ql["pTmin"].as<double>(): ql["W"].as<double>()) ;
+                data->kin.etaRange = std::make_pair((data->proc == DY ? ql["etamin"].as<double>(): ql["ymin"].as<double>()), (data->proc == DY ? ql["etamax"].as<double>(): ql["ymax"].as<double>()));
               }
 
           }
@@ -220,7 +334,7 @@ namespace NangaParbat
         for (auto const& vl : dv["values"])
           {
             // Read central values
-            _means.push_back(vl["value"].as<double>());
+            data->means.push_back(vl["value"].as<double>());
 
             // Read uncertainties
             double u = 0;
@@ -240,15 +354,15 @@ namespace NangaParbat
                 if (err["label"].as<std::string>() == "mult")
                   m.push_back(err["value"].as<double>());
               }
-            _uncor.push_back(sqrt(u));
-            _corra.push_back(a);
-            _corrm.push_back(m);
+            data->uncor.push_back(sqrt(u));
+            data->corra.push_back(a);
+            data->corrm.push_back(m);
 
             // Now concatenate vectors of additive and multiplicative
-            // uncertainties and push it back into "_corr".
+            // uncertainties and push it back into "data->corr".
             std::vector<double> c = a;
             c.insert(c.end(), m.begin(), m.end());
-            _corr.push_back(c);
+            data->corr.push_back(c);
           }
       }
 
@@ -256,7 +370,7 @@ namespace NangaParbat
     for (auto const& vl : datafile["independent_variables"][0]["values"])
       {
         // Increment number of datapoints
-        _kin.ndata++;
+        data->kin.ndata++;
 
         // If the keys "low" and "high" are present the data-point
         // is integrated over the qT bin. If instead the key "value"
@@ -267,91 +381,59 @@ namespace NangaParbat
         // data point is not integrate over qT the first entry of
         // the map pair is set to -1. Make also sure that all bins
         // are either all integrated or all are not by checking if
-        // "_kin.IntqT" has changed after the first data
+        // "data->kin.IntqT" has changed after the first data
         // point. Finally, if the key "factor" is present, gather
         // the factors to be used to multiply the single bins in
         // qT. Set the factors to one be default.
         if (vl["low"] && vl["high"])
           {
-            if (_kin.ndata > 1 and _kin.IntqT != true)
+            if (data->kin.ndata > 1 and data->kin.IntqT != true)
               throw std::runtime_error("[DataHandler::DataHandler]: Mixed qT integrated/non-integrated data points found");
 
-            _kin.IntqT = true;
+            data->kin.IntqT = true;
             const double qTl = vl["low"].as<double>();
             const double qTh = vl["high"].as<double>();
-            if(std::find(_kin.qTv.begin(), _kin.qTv.end(), qTl) == _kin.qTv.end())
-              _kin.qTv.push_back(std::max(vl["low"].as<double>(), 1e-5));
-            if(std::find(_kin.qTv.begin(), _kin.qTv.end(), qTh) == _kin.qTv.end())
-              _kin.qTv.push_back(vl["high"].as<double>());
+            if(std::find(data->kin.qTv.begin(), data->kin.qTv.end(), qTl) == data->kin.qTv.end())
+              data->kin.qTv.push_back(std::max(vl["low"].as<double>(), 1e-5));
+            if(std::find(data->kin.qTv.begin(), data->kin.qTv.end(), qTh) == data->kin.qTv.end())
+              data->kin.qTv.push_back(vl["high"].as<double>());
 
-            _kin.qTmap.push_back(std::make_pair(std::max(qTl, 1e-5), qTh));
+            data->kin.qTmap.push_back(std::make_pair(std::max(qTl, 1e-5), qTh));
           }
         else if (vl["value"])
           {
-            if (_kin.ndata > 1 and _kin.IntqT != false)
+            if (data->kin.ndata > 1 and data->kin.IntqT != false)
               throw std::runtime_error("[DataHandler::DataHandler]: Mixed qT integrated/non-integrated data points found");
 
-            _kin.IntqT = false;
+            data->kin.IntqT = false;
             const double qTval = vl["value"].as<double>();
-            if(std::find(_kin.qTv.begin(), _kin.qTv.end(), qTval) == _kin.qTv.end())
-              _kin.qTv.push_back(std::max(vl["value"].as<double>(), 1e-5));
+            if(std::find(data->kin.qTv.begin(), data->kin.qTv.end(), qTval) == data->kin.qTv.end())
+              data->kin.qTv.push_back(std::max(vl["value"].as<double>(), 1e-5));
 
-            _kin.qTmap.push_back(std::make_pair(-1, qTval));
+            data->kin.qTmap.push_back(std::make_pair(-1, qTval));
           }
         else
           throw std::runtime_error("[DataHandler::DataHandler]: Invalid qT-bin structure");
 
         // Now fill in vector of bin-by-bin prefactors.
         if (vl["factor"])
-          _kin.qTfact.push_back(vl["factor"].as<double>());
+          data->kin.qTfact.push_back(vl["factor"].as<double>());
         else
-          _kin.qTfact.push_back(1);
+          data->kin.qTfact.push_back(1);
       }
 
     // Check that the "DataHandler" has been properly filled in
-    if (_proc == UnknownProcess || _kin.empty())
+    if (data->proc == UnknownProcess || data->kin.empty())
       throw std::runtime_error("[DataHandler::DataHandler]: Object not properly filled in. Probably one or more required keys are missing");
 
-    // Check that the t0 vector is either empty or contains exactly
-    // "_kin.ndata" elements.
-    if (!_t0.empty() && (int) _t0.size() != _kin.ndata)
-      throw std::runtime_error("[DataHandler::DataHandler]: t0 vector has wrong size");
-
-    // Now construct the covariance matrix. First include uncorrelated
-    // and additive correlated uncertainties.
-    _covmat.resize(_kin.ndata, _kin.ndata);
-    for (int i = 0; i < _kin.ndata; i++)
-      for (int j = 0; j < _kin.ndata; j++)
-        _covmat(i, j) =
-          + (i == j ? pow(_uncor[i], 2) : 0)                                                                         // Uncorrelated component (diagonal)
-          + std::inner_product(_corra[i].begin(), _corra[i].end(), _corra[j].begin(), 0.) * _means[i] * _means[j];   // Additive component
-
-    // Then include multiplicative uncertainties using the t0
-    // prescription. If the t0 vector is empty or the fit is to the
-    // central values, use the experimental central values.
-    if (_t0.empty())
-      for (int i = 0; i < _kin.ndata; i++)
-        for (int j = 0; j < _kin.ndata; j++)
-          _covmat(i, j) +=
-            std::inner_product(_corrm[i].begin(), _corrm[i].end(), _corrm[j].begin(), 0.) * _means[i] * _means[j];
-    else
-      for (int i = 0; i < _kin.ndata; i++)
-        for (int j = 0; j < _kin.ndata; j++)
-          _covmat(i, j) +=
-            std::inner_product(_corrm[i].begin(), _corrm[i].end(), _corrm[j].begin(), 0.) * _t0[i] * _t0[j];
-
-    // Cholesky decomposition of the covariance matrix
-    _CholL = CholeskyDecomposition(_covmat);
-
-    // Fluctuate data given the replica ID and the random-number
-    FluctuateData(rng, fluctuation);
 
     // Resize vector of bins according to the number of data
     // point. The following code is currently used only by the
     // FF_SIDIS project and need to be better integrated.
-    _bins.resize(_kin.ndata);
+    data->bins.resize(data->kin.ndata);
 
-    // Fill in binning
+    // Fill in binning. Values in excess of the number of points (as
+    // found in some of the processed HERMES datafiles) are ignored.
     for (auto const& iv : datafile["independent_variables"])
       {
         int i = 0;
@@ -360,13 +442,15 @@ namespace NangaParbat
         if (iv["header"]["name"].as<std::string>() == "z")
           for (auto const& vl : iv["values"])
             {
+              if (i == data->kin.ndata)
+                break;
               if (vl["low"])
-                _bins[i].zmin = vl["low"].as<double>();
+                data->bins[i].zmin = vl["low"].as<double>();
               if (vl["high"])
-                _bins[i].zmax = vl["high"].as<double>();
+                data->bins[i].zmax = vl["high"].as<double>();
               if (vl["value"])
-                _bins[i].zav = vl["value"].as<double>();
-              _bins[i].Intz = _kin.Intv3;
+                data->bins[i].zav = vl["value"].as<double>();
+              data->bins[i].Intz = data->kin.Intv3;
               i++;
             }
 
@@ -374,13 +458,15 @@ namespace NangaParbat
         if (iv["header"]["name"].as<std::string>() == "x")
           for (auto const& vl : iv["values"])
             {
+              if (i == data->kin.ndata)
+                break;
               if (vl["low"])
-                _bins[i].xmin = vl["low"].as<double>();
+                data->bins[i].xmin = vl["low"].as<double>();
               if (vl["high"])
-                _bins[i].xmax = vl["high"].as<double>();
+                data->bins[i].xmax = vl["high"].as<double>();
               if (vl["value"])
-                _bins[i].xav = vl["value"].as<double>();
-              _bins[i].Intx = _kin.Intv2;
+                data->bins[i].xav = vl["value"].as<double>();
+              data->bins[i].Intx = data->kin.Intv2;
               i++;
             }
 
@@ -388,12 +474,14 @@ namespace NangaParbat
         if (iv["header"]["name"].as<std::string>() == "y")
           for (auto const& vl : iv["values"])
             {
+              if (i == data->kin.ndata)
+                break;
               if (vl["low"])
-                _bins[i].ymin = vl["low"].as<double>();
+                data->bins[i].ymin = vl["low"].as<double>();
               if (vl["high"])
-                _bins[i].ymax = vl["high"].as<double>();
+                data->bins[i].ymax = vl["high"].as<double>();
               if (vl["value"])
-                _bins[i].yav = vl["value"].as<double>();
+                data->bins[i].yav = vl["value"].as<double>();
               i++;
             }
 
@@ -401,16 +489,331 @@ namespace NangaParbat
         if (iv["header"]["name"].as<std::string>() == "Q2")
           for (auto const& vl : iv["values"])
             {
+              if (i == data->kin.ndata)
+                break;
               if (vl["low"])
-                _bins[i].Qmin = sqrt(vl["low"].as<double>());
+                data->bins[i].Qmin = sqrt(vl["low"].as<double>());
               if (vl["high"])
-                _bins[i].Qmax = sqrt(vl["high"].as<double>());
+                data->bins[i].Qmax = sqrt(vl["high"].as<double>());
               if (vl["value"])
-                _bins[i].Qav = sqrt(vl["value"].as<double>());
-              _bins[i].IntQ = _kin.Intv1;
+                data->bins[i].Qav = sqrt(vl["value"].as<double>());
+              data->bins[i].IntQ = data->kin.Intv1;
               i++;
             }
       }
+
+    _data = data;
+  }
+
+  //_________________________________________________________________________________
+  void DataHandler::ComputeCovarianceMatrix()
+  {
+    Data const& data = *_data;
+
+    // Check that the t0 vector is either empty or contains exactly
+    // "ndata" elements.
+    if (!_t0.empty() && (int) _t0.size() != data.kin.ndata)
+      throw std::runtime_error("[DataHandler::ComputeCovarianceMatrix]: t0 vector has wrong size");
+
+    // Now construct the covariance matrix. First include uncorrelated
+    // and additive correlated uncertainties.
+    const std::shared_ptr<Covariance> cov = std::make_shared<Covariance>();
+    cov->covmat.resize(data.kin.ndata, data.kin.ndata);
+    for (int i = 0; i < data.kin.ndata; i++)
+      for (int j = 0; j < data.kin.ndata; j++)
+        cov->covmat(i, j) =
+          + (i == j ? pow(data.uncor[i], 2) : 0)                                                                         // Uncorrelated component (diagonal)
+          + std::inner_product(data.corra[i].begin(), data.corra[i].end(), data.corra[j].begin(), 0.) * data.means[i] * data.means[j];   // Additive component
+
+    // Then include multiplicative uncertainties using the t0
+    // prescription. If the t0 vector is empty or the fit is to the
+    // central values, use the experimental central values.
+    if (_t0.empty())
+      for (int i = 0; i < data.kin.ndata; i++)
+        for (int j = 0; j < data.kin.ndata; j++)
+          cov->covmat(i, j) +=
+            std::inner_product(data.corrm[i].begin(), data.corrm[i].end(), data.corrm[j].begin(), 0.) * data.means[i] * data.means[j];
+    else
+      for (int i = 0; i < data.kin.ndata; i++)
+        for (int j = 0; j < data.kin.ndata; j++)
+          cov->covmat(i, j) +=
+            std::inner_product(data.corrm[i].begin(), data.corrm[i].end(), data.corrm[j].begin(), 0.) * _t0[i] * _t0[j];
+
+    // Cholesky decomposition of the covariance matrix
+    cov->CholL = CholeskyDecomposition(cov->covmat);
+
+    // If the correlated uncertainties are fewer than the points, also
+    // decompose the covariance matrix in low-rank form: diagonal
+    // uncorrelated component plus the outer products of the
+    // correlated uncertainties (additive first and multiplicative
+    // second), each of them being a column of U.
+    const int nsys = (data.kin.ndata == 0 ? 0 : data.corr[0].size());
+    if (nsys < data.kin.ndata && std::all_of(data.uncor.begin(), data.uncor.end(), [] (double const& u) -> bool{ return u > 0; }))
+      {
+        std::vector<double> D(data.kin.ndata);
+        std::vector<std::vector<double>> U(data.kin.ndata);
+        for (int i = 0; i < data.kin.ndata; i++)
+          {
+            D[i] = pow(data.uncor[i], 2);
+            const double t0i = (_t0.empty() ? data.means[i] : _t0[i]);
+            for (auto const& a : data.corra[i])
+              U[i].push_back(a * data.means[i]);
+            for (auto const& m : data.corrm[i])
+              U[i].push_back(m * t0i);
+          }
+        cov->CholLR = CholeskyDecomposition(D, U);
+      }
+
+    _cov = cov;
+  }
+
+  //_________________________________________________________________________________
+  void DataHandler::WriteCache(std::string const& file, std::string const& datafile) const
+  {
+    if (!_t0.empty())
+      throw std::runtime_error("[DataHandler::WriteCache]: the covariance matrix depends on the t0 predictions.");
+
+    const std::vector<int64_t> stamp = SourceStamp(datafile);
+    if (stamp.empty())
+      throw std::runtime_error("[DataHandler::WriteCache]: cannot access the datafile '" + datafile + "'.");
+
+    Data const& data = *_data;
+    const int ndata = data.kin.ndata;
+
+    std::string buf{DataCacheMagic, 8};
+
+    // Datafile the cache refers to
+    for (int64_t const& s : stamp)
+      Put<int64_t>(buf, s);
+
+    // General information
+    Put<int64_t>(buf, data.proc);
+    Put<int64_t>(buf, data.obs);
+    Put<double>(buf, data.targetiso);
+    PutString(buf, data.hadron);
+    Put<double>(buf, data.charge);
+    Put<int64_t>(buf, data.tagging.size());
+    for (auto const& t : data.tagging)
+      Put<int64_t>(buf, t);
+    Put<double>(buf, data.prefact);
+
+    // Kinematics
+    Put<int64_t>(buf, ndata);
+    Put<double>(buf, data.kin.Vs);
+    PutVector(buf, data.kin.qTv);
+    Put<int64_t>(buf, data.kin.qTmap.size());
+    for (auto const& m : data.kin.qTmap)
+      {
+        Put<double>(buf, m.first);
+        Put<double>(buf, m.second);
+      }
+    PutVector(buf, data.kin.qTfact);
+    for (auto const& b : {data.kin.var1b, data.kin.var2b, data.kin.var3b, data.kin.etaRange})
+      {
+        Put<double>(buf, b.first);
+        Put<double>(buf, b.second);
+      }
+    for (bool const& b : {data.kin.IntqT, data.kin.Intv1, data.kin.Intv2, data.kin.Intv3, data.kin.PSRed})
+      Put<int64_t>(buf, b);
+    Put<double>(buf, data.kin.pTMin);
+
+    // Central values and uncertainties
+    PutVector(buf, data.means);
+    PutVector(buf, data.uncor);
+    for (int i = 0; i < ndata; i++)
+      {
+        PutVector(buf, data.corra[i]);
+        PutVector(buf, data.corrm[i]);
+      }
+
+    // Labels
+    Put<int64_t>(buf, data.labels.size());
+    for (auto const& l : data.labels)
+      {
+        PutString(buf, l.first);
+        PutString(buf, l.second);
+      }
+
+    // Binning
+    for (auto const& b : data.bins)
+      {
+        for (double const& v : {b.zmin, b.zmax, b.zav, b.xmin, b.xmax, b.xav, b.Qmin, b.Qmax, b.Qav, b.ymin, b.ymax, b.yav})
+          Put<double>(buf, v);
+        for (bool const& v : {b.Intz, b.Intx, b.IntQ, b.Inty})
+          Put<int64_t>(buf, v);
+      }
+
+    // Covariance matrix and its decompositions
+    for (int i = 0; i < ndata; i++)
+      for (int j = 0; j < ndata; j++)
+        Put<double>(buf, _cov->covmat(i, j));
+    for (double const& l : _cov->CholL.v)
+      Put<double>(buf, l);
+    Put<int64_t>(buf, _cov->CholLR.k);
+    PutVector(buf, _cov->CholLR.d);
+    PutVector(buf, _cov->CholLR.u);
+    PutVector(buf, _cov->CholLR.g);
+
+    // Write to a temporary file in the same folder and rename it, such
+    // that readers never see a partially written cache.
+    const std::string tmp = file + ".tmp" + std::to_string(getpid());
+    std::ofstream fout(tmp, std::ios::out | std::ios::binary);
+    if (fout.fail())
+      throw std::runtime_error("[DataHandler::WriteCache]: cannot open file '" + tmp + "'.");
+    fout.write(buf.data(), buf.size());
+    fout.close();
+    if (fout.fail() || std::rename(tmp.c_str(), file.c_str()) != 0)
+      {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("[DataHandler::WriteCache]: cannot write file '" + file + "'.");
+      }
+  }
+
+  //_________________________________________________________________________________
+  bool DataHandler::ReadCache(std::string const& name, std::string const& datafile)
+  {
+    const std::string file = DataCacheFile(datafile);
+    const std::vector<int64_t> stamp = SourceStamp(datafile);
+    std::ifstream fin(file, std::ios::in | std::ios::binary);
+    if (stamp.empty() || fin.fail())
+      return false;
+
+    // Read the whole file in one go
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    const std::string buf = ss.str();
+    if (buf.size() < 8 || std::memcmp(buf.data(), DataCacheMagic, 8) != 0)
+      return false;
+
+    // The cache is used only if it was written from the datafile as it
+    // is now, i.e. with the same size and modification time down to
+    // the nanosecond. Requiring the cache to be newer than the
+    // datafile would fail for edits within the same second and for
+    // datafiles copied preserving the timestamps.
+    if (buf.size() < DataCacheHeaderSize || std::memcmp(buf.data() + 8, stamp.data(), DataCacheHeaderSize - 8) != 0)
+      return false;
+
+    // A corrupted (e.g. truncated) cache is ignored such that the
+    // datafile is parsed instead.
+    try
+      {
+        ParseCache(name, datafile, buf);
+      }
+    catch (std::exception const& e)
+      {
+        std::cout << "[DataHandler::ReadCache]: Warning: ignoring the cache of '" << datafile << "': " << e.what() << std::endl;
+        return false;
+      }
+    return true;
+  }
+
+  //_________________________________________________________________________________
+  void DataHandler::ParseCache(std::string const& name, std::string const& datafile, std::string const& buf)
+  {
+    // Magic string and datafile stamp have already been checked by
+    // "ReadCache"
+    CacheReader r{buf.data() + DataCacheHeaderSize, buf.data() + buf.size()};
+
+    const std::shared_ptr<Data> data = std::make_shared<Data>();
+    data->name = name;
+    data->path = datafile;
+
+    // General information
+    data->proc      = (Process) r.Get<int64_t>();
+    data->obs       = (Observable) r.Get<int64_t>();
+    data->targetiso = r.Get<double>();
+    data->hadron    = r.GetString();
+    data->charge    = r.Get<double>();
+    data->tagging.resize(r.Get<int64_t>());
+    for (auto& t : data->tagging)
+      t = (apfel::QuarkFlavour) r.Get<int64_t>();
+    data->prefact   = r.Get<double>();
+
+    // Kinematics
+    const int ndata = r.Get<int64_t>();
+    data->kin.ndata  = ndata;
+    data->kin.Vs     = r.Get<double>();
+    data->kin.qTv    = r.GetVector();
+    data->kin.qTmap.resize(r.Get<int64_t>());
+    for (auto& m : data->kin.qTmap)
+      {
+        m.first  = r.Get<double>();
+        m.second = r.Get<double>();
+      }
+    data->kin.qTfact = r.GetVector();
+    for (auto b : {&data->kin.var1b, &data->kin.var2b, &data->kin.var3b, &data->kin.etaRange})
+      {
+        b->first  = r.Get<double>();
+        b->second = r.Get<double>();
+      }
+    for (auto b : {&data->kin.IntqT, &data->kin.Intv1, &data->kin.Intv2, &data->kin.Intv3, &data->kin.PSRed})
+      *b = r.Get<int64_t>();
+    data->kin.pTMin = r.Get<double>();
+
+    // Central values and uncertainties
+    data->means = r.GetVector();
+    data->uncor = r.GetVector();
+    for (int i = 0; i < ndata; i++)
+      {
+        data->corra.push_back(r.GetVector());
+        data->corrm.push_back(r.GetVector());
+        std::vector<double> c = data->corra.back();
+        c.insert(c.end(), data->corrm.back().begin(), data->corrm.back().end());
+        data->corr.push_back(c);
+      }
+
+    // Labels
+    const int nlabels = r.Get<int64_t>();
+    for (int l = 0; l < nlabels; l++)
+      {
+        const std::string key = r.GetString();
+        data->labels[key] = r.GetString();
+      }
+
+    // Binning
+    data->bins.resize(ndata);
+    for (auto& b : data->bins)
+      {
+        for (auto v : {&b.zmin, &b.zmax, &b.zav, &b.xmin, &b.xmax, &b.xav, &b.Qmin, &b.Qmax, &b.Qav, &b.ymin, &b.ymax, &b.yav})
+          *v = r.Get<double>();
+        for (auto v : {&b.Intz, &b.Intx, &b.IntQ, &b.Inty})
+          *v = r.Get<int64_t>();
+      }
+
+    // The covariance matrix in the cache is only valid without t0
+    // predictions. Nothing is set before the cache has been read
+    // entirely.
+    if (!_t0.empty())
+      {
+        _data = data;
+        return;
+      }
+
+    const std::shared_ptr<Covariance> cov = std::make_shared<Covariance>();
+    cov->covmat.resize(ndata, ndata);
+    for (int i = 0; i < ndata; i++)
+      for (int j = 0; j < ndata; j++)
+        cov->covmat(i, j) = r.Get<double>();
+    cov->CholL = TriangularMatrix{ndata};
+    for (double& l : cov->CholL.v)
+      l = r.Get<double>();
+    cov->CholLR.k = r.Get<int64_t>();
+    cov->CholLR.d = r.GetVector();
+    cov->CholLR.u = r.GetVector();
+    cov->CholLR.g = r.GetVector();
+    _data = data;
+    _cov  = cov;
+  }
+
+  //_________________________________________________________________________________
+  YAML::Node DataHandler::GetDataFile() const
+  {
+    // If the data have been read from the cache, parse the datafile
+    // only now.
+    if (_data->datafile.IsNull() && !_data->path.empty())
+      return YAML::LoadFile(_data->path);
+
+    return _data->datafile;
   }
   /*
     //_________________________________________________________________________
@@ -525,7 +928,7 @@ namespace NangaParbat
   {
     // Fluctuate data given the replica ID and the random-number
     // generator.
-    _fluctuations = _means;
+    _fluctuations = _data->means;
     if (fluctuation > 0 && rng != NULL)
       {
         // Fluctuate the full data-set "fluctuation" times and keep
@@ -536,36 +939,127 @@ namespace NangaParbat
         for (int irep = 0; irep < fluctuation; irep++)
           {
             // Collect random numbers
-            std::vector<double> z(_means.size());
-            for (int i = 0; i < (int) _means.size(); i++)
+            std::vector<double> z(_data->means.size());
+            for (int i = 0; i < (int) _data->means.size(); i++)
               z[i] = gsl_ran_gaussian(rng, 1);
 
             // Include fluctuations on top of the mean values
-            _fluctuations = _means;
-            for (int i = 0; i < (int) _means.size(); i++)
-              for (int j = 0; j < (int) _means.size(); j++)
-                _fluctuations[i] -= _CholL(i, j) * z[j];
+            _fluctuations = _data->means;
+            for (int i = 0; i < (int) _data->means.size(); i++)
+              {
+                double const* Li = _cov->CholL.Row(i);
+                for (int j = 0; j <= i; j++)
+                  _fluctuations[i] -= Li[j] * z[j];
+              }
           }
       }
   }
 
+  //_________________________________________________________________________
+  apfel::matrix<double> DataHandler::FluctuateBatch(int const& seed, int const& first, int const& nrep, int const& nthreads) const
+  {
+    const int ndata = _data->means.size();
+    apfel::matrix<double> fluct{(size_t) nrep, (size_t) ndata};
+
+    // Replicas are processed in blocks such that each row of the
+    // Cholesky factor is loaded once per block rather than once per
+    // replica. Blocks are independent and are processed
+    // concurrently.
+    const int nb = 16;
+    ParallelFor(( nrep + nb - 1 ) / nb, [&] (int const& ib) -> void
+    {
+      const int r0 = ib * nb;
+      const int r1 = std::min(r0 + nb, nrep);
+
+      // Random numbers of the replicas of this block. Replica 0 is
+      // not fluctuated.
+      std::vector<double> z(( r1 - r0 ) * ndata, 0.);
+      for (int r = r0; r < r1; r++)
+        if (first + r > 0)
+          {
+            const CounterRNG rng{seed, first + r, _data->name};
+            for (int j = 0; j < ndata; j++)
+              z[( r - r0 ) * ndata + j] = rng.Gaussian(j);
+          }
+
+      // Fluctuations f = m - L z
+      for (int r = r0; r < r1; r++)
+        for (int i = 0; i < ndata; i++)
+          fluct(r, i) = _data->means[i];
+
+      if (HasLowRankCovariance())
+        {
+          // Low-rank factor: (L z)_i = d_i z_i + u_i * sum_{j < i} g_j z_j
+          const int k = _cov->CholLR.k;
+          std::vector<double> acc(k);
+          for (int r = r0; r < r1; r++)
+            {
+              double const* zr = z.data() + ( r - r0 ) * ndata;
+              std::fill(acc.begin(), acc.end(), 0.);
+              for (int i = 0; i < ndata; i++)
+                {
+                  double const* ui = _cov->CholLR.u.data() + i * k;
+                  double const* gi = _cov->CholLR.g.data() + i * k;
+                  double Lz = _cov->CholLR.d[i] * zr[i];
+                  for (int a = 0; a < k; a++)
+                    {
+                      Lz     += ui[a] * acc[a];
+                      acc[a] += gi[a] * zr[i];
+                    }
+                  fluct(r, i) -= Lz;
+                }
+            }
+        }
+      else
+        for (int i = 0; i < ndata; i++)
+          {
+            double const* Li = _cov->CholL.Row(i);
+            for (int r = r0; r < r1; r++)
+              {
+                double const* zr = z.data() + ( r - r0 ) * ndata;
+                double Lz = 0;
+                for (int j = 0; j <= i; j++)
+                  Lz += Li[j] * zr[j];
+                fluct(r, i) -= Lz;
+              }
+          }
+    }, nthreads);
+
+    return fluct;
+  }
+
+  //_________________________________________________________________________
+  void DataHandler::FluctuateDataCounterBased(int const& seed, int const& fluctuation)
+  {
+    const apfel::matrix<double> f = FluctuateBatch(seed, fluctuation, 1, 1);
+    for (int i = 0; i < (int) _data->means.size(); i++)
+      _fluctuations[i] = f(0, i);
+  }
+
   //_________________________________________________________________________
   void DataHandler::SetMeans(std::vector<double> const& means, gsl_rng* rng, int const& fluctuation)
   {
+    // The content of the datafile may be shared with other objects,
+    // therefore copy it before changing it. If the data have been
+    // read from the cache, the datafile is parsed first.
+    const std::shared_ptr<Data> data = std::make_shared<Data>(*_data);
+    data->datafile = YAML::Clone(GetDataFile());
+
     // Reset mean values
-    _means = means;
+    data->means = means;
+    _data = data;
 
     // Fluctuate data as required
     FluctuateData(rng, fluctuation);
 
     // Now set means equal to fluctuations
-    _means = _fluctuations;
+    data->means = _fluctuations;
 
     // Change also the central values in the datafile
     int i = 0;
-    for (auto dv : _datafile["dependent_variables"])
+    for (auto dv : data->datafile["dependent_variables"])
       for (auto vl : dv["values"])
-        vl["value"] = _means[i++];
+        vl["value"] = data->means[i++];
   }
 
   //_________________________________________________________________________
@@ -573,22 +1067,22 @@ namespace NangaParbat
   {
     os << "\nDataHandler report:\n";
 
-    os << "- name: " << DH._name << "\n";
+    os << "- name: " << DH._data->name << "\n";
 
-    if (DH._proc == DataHandler::Process::DY)
+    if (DH._data->proc == DataHandler::Process::DY)
       os << "- Process: Drell-Yan\n";
-    else if (DH._proc == DataHandler::Process::SIDIS)
+    else if (DH._data->proc == DataHandler::Process::SIDIS)
       os << "- Process: SIDIS\n";
     else
       os << "- Process: Unknown\n";
 
-    os << "- Target isoscalarity: "   << DH._targetiso << "\n";
-    os << "- Overall prefactor: "     << DH._prefact   << "\n";
-    os << "- Number of points: "      << DH._kin.ndata << "\n";
-    os << "- Center-of-mass energy: " << DH._kin.Vs    << " GeV\n";
+    os << "- Target isoscalarity: "   << DH._data->targetiso << "\n";
+    os << "- Overall prefactor: "     << DH._data->prefact   << "\n";
+    os << "- Number of points: "      << DH._data->kin.ndata << "\n";
+    os << "- Center-of-mass energy: " << DH._data->kin.Vs    << " GeV\n";
 
     os << "- qT bin-bounds: [ ";
-    for (auto const& qTp : DH._kin.qTmap)
+    for (auto const& qTp : DH._data->kin.qTmap)
       {
         os << "(" << qTp.first;
         if (qTp.second > 0)
@@ -598,39 +1092,39 @@ namespace NangaParbat
     os << "] GeV\n";
 
     os << "- qT bin factors: [ ";
-    for (auto const& qTf : DH._kin.qTfact)
+    for (auto const& qTf : DH._data->kin.qTfact)
       os << qTf << " ";
     os << "]\n";
 
-    if (DH._kin.Intv1)
-      os << "- Integration bounds of the first kinematic variable: [" << DH._kin.var1b.first << ": " << DH._kin.var1b.second << "]\n";
+    if (DH._data->kin.Intv1)
+      os << "- Integration bounds of the first kinematic variable: [" << DH._data->kin.var1b.first << ": " << DH._data->kin.var1b.second << "]\n";
     else
-      os << "- Value of the first kinematic variable: " << ( DH._kin.var1b.first + DH._kin.var1b.second ) / 2 << "\n";
+      os << "- Value of the first kinematic variable: " << ( DH._data->kin.var1b.first + DH._data->kin.var1b.second ) / 2 << "\n";
 
-    if (DH._kin.Intv2)
-      os << "- Integration bounds of the second kinematic variable: [" << DH._kin.var2b.first << ": " << DH._kin.var2b.second << "]\n";
+    if (DH._data->kin.Intv2)
+      os << "- Integration bounds of the second kinematic variable: [" << DH._data->kin.var2b.first << ": " << DH._data->kin.var2b.second << "]\n";
     else
-      os << "- Value of the second kinematic variable: " << ( DH._kin.var2b.first + DH._kin.var2b.second ) / 2 << "\n";
+      os << "- Value of the second kinematic variable: " << ( DH._data->kin.var2b.first + DH._data->kin.var2b.second ) / 2 << "\n";
 
-    if (DH._proc == DataHandler::Process::SIDIS)
+    if (DH._data->proc == DataHandler::Process::SIDIS)
       {
-        if (DH._kin.Intv3)
-          os << "- Integration bounds of the third kinematic variable: [" << DH._kin.var3b.first << ": " << DH._kin.var3b.second << "]\n";
+        if (DH._data->kin.Intv3)
+          os << "- Integration bounds of the third kinematic variable: [" << DH._data->kin.var3b.first << ": " << DH._data->kin.var3b.second << "]\n";
         else
-          os << "- Value of the second kinematic variable: " << ( DH._kin.var3b.first + DH._kin.var3b.second ) / 2 << "\n";
+          os << "- Value of the second kinematic variable: " << ( DH._data->kin.var3b.first + DH._data->kin.var3b.second ) / 2 << "\n";
       }
 
-    if (DH._kin.PSRed)
+    if (DH._data->kin.PSRed)
       {
-        if (DH._proc == DataHandler::Process::DY)
+        if (DH._data->proc == DataHandler::Process::DY)
           {
-            os << "- Lepton minimum pT: " << DH._kin.pTMin << " GeV \n";
-            os << "- Lepton range in eta: [" << DH._kin.etaRange.first << ": " << DH._kin.etaRange.second << "]\n";
+            os << "- Lepton minimum pT: " << DH._data->kin.pTMin << " GeV \n";
+            os << "- Lepton range in eta: [" << DH._data->kin.etaRange.first << ": " << DH._data->kin.etaRange.second << "]\n";
           }
-        else if (DH._proc == DataHandler::Process::SIDIS)
+        else if (DH._data->proc == DataHandler::Process::SIDIS)
           {
-            os << "- Minimum W: " << DH._kin.pTMin << " GeV \n";
-            os << "- Range in y: [" << DH._kin.etaRange.first << ": " << DH._kin.etaRange.second << "]\n";
+            os << "- Minimum W: " << DH._data->kin.pTMin << " GeV \n";
+            os << "- Range in y: [" << DH._data->kin.etaRange.first << ": " << DH._data->kin.etaRange.second << "]\n";
           }
 
       }
@@ -638,4 +1132,15 @@ namespace NangaParbat
 
     return os;
   }
+
+  //_________________________________________________________________________________
+  std::string DataCacheFile(std::string const& datafile)
+  {
+    const std::size_t dot = datafile.find_last_of('.');
+    const std::size_t sep = datafile.find_last_of('/');
+    if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+      return datafile + ".bin";
+
+    return datafile.substr(0, dot) + ".bin";
+  }
 }
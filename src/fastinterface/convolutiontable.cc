@@ -28,7 +28,8 @@ namespace NangaParbat
   _qToQmax(1000),
   _acc(1e-7),
   _cuts({}),
-  _cutmask({})
+  _cutmask({}),
+  _incr(false)
   {
   }
 
@@ -46,7 +47,8 @@ namespace NangaParbat
     _Qg(table["Qgrid"].as<std::vector<double>>()),
     _qToQmax(qToQmax),
     _acc(acc),
-    _cuts(cuts)
+    _cuts(cuts),
+    _incr(false)
   {
     // Compute total cut mask as a product of single masks
     _cutmask.resize(_qTfact.size(), true);
@@ -70,6 +72,17 @@ namespace NangaParbat
         // Read weights
         for (auto const& qT : _qTv)
           _WDY.insert({qT, table["weights"][qT].as<std::vector<std::vector<std::vector<double>>>>()});
+
+        // Momentum fractions and rapidity scale on the (Q, xi) nodes
+        for (auto const& Q : _Qg)
+          for (auto const& xi : _xig)
+            {
+              const double Vtau = Q / _Vs;
+              const double x1   = Vtau * xi;
+              _xn1.push_back(x1);
+              _xn2.push_back(pow(Vtau, 2) / x1);
+              _zetan.push_back(Q * Q);
+            }
         break;
 
       case DataHandler::Process::SIDIS:
@@ -79,6 +92,17 @@ namespace NangaParbat
         // Read weights
         for (auto const& qT : _qTv)
           _WSIDIS.insert({qT, table["weights"][qT].as<std::vector<std::vector<std::vector<std::vector<double>>>>>()});
+
+        // Momentum fractions and rapidity scale on the (Q, xb, z)
+        // nodes
+        for (auto const& Q : _Qg)
+          for (auto const& xb : _xbg)
+            for (auto const& z : _zg)
+              {
+                _xn1.push_back(xb);
+                _xn2.push_back(z);
+                _zetan.push_back(Q * Q);
+              }
         break;
 
       default:
@@ -186,17 +210,318 @@ namespace NangaParbat
   }
 
   //_________________________________________________________________________________
-  std::vector<double> ConvolutionTable::GetPredictions(std::function<double(double const&, double const&, double const&)> const& fNP1,
-                                                       std::function<double(double const&, double const&, double const&)> const& fNP2) const
+  std::map<double, double> ConvolutionTable::ConvoluteDY(Parameterisation const& NPFunc) const
+  {
+    // Values of b and of the non-perturbative function on the nodes
+    const int nxi = _xig.size();
+    const int nn  = _xn1.size();
+    std::vector<double> bn(nn);
+    std::vector<double> f1(nn);
+    std::vector<double> f2(nn);
+
+    // If the parameterisation is separable, compute the factors that
+    // do not depend on b once for all qT and Ogata points. In
+    // incremental mode, the buffers of the table are used and only
+    // those that are out of date are recomputed. Non-separable
+    // parameterisations have nothing to buffer, therefore the
+    // incremental mode has no effect on them.
+    std::vector<FactorBuffer> lfb;
+    std::vector<FactorBuffer>& fb = (_incr && NPFunc.IsSeparable() ? _fbuf : lfb);
+    UpdateFactorBuffers(NPFunc, fb);
+
+    // Compute predictions
+    std::map<double, double> pred;
+    for (int iqT = 0; iqT < (int) _qTv.size(); iqT++)
+      {
+        if (_qTv[iqT] / _Qg.front() > _qToQmax)
+          {
+            pred.insert({_qTv[iqT],  0});
+            pred.insert({-_qTv[iqT], 0});
+            continue;
+          }
+        const auto& wgt  = _WDY.at(_qTv[iqT]);
+        const auto& psf  = _PSRed.at(_qTv[iqT]);
+        const auto& dpsf = _dPSRed.at(_qTv[iqT]);
+        double cs  = 0;
+        double dcs = 0;
+        for (int n = 0; n < (int) _zOgata.size(); n++)
+          {
+            // Evaluate the non-perturbative function on all the nodes
+            // at once.
+            EvaluateOnNodes(NPFunc, fb, _zOgata[n] / _qTv[iqT], bn, f1, f2);
+
+            double csn  = 0;
+            double dcsn = 0;
+            for (int tau = 0; tau < (int) _Qg.size(); tau++)
+              for (int alpha = 0; alpha < nxi; alpha++)
+                {
+                  const int    i  = tau * nxi + alpha;
+                  const double wf = wgt[n][tau][alpha] * f1[i] * f2[i];
+                  csn  += wf * psf[tau][alpha];
+                  dcsn += wf * dpsf[tau][alpha];
+                }
+            cs  += csn;
+            dcs += dcsn;
+            // Break the loop if the accuracy is satisfied (assuming
+            // convergence).
+            if (std::abs(csn/cs) < _acc)
+              break;
+          }
+        pred.insert({_qTv[iqT],  cs});
+        pred.insert({-_qTv[iqT], dcs});
+      }
+    return pred;
+  }
+
+  //_________________________________________________________________________________
+  std::map<double, double> ConvolutionTable::ConvoluteSIDIS(Parameterisation const& NPFunc) const
+  {
+    // Values of b and of the non-perturbative functions on the nodes
+    const int nxb = _xbg.size();
+    const int nz  = _zg.size();
+    const int nn  = _xn1.size();
+    std::vector<double> bn(nn);
+    std::vector<double> fn(nn);
+    std::vector<double> dn(nn);
+
+    // Factor buffers of separable parameterisations (see
+    // "ConvoluteDY")
+    std::vector<FactorBuffer> lfb;
+    std::vector<FactorBuffer>& fb = (_incr && NPFunc.IsSeparable() ? _fbuf : lfb);
+    UpdateFactorBuffers(NPFunc, fb);
+
+    // Compute predictions
+    std::map<double, double> pred;
+    for (int iqT = 0; iqT < (int) _qTv.size(); iqT++)
+      {
+        if (_qTv[iqT] / _Qg.front() / _zg.front() > _qToQmax)
+          {
+            pred.insert({_qTv[iqT],  0});
+            continue;
+          }
+        const auto& wgt = _WSIDIS.at(_qTv[iqT]);
+        double cs  = 0;
+        for (int n = 0; n < (int) _zOgata.size(); n++)
+          {
+            // Evaluate the non-perturbative functions on all the nodes
+            // at once.
+            EvaluateOnNodes(NPFunc, fb, _zOgata[n] / _qTv[iqT], bn, fn, dn);
+
+            double csn  = 0;
+            for (int tau = 0; tau < (int) _Qg.size(); tau++)
+              for (int alpha = 0; alpha < nxb; alpha++)
+                for (int beta = 0; beta < nz; beta++)
+                  {
+                    const int i = ( tau * nxb + alpha ) * nz + beta;
+                    csn += wgt[n][tau][alpha][beta] * fn[i] * dn[i];
+                  }
+            cs += csn;
+            // Break the loop if the accuracy is satisfied (assuming
+            // convergence).
+            if (std::abs(csn/cs) < _acc)
+              break;
+          }
+        pred.insert({_qTv[iqT], cs});
+      }
+    return pred;
+  }
+
+  //_________________________________________________________________________________
+  void ConvolutionTable::UpdateFactorBuffers(Parameterisation const& NPFunc, std::vector<FactorBuffer>& fb) const
+  {
+    if (!NPFunc.IsSeparable())
+      return;
+
+    std::vector<double> zetag;
+    for (auto const& Q : _Qg)
+      zetag.push_back(Q * Q);
+
+    switch (_proc)
+      {
+      // Drell-Yan: x factors in x1 and x2, zeta factors in Q
+      case DataHandler::Process::DY:
+        fb.resize(3);
+        UpdateFactorBuffer(NPFunc, _xn1,  Parameterisation::xFactor,    0, fb[0]);
+        UpdateFactorBuffer(NPFunc, _xn2,  Parameterisation::xFactor,    0, fb[1]);
+        UpdateFactorBuffer(NPFunc, zetag, Parameterisation::zetaFactor, 0, fb[2]);
+        break;
+
+      // SIDIS: x factors of the PDF in xb and of the FF in z, zeta
+      // factors of both in Q
+      case DataHandler::Process::SIDIS:
+        fb.resize(4);
+        UpdateFactorBuffer(NPFunc, _xbg,  Parameterisation::xFactor,    0, fb[0]);
+        UpdateFactorBuffer(NPFunc, _zg,   Parameterisation::xFactor,    1, fb[1]);
+        UpdateFactorBuffer(NPFunc, zetag, Parameterisation::zetaFactor, 0, fb[2]);
+        UpdateFactorBuffer(NPFunc, zetag, Parameterisation::zetaFactor, 1, fb[3]);
+        break;
+
+      // e+e- annihilation into two hadrons: two FFs (Not present
+      // yet)
+      case DataHandler::Process::DIA:
+        break;
+      }
+  }
+
+  //_________________________________________________________________________________
+  void ConvolutionTable::EvaluateOnNodes(Parameterisation          const& NPFunc,
+                                         std::vector<FactorBuffer> const& fb,
+                                         double                    const& bq,
+                                         std::vector<double>&             bn,
+                                         std::vector<double>&             f1,
+                                         std::vector<double>&             f2) const
+  {
+    const int  nn  = _xn1.size();
+    const bool sep = NPFunc.IsSeparable();
+    switch (_proc)
+      {
+      // Drell-Yan: b is the same on all the nodes
+      case DataHandler::Process::DY:
+      {
+        std::fill(bn.begin(), bn.end(), bq);
+        if (sep)
+          {
+            const int nxi = _xig.size();
+            std::vector<double> const& X1 = fb[0].tab;
+            std::vector<double> const& X2 = fb[1].tab;
+            std::vector<double> const& Z  = fb[2].tab;
+            const int sx1 = fb[0].stride;
+            const int sx2 = fb[1].stride;
+            const int sz  = fb[2].stride;
+            const std::vector<double> bf = NPFunc.bFactors(bq, 0);
+            for (int i = 0; i < nn; i++)
+              {
+                double const* zf = Z.data() + i / nxi * sz;
+                f1[i] = NPFunc.Combine(X1.data() + i * sx1, bf.data(), zf, 0);
+                f2[i] = NPFunc.Combine(X2.data() + i * sx2, bf.data(), zf, 0);
+              }
+          }
+        else
+          {
+            NPFunc.EvaluateBatch(nn, _xn1.data(), bn.data(), _zetan.data(), 0, f1.data());
+            NPFunc.EvaluateBatch(nn, _xn2.data(), bn.data(), _zetan.data(), 0, f2.data());
+          }
+        break;
+      }
+
+      // SIDIS: b = z * bq, therefore the b factors depend on the node
+      // in z.
+      case DataHandler::Process::SIDIS:
+      {
+        for (int i = 0; i < nn; i++)
+          bn[i] = _xn2[i] * bq;
+        if (sep)
+          {
+            const int nxb = _xbg.size();
+            const int nz  = _zg.size();
+            std::vector<double> const& Xb = fb[0].tab;
+            std::vector<double> const& Xz = fb[1].tab;
+            std::vector<double> const& Zf = fb[2].tab;
+            std::vector<double> const& Zd = fb[3].tab;
+            const int sxb = fb[0].stride;
+            const int sz  = fb[1].stride;
+            const int sfz = fb[2].stride;
+            const int sdz = fb[3].stride;
+            std::vector<std::vector<double>> bff(nz);
+            std::vector<std::vector<double>> bfd(nz);
+            for (int beta = 0; beta < nz; beta++)
+              {
+                bff[beta] = NPFunc.bFactors(_zg[beta] * bq, 0);
+                bfd[beta] = NPFunc.bFactors(_zg[beta] * bq, 1);
+              }
+            for (int tau = 0; tau < (int) _Qg.size(); tau++)
+              for (int alpha = 0; alpha < nxb; alpha++)
+                for (int beta = 0; beta < nz; beta++)
+                  {
+                    const int i = ( tau * nxb + alpha ) * nz + beta;
+                    f1[i] = NPFunc.Combine(Xb.data() + alpha * sxb, bff[beta].data(), Zf.data() + tau * sfz, 0);
+                    f2[i] = NPFunc.Combine(Xz.data() + beta * sz,   bfd[beta].data(), Zd.data() + tau * sdz, 1);
+                  }
+          }
+        else
+          {
+            NPFunc.EvaluateBatch(nn, _xn1.data(), bn.data(), _zetan.data(), 0, f1.data());
+            NPFunc.EvaluateBatch(nn, _xn2.data(), bn.data(), _zetan.data(), 1, f2.data());
+          }
+        break;
+      }
+
+      // e+e- annihilation into two hadrons: two FFs (Not present
+      // yet)
+      case DataHandler::Process::DIA:
+        break;
+      }
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> ConvolutionTable::TabulateFactors(std::vector<double>                                   const& v,
+                                                        std::function<std::vector<double>(double const&)> const& factors,
+                                                        int&                                                         stride) const
+  {
+    std::vector<double> tab;
+    stride = 0;
+    for (int i = 0; i < (int) v.size(); i++)
+      {
+        const std::vector<double> f = factors(v[i]);
+        if (i == 0)
+          stride = f.size();
+        else if ((int) f.size() != stride)
+          throw std::runtime_error("[ConvolutionTable::TabulateFactors]: the number of factors depends on the point.");
+        tab.insert(tab.end(), f.begin(), f.end());
+      }
+    return tab;
+  }
+
+  //_________________________________________________________________________________
+  void ConvolutionTable::UpdateFactorBuffer(Parameterisation             const& NPFunc,
+                                            std::vector<double>          const& v,
+                                            Parameterisation::FactorKind const& kind,
+                                            int                          const& ifunc,
+                                            FactorBuffer&                       fb) const
+  {
+    // Check whether the buffer is up to date
+    const std::vector<double> pars = NPFunc.GetParameters();
+    bool valid = (!fb.tab.empty() && fb.name == NPFunc.GetName() && fb.pars.size() == pars.size());
+    if (valid)
+      for (int ipar : NPFunc.GetFactorDependencies(kind, ifunc))
+        if (fb.pars[ipar] != pars[ipar])
+          {
+            valid = false;
+            break;
+          }
+
+    // The factors only depend on the parameters checked above,
+    // therefore the buffer can be labelled with the current
+    // parameters also if it is not recomputed.
+    fb.pars = pars;
+    if (valid)
+      return;
+
+    fb.name = NPFunc.GetName();
+    if (kind == Parameterisation::xFactor)
+      fb.tab = TabulateFactors(v, [&] (double const& x) -> std::vector<double> { return NPFunc.xFactors(x, ifunc); }, fb.stride);
+    else if (kind == Parameterisation::zetaFactor)
+      fb.tab = TabulateFactors(v, [&] (double const& zeta) -> std::vector<double> { return NPFunc.zetaFactors(zeta, ifunc); }, fb.stride);
+    else
+      throw std::runtime_error("[ConvolutionTable::UpdateFactorBuffer]: only x and zeta factors can be buffered.");
+  }
+
+  //_________________________________________________________________________________
+  void ConvolutionTable::SetIncrementalMode(bool const& incremental)
+  {
+    _incr = incremental;
+    _fbuf.clear();
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> ConvolutionTable::BinPredictions(std::map<double, double> const& pred) const
   {
     const int npred = _qTmap.size();
     std::vector<double> vpred(npred);
-    std::map<double, double> pred;
     switch (_proc)
       {
       // Drell-Yan: two PDFs
       case DataHandler::Process::DY:
-        pred = ConvoluteDY(fNP1);
         if (_IntqT)
           for (int i = 0; i < npred; i++)
             {
@@ -211,7 +536,6 @@ namespace NangaParbat
 
       // SIDIS: one PDF and one FF
       case DataHandler::Process::SIDIS:
-        pred = ConvoluteSIDIS(fNP1, fNP2);
         if (_IntqT)
           for (int i = 0; i < npred; i++)
               vpred[i] = _prefact * (pred.at(_qTmap[i][1]) - pred.at(_qTmap[i][0])) / ( _qTmap[i][1] - _qTmap[i][0]); 
@@ -228,6 +552,188 @@ namespace NangaParbat
     return vpred;
   }
 
+  //_________________________________________________________________________________
+  std::vector<double> ConvolutionTable::GetPredictions(std::function<double(double const&, double const&, double const&)> const& fNP1,
+                                                       std::function<double(double const&, double const&, double const&)> const& fNP2) const
+  {
+    std::map<double, double> pred;
+    switch (_proc)
+      {
+      // Drell-Yan: two PDFs
+      case DataHandler::Process::DY:
+        pred = ConvoluteDY(fNP1);
+        break;
+
+      // SIDIS: one PDF and one FF
+      case DataHandler::Process::SIDIS:
+        pred = ConvoluteSIDIS(fNP1, fNP2);
+        break;
+
+      // e+e- annihilation into two hadrons: two FFs (Not present
+      // yet)
+      case DataHandler::Process::DIA:
+        break;
+      }
+    return BinPredictions(pred);
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> ConvolutionTable::GetPredictions(Parameterisation const& NPFunc) const
+  {
+    std::map<double, double> pred;
+    switch (_proc)
+      {
+      // Drell-Yan: two PDFs
+      case DataHandler::Process::DY:
+        pred = ConvoluteDY(NPFunc);
+        break;
+
+      // SIDIS: one PDF and one FF
+      case DataHandler::Process::SIDIS:
+        pred = ConvoluteSIDIS(NPFunc);
+        break;
+
+      // e+e- annihilation into two hadrons: two FFs (Not present
+      // yet)
+      case DataHandler::Process::DIA:
+        break;
+      }
+    return BinPredictions(pred);
+  }
+
+  //_________________________________________________________________________________
+  std::vector<std::vector<double>> ConvolutionTable::GetPredictionDerivatives(Parameterisation const& NPFunc) const
+  {
+    const int np = NPFunc.GetParameterNumber();
+    const int nn = _xn1.size();
+
+    // Values of b and of the non-perturbative functions and their
+    // gradients on the nodes. The gradients are ordered as
+    // [node][parameter].
+    std::vector<double> bn(nn);
+    std::vector<double> f1(nn);
+    std::vector<double> f2(nn);
+    std::vector<double> g1(nn * np);
+    std::vector<double> g2(nn * np);
+
+    // The functions are evaluated as in "GetPredictions", i.e. through
+    // the factor buffers if the parameterisation is separable and
+    // through "EvaluateBatch" otherwise, such that the Ogata sum is
+    // truncated at the same point. The gradients are evaluated through
+    // "GradientBatch".
+    std::vector<FactorBuffer> lfb;
+    std::vector<FactorBuffer>& fb = (_incr && NPFunc.IsSeparable() ? _fbuf : lfb);
+    UpdateFactorBuffers(NPFunc, fb);
+
+    // Derivatives of the unbinned predictions, one map per parameter
+    std::vector<std::map<double, double>> dpred(np);
+    switch (_proc)
+      {
+      // Drell-Yan: two PDFs. The derivative of f(x1) f(x2) is
+      // f'(x1) f(x2) + f(x1) f'(x2).
+      case DataHandler::Process::DY:
+      {
+        const int nxi = _xig.size();
+        for (int iqT = 0; iqT < (int) _qTv.size(); iqT++)
+          {
+            std::vector<double> dcs(np, 0.);
+            std::vector<double> ddcs(np, 0.);
+            if (_qTv[iqT] / _Qg.front() <= _qToQmax)
+              {
+                const auto& wgt  = _WDY.at(_qTv[iqT]);
+                const auto& psf  = _PSRed.at(_qTv[iqT]);
+                const auto& dpsf = _dPSRed.at(_qTv[iqT]);
+                double cs = 0;
+                for (int n = 0; n < (int) _zOgata.size(); n++)
+                  {
+                    EvaluateOnNodes(NPFunc, fb, _zOgata[n] / _qTv[iqT], bn, f1, f2);
+                    NPFunc.GradientBatch(nn, _xn1.data(), bn.data(), _zetan.data(), 0, g1.data());
+                    NPFunc.GradientBatch(nn, _xn2.data(), bn.data(), _zetan.data(), 0, g2.data());
+
+                    double csn = 0;
+                    for (int tau = 0; tau < (int) _Qg.size(); tau++)
+                      for (int alpha = 0; alpha < nxi; alpha++)
+                        {
+                          const int    i = tau * nxi + alpha;
+                          const double w = wgt[n][tau][alpha];
+                          csn += w * f1[i] * f2[i] * psf[tau][alpha];
+                          for (int ip = 0; ip < np; ip++)
+                            {
+                              const double wd = w * ( g1[i * np + ip] * f2[i] + f1[i] * g2[i * np + ip] );
+                              dcs[ip]  += wd * psf[tau][alpha];
+                              ddcs[ip] += wd * dpsf[tau][alpha];
+                            }
+                        }
+                    cs += csn;
+                    if (std::abs(csn/cs) < _acc)
+                      break;
+                  }
+              }
+            for (int ip = 0; ip < np; ip++)
+              {
+                dpred[ip].insert({_qTv[iqT],  dcs[ip]});
+                dpred[ip].insert({-_qTv[iqT], ddcs[ip]});
+              }
+          }
+        break;
+      }
+
+      // SIDIS: one PDF and one FF. The derivative of f(xb) D(z) is
+      // f'(xb) D(z) + f(xb) D'(z).
+      case DataHandler::Process::SIDIS:
+      {
+        const int nxb = _xbg.size();
+        const int nz  = _zg.size();
+        for (int iqT = 0; iqT < (int) _qTv.size(); iqT++)
+          {
+            std::vector<double> dcs(np, 0.);
+            if (_qTv[iqT] / _Qg.front() / _zg.front() <= _qToQmax)
+              {
+                const auto& wgt = _WSIDIS.at(_qTv[iqT]);
+                double cs = 0;
+                for (int n = 0; n < (int) _zOgata.size(); n++)
+                  {
+                    EvaluateOnNodes(NPFunc, fb, _zOgata[n] / _qTv[iqT], bn, f1, f2);
+                    NPFunc.GradientBatch(nn, _xn1.data(), bn.data(), _zetan.data(), 0, g1.data());
+                    NPFunc.GradientBatch(nn, _xn2.data(), bn.data(), _zetan.data(), 1, g2.data());
+
+                    double csn = 0;
+                    for (int tau = 0; tau < (int) _Qg.size(); tau++)
+                      for (int alpha = 0; alpha < nxb; alpha++)
+                        for (int beta = 0; beta < nz; beta++)
+                          {
+                            const int    i = ( tau * nxb + alpha ) * nz + beta;
+                            const double w = wgt[n][tau][alpha][beta];
+                            csn += w * f1[i] * f2[i];
+                            for (int ip = 0; ip < np; ip++)
+                              dcs[ip] += w * ( g1[i * np + ip] * f2[i] + f1[i] * g2[i * np + ip] );
+                          }
+                    cs += csn;
+                    if (std::abs(csn/cs) < _acc)
+                      break;
+                  }
+              }
+            for (int ip = 0; ip < np; ip++)
+              dpred[ip].insert({_qTv[iqT], dcs[ip]});
+          }
+        break;
+      }
+
+      // e+e- annihilation into two hadrons: two FFs (Not present
+      // yet)
+      case DataHandler::Process::DIA:
+        return std::vector<std::vector<double>>(np);
+      }
+
+    // The binning is linear in the unbinned predictions, therefore it
+    // applies to the derivatives as well.
+    std::vector<std::vector<double>> dvpred(np);
+    for (int ip = 0; ip < np; ip++)
+      dvpred[ip] = BinPredictions(dpred[ip]);
+
+    return dvpred;
+  }
+
   //_________________________________________________________________________________
   std::vector<double> ConvolutionTable::GetPredictions(std::function<double(double const&, double const&, double const&, int const&)> const& fNP) const
   {
@@ -285,4 +791,26 @@ namespace NangaParbat
     std::transform(p1.begin(), p1.end(), p2.begin(), p1.begin(), std::plus<double>());
     return p1;
   }
+
+  //_________________________________________________________________________________
+  std::vector<int> ConvolutionTable::GetFunctionIndices() const
+  {
+    switch (_proc)
+      {
+      // Drell-Yan: two PDFs
+      case DataHandler::Process::DY:
+        return {0};
+
+      // SIDIS: one PDF and one FF
+      case DataHandler::Process::SIDIS:
+        return {0, 1};
+
+      // e+e- annihilation into two hadrons: two FFs
+      case DataHandler::Process::DIA:
+        return {1};
+
+      default:
+        return {0, 1};
+      }
+  }
 }
@@ -6,107 +6,45 @@
 #include "NangaParbat/generategrid.h"
 #include "NangaParbat/bstar.h"
 
-#include <LHAPDF/LHAPDF.h>
-
 namespace NangaParbat
 {
   //_________________________________________________________________________________
-  FastInterface::FastInterface(YAML::Node const& config):
-    _config(config)
+  FastInterface::FastInterface(YAML::Node const& config, std::shared_ptr<TMDService const> const& service):
+    _config(config),
+    _tmds(service)
   {
     // Set verbosity level of APFEL++ to the minimum
     apfel::SetVerbosityLevel(0);
 
-    // Open LHAPDF PDF set
-    LHAPDF::PDF* distpdf = LHAPDF::mkPDF(_config["pdfset"]["name"].as<std::string>(), _config["pdfset"]["member"].as<int>());
-
-    // Rotate PDF set into the QCD evolution basis
-    const auto RotPDFs = [&] (double const& x, double const& mu) -> std::map<int,double> { return apfel::PhysToQCDEv(distpdf->xfxQ(x, mu)); };
-
-    // Heavy-quark thresholds (from PDFs)
-    for (auto const& v : distpdf->flavors())
-      if (v > 0 && v < 7)
-        _Thresholds.push_back(distpdf->quarkThreshold(v));
-
-    // Alpha_s (from PDFs). Get it from the LHAPDF set and tabulate it.
-    _TabAlphas = std::unique_ptr<apfel::TabulateObject<double>>(new apfel::TabulateObject<double> {[&] (double const& mu) -> double{return distpdf->alphasQ(mu); },
-                                                                                                   100, distpdf->qMin(), distpdf->qMax(), 3, _Thresholds
-                                                                                                  });
-
-    // Open LHAPDF FF set
-    LHAPDF::PDF* distff = LHAPDF::mkPDF(_config["ffset"]["name"].as<std::string>(), _config["ffset"]["member"].as<int>());
-
-    // Rotate FF set into the QCD evolution basis
-    const auto RotFFs = [&] (double const& x, double const& mu) -> std::map<int,double> { return apfel::PhysToQCDEv(distff->xfxQ(x, mu)); };
-
-    // Define x-space grid for PDFs
-    std::vector<apfel::SubGrid> vsgpdf;
-    for (auto const& sg : _config["xgridpdf"])
-      vsgpdf.push_back({sg[0].as<int>(), sg[1].as<double>(), sg[2].as<int>()});
-    _gpdf = std::unique_ptr<const apfel::Grid>(new apfel::Grid({vsgpdf}));
-
-    // Construct set of distributions as a function of the scale to be
-    // tabulated for PDFs
-    const auto EvolvedPDFs = [=] (double const& mu) -> apfel::Set<apfel::Distribution>
-    {
-      return apfel::Set<apfel::Distribution>{apfel::EvolutionBasisQCD{apfel::NF(mu, _Thresholds)}, DistributionMap(*_gpdf, RotPDFs, mu)};
-    };
-
-    // Tabulate collinear PDFs
-    _TabPDFs = std::unique_ptr<apfel::TabulateObject<apfel::Set<apfel::Distribution>>>
-               (new apfel::TabulateObject<apfel::Set<apfel::Distribution>> {EvolvedPDFs, 100, distpdf->qMin(), distpdf->qMax(), 3, _Thresholds});
-
-    // Define x-space grid for FFs
-    std::vector<apfel::SubGrid> vsgff;
-    for (auto const& sg : _config["xgridff"])
-      vsgff.push_back({sg[0].as<int>(), sg[1].as<double>(), sg[2].as<int>()});
-    _gff = std::unique_ptr<const apfel::Grid>(new apfel::Grid({vsgff}));
-
-    // Construct set of distributions as a function of the scale to be
-    // tabulated for FFs
-    const auto EvolvedFFs = [=] (double const& mu) -> apfel::Set<apfel::Distribution>
-    {
-      return apfel::Set<apfel::Distribution>{apfel::EvolutionBasisQCD{apfel::NF(mu, _Thresholds)}, DistributionMap(*_gff, RotFFs, mu)};
-    };
-
-    // Tabulate collinear FFs
-    _TabFFs = std::unique_ptr<apfel::TabulateObject<apfel::Set<apfel::Distribution>>>
-              (new apfel::TabulateObject<apfel::Set<apfel::Distribution>> {EvolvedFFs, 100, distff->qMin(), distff->qMax(), 3, _Thresholds});
-
-    // Initialise TMD objects for PDFs
-    _TmdPdfObjs = apfel::InitializeTmdObjects(*_gpdf, _Thresholds);
-
-    // Initialise TMD objects for FFs
-    _TmdFfObjs = apfel::InitializeTmdObjects(*_gff, _Thresholds);
-
-    // Build evolved TMD PDFs and FFs
+    // Collinear distributions, strong coupling, and evolved TMDs
+    if (!_tmds)
+      _tmds = std::make_shared<TMDService const>(_config);
+
+    // TMD PDFs and FFs at the initial scale, Sudakov form factor, and
+    // hard factors. The functions hold a copy of the pointer to the
+    // service so that they do not depend on this object.
+    const std::shared_ptr<TMDService const> tmds = _tmds;
     const int    pto = _config["PerturbativeOrder"].as<int>();
     const double Ci  = _config["TMDscales"]["Ci"].as<double>();
     const double Cf  = _config["TMDscales"]["Cf"].as<double>();
-    const auto Alphas = [&] (double const& mu) -> double{ return _TabAlphas->Evaluate(mu); };
-
-    const auto CollPDFs = [&] (double const& mu) -> apfel::Set<apfel::Distribution> { return _TabPDFs->Evaluate(mu); };
-    _EvTMDPDFs = BuildTmdPDFs(_TmdPdfObjs, CollPDFs, Alphas, pto, Ci);
-    _MatchTMDPDFs = MatchTmdPDFs(_TmdPdfObjs, CollPDFs, Alphas, pto, Ci);
+    const auto Alphas = [=] (double const& mu) -> double{ return tmds->Alphas(mu); };
 
-    const auto CollFFs = [&] (double const& mu) -> apfel::Set<apfel::Distribution> { return _TabFFs->Evaluate(mu); };
-    _EvTMDFFs = BuildTmdFFs(_TmdFfObjs, CollFFs, Alphas, pto, Ci);
-    _MatchTMDFFs = MatchTmdFFs(_TmdFfObjs, CollFFs, Alphas, pto, Ci);
+    const auto CollPDFs = [=] (double const& mu) -> apfel::Set<apfel::Distribution> { return tmds->GetCollinearDistributions("pdf").Evaluate(mu); };
+    _MatchTMDPDFs = MatchTmdPDFs(_tmds->GetTmdObjects("pdf"), CollPDFs, Alphas, pto, Ci);
 
-    _QuarkSudakov = QuarkEvolutionFactor(_TmdPdfObjs, Alphas, pto, Ci, 1e5);
+    const auto CollFFs = [=] (double const& mu) -> apfel::Set<apfel::Distribution> { return tmds->GetCollinearDistributions("ff").Evaluate(mu); };
+    _MatchTMDFFs = MatchTmdFFs(_tmds->GetTmdObjects("ff"), CollFFs, Alphas, pto, Ci);
 
-    _HardFactorDY    = apfel::HardFactor("DY",    _TmdPdfObjs, Alphas, pto, Cf);
-    _HardFactorSIDIS = apfel::HardFactor("SIDIS", _TmdPdfObjs, Alphas, pto, Cf);
+    _QuarkSudakov = QuarkEvolutionFactor(_tmds->GetTmdObjects("pdf"), Alphas, pto, Ci, 1e5);
 
-    // Delete LHAPDF sets
-    delete distpdf;
-    delete distff;
+    _HardFactorDY    = apfel::HardFactor("DY",    _tmds->GetTmdObjects("pdf"), Alphas, pto, Cf);
+    _HardFactorSIDIS = apfel::HardFactor("SIDIS", _tmds->GetTmdObjects("pdf"), Alphas, pto, Cf);
 
     // b* presciption
     _bstar = bstarMap.at(_config["bstar"].as<std::string>());
 
     // Alpha_em (provided by APFEL)
-    apfel::AlphaQED a{_config["alphaem"]["aref"].as<double>(), _config["alphaem"]["Qref"].as<double>(), _Thresholds, {0, 0, 1.777}, 0};
+    apfel::AlphaQED a{_config["alphaem"]["aref"].as<double>(), _config["alphaem"]["Qref"].as<double>(), _tmds->GetThresholds(), {0, 0, 1.777}, 0};
     _TabAlphaem = std::unique_ptr<apfel::TabulateObject<double>>(new apfel::TabulateObject<double> {a, 100, 0.9, 1001, 3});
   }
 
@@ -128,7 +66,7 @@ namespace NangaParbat
     const double frn = 1 - frp;
 
     // Number of active flavours at 'Q'
-    const int nf = apfel::NF(muf, _Thresholds);
+    const int nf = apfel::NF(muf, _tmds->GetThresholds());
 
     // EW charges
     const std::vector<double> Bq = apfel::ElectroWeakCharges(Q, true);
@@ -138,7 +76,7 @@ namespace NangaParbat
 
     // Global factor
     const double factor = apfel::ConvFact * 8 * M_PI * aem2 * _HardFactorDY(muf) / 9 / pow(Q, 3);
-    const std::map<int, apfel::Distribution> xF = QCDEvToPhys(_EvTMDPDFs(bT, muf, zetaf).GetObjects());
+    const std::map<int, apfel::Distribution> xF = QCDEvToPhys(_tmds->Evaluate("pdf", bT, muf, zetaf).GetObjects());
     apfel::DoubleObject<apfel::Distribution> Lumi;
 
     // Treat down and up separately to take isoscalarity of the target
@@ -223,7 +161,7 @@ namespace NangaParbat
         const double prefactor = DHVect[i].GetPrefactor();
 
         // Retrieve kinematics
-        const DataHandler::Kinematics                kin      = DHVect[i].GetKinematics();
+        DataHandler::Kinematics const&               kin      = DHVect[i].GetKinematics();
         const double                                 Vs       = kin.Vs;       // C.M.E.
         const std::vector<double>                    qTv      = kin.qTv;      // Transverse momentum bin bounds
         const std::vector<std::pair<double, double>> qTmap    = kin.qTmap;    // Map of qT bounds to associate to the single bins
@@ -481,7 +419,7 @@ namespace NangaParbat
           throw std::runtime_error("[FastInterface::ComputeTablesSIDIS]: Only SIDIS data sets can be treated here.");
 
         // Retrieve kinematics
-        const DataHandler::Kinematics                kin    = DHVect[i].GetKinematics();
+        DataHandler::Kinematics const&               kin    = DHVect[i].GetKinematics();
         const double                                 Vs     = kin.Vs;       // C.M.E.
         const std::vector<double>                    qTv    = kin.qTv;      // Transverse momentum bin bounds
         const std::vector<std::pair<double, double>> qTmap  = kin.qTmap;    // Map of PhT bounds to associate to the single bins
@@ -545,7 +483,7 @@ namespace NangaParbat
         const std::function<std::map<int, double>(double const&, double const&)> tPDFs = [&] (double const& x, double const& Q) -> std::map<int, double>
         {
           // Get PDFs in the physical basis
-          const std::map<int, double> pr = apfel::QCDEvToPhys(_TabPDFs->EvaluateMapxQ(x, Q));
+          const std::map<int, double> pr = apfel::QCDEvToPhys(_tmds->GetCollinearDistributions("pdf").EvaluateMapxQ(x, Q));
           std::map<int, double> tg = pr;
           // Apply isoscalarity
           tg.at(1)  = frp * pr.at(1)  + frn * pr.at(2);
@@ -571,10 +509,10 @@ namespace NangaParbat
           PerturbativeOrder++;
 
         // Initialise inclusive structure functions
-        const auto IF2 = BuildStructureFunctions(InitializeF2NCObjectsZM(*_gpdf, _Thresholds), RotPDFs, PerturbativeOrder,
-                                                 [=] (double const& Q) -> double{ return _TabAlphas->Evaluate(Q); }, fBq);
-        const auto IFL = BuildStructureFunctions(InitializeFLNCObjectsZM(*_gpdf, _Thresholds), RotPDFs, PerturbativeOrder,
-                                                 [=] (double const& Q) -> double{ return _TabAlphas->Evaluate(Q); }, fBq);
+        const auto IF2 = BuildStructureFunctions(InitializeF2NCObjectsZM(_tmds->GetGrid("pdf"), _tmds->GetThresholds()), RotPDFs, PerturbativeOrder,
+                                                 [=] (double const& Q) -> double{ return _tmds->Alphas(Q); }, fBq);
+        const auto IFL = BuildStructureFunctions(InitializeFLNCObjectsZM(_tmds->GetGrid("pdf"), _tmds->GetThresholds()), RotPDFs, PerturbativeOrder,
+                                                 [=] (double const& Q) -> double{ return _tmds->Alphas(Q); }, fBq);
 
         // Q integrand for the inclusive cross section
         const apfel::Integrator IncQIntegrand{[=] (double const& Q) -> double
@@ -685,7 +623,7 @@ namespace NangaParbat
         int istep = 0;
 
         // Maximum number of active flavours
-        const int nf = apfel::NF(Qb.second, _Thresholds);
+        const int nf = apfel::NF(Qb.second, _tmds->GetThresholds());
 
         // Loop over the qT-bin bounds. IMPORTANT: In the SIDIS case,
         // the vector "qTv" contains the values of of the hadronic pTh
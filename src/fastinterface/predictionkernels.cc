@@ -0,0 +1,55 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/predictionkernels.h"
+#include "NangaParbat/DWS.h"
+#include "NangaParbat/PV17.h"
+#include "NangaParbat/PV19.h"
+#include "NangaParbat/PV19b.h"
+#include "NangaParbat/PV19x.h"
+#include "NangaParbat/PV20Sivers.h"
+#include "NangaParbat/QGG6.h"
+#include "NangaParbat/QGG13.h"
+
+#include <map>
+
+namespace NangaParbat
+{
+  //_________________________________________________________________________________
+  template<class Model>
+  PredictionKernel MakePredictionKernel()
+  {
+    return [] (ConvolutionTable const& ct, Parameterisation const& NPFunc) -> std::vector<double>
+    {
+      Model const* model = dynamic_cast<Model const*>(&NPFunc);
+      if (model == nullptr)
+        throw std::runtime_error("[PredictionKernel]: the kernel does not match the parameterisation " + NPFunc.GetName());
+
+      return ct.Predict(*model);
+    };
+  }
+
+  //_________________________________________________________________________________
+  PredictionKernel GetPredictionKernel(std::string const& name)
+  {
+    // Kernels instantiated at compile time
+    const std::map<std::string, PredictionKernel> kernels
+    {
+      {"DWS",        MakePredictionKernel<DWS>()},
+      {"PV17",       MakePredictionKernel<PV17>()},
+      {"PV19",       MakePredictionKernel<PV19>()},
+      {"PV19b",      MakePredictionKernel<PV19b>()},
+      {"PV19x",      MakePredictionKernel<PV19x>()},
+      {"PV20Sivers", MakePredictionKernel<PV20Sivers>()},
+      {"QGG6",       MakePredictionKernel<QGG6>()},
+      {"QGG13",      MakePredictionKernel<QGG13>()}
+    };
+
+    // Fall back on the type-erased path if no kernel is available
+    if (kernels.count(name) == 0)
+      return [] (ConvolutionTable const& ct, Parameterisation const& NPFunc) -> std::vector<double> { return ct.GetPredictions(NPFunc); };
+
+    return kernels.at(name);
+  }
+}
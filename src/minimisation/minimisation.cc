@@ -191,6 +191,19 @@ namespace NangaParbat
     // Full report
     std::cout << summary.FullReport() << std::endl;
 
+    // Before returning, retrieve best-fit parameters and set them in
+    // the chi2 to make sure they will be used outside this function,
+    // since the last evaluation of the cost function need not be at
+    // the minimum.
+    std::vector<double> bestPars;
+    for (double* const p : initPars)
+      {
+        bestPars.push_back(*p);
+        delete p;
+      }
+    NangaParbat::FcnMinuit fcn{chi2};
+    fcn.SetParameters(bestPars);
+
     // Return minimisation status
     return summary.IsSolutionUsable();
   }
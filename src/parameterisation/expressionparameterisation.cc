@@ -0,0 +1,164 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/expressionparameterisation.h"
+
+#include <algorithm>
+
+namespace NangaParbat
+{
+  //_________________________________________________________________________________
+  ExpressionParameterisation::ExpressionParameterisation(std::string const& name, YAML::Node const& config):
+    Parameterisation{name, 0, {}, true},
+    _parnames(config["parameters"].as<std::vector<std::string>>()),
+    _functions(config["functions"].as<std::vector<std::string>>()),
+    _latex(config["latex"] ? config["latex"].as<std::string>() : ""),
+    _description(config["description"] ? config["description"].as<std::string>() : "Parameterisation defined by expressions in the input card.")
+  {
+    const int npars = _parnames.size();
+    this->_nfuncs = _functions.size();
+    if (this->_nfuncs == 0)
+      throw std::runtime_error("[ExpressionParameterisation::ExpressionParameterisation]: no functions given");
+
+    // Default parameters
+    this->_pars = (config["values"] ? config["values"].as<std::vector<double>>() : std::vector<double>(npars, 0.));
+    if ((int) this->_pars.size() != npars)
+      throw std::runtime_error("[ExpressionParameterisation::ExpressionParameterisation]: the number of values does not match the number of parameters");
+
+    // Variables: kinematics followed by the parameters
+    std::vector<std::string> vars{"x", "b", "zeta"};
+    for (auto const& p : _parnames)
+      {
+        if (std::find(vars.begin(), vars.end(), p) != vars.end())
+          throw std::runtime_error("[ExpressionParameterisation::ExpressionParameterisation]: duplicate or reserved parameter name " + p);
+        vars.push_back(p);
+      }
+    const int nkin = 3;
+
+    const std::map<std::string, double> constants = (config["constants"] ? config["constants"].as<std::map<std::string, double>>() : std::map<std::string, double> {});
+
+    // Parse the functions, differentiate them, and compile the
+    // programs.
+    _deps.resize(npars);
+    for (int ifunc = 0; ifunc < this->_nfuncs; ifunc++)
+      {
+        const Expression f{_functions[ifunc], vars, constants};
+        _xdep.push_back(f.DependsOn(0));
+        _values.push_back(std::make_shared<ExpressionProgram const>(std::vector<Expression>{f}, nkin));
+
+        std::vector<Expression> grad{f};
+        std::vector<std::shared_ptr<ExpressionProgram const>> derivs;
+        for (int ipar = 0; ipar < npars; ipar++)
+          {
+            const Expression df = f.Derive(nkin + ipar);
+            grad.push_back(df);
+            derivs.push_back(std::make_shared<ExpressionProgram const>(std::vector<Expression>{df}, nkin));
+            if (f.DependsOn(nkin + ipar))
+              _deps[ipar].push_back(ifunc);
+          }
+        _derivs.push_back(derivs);
+        _gradients.push_back(std::make_shared<ExpressionProgram const>(grad, nkin));
+      }
+  }
+
+  //_________________________________________________________________________________
+  void ExpressionParameterisation::SetParameters(std::vector<double> const& pars)
+  {
+    if (pars.size() != _parnames.size())
+      throw std::runtime_error("[ExpressionParameterisation::SetParameters]: expected " + std::to_string(_parnames.size()) + " parameters, got " + std::to_string(pars.size()));
+
+    this->_pars = pars;
+  }
+
+  //_________________________________________________________________________________
+  double ExpressionParameterisation::Run(ExpressionProgram const& prog, double const& x, double const& b, double const& zeta, int const& ifunc, double* res) const
+  {
+    if (_xdep[ifunc] && x >= 1)
+      {
+        std::fill(res, res + prog.GetNumberOfOutputs(), 0.);
+        return 0;
+      }
+
+    thread_local std::vector<double> vars;
+    vars.resize(3 + this->_pars.size());
+    vars[0] = x;
+    vars[1] = b;
+    vars[2] = zeta;
+    std::copy(this->_pars.begin(), this->_pars.end(), vars.begin() + 3);
+    prog.Evaluate(vars.data(), res);
+    return res[0];
+  }
+
+  //_________________________________________________________________________________
+  double ExpressionParameterisation::Evaluate(double const& x, double const& b, double const& zeta, int const& ifunc) const
+  {
+    if (ifunc < 0 || ifunc >= this->_nfuncs)
+      throw std::runtime_error("[ExpressionParameterisation::Evaluate]: function index out of range");
+
+    double res;
+    return Run(*_values[ifunc], x, b, zeta, ifunc, &res);
+  }
+
+  //_________________________________________________________________________________
+  void ExpressionParameterisation::EvaluateBatch(int const& n, double const* x, double const* b, double const* zeta, int const& ifunc, double* f) const
+  {
+    if (ifunc < 0 || ifunc >= this->_nfuncs)
+      throw std::runtime_error("[ExpressionParameterisation::EvaluateBatch]: function index out of range");
+
+    double const* arrays[] = {x, b, zeta};
+    _values[ifunc]->EvaluateBatch(n, arrays, this->_pars.data(), f);
+
+    if (_xdep[ifunc])
+      for (int i = 0; i < n; i++)
+        if (x[i] >= 1)
+          f[i] = 0;
+  }
+
+  //_________________________________________________________________________________
+  double ExpressionParameterisation::Derive(double const& x, double const& b, double const& zeta, int const& ifunc, int const& ipar) const
+  {
+    if (ifunc < 0 || ifunc >= this->_nfuncs)
+      throw std::runtime_error("[ExpressionParameterisation::Derive]: function index out of range");
+
+    if (ipar < 0 || ipar >= (int) this->_pars.size())
+      throw std::runtime_error("[ExpressionParameterisation::Derive]: parameter index out of range");
+
+    double res;
+    return Run(*_derivs[ifunc][ipar], x, b, zeta, ifunc, &res);
+  }
+
+  //_________________________________________________________________________________
+  double ExpressionParameterisation::Gradient(double const& x, double const& b, double const& zeta, int const& ifunc, double* grad) const
+  {
+    if (ifunc < 0 || ifunc >= this->_nfuncs)
+      throw std::runtime_error("[ExpressionParameterisation::Gradient]: function index out of range");
+
+    thread_local std::vector<double> res;
+    res.resize(1 + this->_pars.size());
+    Run(*_gradients[ifunc], x, b, zeta, ifunc, res.data());
+    std::copy(res.begin() + 1, res.end(), grad);
+    return res[0];
+  }
+
+  //_________________________________________________________________________________
+  std::vector<int> ExpressionParameterisation::GetParameterDependencies(int const& ipar) const
+  {
+    if (ipar < 0 || ipar >= (int) this->_pars.size())
+      throw std::runtime_error("[ExpressionParameterisation::GetParameterDependencies]: parameter index out of range");
+
+    return _deps[ipar];
+  }
+
+  //_________________________________________________________________________________
+  std::string ExpressionParameterisation::LatexFormula() const
+  {
+    if (!_latex.empty())
+      return _latex;
+
+    std::string formula;
+    for (int ifunc = 0; ifunc < this->_nfuncs; ifunc++)
+      formula += "$$f_{" + std::to_string(ifunc) + "}(x, b_T, \\zeta) = \\texttt{" + _functions[ifunc] + "}$$";
+    return formula;
+  }
+}
@@ -5,6 +5,7 @@
 #include "NangaParbat/meanreplica.h"
 #include "NangaParbat/nonpertfunctions.h"
 #include "NangaParbat/listdir.h"
+#include "NangaParbat/parallelfor.h"
 
 #include <fstream>
 #include <sys/stat.h>
@@ -15,47 +16,72 @@
 namespace NangaParbat
 {
   //_________________________________________________________________________________
-  MeanReplica::MeanReplica(std::string const& InputFolder, std::string const& FitConfigFile, std::vector<int> const& discard):
-    Parameterisation{"MeanReplica", 2}
+  MeanReplica::MeanReplica(std::string      const& InputFolder,
+                           std::string      const& FitConfigFile,
+                           std::vector<int> const& discard,
+                           int              const& nx,
+                           int              const& nbT,
+                           int              const& nzeta,
+                           int              const& nthreads):
+    Parameterisation{"MeanReplica", 2},
+    _nrep(0)
   {
     // Open configuration file
     const YAML::Node fitconfig = YAML::LoadFile(FitConfigFile);
 
-    // Get parameterisation name as a string
-    const std::string parameterisation = fitconfig["Parameterisation"].as<std::string>();
-
-    // Allocate "Parameterisation" derived object using the same
-    // parameterisation used in the fit. This is used only to
-    // retrieve information about the parameterisation.
-    _NPFunc = NangaParbat::GetParametersation(parameterisation);
+    // Get "Parameterisation" derived object using the same
+    // parameterisation used in the fit. This is used to tabulate the
+    // replicas one at a time.
+    _NPFunc = NangaParbat::MakeParameterisation(fitconfig);
 
     // Set the parameters to zero (this will not be used anywhere)
     this->_pars.resize(_NPFunc->GetParameterNames().size(), 0);
 
+    // Generate interpolation grid in x-space (logarithmic)
+    const double xmin = 1e-6;
+    const double xmax = 1;
+    std::vector<double> xv(nx);
+    for (int ix = 0; ix < nx; ix++)
+      xv[ix] = xmin * exp( log( xmax / xmin ) * ix / ( nx - 1 ) );
+
+    // Generate interpolation grid in bT-space (logarithmic)
+    const double bTmin = 1e-5;
+    const double bTmax = 10;
+    std::vector<double> bTv(nbT);
+    for (int ibT = 0; ibT < nbT; ibT++)
+      bTv[ibT] = bTmin * exp( log( bTmax / bTmin ) * ibT / ( nbT - 1 ) );
+
+    // Generate interpolation grid in zeta-space (logarithmic)
+    const double zetamin = 4;
+    const double zetamax = 40000;
+    std::vector<double> zetav(nzeta);
+    for (int izeta = 0; izeta < nzeta; izeta++)
+      zetav[izeta] = zetamin * exp( log( zetamax / zetamin ) * izeta / ( nzeta - 1 ) );
+
+    // Accumulators of mean and sum of the squared deviations from the
+    // mean (Welford's algorithm).
+    _mean.resize(_nfuncs * nx * nbT * nzeta, 0.);
+    _var.resize(_nfuncs * nx * nbT * nzeta, 0.);
+
+    std::cout << "\nTabulating central replica...\n" << std::endl;
+
     // Select replicas according to whether the fit converged (status
     // = 1) and the global error function per data point is less than
-    // a user-given cut.
-    for (auto const& folder : NangaParbat::list_dir(InputFolder))
+    // a user-given cut. Replicas are sorted so that the accumulation
+    // order, and thus the result, does not depend on the file system.
+    std::vector<std::string> folders = NangaParbat::list_dir(InputFolder);
+    std::sort(folders.begin(), folders.end());
+    for (auto const& folder : folders)
       if (folder.substr(0, 8) == "replica_" && folder != "replica_0")
         {
           const bool dsc = (find(discard.begin(), discard.end(), std::stoi(folder.substr(folder.find_last_of("_") + 1, folder.size()))) != discard.end());
+          std::vector<double> pars;
           try
             {
               const YAML::Node report = YAML::LoadFile(InputFolder + "/" + folder + "/Report.yaml");
               if (report["Status"].as<double>() == 1 && !dsc)
-                {
-                  std::vector<double> pars;
-                  for (auto const& m : _NPFunc->GetParameterNames())
-                    pars.push_back(report["Parameters"][m].as<double>());
-
-                  // Allocate "Parameterisation" derived object
-                  // using the same parameterisation used in the
-                  // fit, set the parameters of the usable fits, and
-                  // push it into a vector.
-                  NangaParbat::Parameterisation *fNP = NangaParbat::GetParametersation(parameterisation);
-                  fNP->SetParameters(pars);
-                  _NPFuncv.push_back(fNP);
-                }
+                for (auto const& m : _NPFunc->GetParameterNames())
+                  pars.push_back(report["Parameters"][m].as<double>());
               else
                 std::cout << "[MeanReplica::MeanReplica]: Warning: Replica in folder '" + folder + "' discarded." << std::endl;
             }
@@ -63,79 +89,49 @@ namespace NangaParbat
             {
               std::cout << "[MeanReplica::MeanReplica]: Warning: File 'Report.yaml' not found in folder '" + folder + "'." << std::endl;
             }
+          if (pars.empty())
+            continue;
+
+          // Set the parameters of the replica and accumulate it
+          _NPFunc->SetParameters(pars);
+          _nrep++;
+          ParallelFor(nx * nbT, [&] (int const& ixbT) -> void
+          {
+            const int ix  = ixbT / nbT;
+            const int ibT = ixbT % nbT;
+            for (int ifunc = 0; ifunc < _nfuncs; ifunc++)
+              for (int izeta = 0; izeta < nzeta; izeta++)
+                {
+                  const int    i = ( ( ifunc * nx + ix ) * nbT + ibT ) * nzeta + izeta;
+                  const double f = _NPFunc->Evaluate(xv[ix], bTv[ibT], zetav[izeta], ifunc);
+                  const double d = f - _mean[i];
+                  _mean[i] += d / _nrep;
+                  _var[i]  += d * ( f - _mean[i] );
+                }
+          }, nthreads);
         }
 
-    std::cout << "\nTabulating central replica...\n" << std::endl;
+    if (_nrep == 0)
+      throw std::runtime_error("[MeanReplica::MeanReplica]: no replicas available");
 
-    // Generate interpolation grid in x-space (logarithmic)
-    const int nx = 100;
-    const double xmin = 1e-6;
-    const double xmax = 1;
-    const double xstep = exp( log( xmax / xmin ) / ( nx - 1 ) );
-    std::vector<double> xv;
-    for (double x = xmin; x <= xmax + apfel::eps8; x *= xstep)
-      xv.push_back(x);
-
-    // Generate interpolation grid in bT-space (logarithmic)
-    const int nbT = 100;
-    const double bTmin = 1e-5;
-    const double bTmax = 10;
-    const double bTstep = exp( log( bTmax / bTmin ) / ( nbT - 1 ) );
-    std::vector<double> bTv;
-    for (double bT = bTmin; bT <= bTmax + apfel::eps8; bT *= bTstep)
-      bTv.push_back(bT);
-
-    // Generate interpolation grid in zeta-space (logarithmic)
-    const int nzeta = 50;
-    const double zetamin = 4;
-    const double zetamax = 40000;
-    const double zetastep = exp( log( zetamax / zetamin ) / ( nzeta - 1 ) );
-    std::vector<double> zetav;
-    for (double zeta = zetamin; zeta <= zetamax + apfel::eps8; zeta *= zetastep)
-      zetav.push_back(zeta);
-
-    // Tabulate mean replica
-    _fNP1g.resize(nx, std::vector<std::vector<double>>(nbT, std::vector<double>(nzeta, 0.)));
-    _fNP2g.resize(nx, std::vector<std::vector<double>>(nbT, std::vector<double>(nzeta, 0.)));
-    for (int ix = 0; ix < nx; ix++)
-      for (int ibT = 0; ibT < nbT; ibT++)
-        for (int izeta = 0; izeta < nzeta; izeta++)
-          {
-            for (auto const& fNP : _NPFuncv)
-              {
-                _fNP1g[ix][ibT][izeta] += fNP->Evaluate(xv[ix], bTv[ibT], zetav[izeta], 0);
-                _fNP2g[ix][ibT][izeta] += fNP->Evaluate(xv[ix], bTv[ibT], zetav[izeta], 1);
-              }
-            const int nrep = (int) _NPFuncv.size();
-            _fNP1g[ix][ibT][izeta] /= nrep;
-            _fNP2g[ix][ibT][izeta] /= nrep;
-          }
+    // Turn the sums of the squared deviations into variances
+    for (auto& v : _var)
+      v = (_nrep > 1 ? v / ( _nrep - 1 ) : 0);
 
     // Initialise "apfel::QGrid" objects that will provide the
     // interpolating functions.
-    _xg    = std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {xv,    1});
-    _bTg   = std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {bTv,   1});
-    _zetag = std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {zetav, 1});
+    _xg    = std::make_shared<apfel::QGrid<double> const>(xv,    1);
+    _bTg   = std::make_shared<apfel::QGrid<double> const>(bTv,   1);
+    _zetag = std::make_shared<apfel::QGrid<double> const>(zetav, 1);
   }
 
   //_________________________________________________________________________________
-  MeanReplica::~MeanReplica()
+  double MeanReplica::Interpolate(std::vector<double> const& grid, double const& x, double const& bT, double const& zeta, int const& ifunc) const
   {
-    delete _NPFunc;
-  }
+    const int nx    = _xg->GetQGrid().size();
+    const int nbT   = _bTg->GetQGrid().size();
+    const int nzeta = _zetag->GetQGrid().size();
 
-  //_________________________________________________________________________________
-  double MeanReplica::Evaluate(double const& x, double const& bT, double const& zeta, int const& ifunc) const
-  {
-    if (ifunc < 0 || ifunc >= this->_nfuncs)
-      throw std::runtime_error("[MeanReplica::Evaluate]: function index out of range");
-    /*
-        // Calculate mean over replicas
-        double sum = 0;
-        for (auto const& fNP : _NPFuncv)
-          sum += fNP->Evaluate(x, bT, zeta, ifunc);
-        sum /= _NPFuncv.size();
-    */
     // Interpolate
     const std::tuple<int, int, int> xbounds    = _xg->SumBounds(x);
     const std::tuple<int, int, int> bTbounds   = _bTg->SumBounds(bT);
@@ -149,11 +145,29 @@ namespace NangaParbat
             _xg->Interpolant(std::get<0>(xbounds), ix, x) *
             _bTg->Interpolant(std::get<0>(bTbounds), ibT, bT) *
             _zetag->Interpolant(std::get<0>(zetabounds), izeta, zeta) *
-            _fNP1g[ix][ibT][izeta];
+            grid[( ( ifunc * nx + ix ) * nbT + ibT ) * nzeta + izeta];
 
     return result;
   }
 
+  //_________________________________________________________________________________
+  double MeanReplica::Evaluate(double const& x, double const& bT, double const& zeta, int const& ifunc) const
+  {
+    if (ifunc < 0 || ifunc >= this->_nfuncs)
+      throw std::runtime_error("[MeanReplica::Evaluate]: function index out of range");
+
+    return Interpolate(_mean, x, bT, zeta, ifunc);
+  }
+
+  //_________________________________________________________________________________
+  double MeanReplica::Variance(double const& x, double const& bT, double const& zeta, int const& ifunc) const
+  {
+    if (ifunc < 0 || ifunc >= this->_nfuncs)
+      throw std::runtime_error("[MeanReplica::Variance]: function index out of range");
+
+    return Interpolate(_var, x, bT, zeta, ifunc);
+  }
+
   //_________________________________________________________________________________
   std::string MeanReplica::LatexFormula() const
   {
@@ -6,9 +6,57 @@
 
 namespace NangaParbat
 {
+  //_________________________________________________________________________________
+  std::map<std::string, std::unique_ptr<Parameterisation const>> const& AvailableParameterisations()
+  {
+    // Function-local static initialised only once also in presence
+    // of multiple threads.
+    static const std::map<std::string, std::unique_ptr<Parameterisation const>> AvPars = [] ()
+    {
+      std::map<std::string, std::unique_ptr<Parameterisation const>> m;
+      m["DWS"]   = std::unique_ptr<Parameterisation const>(new DWS{});
+      m["PV17"]  = std::unique_ptr<Parameterisation const>(new PV17{});
+      //m["PV19"]  = std::unique_ptr<Parameterisation const>(new PV19{});
+      m["PV19b"] = std::unique_ptr<Parameterisation const>(new PV19b{});
+      m["PV19x"] = std::unique_ptr<Parameterisation const>(new PV19x{});
+      //m["QGG6"]  = std::unique_ptr<Parameterisation const>(new QGG6{});
+      //m["QGG13"] = std::unique_ptr<Parameterisation const>(new QGG13{});
+      return m;
+    }();
+    return AvPars;
+  }
+
+  //_________________________________________________________________________________
+  std::unique_ptr<Parameterisation> MakeParameterisation(std::string const& name)
+  {
+    const auto p = AvailableParameterisations().find(name);
+    if (p == AvailableParameterisations().end())
+      throw std::runtime_error("[MakeParameterisation]: unknown parameterisation " + name);
+
+    return p->second->Clone();
+  }
+
+  //_________________________________________________________________________________
+  std::unique_ptr<Parameterisation> MakeParameterisation(std::string const& name, ParameterSet const& pars)
+  {
+    std::unique_ptr<Parameterisation> p = MakeParameterisation(name);
+    p->SetParameters(pars.GetValues());
+    return p;
+  }
+
+  //_________________________________________________________________________________
+  std::unique_ptr<Parameterisation> MakeParameterisation(YAML::Node const& config)
+  {
+    const std::string name = config["Parameterisation"].as<std::string>();
+    if (config["Expression"])
+      return std::unique_ptr<Parameterisation>(new ExpressionParameterisation{name, config["Expression"]});
+
+    return MakeParameterisation(name);
+  }
+
   //_________________________________________________________________________________
   Parameterisation* GetParametersation(std::string const& name)
   {
-    return AvPars.at(name);
+    return MakeParameterisation(name).release();
   }
 }
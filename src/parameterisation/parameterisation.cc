@@ -4,6 +4,8 @@
 
 #include "NangaParbat/parameterisation.h"
 
+#include <numeric>
+
 namespace NangaParbat
 {
   //_________________________________________________________________________________
@@ -15,6 +17,62 @@ namespace NangaParbat
   {
   }
 
+  //_________________________________________________________________________________
+  std::unique_ptr<Parameterisation> Parameterisation::Clone() const
+  {
+    throw std::runtime_error("[Parameterisation::Clone]: the parameterisation " + _name + " cannot be cloned");
+  }
+
+  //_________________________________________________________________________________
+  std::unique_ptr<Parameterisation> Parameterisation::Clone(ParameterSet const& pars) const
+  {
+    std::unique_ptr<Parameterisation> c = Clone();
+    c->SetParameters(pars.GetValues());
+    return c;
+  }
+
+  //_________________________________________________________________________________
+  void Parameterisation::EvaluateBatch(int const& n, double const* x, double const* b, double const* zeta, int const& ifunc, double* f) const
+  {
+    for (int i = 0; i < n; i++)
+      f[i] = Evaluate(x[i], b[i], zeta[i], ifunc);
+  }
+
+  //_________________________________________________________________________________
+  double Parameterisation::Gradient(double const& x, double const& b, double const& zeta, int const& ifunc, double* grad) const
+  {
+    for (int ipar = 0; ipar < GetParameterNumber(); ipar++)
+      grad[ipar] = Derive(x, b, zeta, ifunc, ipar);
+    return Evaluate(x, b, zeta, ifunc);
+  }
+
+  //_________________________________________________________________________________
+  void Parameterisation::GradientBatch(int const& n, double const* x, double const* b, double const* zeta, int const& ifunc, double* grad) const
+  {
+    const int np = GetParameterNumber();
+    for (int i = 0; i < n; i++)
+      Gradient(x[i], b[i], zeta[i], ifunc, grad + i * np);
+  }
+
+  //_________________________________________________________________________________
+  std::vector<int> Parameterisation::GetParameterDependencies(int const& ipar) const
+  {
+    if (ipar < 0 || ipar >= GetParameterNumber())
+      throw std::runtime_error("[Parameterisation::GetParameterDependencies]: parameter index out of range");
+
+    std::vector<int> funcs(_nfuncs);
+    std::iota(funcs.begin(), funcs.end(), 0);
+    return funcs;
+  }
+
+  //_________________________________________________________________________________
+  std::vector<int> Parameterisation::GetFactorDependencies(FactorKind const&, int const&) const
+  {
+    std::vector<int> pars(GetParameterNumber());
+    std::iota(pars.begin(), pars.end(), 0);
+    return pars;
+  }
+
   //_________________________________________________________________________________
   std::function<double(double const&, double const&, double const&, int const&)> Parameterisation::Function() const
   {
@@ -0,0 +1,243 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/tabulatedparameterisation.h"
+#include "NangaParbat/parallelfor.h"
+
+#include <algorithm>
+
+namespace NangaParbat
+{
+  namespace
+  {
+    //_________________________________________________________________________________
+    std::vector<double> LogGrid(int const& n, double const& min, double const& max)
+    {
+      std::vector<double> g(n);
+      for (int i = 0; i < n; i++)
+        g[i] = min * exp( log( max / min ) * i / ( n - 1 ) );
+      return g;
+    }
+  }
+
+  //_________________________________________________________________________________
+  TabulatedParameterisation::TabulatedParameterisation(Parameterisation          *NPFunc,
+                                                       std::vector<double> const& xg,
+                                                       std::vector<double> const& bTg,
+                                                       std::vector<double> const& zetag,
+                                                       int                 const& degree,
+                                                       bool                const& derivatives,
+                                                       int                 const& nthreads):
+    Parameterisation{"Tabulated" + NPFunc->GetName(), NPFunc->GetNumberOfFunctions(), NPFunc->GetParameters(), derivatives || NPFunc->HasGradient()},
+    _NPFunc(NPFunc),
+    _derivs(derivatives),
+    _nthreads(nthreads)
+  {
+    // Initialise "apfel::QGrid" objects that will provide the
+    // interpolating functions.
+    _xg    = std::make_shared<apfel::QGrid<double> const>(xg.empty()    ? LogGrid(100, 1e-6, 0.99) : xg,    degree);
+    _bTg   = std::make_shared<apfel::QGrid<double> const>(bTg.empty()   ? LogGrid(100, 1e-5, 10)   : bTg,   degree);
+    _zetag = std::make_shared<apfel::QGrid<double> const>(zetag.empty() ? LogGrid(50, 4, 40000)   : zetag, degree);
+
+    // Tabulate with the current parameters
+    Tabulate();
+  }
+
+  //_________________________________________________________________________________
+  std::unique_ptr<Parameterisation> TabulatedParameterisation::Clone() const
+  {
+    std::unique_ptr<TabulatedParameterisation> c{new TabulatedParameterisation{*this}};
+    c->_owned  = _NPFunc->Clone();
+    c->_NPFunc = c->_owned.get();
+    return std::unique_ptr<Parameterisation>(c.release());
+  }
+
+  //_________________________________________________________________________________
+  void TabulatedParameterisation::SetParameters(std::vector<double> const& pars)
+  {
+    this->_pars = pars;
+    _NPFunc->SetParameters(pars);
+    Tabulate();
+  }
+
+  //_________________________________________________________________________________
+  void TabulatedParameterisation::Tabulate()
+  {
+    const std::vector<double>& xv    = _xg->GetQGrid();
+    const std::vector<double>& bTv   = _bTg->GetQGrid();
+    const std::vector<double>& zetav = _zetag->GetQGrid();
+    const int nx    = xv.size();
+    const int nbT   = bTv.size();
+    const int nzeta = zetav.size();
+
+    // Value of the function followed, if required, by the derivatives
+    _nk = (_derivs ? 1 + GetParameterNumber() : 1);
+    _tab.assign(_nfuncs * nx * nbT * nzeta * _nk, 0.);
+
+    // Each (x, bT) pair of nodes is filled in by one single thread
+    ParallelFor(nx * nbT, [&] (int const& ixbT) -> void
+    {
+      const int ix  = ixbT / nbT;
+      const int ibT = ixbT % nbT;
+      for (int ifunc = 0; ifunc < _nfuncs; ifunc++)
+        for (int izeta = 0; izeta < nzeta; izeta++)
+          {
+            double* t = _tab.data() + ( ( ( ifunc * nx + ix ) * nbT + ibT ) * nzeta + izeta ) * _nk;
+            if (_derivs)
+              t[0] = _NPFunc->Gradient(xv[ix], bTv[ibT], zetav[izeta], ifunc, t + 1);
+            else
+              t[0] = _NPFunc->Evaluate(xv[ix], bTv[ibT], zetav[izeta], ifunc);
+          }
+    }, _nthreads);
+  }
+
+  //_________________________________________________________________________________
+  bool TabulatedParameterisation::Interpolate(double const& x, double const& bT, double const& zeta, int const& ifunc, int const& k, int const& nk, double* res) const
+  {
+    const std::vector<double>& xv    = _xg->GetQGrid();
+    const std::vector<double>& bTv   = _bTg->GetQGrid();
+    const std::vector<double>& zetav = _zetag->GetQGrid();
+    if (x < xv.front() || x > xv.back() || bT < bTv.front() || bT > bTv.back() || zeta < zetav.front() || zeta > zetav.back())
+      return false;
+
+    const int nbT   = bTv.size();
+    const int nzeta = zetav.size();
+
+    // Get summation bounds
+    const std::tuple<int, int, int> xbounds    = _xg->SumBounds(x);
+    const std::tuple<int, int, int> bTbounds   = _bTg->SumBounds(bT);
+    const std::tuple<int, int, int> zetabounds = _zetag->SumBounds(zeta);
+
+    // Interpolation weights in zeta
+    std::vector<double> wzeta;
+    for (int izeta = std::get<1>(zetabounds); izeta < std::get<2>(zetabounds); izeta++)
+      wzeta.push_back(_zetag->Interpolant(std::get<0>(zetabounds), izeta, zeta));
+
+    std::fill(res, res + nk, 0.);
+    for (int ix = std::get<1>(xbounds); ix < std::get<2>(xbounds); ix++)
+      {
+        const double wx = _xg->Interpolant(std::get<0>(xbounds), ix, x);
+        for (int ibT = std::get<1>(bTbounds); ibT < std::get<2>(bTbounds); ibT++)
+          {
+            const double wxbT = wx * _bTg->Interpolant(std::get<0>(bTbounds), ibT, bT);
+            for (int izeta = std::get<1>(zetabounds); izeta < std::get<2>(zetabounds); izeta++)
+              {
+                const double  w = wxbT * wzeta[izeta - std::get<1>(zetabounds)];
+                double const* t = _tab.data() + ( ( ( ifunc * (int) xv.size() + ix ) * nbT + ibT ) * nzeta + izeta ) * _nk + k;
+                for (int j = 0; j < nk; j++)
+                  res[j] += w * t[j];
+              }
+          }
+      }
+    return true;
+  }
+
+  //_________________________________________________________________________________
+  double TabulatedParameterisation::Evaluate(double const& x, double const& bT, double const& zeta, int const& ifunc) const
+  {
+    if (ifunc < 0 || ifunc >= this->_nfuncs)
+      throw std::runtime_error("[TabulatedParameterisation::Evaluate]: function index out of range");
+
+    double res;
+    if (!Interpolate(x, bT, zeta, ifunc, 0, 1, &res))
+      return _NPFunc->Evaluate(x, bT, zeta, ifunc);
+
+    return res;
+  }
+
+  //_________________________________________________________________________________
+  double TabulatedParameterisation::Derive(double const& x, double const& bT, double const& zeta, int const& ifunc, int const& ipar) const
+  {
+    if (ifunc < 0 || ifunc >= this->_nfuncs)
+      throw std::runtime_error("[TabulatedParameterisation::Derive]: function index out of range");
+
+    if (ipar < 0 || ipar >= GetParameterNumber())
+      throw std::runtime_error("[TabulatedParameterisation::Derive]: parameter index out of range");
+
+    double res;
+    if (!_derivs || !Interpolate(x, bT, zeta, ifunc, 1 + ipar, 1, &res))
+      return _NPFunc->Derive(x, bT, zeta, ifunc, ipar);
+
+    return res;
+  }
+
+  //_________________________________________________________________________________
+  double TabulatedParameterisation::Gradient(double const& x, double const& bT, double const& zeta, int const& ifunc, double* grad) const
+  {
+    if (ifunc < 0 || ifunc >= this->_nfuncs)
+      throw std::runtime_error("[TabulatedParameterisation::Gradient]: function index out of range");
+
+    if (!_derivs)
+      return _NPFunc->Gradient(x, bT, zeta, ifunc, grad);
+
+    // Interpolate function and derivatives at once
+    std::vector<double> res(_nk);
+    if (!Interpolate(x, bT, zeta, ifunc, 0, _nk, res.data()))
+      return _NPFunc->Gradient(x, bT, zeta, ifunc, grad);
+
+    std::copy(res.begin() + 1, res.end(), grad);
+    return res[0];
+  }
+
+  //_________________________________________________________________________________
+  std::vector<std::pair<double, double>> TabulatedParameterisation::GetInterpolationError(int const& stride) const
+  {
+    if (stride < 1)
+      throw std::runtime_error("[TabulatedParameterisation::GetInterpolationError]: the stride must be positive");
+
+    const std::vector<double>& xv    = _xg->GetQGrid();
+    const std::vector<double>& bTv   = _bTg->GetQGrid();
+    const std::vector<double>& zetav = _zetag->GetQGrid();
+    const int nx    = xv.size();
+    const int nbT   = bTv.size();
+    const int nzeta = zetav.size();
+    const int ncell = nbT * nzeta * _nk;
+
+    std::vector<std::pair<double, double>> errs(_nfuncs);
+    for (int ifunc = 0; ifunc < _nfuncs; ifunc++)
+      {
+        // Maximum of the absolute value of the function over the grid
+        double fmax = 0;
+        for (int i = ifunc * nx * ncell; i < ( ifunc + 1 ) * nx * ncell; i += _nk)
+          fmax = std::max(fmax, std::abs(_tab[i]));
+
+        // Errors in the middle (in logarithmic scale) of the cells,
+        // one slice in x per thread.
+        const int nxc = ( nx - 2 ) / stride + 1;
+        std::vector<std::pair<double, double>> slice(nxc, {0., 0.});
+        ParallelFor(nxc, [&] (int const& i) -> void
+        {
+          const int    ix = i * stride;
+          const double x  = sqrt(xv[ix] * xv[ix + 1]);
+          for (int ibT = 0; ibT < nbT - 1; ibT += stride)
+            for (int izeta = 0; izeta < nzeta - 1; izeta += stride)
+              {
+                const double bT   = sqrt(bTv[ibT] * bTv[ibT + 1]);
+                const double zeta = sqrt(zetav[izeta] * zetav[izeta + 1]);
+                const double f    = _NPFunc->Evaluate(x, bT, zeta, ifunc);
+                const double err  = std::abs(Evaluate(x, bT, zeta, ifunc) - f);
+                slice[i].first  = std::max(slice[i].first, err);
+                slice[i].second = std::max(slice[i].second, err / std::max(std::abs(f), 1e-3 * fmax));
+              }
+        }, _nthreads);
+
+        for (auto const& s : slice)
+          {
+            errs[ifunc].first  = std::max(errs[ifunc].first,  s.first);
+            errs[ifunc].second = std::max(errs[ifunc].second, s.second);
+          }
+      }
+    return errs;
+  }
+
+  //_________________________________________________________________________________
+  void TabulatedParameterisation::ReportInterpolationError(int const& stride) const
+  {
+    const std::vector<std::pair<double, double>> errs = GetInterpolationError(stride);
+    std::cout << "[TabulatedParameterisation]: interpolation error of " << _NPFunc->GetName() << ":" << std::endl;
+    for (int ifunc = 0; ifunc < _nfuncs; ifunc++)
+      std::cout << "  function " << ifunc << ": max. absolute error = " << errs[ifunc].first
+                << ", max. relative error = " << errs[ifunc].second << std::endl;
+  }
+}
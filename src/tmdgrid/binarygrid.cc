@@ -0,0 +1,406 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/binarygrid.h"
+#include "NangaParbat/listdir.h"
+#include "NangaParbat/numtostring.h"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace NangaParbat
+{
+  // Magic string and maximum number of axes of the binary format
+  const char BinaryGridMagic[] = "NPGRID01";
+  const int  BinaryGridMaxAxes = 4;
+
+  // Size in bytes of the header: magic string, number of axes,
+  // number of nodes of each axis, and number of flavours.
+  const std::size_t BinaryGridHeaderSize = 8 + ( 2 + BinaryGridMaxAxes ) * sizeof(int64_t);
+
+  //_________________________________________________________________________________
+  BinaryGrid::BinaryGrid(std::string const& file):
+    _file(file),
+    _map(nullptr),
+    _size(0)
+  {
+    // Open file and get its size
+    const int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("[BinaryGrid::BinaryGrid]: cannot open file '" + file + "'.");
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (std::size_t) st.st_size < BinaryGridHeaderSize)
+      {
+        close(fd);
+        throw std::runtime_error("[BinaryGrid::BinaryGrid]: file '" + file + "' is not a valid binary grid.");
+      }
+    _size = st.st_size;
+
+    // Map file in memory. The file descriptor is not needed anymore
+    // after the mapping.
+    _map = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (_map == MAP_FAILED)
+      throw std::runtime_error("[BinaryGrid::BinaryGrid]: cannot map file '" + file + "'.");
+
+    // Read header
+    char const* p = static_cast<char const*>(_map);
+    if (std::memcmp(p, BinaryGridMagic, 8) != 0)
+      {
+        munmap(_map, _size);
+        throw std::runtime_error("[BinaryGrid::BinaryGrid]: file '" + file + "' is not a valid binary grid.");
+      }
+    int64_t const* h = reinterpret_cast<int64_t const*>(p + 8);
+    const int naxes = h[0];
+    const int nfl   = h[1 + BinaryGridMaxAxes];
+    if (naxes < 1 || naxes > BinaryGridMaxAxes)
+      {
+        munmap(_map, _size);
+        throw std::runtime_error("[BinaryGrid::BinaryGrid]: file '" + file + "' is corrupted.");
+      }
+
+    // Compute expected size of the file
+    std::size_t nvals = 1;
+    std::size_t nnodes = 0;
+    for (int i = 0; i < naxes; i++)
+      {
+        nvals  *= h[1 + i];
+        nnodes += h[1 + i];
+      }
+    nvals *= nfl;
+    if (_size != BinaryGridHeaderSize + ( nnodes + nfl + nvals ) * sizeof(double))
+      {
+        munmap(_map, _size);
+        throw std::runtime_error("[BinaryGrid::BinaryGrid]: file '" + file + "' is corrupted.");
+      }
+
+    // Copy axes and flavours (they are small) and set pointer to the
+    // grid values.
+    double const* d = reinterpret_cast<double const*>(p + BinaryGridHeaderSize);
+    for (int i = 0; i < naxes; i++)
+      {
+        _axes.push_back(std::vector<double>(d, d + h[1 + i]));
+        d += h[1 + i];
+      }
+    for (int i = 0; i < nfl; i++)
+      _flavours.push_back((int) d[i]);
+    _data = d + nfl;
+  }
+
+  //_________________________________________________________________________________
+  BinaryGrid::~BinaryGrid()
+  {
+    munmap(_map, _size);
+  }
+
+  //_________________________________________________________________________________
+  void WriteBinaryGrid(std::string                      const& file,
+                       std::vector<std::vector<double>> const& axes,
+                       std::vector<int>                 const& flavours,
+                       std::vector<double>              const& data)
+  {
+    if (axes.empty() || (int) axes.size() > BinaryGridMaxAxes)
+      throw std::runtime_error("[WriteBinaryGrid]: invalid number of axes.");
+
+    // Check consistency of the data
+    std::size_t nvals = flavours.size();
+    for (auto const& a : axes)
+      nvals *= a.size();
+    if (nvals != data.size())
+      throw std::runtime_error("[WriteBinaryGrid]: size of the data does not match the axes.");
+
+    // Header
+    std::vector<int64_t> h(2 + BinaryGridMaxAxes, 0);
+    h[0] = axes.size();
+    for (int i = 0; i < (int) axes.size(); i++)
+      h[1 + i] = axes[i].size();
+    h[1 + BinaryGridMaxAxes] = flavours.size();
+
+    std::ofstream fout(file, std::ios::out | std::ios::binary);
+    if (fout.fail())
+      throw std::runtime_error("[WriteBinaryGrid]: cannot open file '" + file + "'.");
+
+    fout.write(BinaryGridMagic, 8);
+    fout.write(reinterpret_cast<char const*>(h.data()), h.size() * sizeof(int64_t));
+    for (auto const& a : axes)
+      fout.write(reinterpret_cast<char const*>(a.data()), a.size() * sizeof(double));
+    const std::vector<double> fl(flavours.begin(), flavours.end());
+    fout.write(reinterpret_cast<char const*>(fl.data()), fl.size() * sizeof(double));
+    fout.write(reinterpret_cast<char const*>(data.data()), data.size() * sizeof(double));
+    fout.close();
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> FlattenTMDGrid(YAML::Node const& grid, std::vector<int>& flavours)
+  {
+    const int nQ    = grid["Qg"].size();
+    const int nx    = grid["xg"].size();
+    const int nqToQ = grid["qToQg"].size();
+    const std::map<int, std::vector<std::vector<std::vector<double>>>> tmds = grid["TMDs"].as<std::map<int, std::vector<std::vector<std::vector<double>>>>>();
+
+    flavours.clear();
+    for (auto const& t : tmds)
+      flavours.push_back(t.first);
+
+    // Flavour is the fastest index
+    const int nfl = flavours.size();
+    std::vector<double> data(nQ * nx * nqToQ * nfl);
+    for (int ifl = 0; ifl < nfl; ifl++)
+      {
+        const std::vector<std::vector<std::vector<double>>>& t = tmds.at(flavours[ifl]);
+        for (int iQ = 0; iQ < nQ; iQ++)
+          for (int ix = 0; ix < nx; ix++)
+            for (int iqT = 0; iqT < nqToQ; iqT++)
+              data[( ( iQ * nx + ix ) * nqToQ + iqT ) * nfl + ifl] = t[iQ][ix][iqT];
+      }
+    return data;
+  }
+
+  //_________________________________________________________________________________
+  void WriteTMDGridBinary(YAML::Node const& grid, std::string const& file)
+  {
+    std::vector<int> flv;
+    const std::vector<double> data = FlattenTMDGrid(grid, flv);
+    WriteBinaryGrid(file, {grid["Qg"].as<std::vector<double>>(), grid["xg"].as<std::vector<double>>(), grid["qToQg"].as<std::vector<double>>()}, flv, data);
+  }
+
+  //_________________________________________________________________________________
+  void WriteStructGridBinary(YAML::Node const& grid, std::string const& file)
+  {
+    const std::vector<double> Qg    = grid["Qg"].as<std::vector<double>>();
+    const std::vector<double> xg    = grid["xg"].as<std::vector<double>>();
+    const std::vector<double> zg    = grid["zg"].as<std::vector<double>>();
+    const std::vector<double> qToQg = grid["qToQg"].as<std::vector<double>>();
+    const std::vector<std::vector<std::vector<std::vector<double>>>> sf = grid["StructureFunction"].as<std::vector<std::vector<std::vector<std::vector<double>>>>>();
+
+    std::vector<double> data;
+    data.reserve(Qg.size() * xg.size() * zg.size() * qToQg.size());
+    for (auto const& sQ : sf)
+      for (auto const& sx : sQ)
+        for (auto const& sz : sx)
+          data.insert(data.end(), sz.begin(), sz.end());
+
+    WriteBinaryGrid(file, {Qg, xg, zg, qToQg}, {0}, data);
+  }
+
+  //_________________________________________________________________________________
+  bool UseBinaryGrid(std::string const& file)
+  {
+    struct stat sb, sy;
+    if (stat((file + ".bin").c_str(), &sb) != 0)
+      return false;
+
+    // Without the YAML version the binary one is the only choice
+    if (stat((file + ".yaml").c_str(), &sy) != 0)
+      return true;
+
+    return std::make_pair(sb.st_mtim.tv_sec, sb.st_mtim.tv_nsec) >= std::make_pair(sy.st_mtim.tv_sec, sy.st_mtim.tv_nsec);
+  }
+
+  //_________________________________________________________________________________
+  void ConvertGridSetToBinary(std::string const& name, std::string const& folder)
+  {
+    const std::string path = folder + "/" + name;
+    for (auto const& f : list_dir(path))
+      {
+        // Only consider members of the set, i.e. "<name>_XXXX.yaml"
+        if (f.size() != name.size() + 10 || f.substr(0, name.size() + 1) != name + "_" || f.substr(f.size() - 5) != ".yaml")
+          continue;
+
+        const std::string bfile = path + "/" + f.substr(0, f.size() - 5) + ".bin";
+        std::cout << "[NangaParbat]: converting " << path + "/" + f << " into " << bfile << std::endl;
+
+        const YAML::Node grid = YAML::LoadFile(path + "/" + f);
+        if (grid["TMDs"])
+          WriteTMDGridBinary(grid, bfile);
+        else if (grid["StructureFunction"])
+          WriteStructGridBinary(grid, bfile);
+        else
+          throw std::runtime_error("[ConvertGridSetToBinary]: unknown grid type in '" + path + "/" + f + "'.");
+      }
+  }
+
+  //_________________________________________________________________________________
+  std::unique_ptr<YAML::Emitter> EmitGridYAML(std::vector<std::vector<double>> const& axes,
+                                              std::vector<int>                 const& flavours,
+                                              std::vector<double>              const& data)
+  {
+    std::unique_ptr<YAML::Emitter> out = std::unique_ptr<YAML::Emitter>(new YAML::Emitter);
+    out->SetFloatPrecision(6);
+    out->SetDoublePrecision(6);
+    *out << YAML::BeginMap;
+    if (axes.size() == 3)
+      {
+        const int nQ    = axes[0].size();
+        const int nx    = axes[1].size();
+        const int nqToQ = axes[2].size();
+        const int nfl   = flavours.size();
+        std::map<int, std::vector<std::vector<std::vector<double>>>> TMDs;
+        for (int ifl = 0; ifl < nfl; ifl++)
+          {
+            std::vector<std::vector<std::vector<double>>> t(nQ, std::vector<std::vector<double>>(nx, std::vector<double>(nqToQ)));
+            for (int iQ = 0; iQ < nQ; iQ++)
+              for (int ix = 0; ix < nx; ix++)
+                for (int iqT = 0; iqT < nqToQ; iqT++)
+                  t[iQ][ix][iqT] = data[( ( iQ * nx + ix ) * nqToQ + iqT ) * nfl + ifl];
+            TMDs.insert({flavours[ifl], t});
+          }
+        *out << YAML::Key << "Qg"    << YAML::Value << YAML::Flow << axes[0];
+        *out << YAML::Key << "xg"    << YAML::Value << YAML::Flow << axes[1];
+        *out << YAML::Key << "qToQg" << YAML::Value << YAML::Flow << axes[2];
+        *out << YAML::Key << "TMDs"  << YAML::Value << YAML::Flow << TMDs;
+      }
+    else if (axes.size() == 4 && flavours.size() == 1)
+      {
+        std::vector<std::vector<std::vector<std::vector<double>>>> SFs(axes[0].size(), std::vector<std::vector<std::vector<double>>>(axes[1].size(), std::vector<std::vector<double>>(axes[2].size())));
+        std::vector<double>::const_iterator it = data.begin();
+        for (auto& sQ : SFs)
+          for (auto& sx : sQ)
+            for (auto& sz : sx)
+              {
+                sz.assign(it, it + axes[3].size());
+                it += axes[3].size();
+              }
+        *out << YAML::Key << "Qg"    << YAML::Value << YAML::Flow << axes[0];
+        *out << YAML::Key << "xg"    << YAML::Value << YAML::Flow << axes[1];
+        *out << YAML::Key << "zg"    << YAML::Value << YAML::Flow << axes[2];
+        *out << YAML::Key << "qToQg" << YAML::Value << YAML::Flow << axes[3];
+        *out << YAML::Key << "StructureFunction"  << YAML::Value << YAML::Flow << SFs;
+      }
+    else
+      throw std::runtime_error("[EmitGridYAML]: unknown grid layout.");
+    *out << YAML::EndMap;
+
+    return out;
+  }
+
+  //_________________________________________________________________________________
+  std::vector<std::vector<double>> ComputeSummaryGrids(std::vector<std::string> const& files, double const& cl)
+  {
+    if (files.empty())
+      throw std::runtime_error("[ComputeSummaryGrids]: no replicas provided.");
+
+    if (cl <= 0 || cl >= 1)
+      throw std::runtime_error("[ComputeSummaryGrids]: the confidence level must be in (0,1).");
+
+    // Get layout from the first replica
+    std::vector<std::vector<double>> axes;
+    std::vector<int> flv;
+    {
+      const BinaryGrid g{files[0]};
+      axes = g.GetAxes();
+      flv  = g.GetFlavours();
+    }
+
+    // Number of values in one slice of the first axis
+    std::size_t slice = flv.size();
+    for (int i = 1; i < (int) axes.size(); i++)
+      slice *= axes[i].size();
+
+    // Values of all replicas in one slice ordered as [node][replica]
+    const int nrep = files.size();
+    std::vector<double> vals(slice * nrep);
+
+    // Position of the bounds in the ordered replicas
+    const double plow = ( 1 - cl ) / 2 * ( nrep - 1 );
+    const double pupp = ( 1 + cl ) / 2 * ( nrep - 1 );
+    const auto Quantile = [=] (double const* v, double const& p) -> double
+    {
+      const int i = std::min((int) std::floor(p), nrep - 1);
+      return (i + 1 < nrep ? v[i] + ( p - i ) * ( v[i+1] - v[i] ) : v[i]);
+    };
+
+    std::vector<std::vector<double>> res(4, std::vector<double>(slice * axes[0].size()));
+    for (int is = 0; is < (int) axes[0].size(); is++)
+      {
+        // Collect the slice of each replica. Each member is mapped
+        // only for the time needed to copy the slice.
+        for (int ir = 0; ir < nrep; ir++)
+          {
+            const BinaryGrid g{files[ir]};
+            if (g.GetAxes() != axes || g.GetFlavours() != flv)
+              throw std::runtime_error("[ComputeSummaryGrids]: replica '" + files[ir] + "' does not share the grid of '" + files[0] + "'.");
+
+            double const* d = g.GetData() + is * slice;
+            for (std::size_t n = 0; n < slice; n++)
+              vals[n * nrep + ir] = d[n];
+          }
+
+        // Compute statistics node by node
+        for (std::size_t n = 0; n < slice; n++)
+          {
+            double* v = vals.data() + n * nrep;
+
+            double mean = 0;
+            for (int ir = 0; ir < nrep; ir++)
+              mean += v[ir];
+            mean /= nrep;
+
+            double var = 0;
+            for (int ir = 0; ir < nrep; ir++)
+              var += pow(v[ir] - mean, 2);
+            var = (nrep > 1 ? var / ( nrep - 1 ) : 0);
+
+            std::sort(v, v + nrep);
+
+            const std::size_t k = is * slice + n;
+            res[0][k] = mean;
+            res[1][k] = sqrt(var);
+            res[2][k] = Quantile(v, plow);
+            res[3][k] = Quantile(v, pupp);
+          }
+      }
+    return res;
+  }
+
+  //_________________________________________________________________________________
+  std::unique_ptr<YAML::Emitter> WriteSummaryMembers(std::vector<std::string> const& files,
+                                                     std::string              const& base,
+                                                     int                      const& first,
+                                                     bool                     const& binary,
+                                                     double                   const& cl)
+  {
+    std::cout << "[NangaParbat]: computing summary members over " << files.size() << " replicas ..." << std::endl;
+    const std::vector<std::vector<double>> sg = ComputeSummaryGrids(files, cl);
+
+    // Layout of the grids
+    const BinaryGrid g{files[0]};
+
+    // Write members
+    const std::vector<std::string> names{"mean", "std", "lower", "upper"};
+    std::map<std::string, int> ids;
+    for (int i = 0; i < (int) names.size(); i++)
+      {
+        const std::string file = base + "_" + num_to_string(first + i);
+        std::ofstream fout(file + ".yaml");
+        fout << EmitGridYAML(g.GetAxes(), g.GetFlavours(), sg[i])->c_str() << std::endl;
+        fout.close();
+
+        if (binary)
+          WriteBinaryGrid(file + ".bin", g.GetAxes(), g.GetFlavours(), sg[i]);
+
+        ids.insert({names[i], first + i});
+      }
+
+    // Info to be appended to the info file
+    std::unique_ptr<YAML::Emitter> out = std::unique_ptr<YAML::Emitter>(new YAML::Emitter);
+    out->SetDoublePrecision(4);
+    *out << YAML::BeginMap;
+    *out << YAML::Key << "SummaryMembers" << YAML::Value << YAML::Flow << ids;
+    *out << YAML::Key << "SummaryCL"      << YAML::Value << cl;
+    *out << YAML::EndMap;
+
+    return out;
+  }
+}
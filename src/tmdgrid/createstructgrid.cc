@@ -11,10 +11,14 @@
 #include "NangaParbat/listdir.h"
 #include "NangaParbat/direxists.h"
 #include "NangaParbat/numtostring.h"
+#include "NangaParbat/binarygrid.h"
+#include "NangaParbat/parallelfor.h"
 
-#include <LHAPDF/LHAPDF.h>
 #include <iomanip>
 #include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <mutex>
 #include <sys/stat.h>
 
 namespace NangaParbat
@@ -25,7 +29,9 @@ namespace NangaParbat
                          std::string const& GridTMDFFfolder,
                          std::string const& Output,
                          std::string const& repID,
-                         std::string const& structype)
+                         std::string const& structype,
+                         bool        const& binary,
+                         bool        const& summary)
   {
     // Distribution type
     const std::string pf = structype;
@@ -33,16 +39,20 @@ namespace NangaParbat
     // Read configuration file
     const YAML::Node config = YAML::LoadFile(GridsDirectory + "/tables/config.yaml");
 
-    // Define vector for grid names
+    // Define vector for replica numbers
     std::vector<std::string> fnames;
 
-    // Collect TMD grids to compute the structure function
-    std::vector<std::unique_ptr<YAML::Emitter>> grids;
-
     // If the replica number (replica ID) is not specified, produce one structure function grid
     // for every TMD PDF grid present in the TMDPDF folder. TMD PDF and TMD FF are matched by replica ID.
     if (repID == "none")
       {
+        // Summary members of the TMD PDF set, if any, are not replicas
+        std::vector<std::string> summ;
+        const YAML::Node pdfinfo = YAML::LoadFile(GridsDirectory + "/" + GridTMDPDFfolder + "/" + GridTMDPDFfolder + ".info");
+        if (pdfinfo["SummaryMembers"])
+          for (auto const& m : pdfinfo["SummaryMembers"].as<std::map<std::string, int>>())
+            summ.push_back(num_to_string(m.second));
+
         for (auto const& f : list_dir(GridsDirectory + "/" + GridTMDPDFfolder))
           {
             // TMDPDF grid file
@@ -58,21 +68,8 @@ namespace NangaParbat
                     // Get replica number from the name of the PDF Grids
                     const std::string repnum = f.substr(f.size() - 9, 4);
 
-                    std::cout << "Computing grid for structure function with replica " << repnum << " ..." << std::endl;
-
-                    // Compute grid and push it back. In the case of
-                    // replica_0 push it in the front to make sure it's
-                    // the first replica.
-                    if (repnum == "0000")
-                      {
-                        grids.insert(grids.begin(), EmitStructGrid(GridsDirectory, GridTMDPDFfolder, GridTMDFFfolder, std::stoi(repnum), pf, Inter4DGrid(pf)));
-                        fnames.insert(fnames.begin(), repnum);
-                      }
-                    else
-                      {
-                        grids.push_back(EmitStructGrid(GridsDirectory, GridTMDPDFfolder, GridTMDFFfolder, std::stoi(repnum), pf, Inter4DGrid(pf)));
-                        fnames.push_back(repnum);
-                      }
+                    if (std::find(summ.begin(), summ.end(), repnum) == summ.end())
+                      fnames.push_back(repnum);
                   }
               }
           }
@@ -80,12 +77,7 @@ namespace NangaParbat
 
     // If the replica ID is specified, do only the grid for that replica.
     else
-      {
-        std::cout << "Computing grid for structure function with replica " << repID << " ..." << std::endl;
-
-        grids.push_back(EmitStructGrid(GridsDirectory, GridTMDPDFfolder, GridTMDFFfolder, std::stoi(repID), pf, Inter4DGrid(pf)));
-        fnames.push_back(repID);
-      }
+      fnames.push_back(repID);
 
     // Output directory
     const std::string outdir = GridsDirectory + "/" + Output;
@@ -94,23 +86,65 @@ namespace NangaParbat
     if (!dir_exists(Output))
       mkdir(outdir.c_str(), ACCESSPERMS);
 
-    // Write info file
-    std::ofstream iout(outdir + "/" + Output + ".info");
-    iout << NangaParbat::EmitStructInfo(GridsDirectory, GridTMDPDFfolder, GridTMDFFfolder, config, grids.size(), pf, Inter4DGrid(pf))->c_str() << std::endl;
-    iout.close();
-
-    // Dump grids to file
-    for (int i = 0; i < (int) grids.size(); i++)
+    // Compute grids. Each grid is written to file as soon as it is
+    // computed so that only one member at the time is held in
+    // memory. Keep track of the binary files that are also needed to
+    // compute the summary members.
+    int maxrep = -1;
+    std::string bfile0;
+    std::vector<std::string> bfiles;
+    for (auto const& repnum : fnames)
       {
-        // Grids numbered sequentially
-        // std::ofstream fpout(outdir + "/" + Output + "_" + num_to_string(i) + ".yaml");
+        std::cout << "Computing grid for structure function with replica " << repnum << " ..." << std::endl;
+
+        // Compute grid
+        const std::unique_ptr<YAML::Emitter> grid = EmitStructGrid(GridsDirectory, GridTMDPDFfolder, GridTMDFFfolder, std::stoi(repnum), pf, Inter4DGrid(pf));
 
         // Grid number = replica number
-        std::ofstream fpout(outdir + "/" + Output + "_" + num_to_string(std::stoi(fnames[i])) + ".yaml");
-        fpout << grids[i]->c_str() << std::endl;
+        const int irep = std::stoi(repnum);
+        const std::string gfile = outdir + "/" + Output + "_" + num_to_string(irep);
+        std::ofstream fpout(gfile + ".yaml");
+        fpout << grid->c_str() << std::endl;
         fpout.close();
+
+        // Binary version of the grid, if required. Otherwise remove the
+        // one possibly left over by a previous production.
+        if (binary || summary)
+          WriteStructGridBinary(YAML::Load(grid->c_str()), gfile + ".bin");
+        else
+          std::remove((gfile + ".bin").c_str());
+
+        if (irep == 0)
+          bfile0 = gfile + ".bin";
+        else
+          bfiles.push_back(gfile + ".bin");
+
+        maxrep = std::max(maxrep, irep);
       }
 
+    // Write info file
+    std::ofstream iout(outdir + "/" + Output + ".info");
+    iout << NangaParbat::EmitStructInfo(GridsDirectory, GridTMDPDFfolder, GridTMDFFfolder, config, fnames.size(), pf, Inter4DGrid(pf))->c_str() << std::endl;
+
+    // Compute summary members over the replicas (replica 0 is used
+    // only if it is the only member) and number them after the last
+    // replica. Remove the binary files if they were only needed for
+    // this purpose.
+    if (summary && !fnames.empty())
+      {
+        if (bfiles.empty())
+          bfiles.push_back(bfile0);
+
+        iout << NangaParbat::WriteSummaryMembers(bfiles, outdir + "/" + Output, maxrep + 1, binary)->c_str() << std::endl;
+
+        if (!binary)
+          {
+            bfiles.push_back(bfile0);
+            for (auto const& bf : bfiles)
+              std::remove(bf.c_str());
+          }
+      }
+    iout.close();
   }
 
   //_________________________________________________________________________________
@@ -189,81 +223,38 @@ namespace NangaParbat
                                                       std::string const& pf,
                                                       FourDGrid   const& fdg,
                                                       int         const& qToQcut)
+  {
+    // The collinear distributions are tabulated from 0.5 GeV and the
+    // strong coupling of each distribution is evaluated directly from
+    // its own LHAPDF set.
+    return EmitStructGridDirect(TMDService{YAML::LoadFile(FitDirectory + "/tables/config.yaml"), {"pdf", "ff"}, 500, 1e-7, 100, 0.5, "own"},
+                                FitDirectory, repnumber, pf, fdg, qToQcut);
+  }
+
+  //_________________________________________________________________________________
+  std::unique_ptr<YAML::Emitter> EmitStructGridDirect(TMDService  const& service,
+                                                      std::string const& FitDirectory,
+                                                      int         const& repnumber,
+                                                      std::string const& pf,
+                                                      FourDGrid   const& fdg,
+                                                      int         const& qToQcut,
+                                                      int         const& nthreads)
   {
     // Timer
     apfel::Timer t;
 
-    // Read configuration file
-    const YAML::Node config = YAML::LoadFile(FitDirectory + "/tables/config.yaml");
-
-    // Perturbative order
-    const int PerturbativeOrder = config["PerturbativeOrder"].as<int>();
+    // Theory settings
+    const YAML::Node config = service.GetConfig();
 
-    // Scale-variation factors
-    const double Ci = config["TMDscales"]["Ci"].as<double>();
+    // Scale-variation factor
     const double Cf = config["TMDscales"]["Cf"].as<double>();
 
-    // Open LHAPDF sets
-    LHAPDF::PDF* distpdf = LHAPDF::mkPDF(config["pdfset"]["name"].as<std::string>(), config["pdfset"]["member"].as<int>());
-    LHAPDF::PDF* distff  = LHAPDF::mkPDF(config["ffset"]["name"].as<std::string>(),  config["ffset"]["member"].as<int>());
-
-    // Get heavy-quark thresholds from the PDF LHAPDF set
-    std::vector<double> ThresholdsPDF;
-    for (auto const& v : distpdf->flavors())
-      if (v > 0 && v < 7)
-        ThresholdsPDF.push_back(distpdf->quarkThreshold(v));
-
-    // Get heavy-quark thresholds from the FF LHAPDF set
-    std::vector<double> ThresholdsFF;
-    for (auto const& v : distff->flavors())
-      if (v > 0 && v < 7)
-        ThresholdsFF.push_back(distff->quarkThreshold(v));
-
-    // Alpha_s (from PDFs and FFs)
-    const auto AlphasPDF = [&] (double const& mu) -> double{ return distpdf->alphasQ(mu); };
-    const auto AlphasFF  = [&] (double const& mu) -> double{ return distff->alphasQ(mu); };
-
-    // Setup APFEL++ x-space grid for PDFs
-    std::vector<apfel::SubGrid> vsgp;
-    for (auto const& sg : config["xgridpdf"])
-      vsgp.push_back({sg[0].as<int>(), sg[1].as<double>(), sg[2].as<int>()});
-    const apfel::Grid gpdf{vsgp};
-
-    // Setup APFEL++ x-space grid for FFs
-    std::vector<apfel::SubGrid> vsgf;
-    for (auto const& sg : config["xgridff"])
-      vsgf.push_back({sg[0].as<int>(), sg[1].as<double>(), sg[2].as<int>()});
-    const apfel::Grid gff{vsgf};
-
-    // Rotate PDF set into the QCD evolution basis
-    const auto RotPDFs = [=] (double const& x, double const& mu) -> std::map<int,double> { return apfel::PhysToQCDEv(distpdf->xfxQ(x, mu)); };
-    const auto RotFFs  = [=] (double const& x, double const& mu) -> std::map<int,double> { return apfel::PhysToQCDEv(distff->xfxQ(x, mu)); };
-
-    // Construct set of distributions as a function of the scale to be
-    // tabulated
-    const auto EvolvedPDFs = [=,&gpdf] (double const& mu) -> apfel::Set<apfel::Distribution>
-    {
-      return apfel::Set<apfel::Distribution>{apfel::EvolutionBasisQCD{apfel::NF(mu, ThresholdsPDF)}, DistributionMap(gpdf, RotPDFs, mu)};
-    };
-    const auto EvolvedFFs = [=,&gff] (double const& mu) -> apfel::Set<apfel::Distribution>
-    {
-      return apfel::Set<apfel::Distribution>{apfel::EvolutionBasisQCD{apfel::NF(mu, ThresholdsPDF)}, DistributionMap(gff, RotFFs, mu)};
-    };
-
-    // Tabulate collinear PDFs and FFs
-    const apfel::TabulateObject<apfel::Set<apfel::Distribution>> TabPDFs{EvolvedPDFs, 100, 0.5, distpdf->qMax(), 3, ThresholdsPDF};
-    const auto CollPDFs = [&] (double const& mu) -> apfel::Set<apfel::Distribution> { return TabPDFs.Evaluate(mu); };
-
-    const apfel::TabulateObject<apfel::Set<apfel::Distribution>> TabFFs{EvolvedFFs, 100, 0.5, distff->qMax(), 3, ThresholdsPDF};
-    const auto CollFFs = [&] (double const& mu) -> apfel::Set<apfel::Distribution> { return TabFFs.Evaluate(mu); };
+    // Heavy-quark thresholds
+    const std::vector<double> ThresholdsPDF = service.GetThresholds();
 
-    // Initialize TMD objects
-    const auto TmdObjPDF = apfel::InitializeTmdObjects(gpdf, ThresholdsPDF);
-    const auto TmdObjFF  = apfel::InitializeTmdObjects(gff,  ThresholdsPDF);
-
-    // Build evolved TMD PDFs and FFs
-    const auto EvTMDPDFs = BuildTmdPDFs(TmdObjPDF, CollPDFs, AlphasPDF, PerturbativeOrder, Ci);
-    const auto EvTMDFFs  = BuildTmdFFs(TmdObjFF, CollFFs, AlphasFF, PerturbativeOrder, Ci);
+    // Evolved TMD PDFs and FFs
+    const auto EvTMDPDFs = service.GetTMDs("pdf");
+    const auto EvTMDFFs  = service.GetTMDs("ff");
 
     // Functions used for the tabulation
     const auto TabFunc    = [] (double const& b) -> double{ return log(b); };
@@ -273,7 +264,7 @@ namespace NangaParbat
     const YAML::Node rep = YAML::LoadFile(FitDirectory + "/replica_" + std::to_string(repnumber) + "/Report.yaml");
 
     // Get parameterisation
-    NangaParbat::Parameterisation* fNP = NangaParbat::GetParametersation(rep["Parameterisation"].as<std::string>());
+    const std::unique_ptr<NangaParbat::Parameterisation> fNP = NangaParbat::MakeParameterisation(rep);
 
     // Double-exponential quadrature object for the Hankel transform
     // const apfel::DoubleExponentialQuadrature DEObj{};
@@ -291,75 +282,82 @@ namespace NangaParbat
 
     // Compute structure function to put in grids, fully differential calculation.
     // At the moment the only SF implemented is FUUT.
-    for (int iQ = 0; iQ < (int) fdg.Qg.size(); iQ++)
-      {
-        const double Q  = fdg.Qg[iQ];
+    // The Q slices are computed concurrently.
+    int ndone = 0;
+    std::mutex mtx;
+    ParallelFor(fdg.Qg.size(), [&] (int const& iQ) -> void
+    {
+      // Parameterisation object of this slice
+      const std::unique_ptr<NangaParbat::Parameterisation> tNP = fNP->Clone();
 
-        // Renormalisation and rapidity scales
-        const double mu   = Cf * Q;
-        const double zeta = Q * Q;
+      const double Q  = fdg.Qg[iQ];
 
-        // EW charges
-        const std::vector<double> Bq = apfel::QCh2;
+      // Renormalisation and rapidity scales
+      const double mu   = Cf * Q;
+      const double zeta = Q * Q;
 
-        // Number of active flavours at mu
-        const int nf = apfel::NF(mu, ThresholdsPDF);
+      // EW charges
+      const std::vector<double> Bq = apfel::QCh2;
 
-        // Define kT-distribution function for direct calculation
-        const std::function<apfel::DoubleObject<apfel::Distribution>(double const&)> Lumib = [=] (double const& bs) -> apfel::DoubleObject<apfel::Distribution>
-        {
-          // Get Evolved TMD PDFs and FFs and rotate them into the physical basis.
-          const std::map<int, apfel::Distribution> xF = QCDEvToPhys(EvTMDPDFs(bs, mu, zeta).GetObjects());
-          const std::map<int, apfel::Distribution> xD = QCDEvToPhys(EvTMDFFs(bs, mu, zeta).GetObjects());
+      // Number of active flavours at mu
+      const int nf = apfel::NF(mu, ThresholdsPDF);
 
-          // Luminosity
-          apfel::DoubleObject<apfel::Distribution> L{};
-          for (int i = 1; i <= nf; i++)
-            {
-              L.AddTerm({Bq[i-1], xF.at(+i), xD.at(+i)});
-              L.AddTerm({Bq[i-1], xF.at(-i), xD.at(-i)});
-            }
-          return L;
-        };
+      // Define kT-distribution function for direct calculation
+      const std::function<apfel::DoubleObject<apfel::Distribution>(double const&)> Lumib = [=] (double const& bs) -> apfel::DoubleObject<apfel::Distribution>
+      {
+        // Get Evolved TMD PDFs and FFs and rotate them into the physical basis.
+        const std::map<int, apfel::Distribution> xF = QCDEvToPhys(EvTMDPDFs(bs, mu, zeta).GetObjects());
+        const std::map<int, apfel::Distribution> xD = QCDEvToPhys(EvTMDFFs(bs, mu, zeta).GetObjects());
 
-        // Perturbative contribution in b-space. We know a priori that
-        // this is enclosed bewteen bmin and bmax. Include an overflow
-        // (and underflow) by a 20% to avoid interpolation problems.
-        const double overflow = 1.2;
-        const double bmin = NangaParbat::bstarmin(0.00001, Q) / overflow;
-        const double bmax = NangaParbat::bstarmin(10, Q) * overflow;
+        // Luminosity
+        apfel::DoubleObject<apfel::Distribution> L{};
+        for (int i = 1; i <= nf; i++)
+          {
+            L.AddTerm({Bq[i-1], xF.at(+i), xD.at(+i)});
+            L.AddTerm({Bq[i-1], xF.at(-i), xD.at(-i)});
+          }
+        return L;
+      };
 
-        const apfel::TabulateObject<apfel::DoubleObject<apfel::Distribution>> tLumib{Lumib, 200, bmin, bmax, 3, {}, TabFunc, InvTabFunc};
+      // Perturbative contribution in b-space. We know a priori that
+      // this is enclosed bewteen bmin and bmax. Include an overflow
+      // (and underflow) by a 20% to avoid interpolation problems.
+      const double overflow = 1.2;
+      const double bmin = NangaParbat::bstarmin(0.00001, Q) / overflow;
+      const double bmax = NangaParbat::bstarmin(10, Q) * overflow;
 
-        for (int ix = 0; ix < (int) fdg.xg.size(); ix++)
-          {
-            const double x  = fdg.xg[ix];
+      const apfel::TabulateObject<apfel::DoubleObject<apfel::Distribution>> tLumib{Lumib, 200, bmin, bmax, 3, {}, TabFunc, InvTabFunc};
 
-            for (int iz = 0; iz < (int) fdg.zg.size(); iz++)
-              {
-                const double z  = fdg.zg[iz];
+      for (int ix = 0; ix < (int) fdg.xg.size(); ix++)
+        {
+          const double x  = fdg.xg[ix];
 
-                // Function in bT space
-                const std::function<double(double const&)> bInt = [=] (double const& b) -> double
-                {
-                  double bTintegrand = b * fNP->Evaluate(x, b, zeta, 0) * fNP->Evaluate(z, b, zeta, 1) / z / z * tLumib.EvaluatexzQ(x, z, NangaParbat::bstarmin(b, Q));
-                  return bTintegrand;
-                };
+          for (int iz = 0; iz < (int) fdg.zg.size(); iz++)
+            {
+              const double z  = fdg.zg[iz];
 
-                // Transform in qT space and fill grid
-                for (int iqT = 0; iqT < (int) fdg.qToQg.size(); iqT++)
-                  {
-                    const double qT  = Q * fdg.qToQg[iqT];
-                    SFs[iQ][ix][iz][iqT] = DEObj.transform(bInt, qT)/ z / (2 * M_PI);
-                  }
-              }
-          }
+              // Function in bT space
+              const std::function<double(double const&)> bInt = [=, &tNP] (double const& b) -> double
+              {
+                double bTintegrand = b * tNP->Evaluate(x, b, zeta, 0) * tNP->Evaluate(z, b, zeta, 1) / z / z * tLumib.EvaluatexzQ(x, z, NangaParbat::bstarmin(b, Q));
+                return bTintegrand;
+              };
 
-        // Report computation status
-        const double perc = 100. * ( iQ + 1 ) / fdg.Qg.size();
-        std::cout << "Status report for the structure function grid computation: "<< std::setw(6) << std::setprecision(4) << perc << "\% completed...\r";
-        std::cout.flush();
-      }
+              // Transform in qT space and fill grid
+              for (int iqT = 0; iqT < (int) fdg.qToQg.size(); iqT++)
+                {
+                  const double qT  = Q * fdg.qToQg[iqT];
+                  SFs[iQ][ix][iz][iqT] = DEObj.transform(bInt, qT)/ z / (2 * M_PI);
+                }
+            }
+        }
+
+      // Report computation status
+      std::lock_guard<std::mutex> lock(mtx);
+      const double perc = 100. * ( ++ndone ) / fdg.Qg.size();
+      std::cout << "Status report for the structure function grid computation: "<< std::setw(6) << std::setprecision(4) << perc << "\% completed...\r";
+      std::cout.flush();
+    }, nthreads);
 
     std::cout << "\n";
 
@@ -8,15 +8,18 @@
 #include "NangaParbat/listdir.h"
 #include "NangaParbat/direxists.h"
 #include "NangaParbat/numtostring.h"
+#include "NangaParbat/binarygrid.h"
+#include "NangaParbat/parallelfor.h"
 
-#include <LHAPDF/LHAPDF.h>
 #include <fstream>
+#include <cstdio>
 #include <sys/stat.h>
+#include <mutex>
 
 namespace NangaParbat
 {
   //____________________________________________________________________________________________________
-  void ProduceTMDGrid(std::string const& ReportFolder, std::string const& Output, std::string const& distype)
+  void ProduceTMDGrid(std::string const& ReportFolder, std::string const& Output, std::string const& distype, bool const& binary, bool const& summary)
   {
     // Distribution type
     const std::string pf = distype;
@@ -27,11 +30,25 @@ namespace NangaParbat
     // Read fit configuration file
     const YAML::Node fitconfig = YAML::LoadFile(ReportFolder + "/fitconfig.yaml");
 
-    // Define vector for grid names
-    std::vector<std::string> fnames;
+    // Output directory
+    const std::string outdir = ReportFolder + "/" + Output;
+
+    // Create output directory if it does not exist
+    if (!dir_exists(Output))
+      mkdir(outdir.c_str(), ACCESSPERMS);
 
-    // Collect reports of valid replicas
-    std::vector<std::unique_ptr<YAML::Emitter>> grids;
+    // TMD ingredients shared by all replicas. The strong coupling is
+    // evaluated directly from the LHAPDF set.
+    const TMDService service{config, {pf}, 500, 1e-7, 100, 0, "own"};
+
+    // Compute the grids of valid replicas. Each grid is written to
+    // file as soon as it is computed so that only one member at the
+    // time is held in memory. Keep track of the binary files that
+    // are also needed to compute the summary members.
+    int nmem   = 0;
+    int maxrep = -1;
+    std::string bfile0;
+    std::vector<std::string> bfiles;
     for (auto const& f : list_dir(ReportFolder))
       {
         const std::string repfile = ReportFolder + "/" + f + "/Report.yaml";
@@ -47,14 +64,13 @@ namespace NangaParbat
             if (f == "mean_replica")
               continue;
 
-            // If the fit converged push it back
+            // If the fit converged compute the grid
             if (rep["Status"].as<int>() == 1)
               {
                 std::cout << "Computing grid for " << repfile << " ..." << std::endl;
 
                 // Get parameterisation
-                const std::string pms = rep["Parameterisation"].as<std::string>();
-                NangaParbat::Parameterisation *NPFunc = NangaParbat::GetParametersation(pms);
+                const std::unique_ptr<NangaParbat::Parameterisation> NPFunc = NangaParbat::MakeParameterisation(rep);
 
                 // Get parameters
                 const std::map<std::string, double> pars = rep["Parameters"].as<std::map<std::string, double>>();
@@ -64,49 +80,57 @@ namespace NangaParbat
                 for (auto const& p : NPFunc->GetParameterNames())
                   vpars.push_back(pars.at(p));
 
-                // Compute grid and push it back. In the case of
-                // replica_0 push it in the front to make sure it's
-                // the first replica.
+                // Compute grid
+                const std::unique_ptr<YAML::Emitter> grid = EmitTMDGrid(service, *NPFunc, vpars, pf, Inter3DGrid(pf));
+
+                // Grid number = replica number
+                const int irep = std::stoi(f.substr(8));
+                const std::string gfile = outdir + "/" + Output + "_" + num_to_string(irep);
+                std::ofstream fpout(gfile + ".yaml");
+                fpout << grid->c_str() << std::endl;
+                fpout.close();
+
+                // Binary version of the grid, if required. Otherwise remove the
+                // one possibly left over by a previous production.
+                if (binary || summary)
+                  WriteTMDGridBinary(YAML::Load(grid->c_str()), gfile + ".bin");
+                else
+                  std::remove((gfile + ".bin").c_str());
+
                 if (f == "replica_0")
-                  {
-                    grids.insert(grids.begin(), EmitTMDGrid(config, pms, vpars, pf, Inter3DGrid(pf)));
-                    fnames.insert(fnames.begin(), f);
-                  }
+                  bfile0 = gfile + ".bin";
                 else
-                  {
-                    grids.push_back(EmitTMDGrid(config, pms, vpars, pf, Inter3DGrid(pf)));
-                    fnames.push_back(f);
-                  }
+                  bfiles.push_back(gfile + ".bin");
 
-                // Delete Parameterisation object
-                //delete NPFunc;
+                nmem++;
+                maxrep = std::max(maxrep, irep);
               }
           }
       }
 
-    // Output directory
-    const std::string outdir = ReportFolder + "/" + Output;
-
-    // Create output directory if it does not exist
-    if (!dir_exists(Output))
-      mkdir(outdir.c_str(), ACCESSPERMS);
-
     // Write info file
     std::ofstream iout(outdir + "/" + Output + ".info");
-    iout << NangaParbat::EmitTMDInfo(config, grids.size(), pf, Inter3DGrid(pf))->c_str() << std::endl;
-    iout.close();
+    iout << NangaParbat::EmitTMDInfo(config, nmem, pf, Inter3DGrid(pf))->c_str() << std::endl;
 
-    // Dump grids to file
-    for (int i = 0; i < (int) grids.size(); i++)
+    // Compute summary members over the replicas (replica_0 is used
+    // only if it is the only member) and number them after the last
+    // replica. Remove the binary files if they were only needed for
+    // this purpose.
+    if (summary && nmem > 0)
       {
-        // Grids numbered sequentially
-        // std::ofstream fpout(outdir + "/" + Output + "_" + num_to_string(i) + ".yaml");
+        if (bfiles.empty())
+          bfiles.push_back(bfile0);
+
+        iout << NangaParbat::WriteSummaryMembers(bfiles, outdir + "/" + Output, maxrep + 1, binary)->c_str() << std::endl;
 
-        // Grid number = replica number
-        std::ofstream fpout(outdir + "/" + Output + "_" + num_to_string(std::stoi(fnames[i].erase(0,8))) + ".yaml");
-        fpout << grids[i]->c_str() << std::endl;
-        fpout.close();
+        if (!binary)
+          {
+            bfiles.push_back(bfile0);
+            for (auto const& bf : bfiles)
+              std::remove(bf.c_str());
+          }
       }
+    iout.close();
   }
 
   //_________________________________________________________________________________
@@ -116,64 +140,54 @@ namespace NangaParbat
                                              std::string         const& pf,
                                              ThreeDGrid          const& tdg)
   {
-    // Timer
-    apfel::Timer t;
-
-    // Open LHAPDF set
-    LHAPDF::PDF* dist = LHAPDF::mkPDF(config[pf + "set"]["name"].as<std::string>(), config[pf + "set"]["member"].as<int>());
-
-    // Rotate set into the QCD evolution basis
-    const auto RotDists = [&] (double const& x, double const& mu) -> std::map<int,double> { return apfel::PhysToQCDEv(dist->xfxQ(x, mu)); };
+    if (pf != "pdf" && pf != "ff")
+      throw std::runtime_error("[EmitTMDGrid]: Unknown distribution prefix.");
 
-    // Heavy-quark thresholds and their b-space counterparts. Also
-    // collect quarks and anti-quarks indices.
-    std::vector<double> Thresholds;
-    std::vector<int> flv;
-    for (int f : dist->flavors())
-      if (f > 0 && f < 7)
-        {
-          Thresholds.push_back(dist->quarkThreshold(f));
-          flv.push_back(f);
-          flv.insert(flv.begin(), -f);
-        }
+    return EmitTMDGrid(TMDService{config, {pf}, 500, 1e-7, 100, 0, "own"}, parameterisation, params, pf, tdg);
+  }
 
-    // Define x-space grid
-    std::vector<apfel::SubGrid> vsg;
-    for (auto const& sg : config["xgrid" + pf])
-      vsg.push_back({sg[0].as<int>(), sg[1].as<double>(), sg[2].as<int>()});
-    const apfel::Grid g{vsg};
+  //_________________________________________________________________________________
+  std::unique_ptr<YAML::Emitter> EmitTMDGrid(TMDService          const& service,
+                                             std::string         const& parameterisation,
+                                             std::vector<double> const& params,
+                                             std::string         const& pf,
+                                             ThreeDGrid          const& tdg,
+                                             int                 const& nthreads)
+  {
+    return EmitTMDGrid(service, *MakeParameterisation(parameterisation), params, pf, tdg, nthreads);
+  }
 
-    // Construct set of distributions as a function of the scale to be
-    // tabulated.
-    const auto EvolvedDists = [=,&g] (double const& mu) -> apfel::Set<apfel::Distribution>
-    {
-      return apfel::Set<apfel::Distribution>{apfel::EvolutionBasisQCD{apfel::NF(mu, Thresholds)}, DistributionMap(g, RotDists, mu)};
-    };
+  //_________________________________________________________________________________
+  std::unique_ptr<YAML::Emitter> EmitTMDGrid(TMDService          const& service,
+                                             Parameterisation    const& parameterisation,
+                                             std::vector<double> const& params,
+                                             std::string         const& pf,
+                                             ThreeDGrid          const& tdg,
+                                             int                 const& nthreads)
+  {
+    // Timer
+    apfel::Timer t;
 
-    // Tabulate collinear distributions
-    const apfel::TabulateObject<apfel::Set<apfel::Distribution>> TabDists{EvolvedDists, 100, dist->qMin(), dist->qMax(), 3, Thresholds};
-    const auto CollDists = [&] (double const& mu) -> apfel::Set<apfel::Distribution> { return TabDists.Evaluate(mu); };
+    // Theory settings
+    const YAML::Node config = service.GetConfig();
 
-    // Strong coupling
-    const auto Alphas = [&] (double const& mu) -> double{ return dist->alphasQ(mu); };
+    // Quarks and anti-quarks indices
+    std::vector<int> flv;
+    for (int f : service.GetFlavours(pf))
+      {
+        flv.push_back(f);
+        flv.insert(flv.begin(), -f);
+      }
 
     // Get TMDs distributions
-    std::function<apfel::Set<apfel::Distribution>(double const&, double const&, double const&)> Tmds;
-    if (pf == "pdf")
-      Tmds = BuildTmdPDFs(apfel::InitializeTmdObjects(g, Thresholds), CollDists, Alphas,
-                          config["PerturbativeOrder"].as<int>(), config["TMDscales"]["Ci"].as<double>());
-    else if (pf == "ff")
-      Tmds = BuildTmdFFs(apfel::InitializeTmdObjects(g, Thresholds), CollDists, Alphas,
-                         config["PerturbativeOrder"].as<int>(), config["TMDscales"]["Ci"].as<double>());
-    else
-      throw std::runtime_error("[EmitTMDGrid]: Unknown distribution prefix.");
+    const auto Tmds = service.GetTMDs(pf);
 
     // Get b* prescription
     const std::function<double(double const&, double const&)> bstar = bstarMap.at(config["bstar"].as<std::string>());
 
-    // Allocate parameterisation object and set parameters
-    Parameterisation *NPFunc = GetParametersation(parameterisation);
-    NPFunc->SetParameters(params);
+    // Parameter set shared by the parameterisation objects of all
+    // threads
+    const ParameterSet ps{params};
 
     // Double-exponential quadrature object for the Hankel transform
     const apfel::DoubleExponentialQuadrature DEObj{};
@@ -188,34 +202,44 @@ namespace NangaParbat
       TMDs.insert({f, std::vector<std::vector<std::vector<double>>>(tdg.Qg.size(),
                                                                     std::vector<std::vector<double>>(tdg.xg.size(),
                                                                                                      std::vector<double>(tdg.qToQg.size())))});
-    for (int iQ = 0; iQ < (int) tdg.Qg.size(); iQ++)
+
+    // Compute the Q slices concurrently. Each slice writes to its own
+    // entries of the map, that is fully allocated beforehand.
+    int ndone = 0;
+    std::mutex mtx;
+    ParallelFor(tdg.Qg.size(), [&] (int const& iQ) -> void
+    {
+      // Parameterisation object of this slice
+      const std::unique_ptr<Parameterisation> NPFunc = parameterisation.Clone(ps);
+
+      // Integrand
+      const std::function<apfel::Set<apfel::Distribution>(double const&)> bTintegrand = [=, &NPFunc] (double const& b) -> apfel::Set<apfel::Distribution>
       {
-        // Integrand
-        const std::function<apfel::Set<apfel::Distribution>(double const&)> bTintegrand = [=] (double const& b) -> apfel::Set<apfel::Distribution>
+        const double Q  = tdg.Qg[iQ];
+        const double Q2 = Q * Q;
+        const double bs = bstar(b, Q);
+        apfel::Set<apfel::Distribution> tdist = Tmds(bs, Q, Q2);
+        tdist.SetMap(cevb);
+        return [&] (double const& x) -> double{ return b * NPFunc->Evaluate(x, b, Q2, (pf == "pdf" ? 0 : 1)) / (pf == "pdf" ? 1 : x * x); } * tdist;
+      };
+      for (int iqT = 0; iqT < (int) tdg.qToQg.size(); iqT++)
         {
-          const double Q  = tdg.Qg[iQ];
-          const double Q2 = Q * Q;
-          const double bs = bstar(b, Q);
-          apfel::Set<apfel::Distribution> tdist = Tmds(bs, Q, Q2);
-          tdist.SetMap(cevb);
-          return [&] (double const& x) -> double{ return b * NPFunc->Evaluate(x, b, Q2, (pf == "pdf" ? 0 : 1)) / (pf == "pdf" ? 1 : x * x); } * tdist;
-        };
-        for (int iqT = 0; iqT < (int) tdg.qToQg.size(); iqT++)
-          {
-            // Transform into qT space
-            const std::map<int, apfel::Distribution> DqT = apfel::QCDEvToPhys(DEObj.transform(bTintegrand, tdg.Qg[iQ] * tdg.qToQg[iqT]).GetObjects());
-            for (int f : flv)
-              {
-                const apfel::Distribution Df = DqT.at(f);
-                for (int ix = 0; ix < (int) tdg.xg.size(); ix++)
-                  TMDs[f][iQ][ix][iqT] = Df.Evaluate(tdg.xg[ix]) / 2 / M_PI;
-              }
-          }
-        // Report computation status
-        const double perc = 100. * ( iQ + 1 ) / tdg.Qg.size();
-        std::cout << "Status report for the TMD grid computation: "<< std::setw(6) << std::setprecision(4) << perc << "\% completed...\r";
-        std::cout.flush();
-      }
+          // Transform into qT space
+          const std::map<int, apfel::Distribution> DqT = apfel::QCDEvToPhys(DEObj.transform(bTintegrand, tdg.Qg[iQ] * tdg.qToQg[iqT]).GetObjects());
+          for (int f : flv)
+            {
+              const apfel::Distribution Df = DqT.at(f);
+              std::vector<std::vector<double>>& TMDf = TMDs.at(f)[iQ];
+              for (int ix = 0; ix < (int) tdg.xg.size(); ix++)
+                TMDf[ix][iqT] = Df.Evaluate(tdg.xg[ix]) / 2 / M_PI;
+            }
+        }
+      // Report computation status
+      std::lock_guard<std::mutex> lock(mtx);
+      const double perc = 100. * ( ++ndone ) / tdg.Qg.size();
+      std::cout << "Status report for the TMD grid computation: "<< std::setw(6) << std::setprecision(4) << perc << "\% completed...\r";
+      std::cout.flush();
+    }, nthreads);
     std::cout << "\n";
 
     // Dump grids to emitter
@@ -229,9 +253,6 @@ namespace NangaParbat
     *out << YAML::Key << "TMDs"  << YAML::Value << YAML::Flow << TMDs;
     *out << YAML::EndMap;
 
-    // Delete LHAPDF set and NP function
-    delete dist;
-
     // Stop timer
     t.stop();
 
@@ -5,22 +5,36 @@
 #include "NangaParbat/factories.h"
 #include "NangaParbat/numtostring.h"
 
+#include <fstream>
+
 namespace NangaParbat
 {
+  //_________________________________________________________________________________
+  template<class Grid>
+  Grid* LoadGridMember(YAML::Node const& info, std::string const& path, std::string const& name, int const& mem)
+  {
+    // Use the binary version of the member if available and up to
+    // date
+    const std::string file = path + "/" + name + "_" + num_to_string(mem);
+    if (UseBinaryGrid(file))
+      {
+        std::cout << "[NangaParbat]: loading " << file + ".bin" << std::endl;
+        return new Grid{info, std::make_shared<BinaryGrid const>(file + ".bin")};
+      }
+    std::cout << "[NangaParbat]: loading " << file + ".yaml" << std::endl;
+    return new Grid{info, YAML::LoadFile(file + ".yaml")};
+  }
+
   //_________________________________________________________________________________
   TMDGrid* mkTMD(std::string const& name, int const& mem)
   {
-    std::cout << "[NangaParbat]: loading " << name + "/" + name + "_" + num_to_string(mem) + ".yaml" << std::endl;
-    return new NangaParbat::TMDGrid{YAML::LoadFile(name + "/" + name + ".info"),
-                                    YAML::LoadFile(name + "/" + name + "_" + num_to_string(mem) + ".yaml")};
+    return LoadGridMember<TMDGrid>(YAML::LoadFile(name + "/" + name + ".info"), name, name, mem);
   }
 
   //_________________________________________________________________________________
   TMDGrid* mkTMD(std::string const& name, std::string const& folder, int const& mem)
   {
-    std::cout << "[NangaParbat]: loading " << folder + "/" + name + "/" + name + "_" + num_to_string(mem) + ".yaml" << std::endl;
-    return new NangaParbat::TMDGrid{YAML::LoadFile(folder + "/"  + name + "/" + name + ".info"),
-                                    YAML::LoadFile(folder + "/"  + name + "/" + name + "_" + num_to_string(mem) + ".yaml")};
+    return LoadGridMember<TMDGrid>(YAML::LoadFile(folder + "/"  + name + "/" + name + ".info"), folder + "/"  + name, name, mem);
   }
 
   //_________________________________________________________________________________
@@ -30,27 +44,21 @@ namespace NangaParbat
     const int nmem = info["NumMembers"].as<int>();
     std::vector<TMDGrid*> tmds(nmem);
     for (int mem = 0; mem < nmem; mem++)
-      {
-        std::cout << "[NangaParbat]: loading " << name + "/" + name + "_" + num_to_string(mem) + ".yaml" << std::endl;
-        tmds[mem] = new NangaParbat::TMDGrid{info, YAML::LoadFile(name + "/" + name + "_" + num_to_string(mem) + ".yaml")};
-      }
+      tmds[mem] = LoadGridMember<TMDGrid>(info, name, name, mem);
+
     return tmds;
   }
 
   //_________________________________________________________________________________
   StructGrid* mkSF(std::string const& name, int const& mem)
   {
-    std::cout << "[NangaParbat]: loading " << name + "/" + name + "_" + num_to_string(mem) + ".yaml" << std::endl;
-    return new NangaParbat::StructGrid{YAML::LoadFile(name + "/" + name + ".info"),
-                                       YAML::LoadFile(name + "/" + name + "_" + num_to_string(mem) + ".yaml")};
+    return LoadGridMember<StructGrid>(YAML::LoadFile(name + "/" + name + ".info"), name, name, mem);
   }
 
   //_________________________________________________________________________________
   StructGrid* mkSF(std::string const& name, std::string const& folder, int const& mem)
   {
-    std::cout << "[NangaParbat]: loading " << folder + "/" + name + "/" + name + "_" + num_to_string(mem) + ".yaml" << std::endl;
-    return new NangaParbat::StructGrid{YAML::LoadFile(folder + "/"  + name + "/" + name + ".info"),
-                                       YAML::LoadFile(folder + "/"  + name + "/" + name + "_" + num_to_string(mem) + ".yaml")};
+    return LoadGridMember<StructGrid>(YAML::LoadFile(folder + "/"  + name + "/" + name + ".info"), folder + "/"  + name, name, mem);
   }
 
   //_________________________________________________________________________________
@@ -60,14 +68,76 @@ namespace NangaParbat
     const int nmem = info["NumMembers"].as<int>();
     std::vector<StructGrid*> sfs(nmem);
     for (int mem = 0; mem < nmem; mem++)
-      {
-        std::cout << "[NangaParbat]: loading " << name + "/" + name + "_" + num_to_string(mem) + ".yaml" << std::endl;
-        sfs[mem] = new NangaParbat::StructGrid{info, YAML::LoadFile(name + "/" + name + "_" + num_to_string(mem) + ".yaml")};
-      }
+      sfs[mem] = LoadGridMember<StructGrid>(info, name, name, mem);
 
     return sfs;
   }
 
+  //_________________________________________________________________________________
+  template<class Grid>
+  LazyGridSet<Grid>::LazyGridSet(std::string const& name, std::string const& folder):
+    _name(name),
+    _path(folder + "/" + name),
+    _info(YAML::LoadFile(_path + "/" + name + ".info")),
+    _sumids(_info["SummaryMembers"] ? _info["SummaryMembers"].as<std::map<std::string, int>>() : std::map<std::string, int> {}),
+    _members(_info["NumMembers"].as<int>())
+  {
+  }
+
+  //_________________________________________________________________________________
+  template<class Grid>
+  Grid const* LazyGridSet<Grid>::GetMember(int const& mem) const
+  {
+    if (mem < 0 || mem >= (int) _members.size())
+      throw std::runtime_error("[LazyGridSet::GetMember]: member out of range.");
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_members[mem])
+      _members[mem] = std::unique_ptr<Grid>(LoadGridMember<Grid>(_info, _path, _name, mem));
+    return _members[mem].get();
+  }
+
+  //_________________________________________________________________________________
+  template<class Grid>
+  std::vector<std::string> LazyGridSet<Grid>::GetSummaryMemberNames() const
+  {
+    std::vector<std::string> names;
+    for (auto const& m : _sumids)
+      names.push_back(m.first);
+    return names;
+  }
+
+  //_________________________________________________________________________________
+  template<class Grid>
+  Grid const* LazyGridSet<Grid>::GetSummaryMember(std::string const& name) const
+  {
+    const auto id = _sumids.find(name);
+    if (id == _sumids.end())
+      throw std::runtime_error("[LazyGridSet::GetSummaryMember]: summary member '" + name + "' not found.");
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unique_ptr<Grid>& m = _summary[name];
+    if (!m)
+      m = std::unique_ptr<Grid>(LoadGridMember<Grid>(_info, _path, _name, id->second));
+    return m.get();
+  }
+
+  //_________________________________________________________________________________
+  LazyGridSet<TMDGrid>* mkTMDsLazy(std::string const& name, std::string const& folder)
+  {
+    return new LazyGridSet<TMDGrid> {name, folder};
+  }
+
+  //_________________________________________________________________________________
+  LazyGridSet<StructGrid>* mkSFsLazy(std::string const& name, std::string const& folder)
+  {
+    return new LazyGridSet<StructGrid> {name, folder};
+  }
+
+  // Explicit instantiations
+  template class LazyGridSet<TMDGrid>;
+  template class LazyGridSet<StructGrid>;
+
   //_________________________________________________________________________________
   std::function<double(double const&, double const&, double const&, double const&)> Convolution(TMDGrid                                           const* TMD1,
                                                                                                 TMDGrid                                           const* TMD2,
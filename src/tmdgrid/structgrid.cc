@@ -20,8 +20,36 @@ namespace NangaParbat
   })),
   _qToQg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid["qToQg"].as<std::vector<double>>(), 3})),
   _Qg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid["Qg"].as<std::vector<double>>(), 3})),
-  _stfunc(grid["StructureFunction"].as<std::vector<std::vector<std::vector<std::vector<double>>>>>())
+  _nx(grid["xg"].size()),
+  _nz(grid["zg"].size()),
+  _nqToQ(grid["qToQg"].size()),
+  _bin(nullptr)
   {
+    // Store the grid contiguously to match the binary format
+    const std::vector<std::vector<std::vector<std::vector<double>>>> sf = grid["StructureFunction"].as<std::vector<std::vector<std::vector<std::vector<double>>>>>();
+    _store.reserve(grid["Qg"].size() * _nx * _nz * _nqToQ);
+    for (auto const& sQ : sf)
+      for (auto const& sx : sQ)
+        for (auto const& sz : sx)
+          _store.insert(_store.end(), sz.begin(), sz.end());
+    _stfunc = _store.data();
+  }
+
+  //_________________________________________________________________________________
+  StructGrid::StructGrid(YAML::Node const& info, std::shared_ptr<BinaryGrid const> const& grid):
+    _info(info),
+    _xg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid->GetAxes().at(1), 3})),
+    _zg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid->GetAxes().at(2), 3})),
+    _qToQg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid->GetAxes().at(3), 3})),
+    _Qg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid->GetAxes().at(0), 3})),
+    _nx(grid->GetAxes()[1].size()),
+    _nz(grid->GetAxes()[2].size()),
+    _nqToQ(grid->GetAxes()[3].size()),
+    _bin(grid),
+    _stfunc(grid->GetData())
+  {
+    if (grid->GetAxes().size() != 4 || grid->GetFlavours().size() != 1)
+      throw std::runtime_error("[StructGrid::StructGrid]: the binary grid does not have the structure-function layout.");
   }
 
   //_________________________________________________________________________________
@@ -76,7 +104,7 @@ namespace NangaParbat
       for (int ix = 0; ix < nx; ix++)
         for (int iz = 0; iz < nz; iz++)
           for (int iqT = 0; iqT < nqT; iqT++)
-            result += IQ[iQ] * Ix[ix] * Iz[iz] * IqT[iqT] * _stfunc[inQ + iQ][inx + ix][inz + iz][inqT + iqT];
+            result += IQ[iQ] * Ix[ix] * Iz[iz] * IqT[iqT] * _stfunc[( ( ( inQ + iQ ) * _nx + inx + ix ) * _nz + inz + iz ) * _nqToQ + inqT + iqT];
 
     return result;
   }
@@ -15,8 +15,30 @@ namespace NangaParbat
   })),
   _qToQg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid["qToQg"].as<std::vector<double>>(), 3})),
   _Qg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid["Qg"].as<std::vector<double>>(), 3})),
-  _tmds(grid["TMDs"].as<std::map<int, std::vector<std::vector<std::vector<double>>>>>())
+  _nx(grid["xg"].size()),
+  _nqToQ(grid["qToQg"].size()),
+  _bin(nullptr)
   {
+    // Store the grid contiguously with the flavour as the fastest
+    // index to match the binary format.
+    _store = FlattenTMDGrid(grid, _flv);
+    _tmds = _store.data();
+  }
+
+  //_________________________________________________________________________________
+  TMDGrid::TMDGrid(YAML::Node const& info, std::shared_ptr<BinaryGrid const> const& grid):
+    _info(info),
+    _xg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid->GetAxes().at(1), 3})),
+    _qToQg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid->GetAxes().at(2), 3})),
+    _Qg(std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {grid->GetAxes().at(0), 3})),
+    _nx(grid->GetAxes()[1].size()),
+    _nqToQ(grid->GetAxes()[2].size()),
+    _flv(grid->GetFlavours()),
+    _bin(grid),
+    _tmds(grid->GetData())
+  {
+    if (grid->GetAxes().size() != 3)
+      throw std::runtime_error("[TMDGrid::TMDGrid]: the binary grid does not have three axes.");
   }
 
   //_________________________________________________________________________________
@@ -53,17 +75,24 @@ namespace NangaParbat
     for (int iqT = 0; iqT < nqT; iqT++)
       IqT[iqT] = _qToQg->Interpolant(std::get<0>(qToQbounds), inqT + iqT, qToQ);
 
-    // Initialise output map to zero
-    std::map<int, double> result;
-    for (auto const& tmd : _tmds)
-      result.insert({tmd.first, 0});
+    // Do the interpolation. The weights of the nodes are common to
+    // all flavours that are contiguous in memory.
+    const int nfl = _flv.size();
+    std::vector<double> res(nfl, 0.);
+    for (int iQ = 0; iQ < nQ; iQ++)
+      for (int ix = 0; ix < nx; ix++)
+        for (int iqT = 0; iqT < nqT; iqT++)
+          {
+            const double w = IQ[iQ] * Ix[ix] * IqT[iqT];
+            double const* t = _tmds + ( ( ( inQ + iQ ) * _nx + inx + ix ) * _nqToQ + inqT + iqT ) * nfl;
+            for (int ifl = 0; ifl < nfl; ifl++)
+              res[ifl] += w * t[ifl];
+          }
 
-    // Do the interpolation
-    for (auto const& tmd : _tmds)
-      for (int iQ = 0; iQ < nQ; iQ++)
-        for (int ix = 0; ix < nx; ix++)
-          for (int iqT = 0; iqT < nqT; iqT++)
-            result[tmd.first] += IQ[iQ] * Ix[ix] * IqT[iqT] * tmd.second[inQ + iQ][inx + ix][inqT + iqT];
+    // Fill in output map
+    std::map<int, double> result;
+    for (int ifl = 0; ifl < nfl; ifl++)
+      result.insert({_flv[ifl], res[ifl]});
 
     return result;
   }
@@ -0,0 +1,157 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/tmdgridset.h"
+#include "NangaParbat/binarygrid.h"
+#include "NangaParbat/numtostring.h"
+
+#include <fstream>
+
+namespace NangaParbat
+{
+  //_________________________________________________________________________________
+  TMDGridSet::TMDGridSet(std::string const& name, std::string const& folder):
+    _info(YAML::LoadFile(folder + "/" + name + "/" + name + ".info")),
+    _nmem(_info["NumMembers"].as<int>())
+  {
+    if (_nmem < 1)
+      throw std::runtime_error("[TMDGridSet::TMDGridSet]: the set has no members.");
+
+    std::vector<std::vector<double>> axes;
+    for (int mem = 0; mem < _nmem; mem++)
+      {
+        const std::string file = folder + "/" + name + "/" + name + "_" + num_to_string(mem);
+
+        // Read the member, from the binary file if available and up to
+        // date
+        std::vector<std::vector<double>> maxes;
+        std::vector<int> flv;
+        std::unique_ptr<BinaryGrid> bin;
+        std::vector<double> yml;
+        double const* data;
+        if (UseBinaryGrid(file))
+          {
+            std::cout << "[NangaParbat]: loading " << file + ".bin" << std::endl;
+            bin = std::unique_ptr<BinaryGrid>(new BinaryGrid{file + ".bin"});
+            maxes = bin->GetAxes();
+            flv   = bin->GetFlavours();
+            data  = bin->GetData();
+          }
+        else
+          {
+            std::cout << "[NangaParbat]: loading " << file + ".yaml" << std::endl;
+            const YAML::Node grid = YAML::LoadFile(file + ".yaml");
+            maxes = {grid["Qg"].as<std::vector<double>>(), grid["xg"].as<std::vector<double>>(), grid["qToQg"].as<std::vector<double>>()};
+            yml   = FlattenTMDGrid(grid, flv);
+            data  = yml.data();
+          }
+
+        // The first member sets axes and flavours, all the others
+        // have to match them.
+        if (mem == 0)
+          {
+            axes   = maxes;
+            _flv   = flv;
+            _msize = axes[0].size() * axes[1].size() * axes[2].size() * _flv.size();
+            _tmds.resize(_nmem * _msize);
+          }
+        else if (maxes != axes || flv != _flv)
+          throw std::runtime_error("[TMDGridSet::TMDGridSet]: member " + std::to_string(mem) + " does not share the grid of member 0.");
+
+        std::copy(data, data + _msize, _tmds.begin() + mem * _msize);
+      }
+
+    _Qg    = std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {axes[0], 3});
+    _xg    = std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {axes[1], 3});
+    _qToQg = std::unique_ptr<apfel::QGrid<double>>(new apfel::QGrid<double> {axes[2], 3});
+    _nx    = axes[1].size();
+    _nqToQ = axes[2].size();
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> TMDGridSet::EvaluateBlock(double const& x, double const& qT, double const& Q) const
+  {
+    // If qT/Q < the first point of the grid, put qT/Q  equal to it.
+    // Do not compute below the first point of the grid.
+    const double qToQ = std::max(qT / Q, _qToQg->GetQGrid().front());
+
+    // Get summation bounds
+    const std::tuple<int, int, int> xbounds    = _xg->SumBounds(x);
+    const std::tuple<int, int, int> qToQbounds = _qToQg->SumBounds(qToQ);
+    const std::tuple<int, int, int> Qbounds    = _Qg->SumBounds(Q);
+
+    // Compute interpolation weights and offsets of the nodes once for
+    // all members.
+    const int nfl = _flv.size();
+    std::vector<double> w;
+    std::vector<std::size_t> off;
+    for (int iQ = std::get<1>(Qbounds); iQ < std::get<2>(Qbounds); iQ++)
+      {
+        const double IQ = _Qg->Interpolant(std::get<0>(Qbounds), iQ, Q);
+        for (int ix = std::get<1>(xbounds); ix < std::get<2>(xbounds); ix++)
+          {
+            const double Ix = _xg->Interpolant(std::get<0>(xbounds), ix, x);
+            for (int iqT = std::get<1>(qToQbounds); iqT < std::get<2>(qToQbounds); iqT++)
+              {
+                w.push_back(IQ * Ix * _qToQg->Interpolant(std::get<0>(qToQbounds), iqT, qToQ));
+                off.push_back(( ( iQ * _nx + ix ) * _nqToQ + iqT ) * nfl);
+              }
+          }
+      }
+
+    // Interpolate all members
+    const int nn = w.size();
+    std::vector<double> res(_nmem * nfl, 0.);
+    for (int mem = 0; mem < _nmem; mem++)
+      {
+        double const* t = _tmds.data() + mem * _msize;
+        double* r = res.data() + mem * nfl;
+        for (int in = 0; in < nn; in++)
+          for (int ifl = 0; ifl < nfl; ifl++)
+            r[ifl] += w[in] * t[off[in] + ifl];
+      }
+    return res;
+  }
+
+  //_________________________________________________________________________________
+  std::vector<std::map<int, double>> TMDGridSet::EvaluateMembers(double const& x, double const& qT, double const& Q) const
+  {
+    const std::vector<double> res = EvaluateBlock(x, qT, Q);
+    const int nfl = _flv.size();
+    std::vector<std::map<int, double>> result(_nmem);
+    for (int mem = 0; mem < _nmem; mem++)
+      for (int ifl = 0; ifl < nfl; ifl++)
+        result[mem].insert({_flv[ifl], res[mem * nfl + ifl]});
+
+    return result;
+  }
+
+  //_________________________________________________________________________________
+  std::map<int, std::pair<double, double>> TMDGridSet::EvaluateMeanStd(double const& x, double const& qT, double const& Q) const
+  {
+    const std::vector<double> res = EvaluateBlock(x, qT, Q);
+
+    // Exclude member 0 if there are replicas
+    const int first = (_nmem > 1 ? 1 : 0);
+    const int nrep  = _nmem - first;
+
+    const int nfl = _flv.size();
+    std::map<int, std::pair<double, double>> result;
+    for (int ifl = 0; ifl < nfl; ifl++)
+      {
+        double mean = 0;
+        for (int mem = first; mem < _nmem; mem++)
+          mean += res[mem * nfl + ifl];
+        mean /= nrep;
+
+        double var = 0;
+        for (int mem = first; mem < _nmem; mem++)
+          var += pow(res[mem * nfl + ifl] - mean, 2);
+        var = (nrep > 1 ? var / ( nrep - 1 ) : 0);
+
+        result.insert({_flv[ifl], {mean, sqrt(var)}});
+      }
+    return result;
+  }
+}
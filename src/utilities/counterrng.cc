@@ -0,0 +1,84 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/counterrng.h"
+
+#include <cmath>
+
+namespace NangaParbat
+{
+  namespace
+  {
+    //_________________________________________________________________________________
+    uint64_t SplitMix64(uint64_t x)
+    {
+      x += 0x9E3779B97F4A7C15ULL;
+      x = ( x ^ ( x >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+      x = ( x ^ ( x >> 27 ) ) * 0x94D049BB133111EBULL;
+      return x ^ ( x >> 31 );
+    }
+
+    //_________________________________________________________________________________
+    uint64_t HashString(std::string const& s)
+    {
+      // FNV-1a
+      uint64_t h = 0xCBF29CE484222325ULL;
+      for (unsigned char c : s)
+        {
+          h ^= c;
+          h *= 0x100000001B3ULL;
+        }
+      return h;
+    }
+  }
+
+  //_________________________________________________________________________________
+  CounterRNG::CounterRNG(uint64_t const& key):
+    _key(key)
+  {
+  }
+
+  //_________________________________________________________________________________
+  CounterRNG::CounterRNG(int const& seed, int const& replica, std::string const& name):
+    CounterRNG{SplitMix64(SplitMix64(SplitMix64((uint64_t) seed) ^ (uint64_t) replica) ^ HashString(name))}
+  {
+  }
+
+  //_________________________________________________________________________________
+  std::array<uint32_t, 4> CounterRNG::Block(uint64_t const& i) const
+  {
+    std::array<uint32_t, 4> c{(uint32_t) i, (uint32_t) ( i >> 32 ), 0, 0};
+    uint32_t k0 = (uint32_t) _key;
+    uint32_t k1 = (uint32_t) ( _key >> 32 );
+
+    // Ten Philox rounds
+    for (int r = 0; r < 10; r++)
+      {
+        const uint64_t p0 = (uint64_t) 0xD2511F53 * c[0];
+        const uint64_t p1 = (uint64_t) 0xCD9E8D57 * c[2];
+        c = {(uint32_t) ( p1 >> 32 ) ^ c[1] ^ k0, (uint32_t) p1, (uint32_t) ( p0 >> 32 ) ^ c[3] ^ k1, (uint32_t) p0};
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+      }
+    return c;
+  }
+
+  //_________________________________________________________________________________
+  double CounterRNG::Uniform(uint64_t const& i) const
+  {
+    // 53 random bits shifted away from zero by half a unit
+    const std::array<uint32_t, 4> b = Block(i);
+    const uint64_t u = ( ( (uint64_t) b[0] << 32 ) | b[1] ) >> 11;
+    return ( u + 0.5 ) / 9007199254740992.;
+  }
+
+  //_________________________________________________________________________________
+  double CounterRNG::Gaussian(uint64_t const& i) const
+  {
+    const std::array<uint32_t, 4> b = Block(i);
+    const double u1 = ( ( ( ( (uint64_t) b[0] << 32 ) | b[1] ) >> 11 ) + 0.5 ) / 9007199254740992.;
+    const double u2 = ( ( ( ( (uint64_t) b[2] << 32 ) | b[3] ) >> 11 ) + 0.5 ) / 9007199254740992.;
+    return sqrt( - 2 * log(u1) ) * cos(2 * M_PI * u2);
+  }
+}
@@ -0,0 +1,660 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/expression.h"
+
+#include <cmath>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace NangaParbat
+{
+  //_________________________________________________________________________________
+  struct ExpressionNode
+  {
+    enum Op: int {Const, Var, Add, Sub, Mul, Div, Neg, Pow, Exp, Log, Sqrt, Abs, Sin, Cos};
+
+    Op                                    op;    //!< Operation
+    double                                value; //!< Value (constants only)
+    int                                   index; //!< Index of the variable (variables only)
+    std::shared_ptr<ExpressionNode const> a;     //!< First operand
+    std::shared_ptr<ExpressionNode const> b;     //!< Second operand (binary operations only)
+  };
+
+  namespace
+  {
+    typedef std::shared_ptr<ExpressionNode const> Node;
+
+    //_________________________________________________________________________________
+    double Apply(int const& op, double const& a, double const& b)
+    {
+      switch (op)
+        {
+        case ExpressionNode::Add:
+          return a + b;
+        case ExpressionNode::Sub:
+          return a - b;
+        case ExpressionNode::Mul:
+          return a * b;
+        case ExpressionNode::Div:
+          return a / b;
+        case ExpressionNode::Neg:
+          return - a;
+        case ExpressionNode::Pow:
+          return pow(a, b);
+        case ExpressionNode::Exp:
+          return exp(a);
+        case ExpressionNode::Log:
+          return log(a);
+        case ExpressionNode::Sqrt:
+          return sqrt(a);
+        case ExpressionNode::Abs:
+          return std::abs(a);
+        case ExpressionNode::Sin:
+          return sin(a);
+        case ExpressionNode::Cos:
+          return cos(a);
+        default:
+          throw std::runtime_error("[Expression]: unknown operation");
+        }
+    }
+
+    //_________________________________________________________________________________
+    Node MakeConst(double const& v)
+    {
+      return Node(new ExpressionNode{ExpressionNode::Const, v, -1, nullptr, nullptr});
+    }
+
+    //_________________________________________________________________________________
+    Node MakeVar(int const& i)
+    {
+      return Node(new ExpressionNode{ExpressionNode::Var, 0, i, nullptr, nullptr});
+    }
+
+    //_________________________________________________________________________________
+    bool IsConst(Node const& n, double const& v)
+    {
+      return n->op == ExpressionNode::Const && n->value == v;
+    }
+
+    //_________________________________________________________________________________
+    Node MakeUnary(ExpressionNode::Op const& op, Node const& a)
+    {
+      // Fold constants
+      if (a->op == ExpressionNode::Const)
+        return MakeConst(Apply(op, a->value, 0));
+
+      // -(-a) = a
+      if (op == ExpressionNode::Neg && a->op == ExpressionNode::Neg)
+        return a->a;
+
+      return Node(new ExpressionNode{op, 0, -1, a, nullptr});
+    }
+
+    //_________________________________________________________________________________
+    Node MakeBinary(ExpressionNode::Op const& op, Node const& a, Node const& b)
+    {
+      // Fold constants
+      if (a->op == ExpressionNode::Const && b->op == ExpressionNode::Const)
+        return MakeConst(Apply(op, a->value, b->value));
+
+      // Remove trivial operations
+      switch (op)
+        {
+        case ExpressionNode::Add:
+          if (IsConst(a, 0))
+            return b;
+          if (IsConst(b, 0))
+            return a;
+          break;
+        case ExpressionNode::Sub:
+          if (IsConst(b, 0))
+            return a;
+          if (IsConst(a, 0))
+            return MakeUnary(ExpressionNode::Neg, b);
+          break;
+        case ExpressionNode::Mul:
+          if (IsConst(a, 0) || IsConst(b, 0))
+            return MakeConst(0);
+          if (IsConst(a, 1))
+            return b;
+          if (IsConst(b, 1))
+            return a;
+          if (IsConst(a, -1))
+            return MakeUnary(ExpressionNode::Neg, b);
+          if (IsConst(b, -1))
+            return MakeUnary(ExpressionNode::Neg, a);
+          break;
+        case ExpressionNode::Div:
+          if (IsConst(a, 0))
+            return MakeConst(0);
+          if (IsConst(b, 1))
+            return a;
+          break;
+        case ExpressionNode::Pow:
+          if (IsConst(b, 0) || IsConst(a, 1))
+            return MakeConst(1);
+          if (IsConst(b, 1))
+            return a;
+          if (IsConst(b, 2))
+            return MakeBinary(ExpressionNode::Mul, a, a);
+          break;
+        default:
+          break;
+        }
+      return Node(new ExpressionNode{op, 0, -1, a, b});
+    }
+
+    //_________________________________________________________________________________
+    Node Derivative(Node const& f, int const& ivar)
+    {
+      Node const& a = f->a;
+      Node const& b = f->b;
+      switch (f->op)
+        {
+        case ExpressionNode::Const:
+          return MakeConst(0);
+        case ExpressionNode::Var:
+          return MakeConst(f->index == ivar ? 1 : 0);
+        case ExpressionNode::Add:
+          return MakeBinary(ExpressionNode::Add, Derivative(a, ivar), Derivative(b, ivar));
+        case ExpressionNode::Sub:
+          return MakeBinary(ExpressionNode::Sub, Derivative(a, ivar), Derivative(b, ivar));
+        case ExpressionNode::Mul:
+          return MakeBinary(ExpressionNode::Add,
+                            MakeBinary(ExpressionNode::Mul, Derivative(a, ivar), b),
+                            MakeBinary(ExpressionNode::Mul, a, Derivative(b, ivar)));
+        case ExpressionNode::Div:
+          // (a / b)' = (a' - (a / b) * b') / b
+          return MakeBinary(ExpressionNode::Div,
+                            MakeBinary(ExpressionNode::Sub, Derivative(a, ivar), MakeBinary(ExpressionNode::Mul, f, Derivative(b, ivar))),
+                            b);
+        case ExpressionNode::Neg:
+          return MakeUnary(ExpressionNode::Neg, Derivative(a, ivar));
+        case ExpressionNode::Pow:
+          // Constant exponent: (a^c)' = c * a^(c - 1) * a'
+          if (b->op == ExpressionNode::Const)
+            return MakeBinary(ExpressionNode::Mul,
+                              MakeBinary(ExpressionNode::Mul, b, MakeBinary(ExpressionNode::Pow, a, MakeConst(b->value - 1))),
+                              Derivative(a, ivar));
+          // General case: (a^b)' = a^b * (b' * log(a) + b * a' / a)
+          return MakeBinary(ExpressionNode::Mul, f,
+                            MakeBinary(ExpressionNode::Add,
+                                       MakeBinary(ExpressionNode::Mul, Derivative(b, ivar), MakeUnary(ExpressionNode::Log, a)),
+                                       MakeBinary(ExpressionNode::Div, MakeBinary(ExpressionNode::Mul, b, Derivative(a, ivar)), a)));
+        case ExpressionNode::Exp:
+          return MakeBinary(ExpressionNode::Mul, f, Derivative(a, ivar));
+        case ExpressionNode::Log:
+          return MakeBinary(ExpressionNode::Div, Derivative(a, ivar), a);
+        case ExpressionNode::Sqrt:
+          return MakeBinary(ExpressionNode::Div, Derivative(a, ivar), MakeBinary(ExpressionNode::Mul, MakeConst(2), f));
+        case ExpressionNode::Abs:
+          return MakeBinary(ExpressionNode::Mul, Derivative(a, ivar), MakeBinary(ExpressionNode::Div, a, f));
+        case ExpressionNode::Sin:
+          return MakeBinary(ExpressionNode::Mul, MakeUnary(ExpressionNode::Cos, a), Derivative(a, ivar));
+        case ExpressionNode::Cos:
+          return MakeUnary(ExpressionNode::Neg, MakeBinary(ExpressionNode::Mul, MakeUnary(ExpressionNode::Sin, a), Derivative(a, ivar)));
+        default:
+          throw std::runtime_error("[Expression::Derive]: unknown operation");
+        }
+    }
+
+    //_________________________________________________________________________________
+    std::string Print(Node const& f, std::vector<std::string> const& variables)
+    {
+      const std::map<int, std::string> functions{
+        {ExpressionNode::Exp, "exp"}, {ExpressionNode::Log, "log"}, {ExpressionNode::Sqrt, "sqrt"},
+        {ExpressionNode::Abs, "abs"}, {ExpressionNode::Sin, "sin"}, {ExpressionNode::Cos, "cos"}};
+      const std::map<int, std::string> operators{
+        {ExpressionNode::Add, " + "}, {ExpressionNode::Sub, " - "}, {ExpressionNode::Mul, " * "},
+        {ExpressionNode::Div, " / "}, {ExpressionNode::Pow, "^"}};
+      switch (f->op)
+        {
+        case ExpressionNode::Const:
+        {
+          std::ostringstream os;
+          os.precision(17);
+          os << f->value;
+          return (f->value < 0 ? "(" + os.str() + ")" : os.str());
+        }
+        case ExpressionNode::Var:
+          return variables[f->index];
+        case ExpressionNode::Neg:
+          return "(-" + Print(f->a, variables) + ")";
+        default:
+          if (f->b)
+            return "(" + Print(f->a, variables) + operators.at(f->op) + Print(f->b, variables) + ")";
+          return functions.at(f->op) + "(" + Print(f->a, variables) + ")";
+        }
+    }
+
+    /**
+     * @brief Recursive-descent parser of expressions
+     */
+    class Parser
+    {
+    public:
+      Parser(std::string const& s, std::vector<std::string> const& variables, std::map<std::string, double> const& constants):
+        _s(s), _variables(variables), _constants(constants), _pos(0)
+      {
+      }
+
+      Node Parse()
+      {
+        const Node n = ParseSum();
+        SkipSpaces();
+        if (_pos != _s.size())
+          Error("unexpected character '" + _s.substr(_pos, 1) + "'");
+        return n;
+      }
+
+    private:
+      void Error(std::string const& msg) const
+      {
+        throw std::runtime_error("[Expression::Expression]: " + msg + " at position " + std::to_string(_pos) + " of '" + _s + "'");
+      }
+
+      void SkipSpaces()
+      {
+        while (_pos < _s.size() && std::isspace(_s[_pos]))
+          _pos++;
+      }
+
+      bool Accept(std::string const& tok)
+      {
+        SkipSpaces();
+        if (_s.compare(_pos, tok.size(), tok) != 0)
+          return false;
+        _pos += tok.size();
+        return true;
+      }
+
+      // sum := product (('+' | '-') product)*
+      Node ParseSum()
+      {
+        Node n = ParseProduct();
+        while (true)
+          if (Accept("+"))
+            n = MakeBinary(ExpressionNode::Add, n, ParseProduct());
+          else if (Accept("-"))
+            n = MakeBinary(ExpressionNode::Sub, n, ParseProduct());
+          else
+            return n;
+      }
+
+      // product := unary (('*' | '/') unary)*
+      Node ParseProduct()
+      {
+        Node n = ParseUnary();
+        while (true)
+          if (Accept("*"))
+            n = MakeBinary(ExpressionNode::Mul, n, ParseUnary());
+          else if (Accept("/"))
+            n = MakeBinary(ExpressionNode::Div, n, ParseUnary());
+          else
+            return n;
+      }
+
+      // unary := ('-' | '+') unary | power
+      Node ParseUnary()
+      {
+        if (Accept("-"))
+          return MakeUnary(ExpressionNode::Neg, ParseUnary());
+        if (Accept("+"))
+          return ParseUnary();
+        return ParsePower();
+      }
+
+      // power := primary (('^' | '**') unary)?
+      Node ParsePower()
+      {
+        const Node n = ParsePrimary();
+        if (Accept("^") || Accept("**"))
+          return MakeBinary(ExpressionNode::Pow, n, ParseUnary());
+        return n;
+      }
+
+      // primary := number | identifier | function '(' arguments ')' | '(' sum ')'
+      Node ParsePrimary()
+      {
+        SkipSpaces();
+        if (_pos >= _s.size())
+          Error("unexpected end of expression");
+
+        // Parentheses
+        if (Accept("("))
+          {
+            const Node n = ParseSum();
+            if (!Accept(")"))
+              Error("missing ')'");
+            return n;
+          }
+
+        // Numbers
+        const char c = _s[_pos];
+        if (std::isdigit(c) || c == '.')
+          {
+            char* end;
+            const double v = std::strtod(_s.c_str() + _pos, &end);
+            if (end == _s.c_str() + _pos)
+              Error("invalid number");
+            _pos = end - _s.c_str();
+            return MakeConst(v);
+          }
+
+        // Identifiers
+        if (!std::isalpha(c) && c != '_')
+          Error("unexpected character '" + _s.substr(_pos, 1) + "'");
+
+        const size_t start = _pos;
+        while (_pos < _s.size() && (std::isalnum(_s[_pos]) || _s[_pos] == '_'))
+          _pos++;
+        const std::string id = _s.substr(start, _pos - start);
+
+        // Functions
+        if (Accept("("))
+          {
+            const std::map<std::string, ExpressionNode::Op> functions{
+              {"exp", ExpressionNode::Exp}, {"log", ExpressionNode::Log}, {"sqrt", ExpressionNode::Sqrt},
+              {"abs", ExpressionNode::Abs}, {"sin", ExpressionNode::Sin}, {"cos", ExpressionNode::Cos}};
+            const Node a = ParseSum();
+            Node n;
+            if (id == "pow")
+              {
+                if (!Accept(","))
+                  Error("pow requires two arguments");
+                n = MakeBinary(ExpressionNode::Pow, a, ParseSum());
+              }
+            else if (functions.count(id) == 1)
+              n = MakeUnary(functions.at(id), a);
+            else
+              Error("unknown function '" + id + "'");
+            if (!Accept(")"))
+              Error("missing ')'");
+            return n;
+          }
+
+        // Variables and constants
+        const auto iv = std::find(_variables.begin(), _variables.end(), id);
+        if (iv != _variables.end())
+          return MakeVar(std::distance(_variables.begin(), iv));
+        if (_constants.count(id) == 1)
+          return MakeConst(_constants.at(id));
+        if (id == "pi")
+          return MakeConst(M_PI);
+
+        Error("unknown identifier '" + id + "'");
+        return nullptr;
+      }
+
+    private:
+      std::string                   const& _s;
+      std::vector<std::string>      const& _variables;
+      std::map<std::string, double> const& _constants;
+      size_t                               _pos;
+    };
+  }
+
+  //_________________________________________________________________________________
+  Expression::Expression(std::string const& expr, std::vector<std::string> const& variables, std::map<std::string, double> const& constants):
+    _variables(variables),
+    _root(Parser{expr, variables, constants}.Parse())
+  {
+  }
+
+  //_________________________________________________________________________________
+  Expression::Expression(std::vector<std::string> const& variables, std::shared_ptr<ExpressionNode const> const& root):
+    _variables(variables),
+    _root(root)
+  {
+  }
+
+  //_________________________________________________________________________________
+  Expression Expression::Derive(int const& ivar) const
+  {
+    if (ivar < 0 || ivar >= (int) _variables.size())
+      throw std::runtime_error("[Expression::Derive]: variable index out of range");
+
+    return Expression{_variables, Derivative(_root, ivar)};
+  }
+
+  //_________________________________________________________________________________
+  bool Expression::DependsOn(int const& ivar) const
+  {
+    const std::function<bool(Node const&)> depends = [&] (Node const& n) -> bool
+    {
+      if (n->op == ExpressionNode::Var)
+        return n->index == ivar;
+      return (n->a && depends(n->a)) || (n->b && depends(n->b));
+    };
+    return depends(_root);
+  }
+
+  //_________________________________________________________________________________
+  double Expression::Evaluate(std::vector<double> const& vars) const
+  {
+    if (vars.size() != _variables.size())
+      throw std::runtime_error("[Expression::Evaluate]: wrong number of variables");
+
+    const std::function<double(Node const&)> eval = [&] (Node const& n) -> double
+    {
+      if (n->op == ExpressionNode::Const)
+        return n->value;
+      if (n->op == ExpressionNode::Var)
+        return vars[n->index];
+      return Apply(n->op, eval(n->a), (n->b ? eval(n->b) : 0));
+    };
+    return eval(_root);
+  }
+
+  //_________________________________________________________________________________
+  std::string Expression::ToString() const
+  {
+    return Print(_root, _variables);
+  }
+
+  // Number of points processed at once by the varying instructions
+  constexpr int Chunk = 64;
+
+  //_________________________________________________________________________________
+  ExpressionProgram::ExpressionProgram(std::vector<Expression> const& exprs, int const& narrays):
+    _nvars(exprs.empty() ? 0 : exprs[0].GetVariables().size()),
+    _narrays(narrays)
+  {
+    if (_narrays < 0 || _narrays > _nvars)
+      throw std::runtime_error("[ExpressionProgram::ExpressionProgram]: invalid number of arrays");
+
+    // Compile the expressions sharing common subexpressions
+    std::map<ExpressionNode const*, int> done;
+    std::map<std::string, int> seen;
+    for (auto const& e : exprs)
+      {
+        if ((int) e.GetVariables().size() != _nvars)
+          throw std::runtime_error("[ExpressionProgram::ExpressionProgram]: the expressions must have the same variables");
+        _outputs.push_back(Compile(e.GetRoot(), done, seen));
+      }
+
+    // Split uniform and varying instructions and collect the uniform
+    // registers used by the varying ones, that need to be broadcast
+    // to arrays.
+    std::vector<bool> bcast(_code.size(), false);
+    for (int i = 0; i < (int) _code.size(); i++)
+      if (!_code[i].uniform)
+        {
+          _varying.push_back(i);
+          for (int r : {_code[i].a, _code[i].b})
+            if (r >= 0 && _code[r].uniform)
+              bcast[r] = true;
+        }
+    for (int i = 0; i < (int) _code.size(); i++)
+      if (bcast[i])
+        _bcast.push_back(i);
+  }
+
+  //_________________________________________________________________________________
+  int ExpressionProgram::Compile(std::shared_ptr<ExpressionNode const> const& node, std::map<ExpressionNode const*, int>& done, std::map<std::string, int>& seen)
+  {
+    const auto id = done.find(node.get());
+    if (id != done.end())
+      return id->second;
+
+    const int a = (node->a ? Compile(node->a, done, seen) : -1);
+    const int b = (node->b ? Compile(node->b, done, seen) : -1);
+
+    // Structurally identical nodes are computed only once
+    uint64_t bits;
+    std::memcpy(&bits, &node->value, sizeof(double));
+    const std::string key = std::to_string(node->op) + "," + std::to_string(a) + "," + std::to_string(b) + "," + std::to_string(node->index) + "," + std::to_string(bits);
+    const auto is = seen.find(key);
+    if (is != seen.end())
+      return done[node.get()] = is->second;
+
+    if (node->op == ExpressionNode::Var && (node->index < 0 || node->index >= _nvars))
+      throw std::runtime_error("[ExpressionProgram::Compile]: variable index out of range");
+
+    bool uniform;
+    if (node->op == ExpressionNode::Const)
+      uniform = true;
+    else if (node->op == ExpressionNode::Var)
+      uniform = (node->index >= _narrays);
+    else
+      uniform = _code[a].uniform && (b < 0 || _code[b].uniform);
+
+    _code.push_back({node->op, a, b, node->index, node->value, uniform});
+    const int r = _code.size() - 1;
+    seen[key] = r;
+    return done[node.get()] = r;
+  }
+
+  //_________________________________________________________________________________
+  void ExpressionProgram::Evaluate(double const* vars, double* res) const
+  {
+    thread_local std::vector<double> regs;
+    regs.resize(_code.size());
+    for (int i = 0; i < (int) _code.size(); i++)
+      {
+        Instruction const& I = _code[i];
+        if (I.op == ExpressionNode::Const)
+          regs[i] = I.value;
+        else if (I.op == ExpressionNode::Var)
+          regs[i] = vars[I.index];
+        else
+          regs[i] = Apply(I.op, regs[I.a], (I.b >= 0 ? regs[I.b] : 0));
+      }
+    for (int o = 0; o < (int) _outputs.size(); o++)
+      res[o] = regs[_outputs[o]];
+  }
+
+  //_________________________________________________________________________________
+  void ExpressionProgram::EvaluateBatch(int const& n, double const* const* arrays, double const* scalars, double* res) const
+  {
+    const int nr = _code.size();
+    thread_local std::vector<double> regs;
+    thread_local std::vector<double> work;
+    thread_local std::vector<double const*> src;
+    regs.resize(nr);
+    work.resize(nr * Chunk);
+    src.resize(nr);
+
+    // Uniform instructions once for all points
+    for (int i = 0; i < nr; i++)
+      {
+        Instruction const& I = _code[i];
+        if (!I.uniform)
+          continue;
+        if (I.op == ExpressionNode::Const)
+          regs[i] = I.value;
+        else if (I.op == ExpressionNode::Var)
+          regs[i] = scalars[I.index - _narrays];
+        else
+          regs[i] = Apply(I.op, regs[I.a], (I.b >= 0 ? regs[I.b] : 0));
+      }
+
+    // Broadcast the uniform registers used by varying instructions
+    for (int r : _bcast)
+      {
+        std::fill(work.begin() + r * Chunk, work.begin() + ( r + 1 ) * Chunk, regs[r]);
+        src[r] = work.data() + r * Chunk;
+      }
+
+    // Varying instructions one chunk of points at a time
+    for (int start = 0; start < n; start += Chunk)
+      {
+        const int m = std::min(Chunk, n - start);
+        for (int i : _varying)
+          {
+            Instruction const& I = _code[i];
+            if (I.op == ExpressionNode::Var)
+              {
+                src[i] = arrays[I.index] + start;
+                continue;
+              }
+            double*       r = work.data() + i * Chunk;
+            double const* A = src[I.a];
+            double const* B = (I.b >= 0 ? src[I.b] : nullptr);
+            switch (I.op)
+              {
+              case ExpressionNode::Add:
+                for (int k = 0; k < m; k++)
+                  r[k] = A[k] + B[k];
+                break;
+              case ExpressionNode::Sub:
+                for (int k = 0; k < m; k++)
+                  r[k] = A[k] - B[k];
+                break;
+              case ExpressionNode::Mul:
+                for (int k = 0; k < m; k++)
+                  r[k] = A[k] * B[k];
+                break;
+              case ExpressionNode::Div:
+                for (int k = 0; k < m; k++)
+                  r[k] = A[k] / B[k];
+                break;
+              case ExpressionNode::Neg:
+                for (int k = 0; k < m; k++)
+                  r[k] = - A[k];
+                break;
+              case ExpressionNode::Pow:
+                for (int k = 0; k < m; k++)
+                  r[k] = pow(A[k], B[k]);
+                break;
+              case ExpressionNode::Exp:
+                for (int k = 0; k < m; k++)
+                  r[k] = exp(A[k]);
+                break;
+              case ExpressionNode::Log:
+                for (int k = 0; k < m; k++)
+                  r[k] = log(A[k]);
+                break;
+              case ExpressionNode::Sqrt:
+                for (int k = 0; k < m; k++)
+                  r[k] = sqrt(A[k]);
+                break;
+              default:
+                for (int k = 0; k < m; k++)
+                  r[k] = Apply(I.op, A[k], 0);
+                break;
+              }
+            src[i] = r;
+          }
+
+        // Copy the outputs
+        for (int o = 0; o < (int) _outputs.size(); o++)
+          {
+            const int ro = _outputs[o];
+            double* out = res + o * n + start;
+            if (_code[ro].uniform)
+              std::fill(out, out + m, regs[ro]);
+            else
+              std::copy(src[ro], src[ro] + m, out);
+          }
+      }
+  }
+}
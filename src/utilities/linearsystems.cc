@@ -4,49 +4,275 @@
 
 #include "NangaParbat/linearsystems.h"
 
-#include <gsl/gsl_linalg.h>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
 
 namespace NangaParbat
 {
+  namespace
+  {
+    // Whether the results are validated
+    std::atomic<bool> Checks{false};
+
+    // Size of the blocks of the factorisation. Two blocks of rows of
+    // a few hundred points fit in the L2 cache.
+    const int BlockSize = 64;
+  }
+
   //_________________________________________________________________________________
-  apfel::matrix<double> CholeskyDecomposition(apfel::matrix<double> const V)
+  void SetLinearSystemChecks(bool const& checks)
   {
-    // Convert two dimentional array to one dimentional for gsl routines
-    const int ndata = V.size(0);
-    double* mat = new double[ndata * ndata];
-    for (int i = 0; i < ndata; i++)
-      for (int j = 0; j < ndata; j++)
-        mat[i * ndata + j] = V(i, j);
+    Checks = checks;
+  }
+
+  //_________________________________________________________________________________
+  bool LinearSystemChecks()
+  {
+    return Checks;
+  }
+
+  //_________________________________________________________________________________
+  void CholeskyDecomposition(int const& n, double* A)
+  {
+    // Pointer to the i-th row in packed storage
+    const auto Row = [&] (int const& i) -> double* { return A + i * ( i + 1 ) / 2; };
+
+    // Rows are processed in blocks. Within a block of rows I, the
+    // tile of the columns J is first updated with the contributions
+    // of the already factorised columns K < J, one tile at the time,
+    // and then factorised. In this way each tile of rows is reused
+    // for a full block rather than being reloaded for each row.
+    for (int i0 = 0; i0 < n; i0 += BlockSize)
+      {
+        const int i1 = std::min(i0 + BlockSize, n);
+        for (int j0 = 0; j0 <= i0; j0 += BlockSize)
+          {
+            const int j1 = std::min(j0 + BlockSize, n);
+            for (int k0 = 0; k0 < j0; k0 += BlockSize)
+              for (int i = i0; i < i1; i++)
+                {
+                  double* Li = Row(i);
+                  for (int j = j0; j < std::min(j1, i + 1); j++)
+                    {
+                      double const* Lj = Row(j);
+                      double s = 0;
+                      for (int k = k0; k < k0 + BlockSize; k++)
+                        s += Li[k] * Lj[k];
+                      Li[j] -= s;
+                    }
+                }
 
-    gsl_matrix_view covmat = gsl_matrix_view_array(mat, ndata, ndata);
+            for (int i = i0; i < i1; i++)
+              {
+                double* Li = Row(i);
+                for (int j = j0; j < std::min(j1, i + 1); j++)
+                  {
+                    double const* Lj = Row(j);
+                    double s = Li[j];
+                    for (int k = j0; k < j; k++)
+                      s -= Li[k] * Lj[k];
 
-    gsl_linalg_cholesky_decomp1(&covmat.matrix);
+                    if (j < i)
+                      Li[j] = s / Lj[j];
+                    else if (s > 0)
+                      Li[j] = sqrt(s);
+                    else
+                      throw std::runtime_error("[CholeskyDecomposition]: Problem with the Cholesky decomposition.");
+                  }
+              }
+          }
+      }
+  }
 
-    apfel::matrix<double> L{(size_t) ndata, (size_t) ndata};
+  //_________________________________________________________________________________
+  TriangularMatrix CholeskyDecomposition(apfel::matrix<double> const& V)
+  {
+    const int ndata = V.size(0);
+    TriangularMatrix L{ndata};
     for (int i = 0; i < ndata; i++)
-      for (int j = 0; j < ndata; j++)
-        if (j > i)
-          L(i, j) = 0;
-        else
-          L(i, j) = gsl_matrix_get(&covmat.matrix, i, j);
+      {
+        double* Li = L.Row(i);
+        for (int j = 0; j <= i; j++)
+          Li[j] = V(i, j);
+      }
+    CholeskyDecomposition(ndata, L.v.data());
+
+    if (!LinearSystemChecks())
+      return L;
 
     // Check that L * L^T = V
     for (int i = 0; i < ndata; i++)
-      for (int j = 0; j < ndata; j++)
+      for (int j = 0; j <= i; j++)
         {
           double T = 0;
-          for (int k = 0; k < ndata; k++)
+          for (int k = 0; k <= j; k++)
             T += L(i, k) * L(j, k);
-          if (abs(T / V(i, j) - 1) > 1e-5)
+          if (!(std::abs(T - V(i, j)) <= 1e-5 * sqrt(V(i, i) * V(j, j))))
             throw std::runtime_error("[CholeskyDecomposition]: Problem with the Cholesky decomposition.");
         }
-    delete[] mat;
     return L;
   }
 
   //_________________________________________________________________________________
-  std::vector<double> SolveLowerSystem(apfel::matrix<double> L, std::vector<double> y)
+  LowRankCholesky CholeskyDecomposition(std::vector<double> const& D, std::vector<std::vector<double>> const& U)
+  {
+    const int ndata = D.size();
+    if ((int) U.size() != ndata)
+      throw std::runtime_error("[CholeskyDecomposition]: mismatch in the number of rows.");
+
+    const int k = (ndata == 0 ? 0 : U[0].size());
+    LowRankCholesky L{k, std::vector<double>(ndata), std::vector<double>(ndata * k), std::vector<double>(ndata * k)};
+
+    // Eliminate one row at the time. After the elimination of the
+    // first j rows, the Schur complement of the remaining block is
+    // D + U S U^T with S a k x k matrix (initially the identity),
+    // such that the pivot is d_j^2 = D_j + u_j S u_j, the generator
+    // is g_j = S u_j / d_j, and S is updated as S - g_j g_j^T.
+    std::vector<double> S(k * k, 0.);
+    for (int a = 0; a < k; a++)
+      S[a * k + a] = 1;
+
+    std::vector<double> Su(k);
+    for (int j = 0; j < ndata; j++)
+      {
+        if ((int) U[j].size() != k)
+          throw std::runtime_error("[CholeskyDecomposition]: rows of U have different lengths.");
+
+        double* uj = L.u.data() + j * k;
+        double* gj = L.g.data() + j * k;
+        std::copy(U[j].begin(), U[j].end(), uj);
+
+        double d2 = D[j];
+        for (int a = 0; a < k; a++)
+          {
+            Su[a] = 0;
+            for (int b = 0; b < k; b++)
+              Su[a] += S[a * k + b] * uj[b];
+            d2 += uj[a] * Su[a];
+          }
+        if (!(d2 > 0))
+          throw std::runtime_error("[CholeskyDecomposition]: Problem with the Cholesky decomposition.");
+
+        L.d[j] = sqrt(d2);
+        for (int a = 0; a < k; a++)
+          gj[a] = Su[a] / L.d[j];
+
+        for (int a = 0; a < k; a++)
+          for (int b = 0; b < k; b++)
+            S[a * k + b] -= gj[a] * gj[b];
+      }
+    return L;
+  }
+
+  //_________________________________________________________________________________
+  void SolveLowerSystem(TriangularMatrix const& L, int const& m, double* x)
+  {
+    if (m > L.n)
+      throw std::runtime_error("[SolveLowerSystem]: too many constants.");
+
+    // Solve the system L * x = y by forward substitution. Each row
+    // of L is contiguous in memory and is read once.
+    for (int i = 0; i < m; i++)
+      {
+        double const* Li = L.Row(i);
+        double s = x[i];
+        for (int j = 0; j < i; j++)
+          s -= Li[j] * x[j];
+
+        x[i] = s / Li[i];
+      }
+  }
+
+  //_________________________________________________________________________________
+  void SolveLowerSystem(TriangularMatrix const& L, int const& m, int const& nrhs, double* X)
+  {
+    if (m > L.n)
+      throw std::runtime_error("[SolveLowerSystem]: too many constants.");
+
+    // Rows of X are processed in blocks. Each block I is first
+    // updated with the contributions of the already solved blocks J <
+    // I, one at the time, and then solved by forward substitution.
+    // The innermost loops run over the contiguous columns of X.
+    for (int i0 = 0; i0 < m; i0 += BlockSize)
+      {
+        const int i1 = std::min(i0 + BlockSize, m);
+        for (int j0 = 0; j0 < i0; j0 += BlockSize)
+          for (int i = i0; i < i1; i++)
+            {
+              double const* Li = L.Row(i);
+              double* Xi = X + i * nrhs;
+              for (int j = j0; j < j0 + BlockSize; j++)
+                {
+                  const double lij = Li[j];
+                  double const* Xj = X + j * nrhs;
+                  for (int r = 0; r < nrhs; r++)
+                    Xi[r] -= lij * Xj[r];
+                }
+            }
+
+        for (int i = i0; i < i1; i++)
+          {
+            double const* Li = L.Row(i);
+            double* Xi = X + i * nrhs;
+            for (int j = i0; j < i; j++)
+              {
+                const double lij = Li[j];
+                double const* Xj = X + j * nrhs;
+                for (int r = 0; r < nrhs; r++)
+                  Xi[r] -= lij * Xj[r];
+              }
+            const double lii = Li[i];
+            for (int r = 0; r < nrhs; r++)
+              Xi[r] /= lii;
+          }
+      }
+  }
+
+  //_________________________________________________________________________________
+  void SolveUpperSystem(TriangularMatrix const& L, int const& m, double* x)
+  {
+    if (m > L.n)
+      throw std::runtime_error("[SolveUpperSystem]: too many constants.");
+
+    // Solve the system L^T * x = y by backward substitution. The i-th
+    // column of L^T is the i-th row of L, therefore, once x_i is
+    // known, it is subtracted from the previous constants such that
+    // the rows of L are still read contiguously and once.
+    for (int i = m - 1; i >= 0; i--)
+      {
+        double const* Li = L.Row(i);
+        x[i] /= Li[i];
+        for (int j = 0; j < i; j++)
+          x[j] -= Li[j] * x[i];
+      }
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> SolveLowerSystem(TriangularMatrix const& L, std::vector<double> const& y)
+  {
+    const int ndata = y.size();
+    std::vector<double> x = y;
+    SolveLowerSystem(L, ndata, x.data());
+
+    if (!LinearSystemChecks())
+      return x;
+
+    // Check that the solution worked
+    for (int i = 0; i < ndata; i++)
+      {
+        double z = 0;
+        for (int j = 0; j <= i; j++)
+          z += L(i, j) * x[j];
+        if (!(std::abs(z - y[i]) / ( 1 + std::abs(y[i]) ) <= 1e-5))
+          throw std::runtime_error("[SolveLowerSystem]: Problem with the forward substitution.");
+      }
+    return x;
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> SolveLowerSystem(apfel::matrix<double> const& L, std::vector<double> const& y)
   {
     // Solve the system L * y = x by forward substitution
     const int ndata = y.size();
@@ -60,20 +286,105 @@ namespace NangaParbat
         x[i] /= L(i, i);
       }
 
+    if (!LinearSystemChecks())
+      return x;
+
     // Check that the solution worked
     for (int i = 0; i < ndata; i++)
       {
         double z = 0;
-        for (int j = 0; j < ndata; j++)
+        for (int j = 0; j <= i; j++)
           z += L(i, j) * x[j];
-        if (abs(z - y[i]) / ( 1 + std::abs(y[i]) ) > 1e-5)
+        if (!(std::abs(z - y[i]) / ( 1 + std::abs(y[i]) ) <= 1e-5))
+          throw std::runtime_error("[SolveLowerSystem]: Problem with the forward substitution.");
+      }
+    return x;
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> SolveLowerSystem(LowRankCholesky const& L, std::vector<double> const& y)
+  {
+    const int ndata = y.size();
+    const int k     = L.k;
+    if (ndata > (int) L.d.size())
+      throw std::runtime_error("[SolveLowerSystem]: too many constants.");
+
+    // Solve the system L * x = y by forward substitution. The sum
+    // over the previous rows, sum_{j < i} L(i, j) x_j, is u_i * z
+    // with z = sum_{j < i} g_j x_j accumulated along the way.
+    std::vector<double> x(ndata);
+    std::vector<double> z(k, 0.);
+    for (int i = 0; i < ndata; i++)
+      {
+        double const* ui = L.u.data() + i * k;
+        double const* gi = L.g.data() + i * k;
+        x[i] = y[i];
+        for (int a = 0; a < k; a++)
+          x[i] -= ui[a] * z[a];
+
+        x[i] /= L.d[i];
+        for (int a = 0; a < k; a++)
+          z[a] += gi[a] * x[i];
+      }
+
+    if (!LinearSystemChecks())
+      return x;
+
+    // Check that the solution worked
+    std::fill(z.begin(), z.end(), 0.);
+    for (int i = 0; i < ndata; i++)
+      {
+        double const* ui = L.u.data() + i * k;
+        double const* gi = L.g.data() + i * k;
+        double w = L.d[i] * x[i];
+        for (int a = 0; a < k; a++)
+          {
+            w    += ui[a] * z[a];
+            z[a] += gi[a] * x[i];
+          }
+        if (!(std::abs(w - y[i]) / ( 1 + std::abs(y[i]) ) <= 1e-5))
           throw std::runtime_error("[SolveLowerSystem]: Problem with the forward substitution.");
       }
     return x;
   }
 
   //_________________________________________________________________________________
-  std::vector<double> SolveUpperSystem(apfel::matrix<double> U, std::vector<double> y)
+  void SolveLowerSystem(LowRankCholesky const& L, int const& m, int const& nrhs, double* X)
+  {
+    const int k = L.k;
+    if (m > (int) L.d.size())
+      throw std::runtime_error("[SolveLowerSystem]: too many constants.");
+
+    // Same as the single-vector case with the accumulators z = sum_{j
+    // < i} g_j x_j promoted to a k x nrhs matrix Z.
+    std::vector<double> Z(k * nrhs, 0.);
+    for (int i = 0; i < m; i++)
+      {
+        double const* ui = L.u.data() + i * k;
+        double const* gi = L.g.data() + i * k;
+        double* Xi = X + i * nrhs;
+        for (int a = 0; a < k; a++)
+          {
+            double const* Za = Z.data() + a * nrhs;
+            for (int r = 0; r < nrhs; r++)
+              Xi[r] -= ui[a] * Za[r];
+          }
+
+        const double di = L.d[i];
+        for (int r = 0; r < nrhs; r++)
+          Xi[r] /= di;
+
+        for (int a = 0; a < k; a++)
+          {
+            double* Za = Z.data() + a * nrhs;
+            for (int r = 0; r < nrhs; r++)
+              Za[r] += gi[a] * Xi[r];
+          }
+      }
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> SolveUpperSystem(apfel::matrix<double> const& U, std::vector<double> const& y)
   {
     // Solve the system U * y = x by backward substitution
     const int ndata = y.size();
@@ -87,46 +398,53 @@ namespace NangaParbat
         x[i] /= U(i, i);
       }
 
+    if (!LinearSystemChecks())
+      return x;
+
     // Check that the solution worked
     for (int i = 0; i < ndata; i++)
       {
         double z = 0;
-        for (int j = 0; j < ndata; j++)
+        for (int j = i; j < ndata; j++)
           z += U(i, j) * x[j];
-        if (abs(z - y[i]) / ( 1 + std::abs(y[i]) ) > 1e-5)
+        if (!(std::abs(z - y[i]) / ( 1 + std::abs(y[i]) ) <= 1e-5))
           throw std::runtime_error("[SolveUpperSystem]: Problem with the backward substitution.");
       }
     return x;
   }
 
   //_________________________________________________________________________________
-  std::vector<double> SolveSymmetricSystem(apfel::matrix<double> A, std::vector<double> rho)
+  std::vector<double> SolveSymmetricSystem(apfel::matrix<double> const& A, std::vector<double> const& rho)
   {
-    // Get Cholesky decomposition of A
-    const apfel::matrix<double> La = CholeskyDecomposition(A);
+    // Get Cholesky decomposition of A and solve La * La^T * lambda =
+    // rho
+    const std::vector<double> lambda = SolveCholeskySystem(CholeskyDecomposition(A), rho);
 
-    // Solve system La * sigma = rho
-    const std::vector<double> sigma = SolveLowerSystem(La, rho);
-
-    // Transpose La
-    const int ndata = rho.size();
-    apfel::matrix<double> LaT{(size_t) ndata, (size_t) ndata};
-    for (int alpha = 0; alpha < ndata; alpha++)
-      for (int beta = 0; beta < ndata; beta++)
-        LaT(alpha, beta) = La(beta, alpha);
-
-    // Solve system LaT * lambda = sigma
-    const std::vector<double> lambda = SolveUpperSystem(LaT, sigma);
+    if (!LinearSystemChecks())
+      return lambda;
 
     // Check that A * lambda = rho
+    const int ndata = rho.size();
     for (int i = 0; i < ndata; i++)
       {
         double z = 0;
         for (int j = 0; j < ndata; j++)
           z += A(i, j) * lambda[j];
-        if (abs(z - rho[i]) / ( 1 + std::abs(rho[i]) ) > 1e-5)
+        if (!(std::abs(z - rho[i]) / ( 1 + std::abs(rho[i]) ) <= 1e-5))
           throw std::runtime_error("[SolveSymmetricSystem]: Problem with the symmetric system.");
       }
     return lambda;
   }
+
+  //_________________________________________________________________________________
+  std::vector<double> SolveCholeskySystem(TriangularMatrix const& L, std::vector<double> const& rho)
+  {
+    // Solve L * sigma = rho by forward substitution and L^T * lambda
+    // = sigma by backward substitution in place.
+    const int n = rho.size();
+    std::vector<double> x = rho;
+    SolveLowerSystem(L, n, x.data());
+    SolveUpperSystem(L, n, x.data());
+    return x;
+  }
 }
@@ -0,0 +1,62 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/parallelfor.h"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <exception>
+#include <algorithm>
+
+namespace NangaParbat
+{
+  //_________________________________________________________________________________
+  void ParallelFor(int const& n, std::function<void(int const&)> const& body, int const& nthreads)
+  {
+    // Number of threads actually used
+    const int nt = std::min(n, (nthreads > 0 ? nthreads : std::max((int) std::thread::hardware_concurrency(), 1)));
+
+    // Run serially if there is nothing to gain
+    if (nt <= 1)
+      {
+        for (int i = 0; i < n; i++)
+          body(i);
+        return;
+      }
+
+    std::atomic<int> next{0};
+    std::exception_ptr error = nullptr;
+    std::mutex mtx;
+    const auto worker = [&] () -> void
+    {
+      for (int i = next++; i < n; i = next++)
+        {
+          try
+            {
+              body(i);
+            }
+          catch (...)
+            {
+              // Record the first exception and stop handing out
+              // indices.
+              std::lock_guard<std::mutex> lock(mtx);
+              if (!error)
+                error = std::current_exception();
+              next = n;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int it = 0; it < nt; it++)
+      threads.push_back(std::thread{worker});
+    for (auto& t : threads)
+      t.join();
+
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
@@ -0,0 +1,49 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/tabulatedtmd.h"
+
+namespace NangaParbat
+{
+  //_________________________________________________________________________________
+  TabulatedTMD::TabulatedTMD(std::function<apfel::Set<apfel::Distribution>(double const&, double const&, double const&)> const& EvTMDs,
+                             std::function<double(double const&, double const&)>                                          const& bstar,
+                             int                                                                                          const& ifl,
+                             double                                                                                       const& x,
+                             double                                                                                       const& Q,
+                             std::vector<double>                                                                          const& bThresholds,
+                             int                                                                                          const& nb,
+                             double                                                                                       const& bmin,
+                             double                                                                                       const& bmax):
+    _x(x),
+    _Q(Q),
+    _tab(std::unique_ptr<apfel::TabulateObject<double>>(new apfel::TabulateObject<double>
+  {
+    [=] (double const& bT) -> double{ return bT * apfel::QCDEvToPhys(EvTMDs(bstar(bT, Q), Q, Q * Q).GetObjects()).at(ifl).Evaluate(x); },
+    nb, bmin, bmax, 3, bThresholds,
+    [] (double const& b) -> double{ return log(b); },
+    [] (double const& fb) -> double{ return exp(fb); }
+  })),
+  _DEObj{}
+  {
+  }
+
+  //_________________________________________________________________________________
+  std::function<double(double const&)> TabulatedTMD::bTSpace(Parameterisation const& NPFunc, int const& ifunc) const
+  {
+    const double Q2 = _Q * _Q;
+    return [=, &NPFunc] (double const& bT) -> double{ return Evaluate(bT) * NPFunc.Evaluate(_x, bT, Q2, ifunc); };
+  }
+
+  //_________________________________________________________________________________
+  std::vector<double> TabulatedTMD::qTSpace(Parameterisation const& NPFunc, int const& ifunc, std::vector<double> const& qTv) const
+  {
+    const std::function<double(double const&)> bInt = bTSpace(NPFunc, ifunc);
+    std::vector<double> tmd(qTv.size());
+    for (int iqT = 0; iqT < (int) qTv.size(); iqT++)
+      tmd[iqT] = _DEObj.transform(bInt, qTv[iqT]);
+
+    return tmd;
+  }
+}
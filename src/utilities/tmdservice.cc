@@ -0,0 +1,175 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/tmdservice.h"
+
+#include <LHAPDF/LHAPDF.h>
+#include <algorithm>
+
+namespace NangaParbat
+{
+  //_________________________________________________________________________________
+  TMDService::TMDService(YAML::Node               const& config,
+                         std::vector<std::string> const& dists,
+                         int                      const& cachesize,
+                         double                   const& resolution,
+                         int                      const& nQ,
+                         double                   const& Qmin,
+                         std::string              const& alphas):
+    _config(config),
+    _cachesize(cachesize),
+    _resolution(resolution)
+  {
+    if (dists.empty())
+      throw std::runtime_error("[TMDService::TMDService]: no distributions requested.");
+
+    for (auto const& pf : dists)
+      if (pf != "pdf" && pf != "ff")
+        throw std::runtime_error("[TMDService::TMDService]: Unknown distribution prefix '" + pf + "'.");
+
+    if (alphas != "tabulated" && alphas != "direct" && alphas != "own")
+      throw std::runtime_error("[TMDService::TMDService]: Unknown strong coupling '" + alphas + "'.");
+
+    // Open LHAPDF sets. They are kept alive by the couplings that are
+    // evaluated directly from them.
+    std::map<std::string, std::shared_ptr<LHAPDF::PDF>> sets;
+    for (auto const& pf : dists)
+      sets.insert({pf, std::shared_ptr<LHAPDF::PDF>(LHAPDF::mkPDF(_config[pf + "set"]["name"].as<std::string>(), _config[pf + "set"]["member"].as<int>()))});
+
+    // Heavy-quark thresholds from the PDF set, if available,
+    // otherwise from the FF set.
+    const std::shared_ptr<LHAPDF::PDF> ref = (sets.count("pdf") ? sets.at("pdf") : sets.at("ff"));
+    for (auto const& v : ref->flavors())
+      if (v > 0 && v < 7)
+        _Thresholds.push_back(ref->quarkThreshold(v));
+
+    // Strong coupling evaluated directly from a set. The first call
+    // initialises the coupling, such that the subsequent concurrent
+    // calls only read it.
+    const auto DirectAlphas = [] (std::shared_ptr<LHAPDF::PDF> const& set) -> std::function<double(double const&)>
+    {
+      set->alphasQ(set->qMax());
+      return [=] (double const& mu) -> double{ return set->alphasQ(mu); };
+    };
+
+    // Strong coupling of the reference set, either tabulated or
+    // direct.
+    if (alphas == "tabulated")
+      {
+        const std::shared_ptr<apfel::TabulateObject<double>> TabAlphas{new apfel::TabulateObject<double>{[&] (double const& mu) -> double{ return ref->alphasQ(mu); },
+                                                                                                            100, ref->qMin(), ref->qMax(), 3, _Thresholds}};
+        _Alphas = [=] (double const& mu) -> double{ return TabAlphas->Evaluate(mu); };
+      }
+    else
+      _Alphas = DirectAlphas(ref);
+
+    // Perturbative order and initial-scale variation factor
+    const int    pto = _config["PerturbativeOrder"].as<int>();
+    const double Ci  = _config["TMDscales"]["Ci"].as<double>();
+
+    int index = 0;
+    for (auto const& pf : dists)
+      {
+        LHAPDF::PDF* dist = sets.at(pf).get();
+        Ingredients& ing = _dists[pf];
+        ing.index = index++;
+
+        // Quark flavours of the set
+        for (auto const& v : dist->flavors())
+          if (v > 0 && v < 7)
+            ing.flavours.push_back(v);
+
+        // Define x-space grid
+        std::vector<apfel::SubGrid> vsg;
+        for (auto const& sg : _config["xgrid" + pf])
+          vsg.push_back({sg[0].as<int>(), sg[1].as<double>(), sg[2].as<int>()});
+        ing.g = std::unique_ptr<const apfel::Grid>(new apfel::Grid{vsg});
+
+        // Rotate set into the QCD evolution basis
+        const auto RotDists = [&] (double const& x, double const& mu) -> std::map<int,double> { return apfel::PhysToQCDEv(dist->xfxQ(x, mu)); };
+
+        // Construct set of distributions as a function of the scale
+        // to be tabulated
+        apfel::Grid const& g = *ing.g;
+        const auto EvolvedDists = [&] (double const& mu) -> apfel::Set<apfel::Distribution>
+        {
+          return apfel::Set<apfel::Distribution>{apfel::EvolutionBasisQCD{apfel::NF(mu, _Thresholds)}, DistributionMap(g, RotDists, mu)};
+        };
+
+        // Tabulate collinear distributions
+        ing.TabDists = std::unique_ptr<apfel::TabulateObject<apfel::Set<apfel::Distribution>>>
+                       (new apfel::TabulateObject<apfel::Set<apfel::Distribution>> {EvolvedDists, nQ, (Qmin > 0 ? Qmin : dist->qMin() + Qmin), dist->qMax(), 3, _Thresholds});
+
+        // Initialise TMD objects
+        ing.TmdObjs = apfel::InitializeTmdObjects(g, _Thresholds);
+
+        // Build evolved TMDs
+        apfel::TabulateObject<apfel::Set<apfel::Distribution>> const* tab = ing.TabDists.get();
+        const auto CollDists = [=] (double const& mu) -> apfel::Set<apfel::Distribution> { return tab->Evaluate(mu); };
+        const std::function<double(double const&)> Alphas = (alphas == "own" ? DirectAlphas(sets.at(pf)) : _Alphas);
+        if (pf == "pdf")
+          ing.EvTMDs = BuildTmdPDFs(ing.TmdObjs, CollDists, Alphas, pto, Ci);
+        else
+          ing.EvTMDs = BuildTmdFFs(ing.TmdObjs, CollDists, Alphas, pto, Ci);
+      }
+  }
+
+  //_________________________________________________________________________________
+  TMDService::Ingredients const& TMDService::Get(std::string const& pf) const
+  {
+    const auto it = _dists.find(pf);
+    if (it == _dists.end())
+      throw std::runtime_error("[TMDService::Get]: distribution '" + pf + "' not initialised.");
+    return it->second;
+  }
+
+  //_________________________________________________________________________________
+  apfel::Set<apfel::Distribution> TMDService::Evaluate(std::string const& pf, double const& b, double const& mu, double const& zeta) const
+  {
+    Ingredients const& ing = Get(pf);
+
+    // Bypass the cache if disabled
+    if (_cachesize <= 0)
+      return ing.EvTMDs(b, mu, zeta);
+
+    const Key key{ing.index, std::llround(log(b) / _resolution), std::llround(log(mu) / _resolution), std::llround(log(zeta) / _resolution)};
+
+    // Look up the cache and, if found, move the entry to the front
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      const auto it = _index.find(key);
+      if (it != _index.end())
+        {
+          _cache.splice(_cache.begin(), _cache, it->second);
+          return it->second->second;
+        }
+    }
+
+    // Compute outside the lock so that concurrent evaluations do not
+    // serialise. If two threads compute the same point, the second
+    // one finds it in the cache and does not insert it again.
+    const apfel::Set<apfel::Distribution> tmds = ing.EvTMDs(b, mu, zeta);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_index.count(key) == 0)
+      {
+        _cache.emplace_front(key, tmds);
+        _index.insert({key, _cache.begin()});
+        if ((int) _cache.size() > _cachesize)
+          {
+            _index.erase(_cache.back().first);
+            _cache.pop_back();
+          }
+      }
+    return tmds;
+  }
+
+  //_________________________________________________________________________________
+  std::function<apfel::Set<apfel::Distribution>(double const&, double const&, double const&)> TMDService::GetTMDs(std::string const& pf) const
+  {
+    // Check that the distribution exists
+    Get(pf);
+    return [=] (double const& b, double const& mu, double const& zeta) -> apfel::Set<apfel::Distribution> { return Evaluate(pf, b, mu, zeta); };
+  }
+}
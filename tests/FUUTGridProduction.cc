@@ -130,7 +130,7 @@ int main(int argc, char* argv[])
   const YAML::Node rep = YAML::LoadFile(RepFolder + "/replica_105/Report.yaml");
 
   // Get parameterisation
-  NangaParbat::Parameterisation* fNP = NangaParbat::GetParametersation(rep["Parameterisation"].as<std::string>());
+  const std::unique_ptr<NangaParbat::Parameterisation> fNP = NangaParbat::MakeParameterisation(rep["Parameterisation"].as<std::string>());
 
   // Get parameters
   const std::map<std::string, double> pars = rep["Parameters"].as<std::map<std::string, double>>();
@@ -224,7 +224,7 @@ int main(int argc, char* argv[])
               const apfel::TabulateObject<apfel::DoubleObject<apfel::Distribution>> tLumib{Lumib, 200, bmin, bmax, 3, {}, TabFunc, InvTabFunc};
 
               // Function in bT space
-              const std::function<double(double const&)> bInt = [=] (double const& b) -> double
+              const std::function<double(double const&)> bInt = [=, &fNP] (double const& b) -> double
               {
                 double bTintegrand = b * fNP->Evaluate(x, b, zeta, 0) * fNP->Evaluate(z, b, zeta, 1) / z / z * tLumib.EvaluatexzQ(x, z, NangaParbat::bstarmin(b, Q));
 
@@ -281,7 +281,6 @@ int main(int argc, char* argv[])
 
   delete distpdf;
   delete distff;
-  delete fNP;
   delete SFs;
 
   return 0;
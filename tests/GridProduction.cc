@@ -82,7 +82,7 @@ int main(int argc, char* argv[])
 
   // Get parameterisation and sets of parameters
   const std::string name = rep["Parameterisation"].as<std::string>();
-  NangaParbat::Parameterisation *NPFunc = NangaParbat::GetParametersation(rep["Parameterisation"].as<std::string>());
+  const std::unique_ptr<NangaParbat::Parameterisation> NPFunc = NangaParbat::MakeParameterisation(rep["Parameterisation"].as<std::string>());
 
   // Get parameters
   const std::map<std::string, double> pars = rep["Parameters"].as<std::map<std::string, double>>();
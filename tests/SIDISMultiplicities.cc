@@ -4,7 +4,6 @@
 // Authors: Valerio Bertone: valerio.bertone@cern.ch
 //
 
-#include <LHAPDF/LHAPDF.h>
 #include <apfel/apfelxx.h>
 #include <yaml-cpp/yaml.h>
 #include <cstring>
@@ -17,6 +16,7 @@
 #include <NangaParbat/nonpertfunctions.h>
 #include <NangaParbat/createtmdgrid.h>
 #include <NangaParbat/datahandler.h>
+#include <NangaParbat/tmdservice.h>
 
 // Main program
 int main(int argc, char* argv[])
@@ -45,45 +45,30 @@ int main(int argc, char* argv[])
   const int PerturbativeOrder = config["PerturbativeOrder"].as<int>();
   std::cout << "\033[1;32mPerturbative order: " << NangaParbat::PtOrderMap.at(PerturbativeOrder) << "\n\033[0m" << std::endl;
 
-  // Open LHAPDF sets
-  // LHAPDF::PDF* distpdf = LHAPDF::mkPDF("GJR08FFnloE", config["pdfset"]["member"].as<int>());
-  // LHAPDF::PDF* distpdf = LHAPDF::mkPDF("MMHT2014nnlo68cl", config["pdfset"]["member"].as<int>());
-  LHAPDF::PDF* distpdf = LHAPDF::mkPDF(config["pdfset"]["name"].as<std::string>(), config["pdfset"]["member"].as<int>());
-  LHAPDF::PDF* distff  = LHAPDF::mkPDF(config["ffset"]["name"].as<std::string>(), config["ffset"]["member"].as<int>());
-
-  // Rotate PDF set into the QCD evolution basis
-  const auto RotPDFs = [=] (double const& x, double const& mu) -> std::map<int,double> { return apfel::PhysToQCDEv(distpdf->xfxQ(x, mu)); };
-  const auto RotFFs  = [=] (double const& x, double const& mu) -> std::map<int,double> { return apfel::PhysToQCDEv(distff->xfxQ(x, mu)); };
-
-  // Get heavy-quark thresholds from the PDF LHAPDF set
-  std::vector<double> Thresholds;
-  for (auto const& v : distpdf->flavors())
-    if (v > 0 && v < 7)
-      Thresholds.push_back(distpdf->quarkThreshold(v));
-
-  // Alpha_s (from PDFs). Get it from the LHAPDF set and tabulate it.
-  const auto Alphas = [&] (double const& mu) -> double{ return distpdf->alphasQ(mu); };
-  const apfel::TabulateObject<double> TabAlphas {[&] (double const& mu) -> double{return distpdf->alphasQ(mu); },
-                                                 100, distpdf->qMin() - 0.5, distpdf->qMax(), 3, Thresholds};
-
-  // Setup APFEL++ x-space grid for PDFs
-  std::vector<apfel::SubGrid> vsgp;
-  for (auto const& sg : config["xgridpdf"])
-    vsgp.push_back({sg[0].as<int>(), sg[1].as<double>(), sg[2].as<int>()});
-  const apfel::Grid gpdf{vsgp};
-
-  // Setup APFEL++ x-space grid for FFs
-  std::vector<apfel::SubGrid> vsgf;
-  for (auto const& sg : config["xgridff"])
-    vsgf.push_back({sg[0].as<int>(), sg[1].as<double>(), sg[2].as<int>()});
-  const apfel::Grid gff{vsgf};
+  // Collinear distributions, strong coupling, and TMD objects. The
+  // collinear distributions are tabulated on 200 nodes starting
+  // slightly below the lower bound of the LHAPDF sets (in
+  // fastinterface.cc the tabulation starts at the lower bound. THIS
+  // HAS AN IMPACT ON THE FINAL PREDICTIONS!) and the strong coupling
+  // is evaluated directly from the PDF set. Each TMD is computed
+  // only once, therefore the cache is not needed.
+  const NangaParbat::TMDService service{config, {"pdf", "ff"}, 0, 1e-7, 200, -0.1, "direct"};
+
+  // Heavy-quark thresholds (from the PDF set)
+  const std::vector<double> Thresholds = service.GetThresholds();
+
+  // Alpha_s (from PDFs)
+  const auto Alphas = [&] (double const& mu) -> double{ return service.Alphas(mu); };
+
+  // APFEL++ x-space grid for PDFs
+  const apfel::Grid& gpdf = service.GetGrid("pdf");
 
   // Scale-variation factors
   const double Ci = config["TMDscales"]["Ci"].as<double>();
   const double Cf = config["TMDscales"]["Cf"].as<double>();
 
   // Get non-perturbative functions
-  const NangaParbat::Parameterisation* fNP = NangaParbat::GetParametersation("PV17");
+  const std::unique_ptr<NangaParbat::Parameterisation> fNP = NangaParbat::MakeParameterisation("PV17");
 
   // Set cut
   const double qToQcut = 3;
@@ -93,35 +78,21 @@ int main(int argc, char* argv[])
   apfel::AlphaQED alphaem{aref, config["alphaem"]["Qref"].as<double>(), Thresholds, {0, 0, 1.777}, 0};
   const apfel::TabulateObject<double> TabAlphaem{alphaem, 100, 0.9, 1001, 3};
 
-  // Construct set of distributions as a function of the scale to be
-  // tabulated
-  const auto EvolvedPDFs = [=,&gpdf] (double const& mu) -> apfel::Set<apfel::Distribution>
-  {
-    return apfel::Set<apfel::Distribution>{apfel::EvolutionBasisQCD{apfel::NF(mu, Thresholds)}, DistributionMap(gpdf, RotPDFs, mu)};
-  };
-  const auto EvolvedFFs = [=,&gff] (double const& mu) -> apfel::Set<apfel::Distribution>
-  {
-    return apfel::Set<apfel::Distribution>{apfel::EvolutionBasisQCD{apfel::NF(mu, Thresholds)}, DistributionMap(gff, RotFFs, mu)};
-  };
-
-  // Tabulate collinear PDFs
-  const apfel::TabulateObject<apfel::Set<apfel::Distribution>> TabPDFs{EvolvedPDFs, 200, distpdf->qMin() - 0.1, distpdf->qMax(), 3, Thresholds}; // ATTENTION! In fastinterface.cc, l. 57 there is only distpdf->qMin(). THIS HAS AN IMPACT ON THE FINAL PREDICTIONS! Same for FFs.
+  // Tabulated collinear PDFs and FFs
+  apfel::TabulateObject<apfel::Set<apfel::Distribution>> const& TabPDFs = service.GetCollinearDistributions("pdf");
   const auto CollPDFs = [&] (double const& mu) -> apfel::Set<apfel::Distribution> { return TabPDFs.Evaluate(mu); };
+  const auto CollFFs  = [&] (double const& mu) -> apfel::Set<apfel::Distribution> { return service.GetCollinearDistributions("ff").Evaluate(mu); };
 
-  // Tabulate collinear FFs
-  const apfel::TabulateObject<apfel::Set<apfel::Distribution>> TabFFs{EvolvedFFs, 200, distff->qMin() - 0.1, distff->qMax(), 3, Thresholds};
-  const auto CollFFs = [&] (double const& mu) -> apfel::Set<apfel::Distribution> { return TabFFs.Evaluate(mu); };
-
-  // Initialize TMD objects
-  const auto TmdObjPDF = apfel::InitializeTmdObjects(gpdf, Thresholds);
-  const auto TmdObjFF  = apfel::InitializeTmdObjects(gff,  Thresholds);
+  // TMD objects
+  const auto& TmdObjPDF = service.GetTmdObjects("pdf");
+  const auto& TmdObjFF  = service.GetTmdObjects("ff");
 
   // Build evolved TMD PDFs
-  const auto EvTMDPDFs    = BuildTmdPDFs(TmdObjPDF, CollPDFs, Alphas, PerturbativeOrder, Ci);
+  const auto EvTMDPDFs    = service.GetTMDs("pdf");
   const auto MatchTMDPDFs = MatchTmdPDFs(TmdObjPDF, CollPDFs, Alphas, PerturbativeOrder, Ci);
 
   // Build evolved TMD FFs
-  const auto EvTMDFFs    = BuildTmdFFs(TmdObjFF, CollFFs, Alphas, PerturbativeOrder, Ci);
+  const auto EvTMDFFs    = service.GetTMDs("ff");
   const auto MatchTMDFFs = MatchTmdFFs(TmdObjFF, CollFFs, Alphas, PerturbativeOrder, Ci);
 
   auto QuarkSudakov = QuarkEvolutionFactor(TmdObjPDF, Alphas, PerturbativeOrder, Ci, 1e5);
@@ -299,9 +270,9 @@ int main(int argc, char* argv[])
 
       // Initialize inclusive structure functions
       const auto IF2 = BuildStructureFunctions(InitializeF2NCObjectsZM(gpdf, Thresholds), tRotPDFs, PerturbativeOrder,
-                                               [=] (double const& Q) -> double{ return TabAlphas.Evaluate(Q); }, fBq);
+                                               Alphas, fBq);
       const auto IFL = BuildStructureFunctions(InitializeFLNCObjectsZM(gpdf, Thresholds), tRotPDFs, PerturbativeOrder,
-                                               [=] (double const& Q) -> double{ return TabAlphas.Evaluate(Q); }, fBq);
+                                               Alphas, fBq);
 
       // Denominator for differential multiplicities
       const auto DiffInclusiveCS = [=](const double Q, const double x) -> double
@@ -369,9 +340,9 @@ int main(int argc, char* argv[])
     		  const double bmax = NangaParbat::bstarmin(10, Qm) * overflow;
     		  const apfel::TabulateObject<apfel::DoubleObject<apfel::Distribution>> tLumib{Lumib, 200, bmin, bmax, 3, {}, TabFunc, InvTabFunc};
 
-    		  const apfel::TabulateObject<double> tf1NP{[=] (double const& tb) -> double { return fNP->Evaluate(xm, tb, zeta, 0); },
+    		  const apfel::TabulateObject<double> tf1NP{[=, &fNP] (double const& tb) -> double { return fNP->Evaluate(xm, tb, zeta, 0); },
     		      100, 5e-5, 5, 3, {}, TabFunc, InvTabFunc};
-    		  const apfel::TabulateObject<double> tf2NP{[=] (double const& tb) -> double { return fNP->Evaluate(zm, tb, zeta, 1); },
+    		  const apfel::TabulateObject<double> tf2NP{[=, &fNP] (double const& tb) -> double { return fNP->Evaluate(zm, tb, zeta, 1); },
     		      100, 5e-5, 5, 3, {}, TabFunc, InvTabFunc};
 
 
@@ -385,9 +356,9 @@ int main(int argc, char* argv[])
     		  const double differ = apfel::ConvFact * apfel::FourPi * aem2 * qTm * Yp * Hf(mu) * DEObj.transform(bInt, qTm) / pow(Qm, 3) / xm / zm / zm ;
           */
 
-          const apfel::TabulateObject<double> tf1NP{[=] (double const& tb) -> double { return fNP->Evaluate(xm, tb, zeta, 0); },
+          const apfel::TabulateObject<double> tf1NP{[=, &fNP] (double const& tb) -> double { return fNP->Evaluate(xm, tb, zeta, 0); },
               100, 5e-5, 5, 3, {}, TabFunc, InvTabFunc};
-          const apfel::TabulateObject<double> tf2NP{[=] (double const& tb) -> double { return fNP->Evaluate(zm, tb, zeta, 1); },
+          const apfel::TabulateObject<double> tf2NP{[=, &fNP] (double const& tb) -> double { return fNP->Evaluate(zm, tb, zeta, 1); },
               100, 5e-5, 5, 3, {}, TabFunc, InvTabFunc};
 
           // Implement ll.741 of fastinterface.cc for the differential case
@@ -472,9 +443,6 @@ int main(int argc, char* argv[])
   fout << em.c_str() << std::endl;
   fout.close();
 
-  delete distpdf;
-  delete distff;
-  delete fNP;
 
   // Delete random-number generator
   gsl_rng_free(rng);
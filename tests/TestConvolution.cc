@@ -32,7 +32,7 @@ int main(int argc, char* argv[])
   const int PerturbativeOrder = 1;
 
   // Get non-perturbative functions
-  const NangaParbat::Parameterisation* fNP = NangaParbat::GetParametersation("PV17");
+  const std::unique_ptr<NangaParbat::Parameterisation> fNP = NangaParbat::MakeParameterisation("PV17");
 
   // Open LHAPDF sets
   LHAPDF::PDF* distpdf = LHAPDF::mkPDF("MMHT2014lo68cl");
@@ -100,7 +100,7 @@ int main(int argc, char* argv[])
       }
     return L;
   };
-  const std::function<double(double const&)> bInt = [=] (double const& b) -> double
+  const std::function<double(double const&)> bInt = [=, &fNP] (double const& b) -> double
   {
     return b * fNP->Evaluate(z, b, Q * Q, 1) * fNP->Evaluate(x, b, Q * Q, 0) * Lumib(NangaParbat::bstarmin(b, Q)).Evaluate(x, z) / z / z;
   };
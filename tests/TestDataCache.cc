@@ -0,0 +1,170 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/datahandler.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+//_________________________________________________________________________________
+// Check that a "DataHandler" object read from the binary cache of a
+// datafile coincides with that obtained by parsing the datafile, with
+// and without t0 predictions, and that corrupted caches and caches of
+// modified datafiles are ignored.
+int main(int argc, char *argv[])
+{
+  if (argc < 3)
+    {
+      std::cerr << "Usage: " << argv[0] << " <output folder> <datafile> [<datafile> ...]" << std::endl;
+      exit(-1);
+    }
+
+  int nfail = 0;
+  const auto Check = [&] (bool const& c, std::string const& what) -> void
+  {
+    if (!c)
+      {
+        std::cerr << "[TestDataCache]: " << what << " differ" << std::endl;
+        nfail++;
+      }
+  };
+
+  for (int it = 2; it < argc; it++)
+    {
+      // Copy datafile into the output folder so that the cache is
+      // written there.
+      const std::string datafile = std::string(argv[1]) + "/TestDataCache.yaml";
+      std::ifstream fin(argv[it]);
+      std::ofstream fout(datafile);
+      fout << fin.rdbuf();
+      fout.close();
+
+      const NangaParbat::DataHandler dy{"Test", YAML::LoadFile(datafile)};
+
+      // Make sure that the cache is actually read by writing one with
+      // different central values. This must not affect the original
+      // object.
+      const std::vector<double> means0 = dy.GetMeanValues();
+      std::vector<double> means = means0;
+      for (auto& m : means)
+        m *= 2;
+      NangaParbat::DataHandler dm = dy;
+      dm.SetMeans(means);
+      dm.WriteCache(NangaParbat::DataCacheFile(datafile), datafile);
+      Check(NangaParbat::DataHandler{"Test", datafile}.GetMeanValues() == means, "central values in the cache");
+      Check(dy.GetMeanValues() == means0, "central values of the original object");
+
+      // Now write the actual cache
+      dy.WriteCache(NangaParbat::DataCacheFile(datafile), datafile);
+
+      std::vector<double> t0 = dy.GetMeanValues();
+      for (int i = 0; i < (int) t0.size(); i++)
+        t0[i] *= 1 + 0.1 * sin(i);
+      const NangaParbat::DataHandler dyt0{"Test", YAML::LoadFile(datafile), nullptr, 0, t0};
+
+      for (auto const& ref : {dy, dyt0})
+        {
+          const NangaParbat::DataHandler dc{"Test", datafile, nullptr, 0, ref.GetT0()};
+
+          Check(dc.GetProcess() == ref.GetProcess() && dc.GetObservable() == ref.GetObservable(), "process");
+          Check(dc.GetTargetIsoscalarity() == ref.GetTargetIsoscalarity() && dc.GetPrefactor() == ref.GetPrefactor(), "prefactors");
+          Check(dc.GetHadron() == ref.GetHadron() && dc.GetCharge() == ref.GetCharge() && dc.GetTagging() == ref.GetTagging(), "final states");
+
+          NangaParbat::DataHandler::Kinematics const& kc = dc.GetKinematics();
+          NangaParbat::DataHandler::Kinematics const& kr = ref.GetKinematics();
+          Check(kc.ndata == kr.ndata && kc.Vs == kr.Vs && kc.qTv == kr.qTv && kc.qTmap == kr.qTmap && kc.qTfact == kr.qTfact, "qT bins");
+          Check(kc.var1b == kr.var1b && kc.var2b == kr.var2b && kc.var3b == kr.var3b, "kinematic bounds");
+          Check(kc.IntqT == kr.IntqT && kc.Intv1 == kr.Intv1 && kc.Intv2 == kr.Intv2 && kc.Intv3 == kr.Intv3, "integration flags");
+          Check(kc.PSRed == kr.PSRed && kc.pTMin == kr.pTMin && kc.etaRange == kr.etaRange, "phase-space reductions");
+
+          Check(dc.GetMeanValues() == ref.GetMeanValues() && dc.GetFluctutatedData() == ref.GetFluctutatedData(), "central values");
+          Check(dc.GetUncorrelatedUnc() == ref.GetUncorrelatedUnc(), "uncorrelated uncertainties");
+          Check(dc.GetAddCorrelatedUnc() == ref.GetAddCorrelatedUnc() && dc.GetMultCorrelatedUnc() == ref.GetMultCorrelatedUnc(), "correlated uncertainties");
+          Check(dc.GetCorrelatedUnc() == ref.GetCorrelatedUnc() && dc.GetLabels() == ref.GetLabels(), "labels");
+
+          bool same = (dc.GetBinning().size() == ref.GetBinning().size());
+          for (int i = 0; same && i < (int) ref.GetBinning().size(); i++)
+            {
+              NangaParbat::DataHandler::Binning const& bc = dc.GetBinning()[i];
+              NangaParbat::DataHandler::Binning const& br = ref.GetBinning()[i];
+              same = (bc.zmin == br.zmin && bc.zmax == br.zmax && bc.zav == br.zav && bc.Intz == br.Intz &&
+                      bc.xmin == br.xmin && bc.xmax == br.xmax && bc.xav == br.xav && bc.Intx == br.Intx &&
+                      bc.Qmin == br.Qmin && bc.Qmax == br.Qmax && bc.Qav == br.Qav && bc.IntQ == br.IntQ &&
+                      bc.ymin == br.ymin && bc.ymax == br.ymax && bc.yav == br.yav && bc.Inty == br.Inty);
+            }
+          Check(same, "bins");
+
+          // The covariance matrix is either read from the cache or
+          // recomputed in the same way, therefore it has to be
+          // identical.
+          for (int i = 0; i < kr.ndata; i++)
+            for (int j = 0; j < kr.ndata; j++)
+              if (dc.GetCovarianceMatrix()(i, j) != ref.GetCovarianceMatrix()(i, j) || dc.GetCholeskyDecomposition()(i, j) != ref.GetCholeskyDecomposition()(i, j))
+                same = false;
+          Check(same, "covariance matrices");
+          Check(dc.HasLowRankCovariance() == ref.HasLowRankCovariance(), "low-rank decompositions");
+          if (dc.HasLowRankCovariance() && ref.HasLowRankCovariance())
+            {
+              NangaParbat::LowRankCholesky const& lc = dc.GetLowRankCholeskyDecomposition();
+              NangaParbat::LowRankCholesky const& lr = ref.GetLowRankCholeskyDecomposition();
+              Check(lc.k == lr.k && lc.d == lr.d && lc.u == lr.u && lc.g == lr.g, "low-rank decompositions");
+            }
+
+          // The datafile is parsed on demand
+          Check(dc.GetDataFile()["dependent_variables"].size() == ref.GetDataFile()["dependent_variables"].size(), "datafiles");
+        }
+
+      // Changing the central values of an object read from the cache
+      // also changes them in the datafile.
+      NangaParbat::DataHandler ds{"Test", datafile};
+      ds.SetMeans(means);
+      bool same = true;
+      int i = 0;
+      for (auto const& dv : ds.GetDataFile()["dependent_variables"])
+        for (auto const& vl : dv["values"])
+          same = same && vl["value"].as<double>() == means[i++];
+      Check(same && i == (int) means.size(), "central values in the datafile");
+
+      // A truncated cache is ignored and the datafile is parsed
+      // instead.
+      std::ifstream cfin(NangaParbat::DataCacheFile(datafile), std::ios::in | std::ios::binary);
+      const std::string cache{std::istreambuf_iterator<char>(cfin), std::istreambuf_iterator<char>()};
+      cfin.close();
+      std::ofstream cfout(NangaParbat::DataCacheFile(datafile), std::ios::out | std::ios::binary);
+      cfout.write(cache.data(), cache.size() / 2);
+      cfout.close();
+      const NangaParbat::DataHandler dt{"Test", datafile};
+      Check(dt.GetMeanValues() == means0 && dt.GetCovarianceMatrix()(0, 0) == dy.GetCovarianceMatrix()(0, 0), "datasets read from a truncated cache");
+
+      // A cache of a datafile modified afterwards is ignored, even if
+      // the size of the datafile is unchanged and the modification
+      // happens within the same second.
+      dy.WriteCache(NangaParbat::DataCacheFile(datafile), datafile);
+      struct stat st;
+      stat(datafile.c_str(), &st);
+      std::ifstream yfin(datafile);
+      std::string yaml{std::istreambuf_iterator<char>(yfin), std::istreambuf_iterator<char>()};
+      yfin.close();
+      const std::size_t iv = yaml.find_first_of("123456789", yaml.find("\n        value: "));
+      yaml[iv] = (yaml[iv] == '9' ? '1' : yaml[iv] + 1);
+      std::ofstream yfout(datafile);
+      yfout << yaml;
+      yfout.close();
+      const struct timespec ts[2] = {st.st_atim, {st.st_mtim.tv_sec, ( st.st_mtim.tv_nsec + 1 ) % 1000000000}};
+      utimensat(AT_FDCWD, datafile.c_str(), ts, 0);
+      const NangaParbat::DataHandler de{"Test", datafile};
+      Check(de.GetMeanValues() == NangaParbat::DataHandler("Test", YAML::LoadFile(datafile)).GetMeanValues() && de.GetMeanValues() != means0, "datasets read from the cache of a modified datafile");
+    }
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestDataCache]: the cached datasets coincide with the parsed ones." << std::endl;
+  return 0;
+}
@@ -0,0 +1,111 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/nonpertfunctions.h"
+#include "NangaParbat/expressionparameterisation.h"
+
+#include <iostream>
+#include <cmath>
+#include <functional>
+
+//_________________________________________________________________________________
+// Check that the DWS parameterisation defined by expressions in a fit
+// card coincides with the hand-written one, derivatives included, that
+// an expression made of separate factors in x, b, and zeta matches its
+// closed form, and that invalid expressions and parameters are
+// rejected.
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      std::cerr << "Usage: " << argv[0] << " <fit card>" << std::endl;
+      exit(-1);
+    }
+
+  const std::unique_ptr<NangaParbat::Parameterisation> NPExpr = NangaParbat::MakeParameterisation(YAML::LoadFile(argv[1]));
+  const std::unique_ptr<NangaParbat::Parameterisation> NPRef  = NangaParbat::MakeParameterisation("DWS");
+
+  int nfail = 0;
+  const auto check = [&] (double const& a, double const& b, std::string const& what) -> void
+  {
+    if (std::abs(a - b) > 1e-12 * std::abs(b))
+      {
+        std::cerr << "[TestExpressionParameterisation]: " << what << ": " << a << " != " << b << std::endl;
+        nfail++;
+      }
+  };
+
+  std::vector<double> x, b, zeta;
+  for (double const& xv : {1e-4, 1e-2, 0.3, 0.9})
+    for (double const& bv : {0.01, 0.5, 2., 8.})
+      for (double const& zv : {4., 100., 1e4})
+        {
+          x.push_back(xv);
+          b.push_back(bv);
+          zeta.push_back(zv);
+        }
+
+  const int n = x.size();
+  for (int ifunc = 0; ifunc < NPRef->GetNumberOfFunctions(); ifunc++)
+    {
+      std::vector<double> fe(n), fr(n);
+      NPExpr->EvaluateBatch(n, x.data(), b.data(), zeta.data(), ifunc, fe.data());
+      NPRef->EvaluateBatch(n, x.data(), b.data(), zeta.data(), ifunc, fr.data());
+      for (int i = 0; i < n; i++)
+        {
+          check(fe[i], fr[i], "batch");
+          check(NPExpr->Evaluate(x[i], b[i], zeta[i], ifunc), fr[i], "value");
+          for (int ipar = 0; ipar < NPRef->GetParameterNumber(); ipar++)
+            check(NPExpr->Derive(x[i], b[i], zeta[i], ifunc, ipar), NPRef->Derive(x[i], b[i], zeta[i], ifunc, ipar), "derivative");
+        }
+    }
+
+  // Expression made of factors that depend on x, b, and zeta
+  // separately
+  YAML::Node sep;
+  sep["parameters"]       = std::vector<std::string>{"a", "g", "h"};
+  sep["values"]           = std::vector<double>{0.3, 0.2, 0.05};
+  sep["constants"]["Q02"] = 3.2;
+  sep["functions"]        = std::vector<std::string>{"x^a * (1 - x) * exp( - g * b^2 ) * (zeta / Q02)^( - h )"};
+  NangaParbat::ExpressionParameterisation NPSep{"Separable", sep};
+  const double a = 0.3, g = 0.2, h = 0.05;
+  for (int i = 0; i < n; i++)
+    {
+      const double lz = log(zeta[i] / 3.2);
+      const double fs = pow(x[i], a) * ( 1 - x[i] ) * exp( - g * b[i] * b[i] ) * exp( - h * lz );
+      check(NPSep.Evaluate(x[i], b[i], zeta[i], 0), fs, "separable value");
+      check(NPSep.Derive(x[i], b[i], zeta[i], 0, 0), log(x[i]) * fs, "separable derivative w.r.t. a");
+      check(NPSep.Derive(x[i], b[i], zeta[i], 0, 1), - b[i] * b[i] * fs, "separable derivative w.r.t. g");
+      check(NPSep.Derive(x[i], b[i], zeta[i], 0, 2), - lz * fs, "separable derivative w.r.t. h");
+    }
+
+  // The number of parameters must match
+  const auto throws = [&] (std::function<void()> const& f, std::string const& what) -> void
+  {
+    try
+      {
+        f();
+        std::cerr << "[TestExpressionParameterisation]: " << what << " accepted" << std::endl;
+        nfail++;
+      }
+    catch (std::runtime_error const&)
+      {
+      }
+  };
+  throws([&] () -> void { NPSep.SetParameters({0.1, 0.2}); }, "wrong number of parameters");
+
+  // Unknown symbols and syntax errors
+  for (auto const& expr : {"exp( - k * b^2 )", "exp( - g * b^2"})
+    {
+      YAML::Node bad = YAML::Clone(sep);
+      bad["functions"] = std::vector<std::string>{expr};
+      throws([&] () -> void { NangaParbat::ExpressionParameterisation{"Invalid", bad}; }, std::string("invalid expression '") + expr + "'");
+    }
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestExpressionParameterisation]: the expression parameterisations are correct." << std::endl;
+  return 0;
+}
@@ -0,0 +1,86 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/datahandler.h"
+#include "NangaParbat/counterrng.h"
+
+#include <iostream>
+
+//_________________________________________________________________________________
+// Check the counter-based random-number generator against the
+// reference values of Philox4x32-10, that the replicas generated by
+// "FluctuateBatch" do not depend on how they are batched or on the
+// number of threads, and that their covariance reproduces the
+// covariance matrix of the dataset.
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      std::cerr << "Usage: " << argv[0] << " <datafile>" << std::endl;
+      exit(-1);
+    }
+
+  int nfail = 0;
+
+  // Reference values for zero key and zero counter
+  const std::array<uint32_t, 4> b = NangaParbat::CounterRNG{0}.Block(0);
+  const std::array<uint32_t, 4> ref{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8};
+  if (b != ref)
+    {
+      std::cerr << "[TestFluctuateBatch]: wrong Philox4x32-10 block" << std::endl;
+      nfail++;
+    }
+
+  const NangaParbat::DataHandler dh{"Test", YAML::LoadFile(argv[1])};
+  const std::vector<double> mean = dh.GetMeanValues();
+  const int ndata = mean.size();
+  const int seed  = 1234;
+  const int nrep  = 20000;
+
+  // All replicas at once, with the default number of threads
+  const apfel::matrix<double> all = dh.FluctuateBatch(seed, 0, nrep);
+
+  // Replica 0 is not fluctuated
+  for (int i = 0; i < ndata; i++)
+    if (all(0, i) != mean[i])
+      {
+        std::cerr << "[TestFluctuateBatch]: replica 0 differs from the central values" << std::endl;
+        nfail++;
+      }
+
+  // A subset of replicas in small batches on one thread
+  for (int first : {1, 17, 999})
+    {
+      const apfel::matrix<double> part = dh.FluctuateBatch(seed, first, 5, 1);
+      for (int r = 0; r < 5; r++)
+        for (int i = 0; i < ndata; i++)
+          if (part(r, i) != all(first + r, i))
+            {
+              std::cerr << "[TestFluctuateBatch]: replica " << first + r << " depends on the batching" << std::endl;
+              nfail++;
+            }
+    }
+
+  // Sample covariance vs. covariance matrix
+  const apfel::matrix<double> cov = dh.GetCovarianceMatrix();
+  for (int i = 0; i < ndata; i++)
+    for (int j = 0; j <= i; j++)
+      {
+        double c = 0;
+        for (int r = 1; r < nrep; r++)
+          c += ( all(r, i) - mean[i] ) * ( all(r, j) - mean[j] );
+        c /= nrep - 1;
+        if (std::abs(c - cov(i, j)) > 0.05 * sqrt(cov(i, i) * cov(j, j)))
+          {
+            std::cerr << "[TestFluctuateBatch]: covariance (" << i << ", " << j << "): " << c << " != " << cov(i, j) << std::endl;
+            nfail++;
+          }
+      }
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestFluctuateBatch]: the fluctuations are reproducible and have the expected covariance." << std::endl;
+  return 0;
+}
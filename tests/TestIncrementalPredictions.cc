@@ -0,0 +1,121 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/convolutiontable.h"
+#include "NangaParbat/nonpertfunctions.h"
+
+#include <iostream>
+#include <cmath>
+
+//_________________________________________________________________________________
+// Small SIDIS table with synthetic weights, such that also the SIDIS
+// path is tested in absence of SIDIS tables in the repository.
+YAML::Node SIDISTable()
+{
+  const std::vector<double> qTv{0.25, 0.5, 1};
+  const std::vector<double> Qg{2, 3, 5};
+  const std::vector<double> xbg{0.05, 0.1, 0.2};
+  const std::vector<double> zg{0.3, 0.5, 0.7};
+  const std::vector<double> zOgata{0.1, 0.5, 1, 2, 4, 8};
+
+  YAML::Node table;
+  table["name"]              = "SIDIS_test";
+  table["process"]           = 1;
+  table["CME"]               = 10;
+  table["qTintegrated"]      = false;
+  table["qT_bounds"]         = qTv;
+  table["qT_map"]            = std::vector<std::vector<double>>{{-1, 0.25}, {-1, 0.5}, {-1, 1}};
+  table["bin_factors"]       = std::vector<double>{1, 1, 1};
+  table["prefactor"]         = 1;
+  table["Ogata_coordinates"] = zOgata;
+  table["Qgrid"]             = Qg;
+  table["xbgrid"]            = xbg;
+  table["zgrid"]             = zg;
+  for (auto const& qT : qTv)
+    {
+      std::vector<std::vector<std::vector<std::vector<double>>>> w(zOgata.size());
+      for (int n = 0; n < (int) zOgata.size(); n++)
+        {
+          w[n].resize(Qg.size(), std::vector<std::vector<double>>(xbg.size(), std::vector<double>(zg.size())));
+          for (int tau = 0; tau < (int) Qg.size(); tau++)
+            for (int alpha = 0; alpha < (int) xbg.size(); alpha++)
+              for (int beta = 0; beta < (int) zg.size(); beta++)
+                w[n][tau][alpha][beta] = qT * zOgata[n] * exp(- zOgata[n]) * ( 1 + tau + alpha * beta );
+        }
+      table["weights"][qT] = w;
+    }
+  return table;
+}
+
+//_________________________________________________________________________________
+// Check that the predictions computed in incremental mode coincide
+// with those computed from scratch when the parameters are varied
+// one at a time.
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      std::cerr << "Usage: " << argv[0] << " <table> [<table> ...]" << std::endl;
+      exit(-1);
+    }
+
+  // Separable parameterisations and a non-separable one, for which
+  // the incremental mode has no effect. The same tables are used for
+  // all of them in sequence to also check that the buffers are not
+  // reused across parameterisations.
+  std::vector<std::unique_ptr<NangaParbat::Parameterisation>> NPFuncs;
+  NPFuncs.push_back(std::unique_ptr<NangaParbat::Parameterisation>(new NangaParbat::PV19{}));
+  for (auto const& name : {"DWS", "PV17", "PV19x", "PV19b"})
+    NPFuncs.push_back(NangaParbat::MakeParameterisation(name));
+
+  // DY tables from the command line followed by the SIDIS table
+  std::vector<YAML::Node> tables;
+  for (int it = 1; it < argc; it++)
+    tables.push_back(YAML::LoadFile(argv[it]));
+  tables.push_back(SIDISTable());
+
+  int nfail = 0;
+  for (auto const& table : tables)
+    {
+      // Same table in incremental and standard mode
+      NangaParbat::ConvolutionTable CTinc{table};
+      NangaParbat::ConvolutionTable CTref{table};
+      CTinc.SetIncrementalMode();
+
+      for (auto const& NPFunc : NPFuncs)
+        {
+          // Start from parameters that give a finite function
+          std::vector<double> pars = NPFunc->GetParameters();
+          for (int ipar = 0; ipar < (int) pars.size(); ipar++)
+            if (pars[ipar] == 0)
+              pars[ipar] = 0.1 * ( ipar + 1 );
+
+          // Vary one parameter at a time, then go back to the
+          // starting point.
+          for (int ipar = 0; ipar <= (int) pars.size(); ipar++)
+            {
+              std::vector<double> p = pars;
+              if (ipar < (int) pars.size())
+                p[ipar] *= 1.1;
+              NPFunc->SetParameters(p);
+
+              const std::vector<double> pinc = CTinc.GetPredictions(*NPFunc);
+              const std::vector<double> pref = CTref.GetPredictions(*NPFunc);
+              for (int i = 0; i < (int) pref.size(); i++)
+                if (std::abs(pinc[i] - pref[i]) > 1e-12 * std::abs(pref[i]))
+                  {
+                    std::cerr << "[TestIncrementalPredictions]: " << CTref.GetName() << ", " << NPFunc->GetName()
+                              << ", parameter " << ipar << ", point " << i << ": " << pinc[i] << " != " << pref[i] << std::endl;
+                    nfail++;
+                  }
+            }
+        }
+    }
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestIncrementalPredictions]: incremental and full predictions agree." << std::endl;
+  return 0;
+}
@@ -0,0 +1,116 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/linearsystems.h"
+
+#include <iostream>
+#include <cmath>
+
+//_________________________________________________________________________________
+// Check the blocked Cholesky decomposition and the triangular solves
+// on symmetric positive-definite matrices whose size is smaller than,
+// equal to, and not a multiple of the block size, with the validation
+// of the results enabled. Also check that the solutions with several
+// vectors of constants at once coincide with those obtained one
+// vector at the time, with both the dense and the low-rank
+// decompositions.
+int main()
+{
+  NangaParbat::SetLinearSystemChecks(true);
+
+  int nfail = 0;
+  for (int n : {1, 7, 64, 150, 300})
+    {
+      // V = D + U U^T with a few columns in U
+      std::vector<double> D(n);
+      std::vector<std::vector<double>> U(n, std::vector<double>(5));
+      for (int i = 0; i < n; i++)
+        {
+          D[i] = 0.5 + 0.01 * i;
+          for (int a = 0; a < 5; a++)
+            U[i][a] = sin(i + 3 * a + 1);
+        }
+      apfel::matrix<double> V{(size_t) n, (size_t) n};
+      for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+          {
+            V(i, j) = (i == j ? D[i] : 0);
+            for (int a = 0; a < 5; a++)
+              V(i, j) += U[i][a] * U[j][a];
+          }
+
+      // The reconstruction is checked internally
+      const NangaParbat::TriangularMatrix L = NangaParbat::CholeskyDecomposition(V);
+
+      std::vector<double> y(n);
+      for (int i = 0; i < n; i++)
+        y[i] = cos(2 * i);
+
+      // Forward substitution
+      const std::vector<double> x = NangaParbat::SolveLowerSystem(L, y);
+
+      // Several vectors of constants at once
+      const int nrhs = 7;
+      std::vector<double> Y(n * nrhs);
+      for (int i = 0; i < n; i++)
+        for (int r = 0; r < nrhs; r++)
+          Y[i * nrhs + r] = (r == 0 ? y[i] : cos(( r + 2 ) * i + r));
+
+      const NangaParbat::LowRankCholesky LR = NangaParbat::CholeskyDecomposition(D, U);
+      std::vector<double> X = Y;
+      std::vector<double> XR = Y;
+      NangaParbat::SolveLowerSystem(L, n, nrhs, X.data());
+      NangaParbat::SolveLowerSystem(LR, n, nrhs, XR.data());
+      for (int r = 0; r < nrhs; r++)
+        {
+          std::vector<double> yr(n);
+          for (int i = 0; i < n; i++)
+            yr[i] = Y[i * nrhs + r];
+          const std::vector<double> xr = NangaParbat::SolveLowerSystem(L, yr);
+          for (int i = 0; i < n; i++)
+            if (std::abs(X[i * nrhs + r] - xr[i]) > 1e-10 * ( 1 + std::abs(xr[i]) ) || std::abs(XR[i * nrhs + r] - xr[i]) > 1e-8 * ( 1 + std::abs(xr[i]) ))
+              {
+                std::cerr << "[TestLinearSystems]: n = " << n << ", vector " << r << ", element " << i << ": "
+                          << X[i * nrhs + r] << ", " << XR[i * nrhs + r] << " != " << xr[i] << std::endl;
+                nfail++;
+              }
+        }
+
+      // Symmetric system, to be compared with the solution of a
+      // sequence of forward and backward substitutions with the
+      // explicit transposed.
+      apfel::matrix<double> LT{(size_t) n, (size_t) n};
+      for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+          LT(i, j) = L(j, i);
+      const std::vector<double> lambda = NangaParbat::SolveSymmetricSystem(V, y);
+      const std::vector<double> lambdaref = NangaParbat::SolveUpperSystem(LT, x);
+      for (int i = 0; i < n; i++)
+        if (std::abs(lambda[i] - lambdaref[i]) > 1e-10 * ( 1 + std::abs(lambdaref[i]) ))
+          {
+            std::cerr << "[TestLinearSystems]: n = " << n << ", element " << i << ": " << lambda[i] << " != " << lambdaref[i] << std::endl;
+            nfail++;
+          }
+    }
+
+  // A matrix which is not positive definite has to be rejected
+  apfel::matrix<double> V{2, 2};
+  V(0, 0) = V(1, 1) = 1;
+  V(0, 1) = V(1, 0) = 2;
+  try
+    {
+      NangaParbat::CholeskyDecomposition(V);
+      std::cerr << "[TestLinearSystems]: non positive-definite matrix decomposed" << std::endl;
+      nfail++;
+    }
+  catch (std::runtime_error const&)
+    {
+    }
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestLinearSystems]: decompositions and solutions are correct." << std::endl;
+  return 0;
+}
@@ -0,0 +1,65 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/datahandler.h"
+
+#include <iostream>
+
+//_________________________________________________________________________________
+// Check that the forward substitution with the low-rank Cholesky
+// decomposition of the covariance matrix coincides with that with the
+// dense one, also for leading blocks of the system.
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      std::cerr << "Usage: " << argv[0] << " <datafile> [<datafile> ...]" << std::endl;
+      exit(-1);
+    }
+
+  int nfail = 0;
+  for (int it = 1; it < argc; it++)
+    {
+      // Both with and without t0 predictions
+      const NangaParbat::DataHandler dh{"Test", YAML::LoadFile(argv[it])};
+      std::vector<double> t0 = dh.GetMeanValues();
+      for (int i = 0; i < (int) t0.size(); i++)
+        t0[i] *= 1 + 0.1 * sin(i);
+      const NangaParbat::DataHandler dht0{"Test", YAML::LoadFile(argv[it]), nullptr, 0, t0};
+
+      for (auto const& d : {dh, dht0})
+        {
+          if (!d.HasLowRankCovariance())
+            {
+              std::cerr << "[TestLowRankCovariance]: low-rank decomposition not available for " << argv[it] << std::endl;
+              nfail++;
+              continue;
+            }
+
+          // Residuals of the size of the data set, and smaller
+          const int ndata = d.GetMeanValues().size();
+          for (int m : {ndata, ndata / 2})
+            {
+              std::vector<double> r(m);
+              for (int i = 0; i < m; i++)
+                r[i] = d.GetMeanValues()[i] * cos(3 * i);
+
+              const std::vector<double> xd = NangaParbat::SolveLowerSystem(d.GetCholeskyDecomposition(), r);
+              const std::vector<double> xl = NangaParbat::SolveLowerSystem(d.GetLowRankCholeskyDecomposition(), r);
+              for (int i = 0; i < m; i++)
+                if (std::abs(xd[i] - xl[i]) > 1e-10 * ( 1 + std::abs(xd[i]) ))
+                  {
+                    std::cerr << "[TestLowRankCovariance]: " << argv[it] << ", point " << i << ": " << xl[i] << " != " << xd[i] << std::endl;
+                    nfail++;
+                  }
+            }
+        }
+    }
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestLowRankCovariance]: low-rank and dense decompositions agree." << std::endl;
+  return 0;
+}
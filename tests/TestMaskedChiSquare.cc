@@ -0,0 +1,87 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/chisquare.h"
+#include "NangaParbat/nonpertfunctions.h"
+
+#include <iostream>
+#include <cmath>
+
+//_________________________________________________________________________________
+// Check that a block added with a mask that selects all the points
+// gives the same chi2 as the block added without a mask, and that the
+// residuals of a training and a validation mask add up to those of
+// all the eligible points.
+int main(int argc, char *argv[])
+{
+  if (argc < 3)
+    {
+      std::cerr << "Usage: " << argv[0] << " <table> <datafile>" << std::endl;
+      exit(-1);
+    }
+
+  int nfail = 0;
+  const auto Check = [&] (double const& a, double const& b, std::string const& what) -> void
+  {
+    if (std::abs(a - b) > 1e-10 * std::max(std::abs(b), 1.))
+      {
+        std::cerr << "[TestMaskedChiSquare]: " << what << ": " << a << " != " << b << std::endl;
+        nfail++;
+      }
+  };
+
+  const YAML::Node table = YAML::LoadFile(argv[1]);
+  const YAML::Node data  = YAML::LoadFile(argv[2]);
+  NangaParbat::ConvolutionTable CT{table};
+  NangaParbat::DataHandler DH{table["name"].as<std::string>(), data, nullptr, 0};
+  const std::unique_ptr<NangaParbat::Parameterisation> NPFunc = NangaParbat::MakeParameterisation("PV17");
+
+  // Plain block and block with a mask that selects all the points
+  NangaParbat::ChiSquare full{NPFunc.get()};
+  full.AddBlock(std::make_pair(&DH, &CT));
+  NangaParbat::ChiSquare all{NPFunc.get()};
+  all.AddBlock(std::make_pair(&DH, &CT), std::valarray<bool>(true, CT.GetCutMask().size()));
+
+  Check(all(), full(), "chi2 with all-true mask");
+  Check(all.GetDataPointNumberAfterCuts(), full.GetDataPointNumberAfterCuts(), "number of points with all-true mask");
+
+  // Training set made of every other eligible point and validation
+  // set made of the remaining ones, as in the cross validation.
+  std::valarray<bool> eligible = CT.GetCutMask();
+  for (int j = std::max(full.GetDataPointNumbers()[0], 0); j < (int) eligible.size(); j++)
+    eligible[j] = false;
+  std::valarray<bool> training = eligible;
+  int ie = 0;
+  for (int j = 0; j < (int) training.size(); j++)
+    if (eligible[j])
+      training[j] = (ie++ % 2 == 0);
+
+  NangaParbat::ChiSquare trn{NPFunc.get()};
+  trn.AddBlock(std::make_pair(&DH, &CT), training);
+  NangaParbat::ChiSquare val{NPFunc.get()};
+  val.AddBlock(std::make_pair(&DH, &CT), eligible && !training);
+
+  Check(trn.GetDataPointNumberAfterCuts() + val.GetDataPointNumberAfterCuts(), full.GetDataPointNumberAfterCuts(), "number of training and validation points");
+  if (trn.GetDataPointNumberAfterCuts() == 0 || val.GetDataPointNumberAfterCuts() == 0)
+    {
+      std::cerr << "[TestMaskedChiSquare]: empty training or validation set" << std::endl;
+      nfail++;
+    }
+
+  // The residuals are linear in the differences between data and
+  // predictions, which vanish for the masked points when computed
+  // with the central values.
+  const std::vector<double> pred = full.GetPredictions(0);
+  const std::vector<double> rf = full.GetResiduals(0, pred, true);
+  const std::vector<double> rt = trn.GetResiduals(0, pred, true);
+  const std::vector<double> rv = val.GetResiduals(0, pred, true);
+  for (int j = 0; j < (int) rf.size(); j++)
+    Check(rt[j] + rv[j], rf[j], "residual " + std::to_string(j));
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestMaskedChiSquare]: the masked chi2 is correct." << std::endl;
+  return 0;
+}
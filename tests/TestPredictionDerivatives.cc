@@ -0,0 +1,97 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/chisquare.h"
+#include "NangaParbat/nonpertfunctions.h"
+
+#include <iostream>
+#include <cmath>
+
+//_________________________________________________________________________________
+// Check that the derivatives of the predictions and of the residuals
+// w.r.t. the parameters agree with central finite differences, for
+// parameterisations with automatic (separable and non-separable) and
+// hand-written derivatives.
+int main(int argc, char *argv[])
+{
+  if (argc < 3)
+    {
+      std::cerr << "Usage: " << argv[0] << " <table> <datafile>" << std::endl;
+      exit(-1);
+    }
+
+  int nfail = 0;
+  const auto Check = [&] (double const& d, double const& fd, double const& scale, std::string const& what) -> void
+  {
+    if (std::abs(d - fd) > 1e-4 * scale)
+      {
+        std::cerr << "[TestPredictionDerivatives]: " << what << ": " << d << " != " << fd << std::endl;
+        nfail++;
+      }
+  };
+
+  const YAML::Node table = YAML::LoadFile(argv[1]);
+  const YAML::Node data  = YAML::LoadFile(argv[2]);
+  NangaParbat::ConvolutionTable CT{table};
+  NangaParbat::DataHandler DH{table["name"].as<std::string>(), data, nullptr, 0};
+
+  for (auto const& name : {"PV17", "PV19b", "DWS"})
+    {
+      const std::unique_ptr<NangaParbat::Parameterisation> NPFunc = NangaParbat::MakeParameterisation(name);
+
+      // Start from parameters that give a finite function
+      std::vector<double> pars = NPFunc->GetParameters();
+      for (int ipar = 0; ipar < (int) pars.size(); ipar++)
+        if (pars[ipar] == 0)
+          pars[ipar] = 0.1 * ( ipar + 1 );
+      NPFunc->SetParameters(pars);
+
+      NangaParbat::ChiSquare chi2{NPFunc.get()};
+      chi2.AddBlock(std::make_pair(&DH, &CT));
+
+      const std::vector<double> pred = CT.GetPredictions(*NPFunc);
+      double pscale = 0;
+      for (double const& p : pred)
+        pscale = std::max(pscale, std::abs(p));
+      const std::vector<double> res = chi2.GetResiduals(0);
+      double rscale = 0;
+      for (double const& r : res)
+        rscale = std::max(rscale, std::abs(r));
+
+      const std::vector<std::vector<double>> dpred = CT.GetPredictionDerivatives(*NPFunc);
+      const std::vector<std::vector<double>> dres  = chi2.GetResidualDerivatives(0);
+      for (int ipar = 0; ipar < (int) pars.size(); ipar++)
+        {
+          // Central finite differences
+          const double h = 1e-4 * std::max(std::abs(pars[ipar]), 0.1);
+          std::vector<double> pp = pars;
+          std::vector<double> pm = pars;
+          pp[ipar] += h;
+          pm[ipar] -= h;
+          NPFunc->SetParameters(pp);
+          const std::vector<double> predp = CT.GetPredictions(*NPFunc);
+          const std::vector<double> resp  = chi2.GetResiduals(0);
+          NPFunc->SetParameters(pm);
+          const std::vector<double> predm = CT.GetPredictions(*NPFunc);
+          const std::vector<double> resm  = chi2.GetResiduals(0);
+          NPFunc->SetParameters(pars);
+
+          const std::vector<double> dresi = chi2.GetResidualDerivatives(0, ipar);
+          const std::string what = std::string(name) + ", parameter " + std::to_string(ipar);
+          for (int j = 0; j < (int) pred.size(); j++)
+            Check(dpred[ipar][j], ( predp[j] - predm[j] ) / 2 / h, pscale, what + ", prediction " + std::to_string(j));
+          for (int j = 0; j < (int) res.size(); j++)
+            {
+              Check(dres[ipar][j], ( resp[j] - resm[j] ) / 2 / h, rscale, what + ", residual " + std::to_string(j));
+              Check(dresi[j], dres[ipar][j], rscale * 1e-6, what + ", single-parameter residual " + std::to_string(j));
+            }
+        }
+    }
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestPredictionDerivatives]: the derivatives agree with finite differences." << std::endl;
+  return 0;
+}
@@ -0,0 +1,87 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/factories.h"
+#include "NangaParbat/tmdgridset.h"
+#include "NangaParbat/numtostring.h"
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <sys/stat.h>
+#include <utime.h>
+
+//_________________________________________________________________________________
+// Check that a set produced in binary format and regenerated in YAML
+// format only is read from the new YAML members rather than from the
+// binary ones left over by the first production, and that binary
+// members that are up to date are still used.
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      std::cerr << "Usage: " << argv[0] << " <output folder>" << std::endl;
+      exit(-1);
+    }
+
+  const std::string name   = "TestStaleBinaryGrids";
+  const std::string folder = std::string(argv[1]) + "/" + name;
+  mkdir(folder.c_str(), ACCESSPERMS);
+
+  const std::vector<std::vector<double>> axes{{1, 2, 4, 8, 16}, {0.01, 0.03, 0.1, 0.3, 0.7}, {0.01, 0.1, 0.5, 1, 2}};
+  const std::vector<int> flavours{-1, 0, 1};
+  const std::size_t size = axes[0].size() * axes[1].size() * axes[2].size() * flavours.size();
+
+  std::ofstream iout(folder + "/" + name + ".info");
+  iout << "TMDType: pdf\nNumMembers: 2" << std::endl;
+  iout.close();
+
+  // First production in binary format (with YAML members alongside)
+  // with all values equal to one, and regeneration of the YAML
+  // members only with all values equal to two. The binary members of
+  // the first production are made one hour older than the new YAML
+  // ones.
+  for (int mem = 0; mem < 2; mem++)
+    {
+      const std::string file = folder + "/" + name + "_" + NangaParbat::num_to_string(mem);
+      NangaParbat::WriteBinaryGrid(file + ".bin", axes, flavours, std::vector<double>(size, 1));
+      std::ofstream fout(file + ".yaml");
+      fout << NangaParbat::EmitGridYAML(axes, flavours, std::vector<double>(size, 2))->c_str() << std::endl;
+      fout.close();
+
+      struct stat st;
+      stat((file + ".yaml").c_str(), &st);
+      const struct utimbuf old{st.st_atime - 3600, st.st_mtime - 3600};
+      utime((file + ".bin").c_str(), &old);
+    }
+
+  int nfail = 0;
+  const auto Check = [&] (double const& v, double const& vex, std::string const& what) -> void
+  {
+    if (std::abs(v - vex) > 1e-6)
+      {
+        std::cerr << "[TestStaleBinaryGrids]: " << what << ": " << v << " != " << vex << std::endl;
+        nfail++;
+      }
+  };
+
+  // Evaluate on a node
+  const double x = axes[1][2], qT = axes[0][2] * axes[2][2], Q = axes[0][2];
+  const std::unique_ptr<NangaParbat::TMDGrid> g0{NangaParbat::mkTMD(name, argv[1], 0)};
+  Check(g0->Evaluate(x, qT, Q).at(0), 2, "stale binary member read by mkTMD");
+  const NangaParbat::TMDGridSet set{name, argv[1]};
+  Check(set.EvaluateMembers(x, qT, Q)[1].at(0), 2, "stale binary member read by TMDGridSet");
+
+  // Binary member written after the YAML one
+  const std::string file1 = folder + "/" + name + "_" + NangaParbat::num_to_string(1);
+  NangaParbat::WriteBinaryGrid(file1 + ".bin", axes, flavours, std::vector<double>(size, 3));
+  const std::unique_ptr<NangaParbat::TMDGrid> g1{NangaParbat::mkTMD(name, argv[1], 1)};
+  Check(g1->Evaluate(x, qT, Q).at(0), 3, "up-to-date binary member read by mkTMD");
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestStaleBinaryGrids]: stale binary members are ignored." << std::endl;
+  return 0;
+}
@@ -0,0 +1,88 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/factories.h"
+#include "NangaParbat/numtostring.h"
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <sys/stat.h>
+
+//_________________________________________________________________________________
+// Check that the summary members of a TMD set, written after replicas
+// whose numbers have a gap, are found through the info file and that
+// they interpolate to the mean and the standard deviation of the
+// replicas.
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      std::cerr << "Usage: " << argv[0] << " <output folder>" << std::endl;
+      exit(-1);
+    }
+
+  // Set with replicas 0, 1, and 3
+  const std::string name   = "TestSummaryMembers";
+  const std::string folder = std::string(argv[1]) + "/" + name;
+  mkdir(folder.c_str(), ACCESSPERMS);
+
+  const std::vector<std::vector<double>> axes{{1, 2, 4, 8, 16}, {0.01, 0.03, 0.1, 0.3, 0.7}, {0.01, 0.1, 0.5, 1, 2}};
+  const std::vector<int> flavours{-1, 0, 1};
+  const std::size_t size = axes[0].size() * axes[1].size() * axes[2].size() * flavours.size();
+  const std::vector<int> reps{0, 1, 3};
+  std::vector<std::string> files;
+  for (int const& r : reps)
+    {
+      std::vector<double> data(size);
+      for (std::size_t k = 0; k < size; k++)
+        data[k] = 1 + 0.1 * r * sin(k);
+
+      const std::string file = folder + "/" + name + "_" + NangaParbat::num_to_string(r) + ".bin";
+      NangaParbat::WriteBinaryGrid(file, axes, flavours, data);
+      if (r > 0)
+        files.push_back(file);
+    }
+
+  std::ofstream iout(folder + "/" + name + ".info");
+  iout << "TMDType: pdf\nNumMembers: " << reps.size() << std::endl;
+  iout << NangaParbat::WriteSummaryMembers(files, folder + "/" + name, reps.back() + 1, true)->c_str() << std::endl;
+  iout.close();
+
+  // Evaluate replicas and summary members on a node
+  const NangaParbat::LazyGridSet<NangaParbat::TMDGrid> set{name, argv[1]};
+  const double x = axes[1][2], qT = axes[0][2] * axes[2][2], Q = axes[0][2];
+  const double v1 = set.GetMember(1)->Evaluate(x, qT, Q).at(0);
+  const std::unique_ptr<NangaParbat::TMDGrid> g3{NangaParbat::mkTMD(name, argv[1], reps.back())};
+  const double v3 = g3->Evaluate(x, qT, Q).at(0);
+  const double mean = set.GetSummaryMember("mean")->Evaluate(x, qT, Q).at(0);
+  const double std  = set.GetSummaryMember("std")->Evaluate(x, qT, Q).at(0);
+
+  int nfail = 0;
+  if (set.GetSummaryMemberNames().size() != 4)
+    {
+      std::cerr << "[TestSummaryMembers]: wrong number of summary members" << std::endl;
+      nfail++;
+    }
+  if (std::abs(mean - ( v1 + v3 ) / 2) > 1e-10 || std::abs(std - std::abs(v1 - v3) / sqrt(2)) > 1e-10)
+    {
+      std::cerr << "[TestSummaryMembers]: mean = " << mean << ", std = " << std << " for replicas " << v1 << ", " << v3 << std::endl;
+      nfail++;
+    }
+  try
+    {
+      set.GetSummaryMember("median");
+      std::cerr << "[TestSummaryMembers]: unknown summary member found" << std::endl;
+      nfail++;
+    }
+  catch (std::runtime_error const&)
+    {
+    }
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestSummaryMembers]: the summary members are correct." << std::endl;
+  return 0;
+}
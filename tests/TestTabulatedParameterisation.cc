@@ -0,0 +1,77 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/tabulatedparameterisation.h"
+#include "NangaParbat/DWS.h"
+
+#include <iostream>
+#include <cmath>
+
+//_________________________________________________________________________________
+// Check that the tabulation of an analytic parameterisation (DWS)
+// reproduces the function and its derivatives off the nodes, that
+// points outside the grid are computed exactly, and that clones can
+// be set independently of the original.
+int main()
+{
+  int nfail = 0;
+  const auto Check = [&] (double const& f, double const& fex, double const& tol, std::string const& what) -> void
+  {
+    if (std::abs(f - fex) > tol * std::max(std::abs(fex), 1e-3))
+      {
+        std::cerr << "[TestTabulatedParameterisation]: " << what << ": " << f << " != " << fex << std::endl;
+        nfail++;
+      }
+  };
+
+  // Logarithmic grids
+  const auto LogGrid = [] (int const& n, double const& min, double const& max) -> std::vector<double>
+  {
+    std::vector<double> g(n);
+    for (int i = 0; i < n; i++)
+      g[i] = min * exp( log( max / min ) * i / ( n - 1 ) );
+    return g;
+  };
+
+  NangaParbat::DWS dws;
+  NangaParbat::TabulatedParameterisation tab{&dws, LogGrid(10, 1e-3, 0.9), LogGrid(200, 1e-2, 5), LogGrid(30, 4, 1e4), 3, true, 1};
+
+  // Points off the nodes of the grid
+  const std::vector<double> xv{0.0123, 0.37};
+  const std::vector<double> bv{0.0157, 0.33, 1.234, 4.1};
+  const std::vector<double> zv{5.5, 91.1876 * 91.1876 / 2, 7777};
+  const int np = dws.GetParameterNumber();
+  std::vector<double> g(np), gex(np);
+  for (double const& x : xv)
+    for (double const& b : bv)
+      for (double const& zeta : zv)
+        for (int ifunc = 0; ifunc < dws.GetNumberOfFunctions(); ifunc++)
+          {
+            const std::string what = "(" + std::to_string(x) + ", " + std::to_string(b) + ", " + std::to_string(zeta) + ")";
+            Check(tab.Evaluate(x, b, zeta, ifunc), dws.Evaluate(x, b, zeta, ifunc), 1e-4, "function at " + what);
+            const double f = tab.Gradient(x, b, zeta, ifunc, g.data());
+            Check(f, dws.Gradient(x, b, zeta, ifunc, gex.data()), 1e-4, "function from the gradient at " + what);
+            for (int ipar = 0; ipar < np; ipar++)
+              Check(g[ipar], gex[ipar], 1e-3, "derivative " + std::to_string(ipar) + " at " + what);
+          }
+
+  // Outside the grid the wrapped parameterisation is used
+  Check(tab.Evaluate(0.1, 10, 100, 0), dws.Evaluate(0.1, 10, 100, 0), 1e-14, "function outside the grid");
+
+  // Clones with different parameters do not affect the original
+  const std::vector<double> pars = dws.GetParameters();
+  const std::vector<double> cpars{2 * pars[0], 3 * pars[1]};
+  const std::unique_ptr<NangaParbat::Parameterisation> clone = tab.Clone(NangaParbat::ParameterSet{cpars});
+  NangaParbat::DWS cdws;
+  cdws.SetParameters(cpars);
+  Check(clone->Evaluate(0.1, 0.5, 100, 0), cdws.Evaluate(0.1, 0.5, 100, 0), 1e-5, "clone");
+  Check(tab.Evaluate(0.1, 0.5, 100, 0), dws.Evaluate(0.1, 0.5, 100, 0), 1e-5, "original after cloning");
+  Check(dws.GetParameters()[0], pars[0], 1e-14, "wrapped parameters after cloning");
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestTabulatedParameterisation]: the tabulated parameterisation is correct." << std::endl;
+  return 0;
+}
@@ -0,0 +1,68 @@
+//
+// Author: Valerio Bertone: valerio.bertone@cern.ch
+//
+
+#include "NangaParbat/crossvalidation.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+//_________________________________________________________________________________
+// Check that the K-fold validation sets partition the eligible points
+// and that the random splits have the requested size and are
+// reproducible.
+int main()
+{
+  int nfail = 0;
+  const auto Check = [&] (bool const& c, std::string const& what) -> void
+  {
+    if (!c)
+      {
+        std::cerr << "[TestTrainingMasks]: " << what << std::endl;
+        nfail++;
+      }
+  };
+
+  // Eligible points: all but every third one
+  std::valarray<bool> mask(true, 40);
+  for (int j = 0; j < 40; j += 3)
+    mask[j] = false;
+  const int neligible = std::count(std::begin(mask), std::end(mask), true);
+
+  // K-fold
+  const std::vector<std::valarray<bool>> kf = NangaParbat::GenerateTrainingMasks(mask, 5, true, 0, 1234, "Test");
+  std::valarray<int> nval(0, 40);
+  for (auto const& m : kf)
+    {
+      Check(std::count(std::begin(m), std::end(m), true) >= neligible - ( neligible + 4 ) / 5, "folds too large");
+      for (int j = 0; j < 40; j++)
+        {
+          Check(!m[j] || mask[j], "training point not eligible");
+          nval[j] += (mask[j] && !m[j]);
+        }
+    }
+  for (int j = 0; j < 40; j++)
+    Check(nval[j] == (mask[j] ? 1 : 0), "folds do not partition the eligible points");
+
+  // Random splits
+  const std::vector<std::valarray<bool>> rs  = NangaParbat::GenerateTrainingMasks(mask, 3, false, 0.7, 1234, "Test");
+  const std::vector<std::valarray<bool>> rs2 = NangaParbat::GenerateTrainingMasks(mask, 3, false, 0.7, 1234, "Test");
+  for (int is = 0; is < 3; is++)
+    {
+      Check(std::count(std::begin(rs[is]), std::end(rs[is]), true) == neligible - (int) floor(neligible * ( 1 - 0.7 )), "wrong size of the training set");
+      Check(std::equal(std::begin(rs[is]), std::end(rs[is]), std::begin(rs2[is])), "splits not reproducible");
+    }
+  Check(!std::equal(std::begin(rs[0]), std::end(rs[0]), std::begin(rs[1])), "splits not independent");
+
+  // Small datasets are entirely used for training
+  const std::vector<std::valarray<bool>> sm = NangaParbat::GenerateTrainingMasks(std::valarray<bool>(true, 5), 3, true, 0, 1234, "Test");
+  for (auto const& m : sm)
+    Check(m.min(), "small dataset split");
+
+  if (nfail > 0)
+    return 1;
+
+  std::cout << "[TestTrainingMasks]: the training masks are correct." << std::endl;
+  return 0;
+}